@@ -0,0 +1,547 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file ContactManifold.cpp
+	@author Jukka Jylanki
+	@brief Contact manifold generation with the separating axis theorem and reference face clipping. */
+#include "ContactManifold.h"
+#include "GJK.h"
+#include "../Geometry/Capsule.h"
+#include "../Geometry/LineSegment.h"
+#include "../Geometry/OBB.h"
+#include "../Geometry/Triangle.h"
+#include "../Math/MathFunc.h"
+
+MATH_BEGIN_NAMESPACE
+
+// An axis is only chosen over a face axis of the first object if it penetrates clearly less. Otherwise the reference
+// face would flip back and forth between nearly equal axes from one frame to the next, which makes the contacts jitter.
+static const float axisSelectionBias = 0.95f;
+
+// Clipping a convex polygon against a plane adds at most one vertex, so clipping a quad against the four side planes
+// of a box face gives at most eight vertices.
+static const int maxClippedPoints = 8;
+
+/// Clips the convex polygon in to the halfspace Dot(planeNormal, p) <= planeD with the Sutherland-Hodgman algorithm.
+/** @return The number of vertices written to out. */
+static int ClipPolygon(const vec *in, int numIn, const vec &planeNormal, float planeD, vec *out)
+{
+	int numOut = 0;
+	if (numIn == 0)
+		return 0;
+	vec prev = in[numIn-1];
+	float prevDist = Dot(planeNormal, prev) - planeD;
+	for(int i = 0; i < numIn; ++i)
+	{
+		vec cur = in[i];
+		float curDist = Dot(planeNormal, cur) - planeD;
+		if ((prevDist <= 0.f) != (curDist <= 0.f))
+			out[numOut++] = prev + (cur - prev) * (prevDist / (prevDist - curDist));
+		if (curDist <= 0.f)
+			out[numOut++] = cur;
+		prev = cur;
+		prevDist = curDist;
+	}
+	return numOut;
+}
+
+/// Stores the given contact points to the manifold, reducing them to the four points that span the largest area.
+static void StoreContactPoints(const vec *points, const float *depths, int numPoints, ContactManifold &m)
+{
+	if (numPoints <= ContactManifold::maxPoints)
+	{
+		for(int i = 0; i < numPoints; ++i)
+		{
+			m.points[i] = points[i];
+			m.depths[i] = depths[i];
+		}
+		m.numPoints = numPoints;
+		return;
+	}
+
+	// Keep the deepest point, the point farthest from it, and the points that form the largest triangles with those two
+	// on either side of the line between them.
+	int deepest = 0;
+	for(int i = 1; i < numPoints; ++i)
+		if (depths[i] > depths[deepest])
+			deepest = i;
+	int farthest = deepest;
+	float farthestDistSq = 0.f;
+	for(int i = 0; i < numPoints; ++i)
+	{
+		float distSq = points[i].DistanceSq(points[deepest]);
+		if (distSq > farthestDistSq)
+		{
+			farthestDistSq = distSq;
+			farthest = i;
+		}
+	}
+	vec edge = points[farthest] - points[deepest];
+	int left = -1, right = -1;
+	float maxArea = 0.f, minArea = 0.f;
+	for(int i = 0; i < numPoints; ++i)
+	{
+		float area = Dot(Cross(edge, points[i] - points[deepest]), m.normal);
+		if (area > maxArea)
+		{
+			maxArea = area;
+			left = i;
+		}
+		else if (area < minArea)
+		{
+			minArea = area;
+			right = i;
+		}
+	}
+
+	int selected[ContactManifold::maxPoints] = { deepest, farthest, left, right };
+	m.numPoints = 0;
+	for(int i = 0; i < ContactManifold::maxPoints; ++i)
+		if (selected[i] >= 0 && (i == 0 || selected[i] != deepest))
+		{
+			m.points[m.numPoints] = points[selected[i]];
+			m.depths[m.numPoints] = depths[selected[i]];
+			++m.numPoints;
+		}
+}
+
+/// Clips the incident face against the side planes of the reference face, and stores the clipped points that lie below the
+/// reference face to the manifold.
+/** @param refNormal The unit outward normal of the reference face.
+	@param refIsA If true, the reference face belongs to a and the incident face to b, and m.normal == refNormal. Otherwise
+		the reference face belongs to b, and m.normal == -refNormal. */
+static void ClipIncidentFace(const vec *refFace, int numRef, const vec &refNormal, const vec *incident, int numIncident, bool refIsA, ContactManifold &m)
+{
+	vec buffer1[maxClippedPoints];
+	vec buffer2[maxClippedPoints];
+	vec *in = buffer1;
+	vec *out = buffer2;
+	for(int i = 0; i < numIncident; ++i)
+		in[i] = incident[i];
+	int n = numIncident;
+
+	vec refCenter = refFace[0];
+	for(int i = 1; i < numRef; ++i)
+		refCenter += refFace[i];
+	refCenter /= (float)numRef;
+
+	for(int i = 0; i < numRef && n > 0; ++i)
+	{
+		const vec &edgeStart = refFace[i];
+		vec sideNormal = Cross(refFace[(i+1) % numRef] - edgeStart, refNormal);
+		if (Dot(sideNormal, refCenter - edgeStart) > 0.f)
+			sideNormal = -sideNormal;
+		n = ClipPolygon(in, n, sideNormal, Dot(sideNormal, edgeStart), out);
+		Swap(in, out);
+	}
+
+	// The points of the incident face are on the surface of the incident object. If that is a, move the points along
+	// the normal onto the reference face of b.
+	vec points[maxClippedPoints];
+	float depths[maxClippedPoints];
+	int numPoints = 0;
+	const float refD = Dot(refNormal, refFace[0]);
+	for(int i = 0; i < n; ++i)
+	{
+		float depth = refD - Dot(refNormal, in[i]);
+		if (depth >= 0.f)
+		{
+			points[numPoints] = refIsA ? in[i] : in[i] + refNormal * depth;
+			depths[numPoints] = depth;
+			++numPoints;
+		}
+	}
+
+	// The objects only touch, and rounding errors place the clipped points slightly above the reference face.
+	if (numPoints == 0)
+	{
+		int deepest = 0;
+		for(int i = 1; i < numIncident; ++i)
+			if (Dot(refNormal, incident[i]) < Dot(refNormal, incident[deepest]))
+				deepest = i;
+		points[0] = incident[deepest];
+		depths[0] = 0.f;
+		numPoints = 1;
+	}
+	StoreContactPoints(points, depths, numPoints, m);
+}
+
+/// Returns the outward normal of the face of the given OBB that points the most towards the given direction, and outputs
+/// the corner points of that face in winding order.
+static vec OBBFace(const OBB &o, const vec &direction, vec *outFace)
+{
+	int k = 0;
+	float maxDot = Abs(Dot(direction, o.axis[0]));
+	for(int i = 1; i < 3; ++i)
+	{
+		float d = Abs(Dot(direction, o.axis[i]));
+		if (d > maxDot)
+		{
+			maxDot = d;
+			k = i;
+		}
+	}
+	vec normal = Dot(direction, o.axis[k]) >= 0.f ? o.axis[k] : -o.axis[k];
+	vec c = o.pos + normal * o.r[k];
+	vec u = o.axis[(k+1)%3] * o.r[(k+1)%3];
+	vec v = o.axis[(k+2)%3] * o.r[(k+2)%3];
+	outFace[0] = c + u + v;
+	outFace[1] = c - u + v;
+	outFace[2] = c - u - v;
+	outFace[3] = c + u - v;
+	return normal;
+}
+
+/// Returns the edge of the given OBB parallel to o.axis[edgeAxis] that lies the farthest in the given direction.
+static LineSegment OBBSupportEdge(const OBB &o, int edgeAxis, const vec &direction)
+{
+	vec c = o.pos;
+	for(int k = 0; k < 3; ++k)
+		if (k != edgeAxis)
+			c += o.axis[k] * (Dot(direction, o.axis[k]) >= 0.f ? o.r[k] : -o.r[k]);
+	vec e = o.axis[edgeAxis] * o.r[edgeAxis];
+	return LineSegment(c - e, c + e);
+}
+
+/// Stores the single contact point where the edge ea of a and the edge eb of b pass closest to each other.
+static void StoreEdgeContact(const LineSegment &ea, const LineSegment &eb, float depth, ContactManifold &m)
+{
+	float d, d2;
+	ea.ClosestPoint(eb, d, d2);
+	m.points[0] = eb.GetPoint(d2);
+	m.depths[0] = depth;
+	m.numPoints = 1;
+}
+
+/// Returns the projection radius of the given OBB onto the given axis.
+static float OBBProjectionRadius(const OBB &o, const vec &axis)
+{
+	return o.r.x * Abs(Dot(axis, o.axis[0])) + o.r.y * Abs(Dot(axis, o.axis[1])) + o.r.z * Abs(Dot(axis, o.axis[2]));
+}
+
+bool ComputeContactManifold(const OBB &a, const OBB &b, ContactManifold &outManifold)
+{
+	// The separating axis test of Ericson, Real-Time Collision Detection, p. 103, expressed in the local space of a, so that
+	// all the projections onto the 15 axes come from the same rotation matrix.
+	const vec d = b.pos - a.pos;
+	float R[3][3];
+	float absR[3][3];
+	float ta[3];
+	float tb[3];
+	for(int i = 0; i < 3; ++i)
+	{
+		for(int j = 0; j < 3; ++j)
+		{
+			R[i][j] = Dot(a.axis[i], b.axis[j]);
+			absR[i][j] = Abs(R[i][j]);
+		}
+		ta[i] = Dot(d, a.axis[i]);
+		tb[i] = Dot(d, b.axis[i]);
+	}
+
+	float faceADepth = FLOAT_INF;
+	int faceA = 0;
+	for(int i = 0; i < 3; ++i)
+	{
+		float depth = a.r[i] + b.r[0] * absR[i][0] + b.r[1] * absR[i][1] + b.r[2] * absR[i][2] - Abs(ta[i]);
+		if (depth < 0.f)
+			return false;
+		if (depth < faceADepth)
+		{
+			faceADepth = depth;
+			faceA = i;
+		}
+	}
+
+	float faceBDepth = FLOAT_INF;
+	int faceB = 0;
+	for(int j = 0; j < 3; ++j)
+	{
+		float depth = a.r[0] * absR[0][j] + a.r[1] * absR[1][j] + a.r[2] * absR[2][j] + b.r[j] - Abs(tb[j]);
+		if (depth < 0.f)
+			return false;
+		if (depth < faceBDepth)
+		{
+			faceBDepth = depth;
+			faceB = j;
+		}
+	}
+
+	float edgeDepth = FLOAT_INF;
+	int edgeA = 0, edgeB = 0;
+	vec edgeNormal = vec::zero;
+	for(int i = 0; i < 3; ++i)
+		for(int j = 0; j < 3; ++j)
+		{
+			// Parallel edges do not span an axis. The face axes cover that case.
+			float lengthSq = 1.f - R[i][j] * R[i][j];
+			if (lengthSq < 1e-6f)
+				continue;
+			int i1 = (i+1)%3, i2 = (i+2)%3, j1 = (j+1)%3, j2 = (j+2)%3;
+			float ra = a.r[i1] * absR[i2][j] + a.r[i2] * absR[i1][j];
+			float rb = b.r[j1] * absR[i][j2] + b.r[j2] * absR[i][j1];
+			float dist = Abs(ta[i2] * R[i1][j] - ta[i1] * R[i2][j]);
+			float depth = (ra + rb - dist) / Sqrt(lengthSq);
+			if (depth < 0.f)
+				return false;
+			if (depth < edgeDepth)
+			{
+				edgeDepth = depth;
+				edgeA = i;
+				edgeB = j;
+			}
+		}
+
+	vec refFace[4];
+	vec incidentFace[4];
+	if (edgeDepth < axisSelectionBias * Min(faceADepth, faceBDepth))
+	{
+		edgeNormal = Cross(a.axis[edgeA], b.axis[edgeB]).Normalized();
+		outManifold.normal = Dot(edgeNormal, d) >= 0.f ? edgeNormal : -edgeNormal;
+		StoreEdgeContact(OBBSupportEdge(a, edgeA, outManifold.normal), OBBSupportEdge(b, edgeB, -outManifold.normal), edgeDepth, outManifold);
+	}
+	else if (faceBDepth < axisSelectionBias * faceADepth)
+	{
+		vec refNormal = OBBFace(b, tb[faceB] >= 0.f ? -b.axis[faceB] : b.axis[faceB], refFace);
+		outManifold.normal = -refNormal;
+		OBBFace(a, outManifold.normal, incidentFace);
+		ClipIncidentFace(refFace, 4, refNormal, incidentFace, 4, false, outManifold);
+	}
+	else
+	{
+		vec refNormal = OBBFace(a, ta[faceA] >= 0.f ? a.axis[faceA] : -a.axis[faceA], refFace);
+		outManifold.normal = refNormal;
+		OBBFace(b, -refNormal, incidentFace);
+		ClipIncidentFace(refFace, 4, refNormal, incidentFace, 4, true, outManifold);
+	}
+	return true;
+}
+
+/// Computes the penetration depth of an OBB and a triangle along the given unit axis, and orients the axis from a towards b.
+/** @return The penetration depth, or a negative value if the axis separates the objects. */
+static float OBBTriangleAxisDepth(const OBB &a, const Triangle &b, vec &axis)
+{
+	float c = Dot(axis, a.pos);
+	float r = OBBProjectionRadius(a, axis);
+	float triMin, triMax;
+	b.ProjectToAxis(axis, triMin, triMax);
+	float depthPositive = c + r - triMin; // Pushing b towards +axis.
+	float depthNegative = triMax - (c - r); // Pushing b towards -axis.
+	if (depthPositive <= depthNegative)
+		return depthPositive;
+	axis = -axis;
+	return depthNegative;
+}
+
+bool ComputeContactManifold(const OBB &a, const Triangle &b, ContactManifold &outManifold)
+{
+	float faceADepth = FLOAT_INF;
+	vec faceANormal = vec::zero;
+	for(int i = 0; i < 3; ++i)
+	{
+		vec axis = a.axis[i];
+		float depth = OBBTriangleAxisDepth(a, b, axis);
+		if (depth < 0.f)
+			return false;
+		if (depth < faceADepth)
+		{
+			faceADepth = depth;
+			faceANormal = axis;
+		}
+	}
+
+	float faceBDepth = FLOAT_INF;
+	vec faceBNormal = b.UnnormalizedNormalCCW();
+	if (faceBNormal.LengthSq() > 1e-12f)
+	{
+		faceBNormal.Normalize();
+		faceBDepth = OBBTriangleAxisDepth(a, b, faceBNormal);
+		if (faceBDepth < 0.f)
+			return false;
+	}
+
+	const vec triangle[3] = { b.a, b.b, b.c };
+	float edgeDepth = FLOAT_INF;
+	int edgeA = 0, edgeB = 0;
+	vec edgeNormal = vec::zero;
+	for(int i = 0; i < 3; ++i)
+		for(int j = 0; j < 3; ++j)
+		{
+			vec axis = Cross(a.axis[i], triangle[(j+1)%3] - triangle[j]);
+			float lengthSq = axis.LengthSq();
+			if (lengthSq < 1e-6f * triangle[(j+1)%3].DistanceSq(triangle[j]))
+				continue;
+			axis /= Sqrt(lengthSq);
+			float depth = OBBTriangleAxisDepth(a, b, axis);
+			if (depth < 0.f)
+				return false;
+			if (depth < edgeDepth)
+			{
+				edgeDepth = depth;
+				edgeA = i;
+				edgeB = j;
+				edgeNormal = axis;
+			}
+		}
+
+	vec refFace[4];
+	vec incidentFace[4];
+	if (edgeDepth < axisSelectionBias * Min(faceADepth, faceBDepth))
+	{
+		outManifold.normal = edgeNormal;
+		StoreEdgeContact(OBBSupportEdge(a, edgeA, edgeNormal), LineSegment(triangle[edgeB], triangle[(edgeB+1)%3]), edgeDepth, outManifold);
+	}
+	else if (faceBDepth < axisSelectionBias * faceADepth)
+	{
+		outManifold.normal = faceBNormal;
+		OBBFace(a, faceBNormal, incidentFace);
+		ClipIncidentFace(triangle, 3, -faceBNormal, incidentFace, 4, false, outManifold);
+	}
+	else
+	{
+		outManifold.normal = OBBFace(a, faceANormal, refFace);
+		ClipIncidentFace(refFace, 4, outManifold.normal, triangle, 3, true, outManifold);
+	}
+	return true;
+}
+
+bool ComputeContactManifold(const Capsule &a, const OBB &b, ContactManifold &outManifold)
+{
+	vec closestA, closestB;
+	GJKDistance(a.l, b, closestA, closestB);
+	// Use the distance between the closest points instead of the returned distance, so that the normal is exactly normalized.
+	float dist = closestA.Distance(closestB);
+	if (dist >= a.r)
+		return false;
+
+	int faceAxis = -1;
+	float depth;
+	if (dist > 1e-3f * a.r)
+	{
+		// The line segment is outside the OBB, so the closest points give the exact contact normal.
+		outManifold.normal = (closestB - closestA) / dist;
+		depth = a.r - dist;
+		for(int k = 0; k < 3; ++k)
+			if (Abs(Dot(outManifold.normal, b.axis[k])) > 1.f - 1e-3f)
+				faceAxis = k;
+	}
+	else
+	{
+		// The line segment penetrates the OBB. Find the axis of least penetration among the face normals of the OBB and the
+		// cross products of the line segment with the edges of the OBB. Projected onto an axis, the capsule is the line
+		// segment extended by its radius on both sides.
+		const vec segmentCenter = a.l.CenterPoint();
+		const vec segmentHalf = (a.l.b - a.l.a) * 0.5f;
+		const vec d = b.pos - segmentCenter;
+		float faceDepth = FLOAT_INF;
+		for(int k = 0; k < 3; ++k)
+		{
+			float axisDepth = Abs(Dot(segmentHalf, b.axis[k])) + a.r + b.r[k] - Abs(Dot(d, b.axis[k]));
+			if (axisDepth < 0.f)
+				return false;
+			if (axisDepth < faceDepth)
+			{
+				faceDepth = axisDepth;
+				faceAxis = k;
+			}
+		}
+		float edgeDepth = FLOAT_INF;
+		int edgeAxis = 0;
+		vec edgeNormal = vec::zero;
+		for(int k = 0; k < 3; ++k)
+		{
+			vec axis = Cross(segmentHalf, b.axis[k]);
+			float lengthSq = axis.LengthSq();
+			if (lengthSq < 1e-6f * segmentHalf.LengthSq())
+				continue;
+			axis /= Sqrt(lengthSq);
+			float axisDepth = Abs(Dot(segmentHalf, axis)) + a.r + OBBProjectionRadius(b, axis) - Abs(Dot(d, axis));
+			if (axisDepth < 0.f)
+				return false;
+			if (axisDepth < edgeDepth)
+			{
+				edgeDepth = axisDepth;
+				edgeAxis = k;
+				edgeNormal = axis;
+			}
+		}
+		if (edgeDepth < axisSelectionBias * faceDepth)
+		{
+			outManifold.normal = Dot(edgeNormal, d) >= 0.f ? edgeNormal : -edgeNormal;
+			StoreEdgeContact(a.l, OBBSupportEdge(b, edgeAxis, -outManifold.normal), edgeDepth, outManifold);
+			return true;
+		}
+		outManifold.normal = Dot(b.axis[faceAxis], d) >= 0.f ? b.axis[faceAxis] : -b.axis[faceAxis];
+		depth = faceDepth;
+		// If the face clipping below finds no points, the contact is at the deepest end point of the line segment.
+		closestB = b.ClosestPoint(Dot(outManifold.normal, a.l.a) >= Dot(outManifold.normal, a.l.b) ? a.l.a : a.l.b);
+	}
+
+	if (faceAxis >= 0)
+	{
+		// The contact is on a face of the OBB. Clip the line segment against the side planes of that face, and compute the depth
+		// of both clipped end points, which gives two contact points when the capsule lies on the face.
+		const vec faceNormal = Dot(outManifold.normal, b.axis[faceAxis]) >= 0.f ? -b.axis[faceAxis] : b.axis[faceAxis];
+		const vec faceCenter = b.pos + faceNormal * b.r[faceAxis];
+		const vec dir = a.l.b - a.l.a;
+		float tMin = 0.f, tMax = 1.f;
+		for(int k = 0; k < 3 && tMin <= tMax; ++k)
+		{
+			if (k == faceAxis)
+				continue;
+			float start = Dot(b.axis[k], a.l.a - faceCenter);
+			float delta = Dot(b.axis[k], dir);
+			if (Abs(delta) < 1e-6f)
+			{
+				if (Abs(start) > b.r[k])
+					tMax = -1.f;
+				continue;
+			}
+			float t1 = (-b.r[k] - start) / delta;
+			float t2 = (b.r[k] - start) / delta;
+			tMin = Max(tMin, Min(t1, t2));
+			tMax = Min(tMax, Max(t1, t2));
+		}
+		outManifold.numPoints = 0;
+		if (tMin <= tMax)
+		{
+			const float ts[2] = { tMin, tMax };
+			const int numEndPoints = (tMax - tMin) * dir.Length() > 1e-4f * a.r ? 2 : 1;
+			for(int i = 0; i < numEndPoints; ++i)
+			{
+				vec p = a.l.a + dir * ts[i];
+				float height = Dot(faceNormal, p - faceCenter);
+				if (height <= a.r)
+				{
+					outManifold.points[outManifold.numPoints] = p - faceNormal * height;
+					outManifold.depths[outManifold.numPoints] = a.r - height;
+					++outManifold.numPoints;
+				}
+			}
+		}
+		if (outManifold.numPoints > 0)
+		{
+			outManifold.normal = -faceNormal;
+			return true;
+		}
+		// The line segment passes the face outside its side planes, so the contact is on an edge of the face instead.
+	}
+
+	outManifold.points[0] = closestB;
+	outManifold.depths[0] = depth;
+	outManifold.numPoints = 1;
+	return true;
+}
+
+MATH_END_NAMESPACE
@@ -0,0 +1,71 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file ContactManifold.h
+	@author Jukka Jylanki
+	@brief Generation of the contact points between two intersecting convex objects for rigid body simulation. */
+#pragma once
+
+#include "../MathGeoLibFwd.h"
+#include "../Math/float3.h"
+
+MATH_BEGIN_NAMESPACE
+
+/// A set of contact points between two intersecting objects a and b that all share the same contact normal.
+/** Pushing b by depths[i] along the normal separates the objects at the contact point i. The point of b that is in contact is
+	points[i], and the corresponding point of a is points[i] + normal * depths[i].
+	@see ComputeContactManifold(). */
+struct ContactManifold
+{
+	/// The maximum number of contact points in a manifold. More points than this are reduced to the ones that span the
+	/// largest area, since four points are enough to keep a box resting on a face stable.
+	static const int maxPoints = 4;
+
+	/// The unit direction from a towards b along which the objects penetrate the least.
+	vec normal;
+	/// The contact points on the surface of b.
+	vec points[maxPoints];
+	/// The penetration depths at each contact point, all >= 0.
+	float depths[maxPoints];
+	/// The number of valid elements in points and depths, 1-4 when the objects intersect.
+	int numPoints;
+
+	ContactManifold():numPoints(0) {}
+};
+
+/// Computes the contact manifold between two OBBs.
+/** The axis of least penetration is found with the separating axis theorem. If it is a face normal, the face of the other OBB
+	that faces it the most is clipped against the side planes of the reference face, which gives up to four contact points.
+	If it is the cross product of two edges, the contact is the single point where the edges pass closest to each other.
+	@param outManifold [out] Receives the contact points. This is only filled if the objects intersect.
+	@return True if the objects intersect, false otherwise.
+	@see OBB::Intersects(). */
+bool ComputeContactManifold(const OBB &a, const OBB &b, ContactManifold &outManifold);
+
+/// Computes the contact manifold between an OBB and a triangle.
+/** This works like ComputeContactManifold(const OBB &, const OBB &, ContactManifold &), with the triangle acting as a box with
+	a single face. The triangle is two-sided, i.e. it pushes the OBB out of the side it penetrates the least.
+	@param outManifold [out] Receives the contact points. This is only filled if the objects intersect.
+	@return True if the objects intersect, false otherwise. */
+bool ComputeContactManifold(const OBB &a, const Triangle &b, ContactManifold &outManifold);
+
+/// Computes the contact manifold between a capsule and an OBB.
+/** If the line segment of the capsule lies outside the OBB, the contact normal is the direction between the closest points.
+	Otherwise the axis of least penetration is found with the separating axis theorem. If the contact is on a face of the
+	OBB, the line segment is clipped against the face, which gives two contact points for a capsule lying on the face.
+	@param outManifold [out] Receives the contact points. This is only filled if the objects intersect.
+	@return True if the objects intersect, false otherwise. */
+bool ComputeContactManifold(const Capsule &a, const OBB &b, ContactManifold &outManifold);
+
+MATH_END_NAMESPACE
@@ -14,7 +14,7 @@
 
 /** @file GJK.cpp
 	@author Jukka Jylnki
-	@brief Implementation of the Gilbert-Johnson-Keerthi (GJK) convex polyhedron intersection test. */
+	@brief Implementation of the Gilbert-Johnson-Keerthi (GJK) convex polyhedron intersection test, and the Expanding Polytope Algorithm (EPA). */
 #include "GJK.h"
 #include "../Geometry/LineSegment.h"
 #include "../Geometry/Triangle.h"
@@ -347,4 +347,481 @@ vec UpdateSimplex(vec *s, int &n)
 	}
 }
 
+bool GJKTetrahedronContainsOrigin(const vec *s)
+{
+	// The origin is inside if it is on the same side of each face as the opposite vertex. Each of the four determinants
+	// below is the signed volume of the tetrahedron with one vertex replaced by the origin, and their sum is the signed
+	// volume of the whole tetrahedron.
+	float v0 = Dot(s[1], Cross(s[2], s[3]));
+	float v1 = -Dot(s[0], Cross(s[2], s[3]));
+	float v2 = Dot(s[0], Cross(s[1], s[3]));
+	float v3 = -Dot(s[0], Cross(s[1], s[2]));
+	return (v0 > 0.f && v1 > 0.f && v2 > 0.f && v3 > 0.f) || (v0 < 0.f && v1 < 0.f && v2 < 0.f && v3 < 0.f);
+}
+
+/// Computes the point of the line segment s[i0]->s[i1] closest to the origin.
+/** @param outIndices [out] Receives the indices of the points of the smallest sub-simplex that contains the closest point.
+	@param outLambda [out] Receives the barycentric coordinates of the closest point with respect to the points in outIndices.
+	@param outNumIndices [out] Receives the number of points in outIndices.
+	@return The point of the line segment closest to the origin. */
+static vec ClosestPointOnSegmentToOrigin(const vec *s, int i0, int i1, int *outIndices, float *outLambda, int &outNumIndices)
+{
+	vec d = s[i1] - s[i0];
+	float dd = Dot(d, d);
+	float t = -Dot(s[i0], d);
+	if (t <= 0.f || dd <= 0.f)
+	{
+		outIndices[0] = i0; outLambda[0] = 1.f;
+		outNumIndices = 1;
+		return s[i0];
+	}
+	if (t >= dd)
+	{
+		outIndices[0] = i1; outLambda[0] = 1.f;
+		outNumIndices = 1;
+		return s[i1];
+	}
+	t /= dd;
+	outIndices[0] = i0; outLambda[0] = 1.f - t;
+	outIndices[1] = i1; outLambda[1] = t;
+	outNumIndices = 2;
+	return s[i0] + t * d;
+}
+
+/// Computes the point of the triangle s[i0]->s[i1]->s[i2] closest to the origin. The parameters are as in ClosestPointOnSegmentToOrigin().
+/** The origin is first projected onto the plane of the triangle, and the barycentric coordinates of the projected point are computed
+	from the signed areas of the subtriangles it spans. Unlike the Voronoi region tests of Ericson, Real-Time Collision Detection, p. 141,
+	which multiply pairs of dot products, this keeps the precision when the triangle is far from the origin compared to its size, which
+	is the common case when GJK converges towards a flat feature. If the projected point is outside the triangle, the closest point is
+	on one of the edges opposite to the vertices with a negative barycentric coordinate. */
+static vec ClosestPointOnTriangleToOrigin(const vec *s, int i0, int i1, int i2, int *outIndices, float *outLambda, int &outNumIndices)
+{
+	const int tri[3] = { i0, i1, i2 };
+	vec normal = Cross(s[i1] - s[i0], s[i2] - s[i0]);
+	float nn = Dot(normal, normal);
+	bool testEdge[3] = { true, true, true };
+	if (nn > 0.f)
+	{
+		vec p = normal * (Dot(s[i0], normal) / nn);
+		float barycentric[3];
+		for(int i = 0; i < 3; ++i)
+			barycentric[i] = Dot(Cross(s[tri[(i+1)%3]] - p, s[tri[(i+2)%3]] - p), normal) / nn;
+		if (barycentric[0] >= 0.f && barycentric[1] >= 0.f && barycentric[2] >= 0.f)
+		{
+			float sum = barycentric[0] + barycentric[1] + barycentric[2];
+			for(int i = 0; i < 3; ++i)
+			{
+				outIndices[i] = tri[i];
+				outLambda[i] = barycentric[i] / sum;
+			}
+			outNumIndices = 3;
+			// Return the point that the barycentric coordinates produce instead of p, so that the closest points that
+			// GJKDistance() computes from them are consistent with the returned distance.
+			return outLambda[0] * s[i0] + outLambda[1] * s[i1] + outLambda[2] * s[i2];
+		}
+		for(int i = 0; i < 3; ++i)
+			testEdge[i] = barycentric[i] < 0.f;
+	}
+	// Otherwise test the edges. If the triangle is degenerate, all three of them are tested.
+	vec closest = vec::zero;
+	float closestDistSq = FLOAT_INF;
+	for(int i = 0; i < 3; ++i)
+	{
+		if (!testEdge[i])
+			continue;
+		int edgeIndices[2];
+		float edgeLambda[2];
+		int numEdgeIndices;
+		vec pt = ClosestPointOnSegmentToOrigin(s, tri[(i+1)%3], tri[(i+2)%3], edgeIndices, edgeLambda, numEdgeIndices);
+		float distSq = pt.LengthSq();
+		if (distSq < closestDistSq)
+		{
+			closestDistSq = distSq;
+			closest = pt;
+			outNumIndices = numEdgeIndices;
+			for(int j = 0; j < numEdgeIndices; ++j)
+			{
+				outIndices[j] = edgeIndices[j];
+				outLambda[j] = edgeLambda[j];
+			}
+		}
+	}
+	return closest;
+}
+
+vec GJKClosestPointOnSimplex(vec *s, vec *supportA, vec *supportB, float *lambda, int &n)
+{
+	assume(n >= 1 && n <= 4);
+	int indices[4] = { 0, 1, 2, 3 };
+	float l[4] = { 1.f, 0.f, 0.f, 0.f };
+	int numIndices = n;
+	vec closest = s[0];
+
+	if (n == 2)
+		closest = ClosestPointOnSegmentToOrigin(s, 0, 1, indices, l, numIndices);
+	else if (n == 3)
+		closest = ClosestPointOnTriangleToOrigin(s, 0, 1, 2, indices, l, numIndices);
+	else if (n == 4)
+	{
+		// Compute the barycentric coordinates of the origin with respect to the tetrahedron from the signed volumes spanned by
+		// the origin and each face. If all of them are positive, the origin is inside. See Ericson, Real-Time Collision Detection, p. 142.
+		static const int faces[4][4] = { { 0, 1, 2, 3 }, { 0, 2, 3, 1 }, { 0, 3, 1, 2 }, { 1, 3, 2, 0 } };
+		bool originInside = true;
+		float barycentric[4];
+		float barycentricSum = 0.f;
+		for(int f = 0; f < 4; ++f)
+		{
+			const vec &a = s[faces[f][0]];
+			vec normal = Cross(s[faces[f][1]] - a, s[faces[f][2]] - a);
+			float signOrigin = -Dot(a, normal);
+			float signOpposite = Dot(s[faces[f][3]] - a, normal);
+			originInside = originInside && signOrigin * signOpposite > 0.f;
+			barycentric[faces[f][3]] = signOrigin / signOpposite;
+			barycentricSum += barycentric[faces[f][3]];
+		}
+		// The barycentric coordinates of a point inside the tetrahedron sum up to one. If they do not, the tetrahedron is
+		// so flat that the signs above are not reliable.
+		if (originInside && EqualAbs(barycentricSum, 1.f, 1e-4f))
+		{
+			for(int i = 0; i < 4; ++i)
+				lambda[i] = barycentric[i] / barycentricSum;
+			return vec::zero;
+		}
+		// Otherwise the closest point lies on the boundary. When GJK converges towards a flat feature, the new point is nearly
+		// coplanar with the previous triangle, so instead of culling faces by the side the origin is on, all faces are tested.
+		float closestDistSq = FLOAT_INF;
+		for(int f = 0; f < 4; ++f)
+		{
+			int faceIndices[3];
+			float faceLambda[3];
+			int numFaceIndices;
+			vec pt = ClosestPointOnTriangleToOrigin(s, faces[f][0], faces[f][1], faces[f][2], faceIndices, faceLambda, numFaceIndices);
+			float distSq = pt.LengthSq();
+			if (distSq < closestDistSq)
+			{
+				closestDistSq = distSq;
+				closest = pt;
+				numIndices = numFaceIndices;
+				for(int i = 0; i < numFaceIndices; ++i)
+				{
+					indices[i] = faceIndices[i];
+					l[i] = faceLambda[i];
+				}
+			}
+		}
+	}
+
+	// Compact the simplex to the points that support the closest point.
+	vec newS[4], newA[4], newB[4];
+	for(int i = 0; i < numIndices; ++i)
+	{
+		newS[i] = s[indices[i]];
+		newA[i] = supportA[indices[i]];
+		newB[i] = supportB[indices[i]];
+	}
+	for(int i = 0; i < numIndices; ++i)
+	{
+		s[i] = newS[i];
+		supportA[i] = newA[i];
+		supportB[i] = newB[i];
+		lambda[i] = l[i];
+	}
+	n = numIndices;
+	return closest;
+}
+
+/// Returns a unit vector perpendicular to the given vector, by crossing it with the coordinate axis that is the least parallel to it.
+static vec PerpendicularDirection(const vec &v)
+{
+	vec axis = Abs(v.x) < Abs(v.y) ? (Abs(v.x) < Abs(v.z) ? DIR_VEC(1, 0, 0) : DIR_VEC(0, 0, 1))
+	                               : (Abs(v.y) < Abs(v.z) ? DIR_VEC(0, 1, 0) : DIR_VEC(0, 0, 1));
+	return Cross(v, axis).Normalized();
+}
+
+int EPAExpansionDirections(const vec *s, int n, vec *outDirections)
+{
+	assume(n >= 1 && n <= 3);
+	if (n == 3)
+	{
+		vec normal = Cross(s[1] - s[0], s[2] - s[0]);
+		if (normal.LengthSq() > 1e-12f)
+		{
+			normal.Normalize();
+			outDirections[0] = normal;
+			outDirections[1] = -normal;
+			return 2;
+		}
+		// The triangle is degenerate, so treat it as its longest edge.
+		n = 2;
+		if ((s[2] - s[0]).LengthSq() > (s[1] - s[0]).LengthSq())
+		{
+			vec edge[2] = { s[0], s[2] };
+			return EPAExpansionDirections(edge, 2, outDirections);
+		}
+	}
+	if (n == 2)
+	{
+		vec edge = s[1] - s[0];
+		vec u = PerpendicularDirection(edge);
+		vec v = Cross(edge, u).Normalized();
+		const float sin120 = 0.866025404f;
+		outDirections[0] = u;
+		outDirections[1] = -0.5f * u + sin120 * v;
+		outDirections[2] = -0.5f * u - sin120 * v;
+		return 3;
+	}
+	const float c = 0.577350269f; // 1/sqrt(3)
+	outDirections[0] = DIR_VEC(c, c, c);
+	outDirections[1] = DIR_VEC(c, -c, -c);
+	outDirections[2] = DIR_VEC(-c, c, -c);
+	outDirections[3] = DIR_VEC(-c, -c, c);
+	return 4;
+}
+
+bool EPAPolytope::Init(const vec *points, const vec *pointsA, const vec *pointsB, int numPoints)
+{
+	assume(numPoints <= maxVertices);
+	if (numPoints < 4)
+		return false;
+
+	// Pick four points that span a tetrahedron of maximal extent: the point farthest from the first point, the point
+	// farthest from the line through these two, and the point farthest from the plane through these three.
+	int t[4] = { 0, 0, 0, 0 };
+	float best = 0.f;
+	for(int i = 1; i < numPoints; ++i)
+		if ((points[i] - points[0]).LengthSq() > best)
+		{
+			best = (points[i] - points[0]).LengthSq();
+			t[1] = i;
+		}
+	best = 0.f;
+	for(int i = 1; i < numPoints; ++i)
+		if (Cross(points[t[1]] - points[0], points[i] - points[0]).LengthSq() > best)
+		{
+			best = Cross(points[t[1]] - points[0], points[i] - points[0]).LengthSq();
+			t[2] = i;
+		}
+	vec normal = Cross(points[t[1]] - points[0], points[t[2]] - points[0]);
+	best = 0.f;
+	float volume = 0.f;
+	for(int i = 1; i < numPoints; ++i)
+		if (Abs(Dot(points[i] - points[0], normal)) > best)
+		{
+			volume = Dot(points[i] - points[0], normal);
+			best = Abs(volume);
+			t[3] = i;
+		}
+	if (!(best > 1e-12f * Max(1.f, normal.Length() * (points[t[1]] - points[0]).Length())))
+		return false;
+
+	// Order the vertices so that the fourth vertex is behind the first face, and the faces below are counter-clockwise
+	// when viewed from outside the tetrahedron.
+	if (volume > 0.f)
+		Swap(t[1], t[2]);
+	for(int i = 0; i < 4; ++i)
+	{
+		vertices[i] = points[t[i]];
+		supportA[i] = pointsA[t[i]];
+		supportB[i] = pointsB[t[i]];
+	}
+	numVertices = 4;
+	numFaces = 4;
+	SetFace(0, 0, 1, 2);
+	SetFace(1, 0, 3, 1);
+	SetFace(2, 0, 2, 3);
+	SetFace(3, 1, 3, 2);
+
+	for(int i = 1; i < numPoints; ++i)
+		if (i != t[1] && i != t[2] && i != t[3])
+			AddVertex(points[i], pointsA[i], pointsB[i]);
+	return true;
+}
+
+void EPAPolytope::SetFace(int face, int v0, int v1, int v2)
+{
+	faces[face][0] = v0;
+	faces[face][1] = v1;
+	faces[face][2] = v2;
+	// Compute the normal from the two edges adjacent to the vertex opposite the longest edge, which loses the least
+	// precision for the sliver faces that appear when the support points cluster on a flat feature.
+	const vec &p0 = vertices[v0], &p1 = vertices[v1], &p2 = vertices[v2];
+	float e0 = p1.DistanceSq(p2), e1 = p2.DistanceSq(p0), e2 = p0.DistanceSq(p1);
+	vec normal;
+	if (e0 >= e1 && e0 >= e2)
+		normal = Cross(p1 - p0, p2 - p0);
+	else if (e1 >= e2)
+		normal = Cross(p2 - p1, p0 - p1);
+	else
+		normal = Cross(p0 - p2, p1 - p2);
+	float length = normal.Length();
+	if (length > 1e-12f)
+	{
+		faceNormal[face] = normal / length;
+		faceDistance[face] = (Dot(faceNormal[face], p0) + Dot(faceNormal[face], p1) + Dot(faceNormal[face], p2)) * (1.f / 3.f);
+	}
+	else
+	{
+		faceNormal[face] = vec::zero;
+		faceDistance[face] = FLOAT_INF;
+	}
+}
+
+int EPAPolytope::ClosestFace() const
+{
+	int closest = 0;
+	for(int i = 1; i < numFaces; ++i)
+		if (faceDistance[i] < faceDistance[closest])
+			closest = i;
+	return closest;
+}
+
+bool EPAPolytope::AddVertex(const vec &point, const vec &pointA, const vec &pointB)
+{
+	if (numVertices >= maxVertices)
+		return false;
+
+	// Find the faces that the new vertex can see. Start from the face the vertex is farthest in front of, and flood fill
+	// across the edges to the neighboring visible faces only, so that numerical imprecision in the visibility tests cannot
+	// carve a disconnected hole in the polytope. The edges of the visible region form the horizon, which is stored in the
+	// winding order of the visible faces.
+	bool visible[maxFaces];
+	bool inFront[maxFaces];
+	int seed = -1;
+	float seedHeight = 0.f;
+	for(int i = 0; i < numFaces; ++i)
+	{
+		float height = Dot(faceNormal[i], point) - faceDistance[i];
+		inFront[i] = height > 1e-6f * Max(1.f, Abs(faceDistance[i]));
+		visible[i] = false;
+		if (inFront[i] && height > seedHeight)
+		{
+			seed = i;
+			seedHeight = height;
+		}
+	}
+	if (seed < 0)
+		return false;
+
+	int stack[maxFaces];
+	int stackSize = 1;
+	stack[0] = seed;
+	visible[seed] = true;
+	int numVisible = 1;
+	int neighbors[maxFaces][3];
+	while(stackSize > 0)
+	{
+		int i = stack[--stackSize];
+		for(int j = 0; j < 3; ++j)
+		{
+			int v0 = faces[i][j];
+			int v1 = faces[i][(j+1)%3];
+			int neighbor = -1;
+			for(int k = 0; k < numFaces && neighbor < 0; ++k)
+				for(int l = 0; l < 3; ++l)
+					if (faces[k][l] == v1 && faces[k][(l+1)%3] == v0)
+					{
+						neighbor = k;
+						break;
+					}
+			neighbors[i][j] = neighbor;
+			if (neighbor < 0 || visible[neighbor])
+				continue;
+			// If the new vertex lies on the line through the edge, the face that would connect the edge to it is degenerate,
+			// so remove the neighboring face too, regardless of which side of it the vertex was found to be.
+			vec edge = vertices[v1] - vertices[v0];
+			vec toPoint = point - vertices[v0];
+			if (inFront[neighbor] || Cross(edge, toPoint).LengthSq() <= 1e-10f * edge.LengthSq() * toPoint.LengthSq())
+			{
+				visible[neighbor] = true;
+				++numVisible;
+				stack[stackSize++] = neighbor;
+			}
+		}
+	}
+
+	int horizon[maxFaces][2];
+	int numHorizonEdges = 0;
+	for(int i = 0; i < numFaces; ++i)
+		if (visible[i])
+			for(int j = 0; j < 3; ++j)
+				if (neighbors[i][j] < 0 || !visible[neighbors[i][j]])
+				{
+					if (numHorizonEdges >= maxFaces)
+						return false;
+					horizon[numHorizonEdges][0] = faces[i][j];
+					horizon[numHorizonEdges][1] = faces[i][(j+1)%3];
+					++numHorizonEdges;
+				}
+	if (numVisible == 0 || numFaces - numVisible + numHorizonEdges > maxFaces)
+		return false;
+
+	// Replace the visible faces with a fan of faces that connect the horizon to the new vertex.
+	int numFacesLeft = 0;
+	for(int i = 0; i < numFaces; ++i)
+		if (!visible[i])
+		{
+			faces[numFacesLeft][0] = faces[i][0];
+			faces[numFacesLeft][1] = faces[i][1];
+			faces[numFacesLeft][2] = faces[i][2];
+			faceNormal[numFacesLeft] = faceNormal[i];
+			faceDistance[numFacesLeft] = faceDistance[i];
+			++numFacesLeft;
+		}
+	int v = numVertices++;
+	vertices[v] = point;
+	supportA[v] = pointA;
+	supportB[v] = pointB;
+	numFaces = numFacesLeft;
+	for(int i = 0; i < numHorizonEdges; ++i)
+		SetFace(numFaces++, horizon[i][0], horizon[i][1], v);
+	return true;
+}
+
+void EPAPolytope::FaceBarycentric(int face, const vec &point, float *outLambda) const
+{
+	const int *f = faces[face];
+	const vec &normal = faceNormal[face];
+	float area = Dot(Cross(vertices[f[1]] - vertices[f[0]], vertices[f[2]] - vertices[f[0]]), normal);
+	for(int i = 0; i < 3; ++i)
+		outLambda[i] = Dot(Cross(vertices[f[(i+1)%3]] - point, vertices[f[(i+2)%3]] - point), normal) / area;
+}
+
+void EPAPolytope::FaceContactPoints(int face, vec &outPointA, vec &outPointB) const
+{
+	vec p = faceNormal[face] * faceDistance[face];
+	float lambda[3];
+	FaceBarycentric(face, p, lambda);
+	// Flat features of the objects produce coplanar faces, and the closest one may be any of them. The projection of the
+	// origin lies inside one of them, so switch to that face if it is not inside this one.
+	const float eps = -1e-4f;
+	if (!(lambda[0] >= eps && lambda[1] >= eps && lambda[2] >= eps))
+		for(int i = 0; i < numFaces; ++i)
+			if (Dot(faceNormal[i], faceNormal[face]) >= 1.f - 1e-4f && EqualAbs(faceDistance[i], faceDistance[face], 1e-4f * Max(1.f, faceDistance[face])))
+			{
+				float l[3];
+				FaceBarycentric(i, p, l);
+				if (l[0] >= eps && l[1] >= eps && l[2] >= eps)
+				{
+					face = i;
+					lambda[0] = l[0]; lambda[1] = l[1]; lambda[2] = l[2];
+					break;
+				}
+			}
+
+	const int *f = faces[face];
+	float sum = 0.f;
+	for(int i = 0; i < 3; ++i)
+	{
+		lambda[i] = Max(0.f, lambda[i]);
+		sum += lambda[i];
+	}
+	if (!(sum > 0.f)) // Degenerate face, fall back to the first vertex.
+	{
+		lambda[0] = sum = 1.f;
+		lambda[1] = lambda[2] = 0.f;
+	}
+	outPointA = (lambda[0] * supportA[f[0]] + lambda[1] * supportA[f[1]] + lambda[2] * supportA[f[2]]) / sum;
+	outPointB = (lambda[0] * supportB[f[0]] + lambda[1] * supportB[f[1]] + lambda[2] * supportB[f[2]]) / sum;
+}
+
 MATH_END_NAMESPACE
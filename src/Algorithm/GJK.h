@@ -14,16 +14,89 @@
 
 /** @file GJK.h
 	@author Jukka Jylanki
-	@brief Implementation of the Gilbert-Johnson-Keerthi (GJK) convex polyhedron intersection test. */
+	@brief Implementation of the Gilbert-Johnson-Keerthi (GJK) convex polyhedron intersection and distance tests,
+	and the Expanding Polytope Algorithm (EPA) for penetration depth. */
 #pragma once
 
 #include "../MathGeoLibFwd.h"
 #include "../Math/float3.h"
+#include "../Math/Quat.h"
 
 MATH_BEGIN_NAMESPACE
 
 vec UpdateSimplex(vec *s, int &n);
 
+/// Computes the point of the simplex s closest to the origin, and reduces the simplex to the smallest sub-simplex that contains that point.
+/** Unlike UpdateSimplex(), this function makes no assumptions about how the simplex was constructed, and tracks the
+	points of the two shapes that produced each simplex point, so that the closest points on the shapes can be recovered.
+	@param s [in, out] The points of the simplex in the Minkowski difference A-B.
+	@param supportA [in, out] The points of shape A that produced the simplex points, reordered along with s.
+	@param supportB [in, out] The points of shape B that produced the simplex points, reordered along with s.
+	@param lambda [out] Receives the barycentric coordinates of the closest point with respect to the new simplex.
+	@param n [in, out] The number of points in the simplex, 1-4. If the origin is inside a tetrahedron, this is left at 4.
+	@return The point of the simplex closest to the origin. */
+vec GJKClosestPointOnSimplex(vec *s, vec *supportA, vec *supportB, float *lambda, int &n);
+
+/// Computes the search directions for growing a degenerate simplex into a polytope that contains the origin in its interior.
+/** When the objects only touch, or GJK finds the origin on a face, edge or vertex of the simplex, GJK terminates with
+	fewer than four points. The Expanding Polytope Algorithm needs a polytope that contains the origin in its interior, so
+	the simplex is grown by the support points in the directions returned here: both normals of a triangle, three directions
+	at 120 degree intervals around a line segment, or the four vertex directions of a regular tetrahedron for a single point.
+	If the origin lies in the relative interior of the simplex, and the Minkowski difference extends past the origin in each
+	of these directions, the convex hull of the simplex and the new support points contains the origin in its interior.
+	@param s The points of the simplex.
+	@param n The number of points in the simplex, 1-3.
+	@param outDirections [out] An array of at least four elements that receives the unit search directions.
+	@return The number of directions written to outDirections. */
+int EPAExpansionDirections(const vec *s, int n, vec *outDirections);
+
+/// The convex polytope that the Expanding Polytope Algorithm grows inside the Minkowski difference A-B.
+/** The polytope starts from a tetrahedron that contains the origin, and is expanded one support point at a time towards
+	its face closest to the origin, until that face lies on the boundary of the Minkowski difference. The storage has a fixed
+	capacity, so that the algorithm does not allocate memory.
+	@see GJKPenetration(). */
+struct EPAPolytope
+{
+	static const int maxVertices = 128;
+	static const int maxFaces = 2*maxVertices;
+
+	/// The vertices of the polytope, in the Minkowski difference A-B.
+	vec vertices[maxVertices];
+	/// The points of shape A and B that produced each vertex.
+	vec supportA[maxVertices];
+	vec supportB[maxVertices];
+	int numVertices;
+
+	/// The vertex indices of each face, in counter-clockwise order when viewed from outside the polytope.
+	int faces[maxFaces][3];
+	/// The outward-pointing unit normal of each face.
+	vec faceNormal[maxFaces];
+	/// The signed distance of the plane of each face from the origin, or FLOAT_INF if the face is degenerate.
+	float faceDistance[maxFaces];
+	int numFaces;
+
+	/// Initializes the polytope to the convex hull of the given points.
+	/** @param points The points in the Minkowski difference A-B, at most maxVertices of them.
+		@param pointsA The points of shape A that produced each point.
+		@param pointsB The points of shape B that produced each point.
+		@return False if the points do not span a tetrahedron. */
+	bool Init(const vec *points, const vec *pointsA, const vec *pointsB, int numPoints);
+
+	/// Returns the index of the face whose plane is closest to the origin.
+	int ClosestFace() const;
+
+	/// Adds a new vertex to the polytope, replacing the faces it can see with a fan of faces around the new vertex.
+	/** @return False if the polytope is out of space, or the new vertex does not see any face. */
+	bool AddVertex(const vec &point, const vec &pointA, const vec &pointB);
+
+	/// Computes the points of shapes A and B that produce the projection of the origin onto the given face.
+	void FaceContactPoints(int face, vec &outPointA, vec &outPointB) const;
+
+private:
+	void SetFace(int face, int v0, int v1, int v2);
+	void FaceBarycentric(int face, const vec &point, float *outLambda) const;
+};
+
 #define SUPPORT(dir) (a.ExtremePoint(dir, maxS) - b.ExtremePoint(-dir, minS));
 
 template<typename A, typename B>
@@ -60,4 +133,457 @@ bool GJKIntersect(const A &a, const B &b)
 	return false; // Report no intersection.
 }
 
+/// Caches the result of a GJKIntersect() query between two objects, so that the next query between the same objects can start from it.
+/** When the objects move only a little between the queries, such as a pair of bodies in a physics simulation on consecutive
+	frames, the separating axis found in the previous query usually still separates the objects, and the directions of the
+	simplex that enclosed the origin usually still produce a simplex that encloses it. The warm-started query then terminates
+	after one or four support function evaluations, instead of iterating from an arbitrary starting point.
+	Keep one cache per object pair. A cache that is used for a different pair of objects still gives correct results, but does
+	not save any work.
+	@see GJKIntersect(const A &, const B &, GJKCache &). */
+struct GJKCache
+{
+	/// The search directions to try first. These are the separating axis found in the previous query, or the points of the
+	/// simplex that enclosed the origin.
+	vec directions[4];
+	/// The number of valid elements in directions. 0 if there is no previous query, 1 if the objects were separate in the
+	/// previous query, and 2-4 if they intersected.
+	int numDirections;
+
+	GJKCache():numDirections(0) {}
+
+	/// Forgets the previous query, so that the next query starts from scratch.
+	void Reset() { numDirections = 0; }
+};
+
+/// Returns true if the origin lies inside the tetrahedron s[0]-s[3], which may be in either winding order.
+bool GJKTetrahedronContainsOrigin(const vec *s);
+
+/// Tests whether the two given convex objects intersect, starting from the result of the previous query cached in the given object.
+/** This function works for any pair of objects that implement the functions ExtremePoint(direction, projectionDistance) and AnyPointFast().
+	@param cache [in, out] The cached result of the previous query between these objects, which is updated with the result of
+		this query. Default-construct or Reset() the cache before the first query.
+	@return The same result as GJKIntersect(a, b).
+	@see GJKCache. */
+template<typename A, typename B>
+bool GJKIntersect(const A &a, const B &b, GJKCache &cache)
+{
+	vec support[4];
+	float maxS, minS;
+	if (cache.numDirections == 1)
+	{
+		// The objects were separate in the previous query. If the same axis still separates them, they still are.
+		support[0] = SUPPORT(cache.directions[0]);
+		if (minS + maxS < 0.f)
+			return false;
+	}
+	else if (cache.numDirections == 4)
+	{
+		// The objects intersected in the previous query. If the support points in the directions of the previous simplex
+		// still enclose the origin, they still do.
+		for(int i = 0; i < 4; ++i)
+			support[i] = SUPPORT(cache.directions[i]);
+		if (GJKTetrahedronContainsOrigin(support))
+		{
+			for(int i = 0; i < 4; ++i)
+				cache.directions[i] = support[i];
+			return true;
+		}
+	}
+
+	// The cached result is no longer valid. Run the regular GJK iteration, which starts from a point near the middle of
+	// the Minkowski difference, since that converges faster than starting from one of the extreme points found above.
+	support[0] = a.AnyPointFast() - b.AnyPointFast();
+	vec d = -support[0];
+	cache.numDirections = 0;
+	if (d.LengthSq() < 1e-7f)
+		return true;
+	const int maxIterations = 50;
+	// Remember the search direction of each support point, so that the directions that produced the final simplex can be cached.
+	vec points[maxIterations];
+	vec directions[maxIterations];
+	int n = 1;
+	for(int iteration = 0; iteration < maxIterations; ++iteration)
+	{
+		vec newSupport = SUPPORT(d);
+		if (minS + maxS < 0.f)
+		{
+			cache.directions[0] = d;
+			cache.numDirections = 1;
+			return false;
+		}
+		points[iteration] = newSupport;
+		directions[iteration] = d;
+		support[n++] = newSupport;
+		int numPoints = n;
+		d = UpdateSimplex(support, n);
+		if (n == 0)
+		{
+			// UpdateSimplex() leaves the points of the simplex that enclosed the origin in place. The search directions that
+			// produced them reproduce the same simplex in the next query if the objects have not moved. The starting point was
+			// not produced by a search direction, so use its own direction for it instead.
+			for(int i = 0; i < numPoints; ++i)
+			{
+				cache.directions[i] = support[i];
+				for(int j = 0; j <= iteration; ++j)
+					if (points[j].BitEquals(support[i]))
+						cache.directions[i] = directions[j];
+			}
+			cache.numDirections = numPoints;
+			return true;
+		}
+	}
+	assume2(false && "GJK intersection test did not converge to a result!", a.SerializeToString(), b.SerializeToString());
+	return false;
+}
+
+/// Runs the GJK distance iteration on the two given convex objects, and returns the final simplex.
+/** This is the common implementation of GJKDistance() and GJKPenetration().
+	@param s [out] An array of four points that receives the final simplex in the Minkowski difference A-B.
+	@param supportA [out] An array of four points that receives the points of a that produced the simplex points.
+	@param supportB [out] An array of four points that receives the points of b that produced the simplex points.
+	@param n [out] Receives the number of points in the final simplex. If the objects intersect, this is 4 if the origin is
+		inside the simplex, or less if the origin lies on the boundary of the simplex.
+	@param tolerance If nonzero, the iteration stops as soon as the returned distance is known to be at most this much
+		larger than the actual distance. Curved objects converge only asymptotically, so this saves iterations when the
+		distance is small.
+	@see GJKDistance(). */
+template<typename A, typename B>
+float GJKDistanceSimplex(const A &a, const B &b, vec *s, vec *supportA, vec *supportB, int &n, vec &outClosestPointA, vec &outClosestPointB,
+	float tolerance = 0.f)
+{
+	float lambda[4];
+	supportA[0] = a.AnyPointFast();
+	supportB[0] = b.AnyPointFast();
+	s[0] = supportA[0] - supportB[0];
+	n = 1; // Stores the current number of points in the search simplex.
+	vec v = s[0]; // The point of the current simplex closest to the origin.
+	float distSq = v.LengthSq();
+	// The closest point can only be computed up to a precision relative to the magnitude of the simplex points, so
+	// distances below that are reported as an intersection.
+	float epsilonSq = 1e-12f * Max(1.f, distSq);
+	outClosestPointA = supportA[0];
+	outClosestPointB = supportB[0];
+	int nIterations = 64; // Robustness check: Limit the maximum number of iterations, curved objects converge only asymptotically.
+	while(nIterations-- > 0 && distSq > epsilonSq)
+	{
+		vec newSupportA = a.ExtremePoint(-v);
+		vec newSupportB = b.ExtremePoint(v);
+		vec w = newSupportA - newSupportB;
+		epsilonSq = Max(epsilonSq, 1e-12f * w.LengthSq());
+		// If the new support point does not get closer to the origin along v than the current simplex, the
+		// distance has been found up to the relative tolerance. Dot(v, w) / |v| is a lower bound of the distance.
+		float improvement = distSq - Dot(v, w);
+		if (improvement <= 1e-6f * distSq || improvement * improvement <= tolerance * tolerance * distSq)
+			break;
+		s[n] = w;
+		supportA[n] = newSupportA;
+		supportB[n] = newSupportB;
+		++n;
+		v = GJKClosestPointOnSimplex(s, supportA, supportB, lambda, n);
+
+		vec closestA = lambda[0] * supportA[0];
+		vec closestB = lambda[0] * supportB[0];
+		for(int i = 1; i < n; ++i)
+		{
+			closestA += lambda[i] * supportA[i];
+			closestB += lambda[i] * supportB[i];
+		}
+		if (n == 4) // The origin is inside the simplex, so the objects intersect.
+		{
+			outClosestPointA = closestA;
+			outClosestPointB = closestB;
+			return 0.f;
+		}
+		float newDistSq = v.LengthSq();
+		if (newDistSq >= distSq) // Floating point imprecision prevents further progress. Keep the previous result.
+			break;
+		distSq = newDistSq;
+		outClosestPointA = closestA;
+		outClosestPointB = closestB;
+	}
+	return distSq > epsilonSq ? Sqrt(distSq) : 0.f;
+}
+
+/// Computes the distance between the two given convex objects, and the closest points on each of them.
+/** This function works for any pair of objects that implement the functions ExtremePoint(direction) and AnyPointFast().
+	@param outClosestPointA [out] Receives the point of a that is closest to b.
+	@param outClosestPointB [out] Receives the point of b that is closest to a. If the objects intersect, this is a point
+		common to both objects, approximately equal to outClosestPointA.
+	@return The distance between a and b, or 0 if the objects intersect.
+	@see GJKIntersect(), GJKPenetration(). */
+template<typename A, typename B>
+float GJKDistance(const A &a, const B &b, vec &outClosestPointA, vec &outClosestPointB)
+{
+	vec s[4], supportA[4], supportB[4];
+	int n;
+	return GJKDistanceSimplex(a, b, s, supportA, supportB, n, outClosestPointA, outClosestPointB);
+}
+
+/// Computes the penetration depth of the two given convex objects with the Expanding Polytope Algorithm.
+/** This function works for any pair of objects that implement the functions ExtremePoint(direction) and AnyPointFast().
+	The simplex that GJK finds to contain the origin is used as the initial polytope, which is then expanded towards the
+	boundary of the Minkowski difference A-B until the face closest to the origin is found.
+	@param outNormal [out] Receives the unit direction from a towards b along which the objects penetrate the least.
+		Translating b by outDepth * outNormal, or a by -outDepth * outNormal, separates the objects.
+	@param outDepth [out] Receives the penetration depth, i.e. the length of the minimum translation vector.
+	@param outContactPointA [out] Receives the point of a that penetrates the deepest into b along outNormal.
+	@param outContactPointB [out] Receives the point of b that penetrates the deepest into a along -outNormal.
+		outContactPointA - outContactPointB is approximately outDepth * outNormal.
+	@return True if the objects intersect, in which case the output parameters are filled. False if the objects are disjoint,
+		in which case the output parameters are left untouched.
+	@see GJKIntersect(), GJKDistance(). */
+template<typename A, typename B>
+bool GJKPenetration(const A &a, const B &b, vec &outNormal, float &outDepth, vec &outContactPointA, vec &outContactPointB)
+{
+	vec s[4], supportA[4], supportB[4];
+	int n;
+	vec closestPointA, closestPointB;
+	if (GJKDistanceSimplex(a, b, s, supportA, supportB, n, closestPointA, closestPointB) > 0.f)
+		return false;
+
+	// The objects intersect. If the origin was found on a face, edge or vertex of the simplex, grow the simplex so that it
+	// contains the origin in its interior.
+	vec points[8], pointsA[8], pointsB[8];
+	int numPoints = n;
+	for(int i = 0; i < n; ++i)
+	{
+		points[i] = s[i];
+		pointsA[i] = supportA[i];
+		pointsB[i] = supportB[i];
+	}
+	if (n < 4)
+	{
+		float scale = 1.f;
+		for(int i = 0; i < n; ++i)
+			scale = Max(scale, s[i].Length());
+		vec dirs[4];
+		int numDirs = EPAExpansionDirections(s, n, dirs);
+		for(int i = 0; i < numDirs; ++i)
+		{
+			pointsA[numPoints] = a.ExtremePoint(dirs[i]);
+			pointsB[numPoints] = b.ExtremePoint(-dirs[i]);
+			points[numPoints] = pointsA[numPoints] - pointsB[numPoints];
+			if (Dot(points[numPoints], dirs[i]) <= 1e-6f * scale)
+			{
+				// The Minkowski difference does not extend past the origin in this direction, so the objects only touch.
+				outNormal = dirs[i];
+				outDepth = 0.f;
+				outContactPointA = closestPointA;
+				outContactPointB = closestPointB;
+				return true;
+			}
+			++numPoints;
+		}
+	}
+
+	EPAPolytope polytope;
+	if (!polytope.Init(points, pointsA, pointsB, numPoints))
+	{
+		// The Minkowski difference is flat, so the objects only touch, and there is no unique normal.
+		outNormal = DIR_VEC(1, 0, 0);
+		outDepth = 0.f;
+		outContactPointA = closestPointA;
+		outContactPointB = closestPointB;
+		return true;
+	}
+	int face = polytope.ClosestFace();
+	// The support points found along the face normals bound the depth from above. Remember the best such direction in case
+	// the polytope runs out of space before it converges, which can happen with deeply penetrating curved objects.
+	vec bestNormal = vec::zero, bestPointA = vec::zero, bestPointB = vec::zero;
+	float bestDepth = FLOAT_INF;
+	bool converged = false;
+	for(int nIterations = 0; nIterations < EPAPolytope::maxVertices; ++nIterations)
+	{
+		const vec &normal = polytope.faceNormal[face];
+		vec pointA = a.ExtremePoint(normal);
+		vec pointB = b.ExtremePoint(-normal);
+		vec w = pointA - pointB;
+		float depth = Dot(w, normal);
+		if (depth < bestDepth)
+		{
+			bestDepth = depth;
+			bestNormal = normal;
+			bestPointA = pointA;
+			bestPointB = pointB;
+		}
+		// If the Minkowski difference does not extend past the closest face, that face lies on its boundary.
+		if (depth - polytope.faceDistance[face] <= 1e-5f * Max(1.f, polytope.faceDistance[face]))
+		{
+			converged = true;
+			break;
+		}
+		if (!polytope.AddVertex(w, pointA, pointB))
+			break; // Out of space, or numerical imprecision prevents further progress.
+		face = polytope.ClosestFace();
+	}
+	if (!converged && bestDepth - polytope.faceDistance[face] > 1e-3f * Max(1.f, bestDepth))
+	{
+		// Report the direction that is known to separate the objects instead of the closest face, whose normal can be
+		// far from the correct one if the polytope is still coarse.
+		outNormal = bestNormal;
+		outDepth = Max(0.f, bestDepth);
+		outContactPointA = bestPointA;
+		outContactPointB = bestPointB;
+		return true;
+	}
+	outNormal = polytope.faceNormal[face];
+	outDepth = Max(0.f, polytope.faceDistance[face]);
+	polytope.FaceContactPoints(face, outContactPointA, outContactPointB);
+	return true;
+}
+
+/// Computes the distance between the two given convex objects.
+/** @see GJKDistance(const A &, const B &, vec &, vec &). */
+template<typename A, typename B>
+float GJKDistance(const A &a, const B &b)
+{
+	vec closestPointA, closestPointB;
+	return GJKDistance(a, b, closestPointA, closestPointB);
+}
+
+/// Presents the object shape, rotated about a pivot point and then translated, to the GJK functions.
+/** This is used by GJKTimeOfImpact() to evaluate the support function of a moving object at a given time, without
+	having to transform a copy of the object itself. */
+template<typename T>
+struct GJKMovedShape
+{
+	const T &shape;
+	Quat rotation;
+	Quat inverseRotation;
+	vec pivot;
+	vec translation;
+	bool rotates;
+
+	GJKMovedShape(const T &shape_, const vec &translation_)
+	:shape(shape_), rotation(Quat::identity), inverseRotation(Quat::identity), pivot(vec::zero), translation(translation_), rotates(false)
+	{
+	}
+
+	GJKMovedShape(const T &shape_, const Quat &rotation_, const vec &pivot_, const vec &translation_)
+	:shape(shape_), rotation(rotation_), inverseRotation(rotation_.Conjugated()), pivot(pivot_), translation(translation_), rotates(true)
+	{
+	}
+
+	vec Transform(const vec &point) const
+	{
+		return rotates ? rotation.Transform(point - pivot) + pivot + translation : point + translation;
+	}
+
+	vec ExtremePoint(const vec &direction) const
+	{
+		return Transform(shape.ExtremePoint(rotates ? inverseRotation.Transform(direction) : direction));
+	}
+
+	vec AnyPointFast() const { return Transform(shape.AnyPointFast()); }
+};
+
+/// Computes the time of impact of the object a, moving with the given linear and angular velocity, against the object b.
+/** Uses conservative advancement: GJKDistance() gives the distance and the separating direction between the objects at the
+	current time, and an upper bound of how fast any point of a can approach b along that direction gives a step in time
+	during which the objects cannot collide. The steps are repeated until the objects are closer than the given tolerance.
+	Unlike testing the objects at fixed time steps, this cannot tunnel past b, however fast a moves.
+	Over the time interval [0, 1], the object a rotates about the given pivot point by the angle |angularVelocity| radians
+	around the axis angularVelocity, and translates by velocity. If b is also moving linearly, pass the velocity of a relative to b.
+	This function works for any pair of objects that implement the functions ExtremePoint(direction) and AnyPointFast().
+	@param tolerance The distance at which the objects are considered to touch. The time of impact is reported at the
+		first time found where the distance between the objects drops below this, so the objects may still be separated
+		by at most this much at that time. The tolerance should be well above the floating point precision of the
+		coordinates.
+	@param outTimeOfImpact [out] Receives the time in the range [0, 1] at which the objects touch.
+	@param outNormal [out] Receives the unit direction from a towards b at the time of impact.
+	@param outContactPointA [out] Receives the point of a closest to b at the time of impact.
+	@param outContactPointB [out] Receives the point of b closest to a at the time of impact.
+	@return True if the objects touch during the time interval [0, 1], in which case the output parameters are filled.
+		If the objects already intersect at time 0, the time of impact is 0, and the normal and the contact points are
+		computed with GJKPenetration().
+	@see GJKDistance(), GJKPenetration(). */
+template<typename A, typename B>
+bool GJKTimeOfImpact(const A &a, const vec &velocity, const vec &angularVelocity, const vec &pivot, const B &b, float tolerance,
+	float &outTimeOfImpact, vec &outNormal, vec &outContactPointA, vec &outContactPointB)
+{
+	assume(tolerance > 0.f);
+	float angularSpeed = angularVelocity.Length();
+	vec rotationAxis = angularSpeed > 0.f ? angularVelocity / angularSpeed : vec::unitX;
+	// Bound the distance of the points of a from the pivot by the farthest corner of the bounding box of a.
+	float maxRadius = 0.f;
+	if (angularSpeed > 0.f)
+	{
+		float dx = Max(Abs(a.ExtremePoint(DIR_VEC(1.f, 0.f, 0.f)).x - pivot.x), Abs(a.ExtremePoint(DIR_VEC(-1.f, 0.f, 0.f)).x - pivot.x));
+		float dy = Max(Abs(a.ExtremePoint(DIR_VEC(0.f, 1.f, 0.f)).y - pivot.y), Abs(a.ExtremePoint(DIR_VEC(0.f, -1.f, 0.f)).y - pivot.y));
+		float dz = Max(Abs(a.ExtremePoint(DIR_VEC(0.f, 0.f, 1.f)).z - pivot.z), Abs(a.ExtremePoint(DIR_VEC(0.f, 0.f, -1.f)).z - pivot.z));
+		maxRadius = Sqrt(dx*dx + dy*dy + dz*dz);
+	}
+
+	// Run the queries in a coordinate frame centered at b, since far from the origin the precision of the distance is
+	// limited by the magnitude of the coordinates.
+	vec toLocal = POINT_VEC_SCALAR(0.f) - b.AnyPointFast();
+	GJKMovedShape<B> localB(b, toLocal);
+
+	float t = 0.f;
+	int nIterations = 128; // Robustness check: Limit the maximum number of iterations, grazing contacts converge slowly.
+	for(;;)
+	{
+		GJKMovedShape<A> movedA = (angularSpeed > 0.f)
+			? GJKMovedShape<A>(a, Quat::RotateAxisAngle(DIR_TO_FLOAT3(rotationAxis), angularSpeed * t), pivot, velocity * t + toLocal)
+			: GJKMovedShape<A>(a, velocity * t + toLocal);
+		vec pointA, pointB, simplex[4], supportA[4], supportB[4];
+		int n;
+		// Since the iteration stops when the distance is known up to a tenth of the tolerance, the steps below, which aim at
+		// half the tolerance, cannot pass the time of impact.
+		float dist = GJKDistanceSimplex(movedA, localB, simplex, supportA, supportB, n, pointA, pointB, 0.1f * tolerance);
+		pointA -= toLocal;
+		pointB -= toLocal;
+		if (dist <= 0.f)
+		{
+			if (t == 0.f)
+			{
+				float depth;
+				GJKPenetration(movedA, localB, outNormal, depth, outContactPointA, outContactPointB);
+				outContactPointA -= toLocal;
+				outContactPointB -= toLocal;
+			}
+			else // Rounding brought the objects into contact. Keep the normal from the previous step.
+			{
+				outContactPointA = pointA;
+				outContactPointB = pointB;
+			}
+			outTimeOfImpact = t;
+			return true;
+		}
+		vec normal = (pointB - pointA) / dist;
+		outNormal = normal;
+		if (dist <= tolerance || nIterations-- <= 0) // If the iteration limit is reached, conservatively report an impact.
+		{
+			outTimeOfImpact = t;
+			outContactPointA = pointA;
+			outContactPointB = pointB;
+			return true;
+		}
+		// The points of a move towards b along the normal at most this fast.
+		float approachSpeed = Dot(velocity, normal) + angularSpeed * maxRadius;
+		if (approachSpeed <= 0.f)
+		{
+			// If the normal is a separating axis, the objects are moving apart along it, and cannot meet.
+			if (Dot(localB.ExtremePoint(-normal) - movedA.ExtremePoint(normal), normal) > 0.f)
+				return false;
+			// Otherwise the normal is too imprecise to be a separating axis. Fall back to the bound of the speed of a in any direction.
+			approachSpeed = velocity.Length() + angularSpeed * maxRadius;
+		}
+		// Advance until the objects are half the tolerance apart, so that the iteration converges in a finite number of steps.
+		t += (dist - 0.5f * tolerance) / approachSpeed;
+		if (t > 1.f)
+			return false;
+	}
+}
+
+/// Computes the time of impact of the object a, moving linearly by velocity over the time interval [0, 1], against the object b.
+/** @see GJKTimeOfImpact(const A &, const vec &, const vec &, const vec &, const B &, float, float &, vec &, vec &, vec &). */
+template<typename A, typename B>
+bool GJKTimeOfImpact(const A &a, const vec &velocity, const B &b, float tolerance, float &outTimeOfImpact, vec &outNormal,
+	vec &outContactPointA, vec &outContactPointB)
+{
+	return GJKTimeOfImpact(a, velocity, vec::zero, vec::zero, b, tolerance, outTimeOfImpact, outNormal, outContactPointA, outContactPointB);
+}
+
 MATH_END_NAMESPACE
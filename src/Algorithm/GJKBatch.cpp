@@ -0,0 +1,171 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file GJKBatch.cpp
+	@author Jukka Jylanki
+	@brief SSE implementation of the simplex update step of the batched GJK intersection test. */
+#include "GJKBatch.h"
+
+MATH_BEGIN_NAMESPACE
+
+#ifdef MATH_SSE
+
+GJKBatchVec UpdateSimplex(GJKBatchVec *s, simd4f &n)
+{
+	// Each lane takes the first matching case in the same order as the scalar UpdateSimplex(), whose comments describe the
+	// voronoi regions that are tested. Each case is evaluated in all lanes, and the lanes that are still undecided and fall
+	// into that case take its new simplex, point count and search direction. The cases read the original points s0-s3, and
+	// write the results to s[0]-s[3].
+	const simd4f zero = _mm_setzero_ps();
+	const simd4f two = _mm_set1_ps(2.f);
+	const simd4f three = _mm_set1_ps(3.f);
+	const GJKBatchVec s0 = s[0];
+	const GJKBatchVec s1 = s[1];
+	const GJKBatchVec s2 = s[2];
+	const GJKBatchVec s3 = s[3];
+	GJKBatchVec dir(zero, zero, zero);
+
+	// n == 2: Line segment s0->s1.
+	simd4f undecided = _mm_cmpeq_ps(n, two);
+	{
+		GJKBatchVec d01 = s1 - s0;
+		GJKBatchVec newDir = d01.Cross(d01.Cross(s1));
+		dir = GJKBatchVec::Select(dir, newDir, undecided);
+		// Case 3) The origin is contained in the line segment.
+		simd4f contained = _mm_andnot_ps(_mm_cmpgt_ps(newDir.LengthSq(), _mm_set1_ps(1e-7f)), undecided);
+		n = _mm_andnot_ps(contained, n);
+	}
+
+	// n == 3: Triangle s0->s1->s2.
+	undecided = _mm_cmpeq_ps(n, three);
+	{
+		GJKBatchVec d12 = s2 - s1;
+		GJKBatchVec d02 = s2 - s0;
+		GJKBatchVec triNormal = d02.Cross(d12);
+
+		// Case 4) Edge 1->2 is closest.
+		simd4f mask = _mm_and_ps(undecided, _mm_cmplt_ps(s1.Dot(d12.Cross(triNormal)), zero));
+		dir = GJKBatchVec::Select(dir, d12.Cross(d12.Cross(s1)), mask);
+		s[0] = GJKBatchVec::Select(s[0], s1, mask);
+		s[1] = GJKBatchVec::Select(s[1], s2, mask);
+		n = GJKBatchVec::Select(n, two, mask);
+		undecided = _mm_andnot_ps(mask, undecided);
+
+		// Case 5) Edge 0->2 is closest.
+		mask = _mm_and_ps(undecided, _mm_cmplt_ps(s0.Dot(triNormal.Cross(d02)), zero));
+		dir = GJKBatchVec::Select(dir, d02.Cross(d02.Cross(s0)), mask);
+		s[1] = GJKBatchVec::Select(s[1], s2, mask);
+		n = GJKBatchVec::Select(n, two, mask);
+		undecided = _mm_andnot_ps(mask, undecided);
+
+		simd4f scaledSignedDistToTriangle = triNormal.Dot(s2);
+		simd4f distSq = _mm_mul_ps(scaledSignedDistToTriangle, scaledSignedDistToTriangle);
+		simd4f scaledEpsilonSq = _mm_mul_ps(_mm_set1_ps(1e-6f), triNormal.LengthSq());
+		simd4f farFromTriangle = _mm_cmpgt_ps(distSq, scaledEpsilonSq);
+
+		// Case 6) The origin is on the side of the triangle normal, or case 7) it is on the opposite side, and the first
+		// two points are swapped to keep the triangle winding towards the origin.
+		mask = _mm_and_ps(undecided, farFromTriangle);
+		simd4f negativeSide = _mm_and_ps(mask, _mm_cmple_ps(scaledSignedDistToTriangle, zero));
+		simd4f positiveSide = _mm_andnot_ps(negativeSide, mask);
+		dir = GJKBatchVec::Select(dir, triNormal, negativeSide);
+		dir = GJKBatchVec::Select(dir, -triNormal, positiveSide);
+		s[0] = GJKBatchVec::Select(s[0], s1, positiveSide);
+		s[1] = GJKBatchVec::Select(s[1], s0, positiveSide);
+
+		// Case 8) The origin lies directly inside the triangle.
+		n = _mm_andnot_ps(_mm_andnot_ps(farFromTriangle, undecided), n);
+	}
+
+	// n == 4: Tetrahedron s0->s1->s2->s3.
+	undecided = _mm_cmpeq_ps(n, _mm_set1_ps(4.f));
+	if (_mm_movemask_ps(undecided))
+	{
+		GJKBatchVec d01 = s1 - s0;
+		GJKBatchVec d02 = s2 - s0;
+		GJKBatchVec d03 = s3 - s0;
+		GJKBatchVec tri013Normal = d01.Cross(d03);
+		GJKBatchVec tri023Normal = d03.Cross(d02);
+		GJKBatchVec d12 = s2 - s1;
+		GJKBatchVec d13 = s3 - s1;
+		GJKBatchVec tri123Normal = d12.Cross(d13);
+		GJKBatchVec d23 = s3 - s2;
+
+		simd4f inE03_1 = tri013Normal.Cross(d03).Dot(s3);
+		simd4f inE03_2 = d03.Cross(tri023Normal).Dot(s3);
+		simd4f inE13_0 = d13.Cross(tri013Normal).Dot(s3);
+		simd4f inE13_2 = tri123Normal.Cross(d13).Dot(s3);
+		simd4f inE23_0 = tri023Normal.Cross(d23).Dot(s3);
+		simd4f inE23_1 = d23.Cross(tri123Normal).Dot(s3);
+
+		// Case 6) Edge 0->3 is closest.
+		simd4f mask = _mm_and_ps(undecided, _mm_and_ps(_mm_cmple_ps(inE03_1, zero), _mm_cmple_ps(inE03_2, zero)));
+		dir = GJKBatchVec::Select(dir, d03.Cross(d03.Cross(s3)), mask);
+		s[1] = GJKBatchVec::Select(s[1], s3, mask);
+		n = GJKBatchVec::Select(n, two, mask);
+		undecided = _mm_andnot_ps(mask, undecided);
+
+		// Case 8) Edge 1->3 is closest.
+		mask = _mm_and_ps(undecided, _mm_and_ps(_mm_cmple_ps(inE13_0, zero), _mm_cmple_ps(inE13_2, zero)));
+		dir = GJKBatchVec::Select(dir, d13.Cross(d13.Cross(s3)), mask);
+		s[0] = GJKBatchVec::Select(s[0], s1, mask);
+		s[1] = GJKBatchVec::Select(s[1], s3, mask);
+		n = GJKBatchVec::Select(n, two, mask);
+		undecided = _mm_andnot_ps(mask, undecided);
+
+		// Case 9) Edge 2->3 is closest.
+		mask = _mm_and_ps(undecided, _mm_and_ps(_mm_cmple_ps(inE23_0, zero), _mm_cmple_ps(inE23_1, zero)));
+		dir = GJKBatchVec::Select(dir, d23.Cross(d23.Cross(s3)), mask);
+		s[0] = GJKBatchVec::Select(s[0], s2, mask);
+		s[1] = GJKBatchVec::Select(s[1], s3, mask);
+		n = GJKBatchVec::Select(n, two, mask);
+		undecided = _mm_andnot_ps(mask, undecided);
+
+		// Case 11) Triangle 0->1->3 is closest.
+		mask = _mm_and_ps(undecided, _mm_and_ps(_mm_cmplt_ps(s3.Dot(tri013Normal), zero),
+			_mm_and_ps(_mm_cmpge_ps(inE13_0, zero), _mm_cmpge_ps(inE03_1, zero))));
+		dir = GJKBatchVec::Select(dir, tri013Normal, mask);
+		s[2] = GJKBatchVec::Select(s[2], s3, mask);
+		n = GJKBatchVec::Select(n, three, mask);
+		undecided = _mm_andnot_ps(mask, undecided);
+
+		// Case 12) Triangle 0->2->3 is closest.
+		mask = _mm_and_ps(undecided, _mm_and_ps(_mm_cmplt_ps(s3.Dot(tri023Normal), zero),
+			_mm_and_ps(_mm_cmpge_ps(inE23_0, zero), _mm_cmpge_ps(inE03_2, zero))));
+		dir = GJKBatchVec::Select(dir, tri023Normal, mask);
+		s[0] = GJKBatchVec::Select(s[0], s2, mask);
+		s[1] = GJKBatchVec::Select(s[1], s0, mask);
+		s[2] = GJKBatchVec::Select(s[2], s3, mask);
+		n = GJKBatchVec::Select(n, three, mask);
+		undecided = _mm_andnot_ps(mask, undecided);
+
+		// Case 13) Triangle 1->2->3 is closest.
+		mask = _mm_and_ps(undecided, _mm_and_ps(_mm_cmplt_ps(s3.Dot(tri123Normal), zero),
+			_mm_and_ps(_mm_cmpge_ps(inE13_2, zero), _mm_cmpge_ps(inE23_1, zero))));
+		dir = GJKBatchVec::Select(dir, tri123Normal, mask);
+		s[0] = GJKBatchVec::Select(s[0], s1, mask);
+		s[1] = GJKBatchVec::Select(s[1], s2, mask);
+		s[2] = GJKBatchVec::Select(s[2], s3, mask);
+		n = GJKBatchVec::Select(n, three, mask);
+		undecided = _mm_andnot_ps(mask, undecided);
+
+		// Case 14) The origin is contained in the tetrahedron.
+		n = _mm_andnot_ps(undecided, n);
+	}
+	return dir;
+}
+
+#endif
+
+MATH_END_NAMESPACE
@@ -0,0 +1,356 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file GJKBatch.h
+	@author Jukka Jylanki
+	@brief A batched Gilbert-Johnson-Keerthi (GJK) intersection test that processes four object pairs at a time with SSE. */
+#pragma once
+
+#include "../MathGeoLibFwd.h"
+#include "../Math/float3.h"
+#include "GJK.h"
+
+#ifdef MATH_SSE
+#include "../Geometry/AABB.h"
+#include "../Geometry/Capsule.h"
+#include "../Geometry/LineSegment.h"
+#include "../Geometry/OBB.h"
+#include "../Geometry/Sphere.h"
+#include "../Geometry/Triangle.h"
+#endif
+
+MATH_BEGIN_NAMESPACE
+
+#ifdef MATH_SSE
+
+/// Four 3D vectors in structure-of-arrays layout, one in each SSE lane.
+struct GJKBatchVec
+{
+	simd4f x, y, z;
+
+	GJKBatchVec() {}
+	GJKBatchVec(simd4f x_, simd4f y_, simd4f z_):x(x_), y(y_), z(z_) {}
+
+	/// Loads lane i from the vector pts[i < count ? i : count-1].
+	static GJKBatchVec Load(const vec *pts, int count)
+	{
+		float px[4], py[4], pz[4];
+		for(int i = 0; i < 4; ++i)
+		{
+			const vec &p = pts[i < count ? i : count-1];
+			px[i] = p.x;
+			py[i] = p.y;
+			pz[i] = p.z;
+		}
+		return GJKBatchVec(_mm_loadu_ps(px), _mm_loadu_ps(py), _mm_loadu_ps(pz));
+	}
+
+	/// Returns b in the lanes where mask is set, and a in the others.
+	static simd4f Select(simd4f a, simd4f b, simd4f mask)
+	{
+#ifdef MATH_SSE41
+		return _mm_blendv_ps(a, b, mask);
+#else
+		return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a));
+#endif
+	}
+
+	static GJKBatchVec Select(const GJKBatchVec &a, const GJKBatchVec &b, simd4f mask)
+	{
+		return GJKBatchVec(Select(a.x, b.x, mask), Select(a.y, b.y, mask), Select(a.z, b.z, mask));
+	}
+
+	simd4f Dot(const GJKBatchVec &v) const { return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, v.x), _mm_mul_ps(y, v.y)), _mm_mul_ps(z, v.z)); }
+	simd4f LengthSq() const { return Dot(*this); }
+
+	GJKBatchVec Cross(const GJKBatchVec &v) const
+	{
+		return GJKBatchVec(_mm_sub_ps(_mm_mul_ps(y, v.z), _mm_mul_ps(z, v.y)),
+		                   _mm_sub_ps(_mm_mul_ps(z, v.x), _mm_mul_ps(x, v.z)),
+		                   _mm_sub_ps(_mm_mul_ps(x, v.y), _mm_mul_ps(y, v.x)));
+	}
+
+	GJKBatchVec operator +(const GJKBatchVec &v) const { return GJKBatchVec(_mm_add_ps(x, v.x), _mm_add_ps(y, v.y), _mm_add_ps(z, v.z)); }
+	GJKBatchVec operator -(const GJKBatchVec &v) const { return GJKBatchVec(_mm_sub_ps(x, v.x), _mm_sub_ps(y, v.y), _mm_sub_ps(z, v.z)); }
+	GJKBatchVec operator *(simd4f s) const { return GJKBatchVec(_mm_mul_ps(x, s), _mm_mul_ps(y, s), _mm_mul_ps(z, s)); }
+	GJKBatchVec operator -() const
+	{
+		const simd4f signMask = _mm_set1_ps(-0.f);
+		return GJKBatchVec(_mm_xor_ps(x, signMask), _mm_xor_ps(y, signMask), _mm_xor_ps(z, signMask));
+	}
+};
+
+/// The four-wide version of UpdateSimplex(vec *s, int &n).
+/** Performs the same voronoi region tests and simplex reduction as UpdateSimplex(), independently in each lane.
+	@param s [in, out] The points of the simplices.
+	@param n [in, out] The number of points in the simplex of each lane, 2-4, as floats. In the lanes where the origin is contained
+	                   in the simplex, this is set to zero.
+	@return The new search directions. */
+GJKBatchVec UpdateSimplex(GJKBatchVec *s, simd4f &n);
+
+/// Stores four objects of type T in structure-of-arrays layout, and computes their support functions four at a time.
+/** This template is specialized for the object types with a closed-form support function: AABB, OBB, Sphere, Capsule,
+	LineSegment and Triangle. Each specialization loads lane i from the object objects[i < count ? i : count-1], and
+	returns from ExtremePoint() the same point as the ExtremePoint() function of the object type. */
+template<typename T>
+struct GJKBatchShape;
+
+template<>
+struct GJKBatchShape<AABB>
+{
+	GJKBatchVec minPoint, maxPoint;
+
+	void Load(const AABB *objects, int count)
+	{
+		vec pts[4];
+		for(int i = 0; i < 4; ++i) pts[i] = objects[i < count ? i : count-1].minPoint;
+		minPoint = GJKBatchVec::Load(pts, 4);
+		for(int i = 0; i < 4; ++i) pts[i] = objects[i < count ? i : count-1].maxPoint;
+		maxPoint = GJKBatchVec::Load(pts, 4);
+	}
+
+	GJKBatchVec ExtremePoint(const GJKBatchVec &direction) const
+	{
+		const simd4f zero = _mm_setzero_ps();
+		return GJKBatchVec(GJKBatchVec::Select(minPoint.x, maxPoint.x, _mm_cmpge_ps(direction.x, zero)),
+		                   GJKBatchVec::Select(minPoint.y, maxPoint.y, _mm_cmpge_ps(direction.y, zero)),
+		                   GJKBatchVec::Select(minPoint.z, maxPoint.z, _mm_cmpge_ps(direction.z, zero)));
+	}
+};
+
+template<>
+struct GJKBatchShape<OBB>
+{
+	GJKBatchVec pos, axis[3];
+	simd4f r[3];
+
+	void Load(const OBB *objects, int count)
+	{
+		vec pts[4];
+		for(int i = 0; i < 4; ++i) pts[i] = objects[i < count ? i : count-1].pos;
+		pos = GJKBatchVec::Load(pts, 4);
+		for(int j = 0; j < 3; ++j)
+		{
+			float radius[4];
+			for(int i = 0; i < 4; ++i)
+			{
+				const OBB &obb = objects[i < count ? i : count-1];
+				pts[i] = obb.axis[j];
+				radius[i] = obb.r[j];
+			}
+			axis[j] = GJKBatchVec::Load(pts, 4);
+			r[j] = _mm_loadu_ps(radius);
+		}
+	}
+
+	GJKBatchVec ExtremePoint(const GJKBatchVec &direction) const
+	{
+		const simd4f zero = _mm_setzero_ps();
+		const simd4f signMask = _mm_set1_ps(-0.f);
+		GJKBatchVec pt = pos;
+		for(int j = 0; j < 3; ++j)
+		{
+			// Flip the sign of the half-extent in the lanes where the direction points to the negative side of the axis.
+			simd4f negative = _mm_cmplt_ps(direction.Dot(axis[j]), zero);
+			pt = pt + axis[j] * _mm_xor_ps(r[j], _mm_and_ps(negative, signMask));
+		}
+		return pt;
+	}
+};
+
+template<>
+struct GJKBatchShape<Sphere>
+{
+	GJKBatchVec pos;
+	simd4f r;
+
+	void Load(const Sphere *objects, int count)
+	{
+		vec pts[4];
+		float radius[4];
+		for(int i = 0; i < 4; ++i)
+		{
+			pts[i] = objects[i < count ? i : count-1].pos;
+			radius[i] = objects[i < count ? i : count-1].r;
+		}
+		pos = GJKBatchVec::Load(pts, 4);
+		r = _mm_loadu_ps(radius);
+	}
+
+	GJKBatchVec ExtremePoint(const GJKBatchVec &direction) const
+	{
+		return pos + direction * _mm_div_ps(r, _mm_sqrt_ps(direction.LengthSq()));
+	}
+};
+
+template<>
+struct GJKBatchShape<LineSegment>
+{
+	GJKBatchVec a, b, ab;
+
+	void Load(const LineSegment *objects, int count)
+	{
+		vec pts[4];
+		for(int i = 0; i < 4; ++i) pts[i] = objects[i < count ? i : count-1].a;
+		a = GJKBatchVec::Load(pts, 4);
+		for(int i = 0; i < 4; ++i) pts[i] = objects[i < count ? i : count-1].b;
+		b = GJKBatchVec::Load(pts, 4);
+		ab = b - a;
+	}
+
+	GJKBatchVec ExtremePoint(const GJKBatchVec &direction) const
+	{
+		return GJKBatchVec::Select(a, b, _mm_cmpge_ps(direction.Dot(ab), _mm_setzero_ps()));
+	}
+};
+
+template<>
+struct GJKBatchShape<Capsule>
+{
+	GJKBatchShape<LineSegment> l;
+	simd4f r;
+
+	void Load(const Capsule *objects, int count)
+	{
+		LineSegment segments[4];
+		float radius[4];
+		for(int i = 0; i < 4; ++i)
+		{
+			segments[i] = objects[i < count ? i : count-1].l;
+			radius[i] = objects[i < count ? i : count-1].r;
+		}
+		l.Load(segments, 4);
+		r = _mm_loadu_ps(radius);
+	}
+
+	GJKBatchVec ExtremePoint(const GJKBatchVec &direction) const
+	{
+		return l.ExtremePoint(direction) + direction * _mm_div_ps(r, _mm_sqrt_ps(direction.LengthSq()));
+	}
+};
+
+template<>
+struct GJKBatchShape<Triangle>
+{
+	GJKBatchVec a, b, c;
+
+	void Load(const Triangle *objects, int count)
+	{
+		vec pts[4];
+		for(int i = 0; i < 4; ++i) pts[i] = objects[i < count ? i : count-1].a;
+		a = GJKBatchVec::Load(pts, 4);
+		for(int i = 0; i < 4; ++i) pts[i] = objects[i < count ? i : count-1].b;
+		b = GJKBatchVec::Load(pts, 4);
+		for(int i = 0; i < 4; ++i) pts[i] = objects[i < count ? i : count-1].c;
+		c = GJKBatchVec::Load(pts, 4);
+	}
+
+	GJKBatchVec ExtremePoint(const GJKBatchVec &direction) const
+	{
+		// Like Triangle::ExtremePoint(), prefers the earlier vertex on ties.
+		simd4f maxD = direction.Dot(a);
+		simd4f dB = direction.Dot(b);
+		simd4f dC = direction.Dot(c);
+		simd4f takeB = _mm_cmpgt_ps(dB, maxD);
+		GJKBatchVec pt = GJKBatchVec::Select(a, b, takeB);
+		maxD = GJKBatchVec::Select(maxD, dB, takeB);
+		return GJKBatchVec::Select(pt, c, _mm_cmpgt_ps(dC, maxD));
+	}
+};
+
+/// Runs GJKIntersect() on the pairs (a[i], b[i]), 0 <= i < count <= 4, one pair in each SSE lane.
+/** The lanes run the GJK iteration in lockstep. Each lane is masked out as soon as its pair is found to be separated or
+	intersecting, and the loop exits when all lanes have converged.
+	@return A bit mask where bit i is set if the pair i intersects. */
+template<typename A, typename B>
+int GJKIntersectBatch4(const A *a, const B *b, int count)
+{
+	assume(count >= 1 && count <= 4);
+	GJKBatchShape<A> shapeA;
+	GJKBatchShape<B> shapeB;
+	shapeA.Load(a, count);
+	shapeB.Load(b, count);
+
+	const simd4f zero = _mm_setzero_ps();
+	const simd4f one = _mm_set1_ps(1.f);
+
+	GJKBatchVec support[4];
+	vec anyPoint[4];
+	for(int i = 0; i < 4; ++i)
+		anyPoint[i] = a[i < count ? i : count-1].AnyPointFast() - b[i < count ? i : count-1].AnyPointFast();
+	support[0] = GJKBatchVec::Load(anyPoint, 4);
+	support[1] = support[2] = support[3] = support[0];
+	GJKBatchVec d = -support[0];
+	// The lanes whose first arbitrary point already is the zero vector are done.
+	simd4f intersects = _mm_cmplt_ps(d.LengthSq(), _mm_set1_ps(1e-7f));
+	const simd4f laneIndex = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
+	simd4f active = _mm_andnot_ps(intersects, _mm_cmplt_ps(laneIndex, _mm_set1_ps((float)count)));
+	simd4f n = one;
+	int nIterations = 50;
+	while(_mm_movemask_ps(active) && nIterations-- > 0)
+	{
+		GJKBatchVec newSupport = shapeA.ExtremePoint(d) - shapeB.ExtremePoint(-d);
+		// Mask out the lanes where the most extreme point in the search direction did not walk past the origin: no intersection.
+		active = _mm_andnot_ps(_mm_cmplt_ps(newSupport.Dot(d), zero), active);
+		// Add the new point to the simplex of each active lane.
+		support[1] = GJKBatchVec::Select(support[1], newSupport, _mm_and_ps(active, _mm_cmpeq_ps(n, one)));
+		support[2] = GJKBatchVec::Select(support[2], newSupport, _mm_and_ps(active, _mm_cmpeq_ps(n, _mm_set1_ps(2.f))));
+		support[3] = GJKBatchVec::Select(support[3], newSupport, _mm_and_ps(active, _mm_cmpeq_ps(n, _mm_set1_ps(3.f))));
+		n = _mm_add_ps(n, _mm_and_ps(active, one));
+		d = UpdateSimplex(support, n);
+		// Mask out the lanes where the origin was contained in the simplex: intersection.
+		simd4f found = _mm_and_ps(active, _mm_cmpeq_ps(n, zero));
+		intersects = _mm_or_ps(intersects, found);
+		active = _mm_andnot_ps(found, active);
+	}
+	assume(_mm_movemask_ps(active) == 0 && "GJK intersection test did not converge to a result!");
+	return _mm_movemask_ps(intersects);
+}
+
+#endif
+
+/// Tests the pairs of objects (a[i], b[i]), 0 <= i < numPairs, for intersection using the GJK algorithm.
+/** Returns the same results as calling GJKIntersect(a[i], b[i]) for each pair, up to floating point rounding for objects that
+	are just touching. With SSE enabled, the pairs are processed four at a time in structure-of-arrays form, and the object
+	types must be ones with a closed-form support function: AABB, OBB, Sphere, Capsule, LineSegment or Triangle. Without
+	SSE, this function runs GJKIntersect() on each pair in turn.
+	@param outIntersects [out] An array of numPairs elements that receives the result of the test for each pair.
+	@return The number of intersecting pairs.
+	@see GJKIntersect(). */
+template<typename A, typename B>
+int GJKIntersectBatch(const A *a, const B *b, int numPairs, bool *outIntersects)
+{
+	int numIntersecting = 0;
+#ifdef MATH_SSE
+	for(int i = 0; i < numPairs; i += 4)
+	{
+		int count = (numPairs - i < 4) ? numPairs - i : 4;
+		int mask = GJKIntersectBatch4(a + i, b + i, count);
+		for(int j = 0; j < count; ++j)
+		{
+			outIntersects[i+j] = (mask & (1 << j)) != 0;
+			numIntersecting += outIntersects[i+j] ? 1 : 0;
+		}
+	}
+#else
+	for(int i = 0; i < numPairs; ++i)
+	{
+		outIntersects[i] = GJKIntersect(a[i], b[i]);
+		numIntersecting += outIntersects[i] ? 1 : 0;
+	}
+#endif
+	return numIntersecting;
+}
+
+MATH_END_NAMESPACE
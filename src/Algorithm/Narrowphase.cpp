@@ -0,0 +1,309 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file Narrowphase.cpp
+	@author Jukka Jylanki
+	@brief Function tables for dispatching the narrowphase queries by the types of the objects. */
+#include "Narrowphase.h"
+#include "GJK.h"
+#include "../Geometry/AABB.h"
+#include "../Geometry/Capsule.h"
+#include "../Geometry/Frustum.h"
+#include "../Geometry/LineSegment.h"
+#include "../Geometry/OBB.h"
+#include "../Geometry/Polygon.h"
+#include "../Geometry/Polyhedron.h"
+#include "../Geometry/Sphere.h"
+#include "../Geometry/Triangle.h"
+#include "../Math/MathFunc.h"
+#include <string.h>
+
+MATH_BEGIN_NAMESPACE
+
+// The queries between two concrete types. The generic versions call the Intersects() member function of a, and fall back to
+// GJK for the distance and the closest point. The specializations below override these for the pairs that have a
+// dedicated member function.
+template<typename A, typename B>
+bool PairIntersects(const A &a, const B &b)
+{
+	return a.Intersects(b);
+}
+
+template<typename A, typename B>
+float PairDistance(const A &a, const B &b)
+{
+	return GJKDistance(a, b);
+}
+
+template<typename A, typename B>
+vec PairClosestPoint(const A &a, const B &b)
+{
+	vec closestPointA, closestPointB;
+	GJKDistance(a, b, closestPointA, closestPointB);
+	return closestPointA;
+}
+
+// Sphere has no Intersects(LineSegment), and the triangle test of LineSegment takes its output parameters without defaults.
+template<>
+bool PairIntersects(const Sphere &a, const LineSegment &b)
+{
+	return b.Intersects(a);
+}
+
+template<>
+bool PairIntersects(const LineSegment &a, const Triangle &b)
+{
+	return a.Intersects(b, 0, 0);
+}
+
+// Polyhedron::Intersects(Frustum) tests containment with the approximate centroid and the frustum edges, which reports false
+// positives for separated objects, so go through the polyhedron of the frustum instead.
+template<>
+bool PairIntersects(const Polyhedron &a, const Frustum &b)
+{
+	return b.Intersects(a);
+}
+
+#define MEMBER_DISTANCE(A, B) template<> float PairDistance(const A &a, const B &b) { return a.Distance(b); }
+#define REVERSE_DISTANCE(A, B) template<> float PairDistance(const A &a, const B &b) { return b.Distance(a); }
+
+MEMBER_DISTANCE(AABB, Sphere)
+MEMBER_DISTANCE(Capsule, Capsule)
+MEMBER_DISTANCE(Capsule, LineSegment)
+MEMBER_DISTANCE(Capsule, Sphere)
+REVERSE_DISTANCE(Capsule, Triangle)
+MEMBER_DISTANCE(LineSegment, Capsule)
+MEMBER_DISTANCE(LineSegment, LineSegment)
+MEMBER_DISTANCE(LineSegment, Sphere)
+MEMBER_DISTANCE(OBB, Sphere)
+MEMBER_DISTANCE(Sphere, AABB)
+MEMBER_DISTANCE(Sphere, Capsule)
+MEMBER_DISTANCE(Sphere, LineSegment)
+MEMBER_DISTANCE(Sphere, OBB)
+MEMBER_DISTANCE(Sphere, Sphere)
+MEMBER_DISTANCE(Sphere, Triangle)
+MEMBER_DISTANCE(Triangle, Capsule)
+MEMBER_DISTANCE(Triangle, Sphere)
+
+#undef MEMBER_DISTANCE
+#undef REVERSE_DISTANCE
+
+template<>
+vec PairClosestPoint(const LineSegment &a, const LineSegment &b)
+{
+	return a.ClosestPoint(b);
+}
+
+template<>
+vec PairClosestPoint(const LineSegment &a, const Triangle &b)
+{
+	vec closestPointA;
+	b.ClosestPoint(a, &closestPointA);
+	return closestPointA;
+}
+
+template<>
+vec PairClosestPoint(const Triangle &a, const LineSegment &b)
+{
+	return a.ClosestPoint(b);
+}
+
+template<>
+vec PairClosestPoint(const Triangle &a, const Triangle &b)
+{
+	return a.ClosestPoint(b);
+}
+
+// Adapters from the type-erased objects to the typed queries, for a single pair and for a bucket of pairs of the same types.
+template<typename A, typename B>
+bool IntersectsThunk(const void *a, const void *b)
+{
+	return PairIntersects(*reinterpret_cast<const A*>(a), *reinterpret_cast<const B*>(b));
+}
+
+template<typename A, typename B>
+float DistanceThunk(const void *a, const void *b)
+{
+	return PairDistance(*reinterpret_cast<const A*>(a), *reinterpret_cast<const B*>(b));
+}
+
+template<typename A, typename B>
+vec ClosestPointThunk(const void *a, const void *b)
+{
+	return PairClosestPoint(*reinterpret_cast<const A*>(a), *reinterpret_cast<const B*>(b));
+}
+
+template<typename A, typename B>
+void IntersectsBatchThunk(const NarrowphaseBatch::SortedPair *pairs, int numPairs, bool *outResults)
+{
+	for(int i = 0; i < numPairs; ++i)
+		outResults[pairs[i].index] = PairIntersects(*reinterpret_cast<const A*>(pairs[i].a), *reinterpret_cast<const B*>(pairs[i].b));
+}
+
+template<typename A, typename B>
+void DistanceBatchThunk(const NarrowphaseBatch::SortedPair *pairs, int numPairs, float *outResults)
+{
+	for(int i = 0; i < numPairs; ++i)
+		outResults[pairs[i].index] = PairDistance(*reinterpret_cast<const A*>(pairs[i].a), *reinterpret_cast<const B*>(pairs[i].b));
+}
+
+template<typename A, typename B>
+void ClosestPointBatchThunk(const NarrowphaseBatch::SortedPair *pairs, int numPairs, vec *outResults)
+{
+	for(int i = 0; i < numPairs; ++i)
+		outResults[pairs[i].index] = PairClosestPoint(*reinterpret_cast<const A*>(pairs[i].a), *reinterpret_cast<const B*>(pairs[i].b));
+}
+
+typedef bool (*IntersectsFunc)(const void *a, const void *b);
+typedef float (*DistanceFunc)(const void *a, const void *b);
+typedef vec (*ClosestPointFunc)(const void *a, const void *b);
+typedef void (*IntersectsBatchFunc)(const NarrowphaseBatch::SortedPair *pairs, int numPairs, bool *outResults);
+typedef void (*DistanceBatchFunc)(const NarrowphaseBatch::SortedPair *pairs, int numPairs, float *outResults);
+typedef void (*ClosestPointBatchFunc)(const NarrowphaseBatch::SortedPair *pairs, int numPairs, vec *outResults);
+
+// The function tables are indexed by [a.type][b.type], and list the columns and rows in the order of the GeomType enumerators.
+// The entries of the unsupported types GTPoint, GTCircle, GTLine, GTPlane and GTRay are null.
+#define NARROWPHASE_NULL_ROW { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 }
+#define NARROWPHASE_ROW(A, func) { 0, func<A, AABB>, func<A, Capsule>, 0, func<A, Frustum>, 0, func<A, LineSegment>, \
+	func<A, OBB>, 0, func<A, Polygon>, func<A, Polyhedron>, 0, func<A, Sphere>, func<A, Triangle> }
+#define NARROWPHASE_TABLE(func) { NARROWPHASE_NULL_ROW, NARROWPHASE_ROW(AABB, func), NARROWPHASE_ROW(Capsule, func), \
+	NARROWPHASE_NULL_ROW, NARROWPHASE_ROW(Frustum, func), NARROWPHASE_NULL_ROW, NARROWPHASE_ROW(LineSegment, func), \
+	NARROWPHASE_ROW(OBB, func), NARROWPHASE_NULL_ROW, NARROWPHASE_ROW(Polygon, func), NARROWPHASE_ROW(Polyhedron, func), \
+	NARROWPHASE_NULL_ROW, NARROWPHASE_ROW(Sphere, func), NARROWPHASE_ROW(Triangle, func) }
+
+static const IntersectsFunc intersectsTable[numGeomTypes][numGeomTypes] = NARROWPHASE_TABLE(IntersectsThunk);
+static const DistanceFunc distanceTable[numGeomTypes][numGeomTypes] = NARROWPHASE_TABLE(DistanceThunk);
+static const ClosestPointFunc closestPointTable[numGeomTypes][numGeomTypes] = NARROWPHASE_TABLE(ClosestPointThunk);
+static const IntersectsBatchFunc intersectsBatchTable[numGeomTypes][numGeomTypes] = NARROWPHASE_TABLE(IntersectsBatchThunk);
+static const DistanceBatchFunc distanceBatchTable[numGeomTypes][numGeomTypes] = NARROWPHASE_TABLE(DistanceBatchThunk);
+static const ClosestPointBatchFunc closestPointBatchTable[numGeomTypes][numGeomTypes] = NARROWPHASE_TABLE(ClosestPointBatchThunk);
+
+#undef NARROWPHASE_NULL_ROW
+#undef NARROWPHASE_ROW
+#undef NARROWPHASE_TABLE
+
+bool GeomRef::IsSupported() const
+{
+	return intersectsTable[type][type] != 0;
+}
+
+bool GeomIntersects(const GeomRef &a, const GeomRef &b)
+{
+	IntersectsFunc func = intersectsTable[a.type][b.type];
+	assume(func != 0);
+	return func ? func(a.object, b.object) : false;
+}
+
+float GeomDistance(const GeomRef &a, const GeomRef &b)
+{
+	DistanceFunc func = distanceTable[a.type][b.type];
+	assume(func != 0);
+	return func ? func(a.object, b.object) : FLOAT_NAN;
+}
+
+vec GeomClosestPoint(const GeomRef &a, const GeomRef &b)
+{
+	ClosestPointFunc func = closestPointTable[a.type][b.type];
+	assume(func != 0);
+	return func ? func(a.object, b.object) : vec::nan;
+}
+
+void NarrowphaseBatch::SortByType(const GeomPair *pairs, int numPairs)
+{
+	// Counting sort: count the pairs of each type pair, turn the counts into the start offsets of the buckets, and place the
+	// pairs into their buckets. The order of the pairs within a bucket is preserved.
+	const int numBuckets = numGeomTypes * numGeomTypes;
+	memset(bucketStart, 0, sizeof(bucketStart));
+	for(int i = 0; i < numPairs; ++i)
+		++bucketStart[pairs[i].a.type * numGeomTypes + pairs[i].b.type + 1];
+	for(int i = 0; i < numBuckets; ++i)
+		bucketStart[i + 1] += bucketStart[i];
+
+	// The object pointers are copied along with the index, so that each bucket is then read sequentially.
+	sortedPairs.resize(numPairs);
+	int bucketEnd[numBuckets];
+	memcpy(bucketEnd, bucketStart, sizeof(bucketEnd));
+	for(int i = 0; i < numPairs; ++i)
+	{
+		SortedPair &p = sortedPairs[bucketEnd[pairs[i].a.type * numGeomTypes + pairs[i].b.type]++];
+		p.a = pairs[i].a.object;
+		p.b = pairs[i].b.object;
+		p.index = i;
+	}
+}
+
+void NarrowphaseBatch::Intersects(const GeomPair *pairs, int numPairs, bool *outResults)
+{
+	SortByType(pairs, numPairs);
+	for(int typeA = 0; typeA < numGeomTypes; ++typeA)
+		for(int typeB = 0; typeB < numGeomTypes; ++typeB)
+		{
+			const int bucket = typeA * numGeomTypes + typeB;
+			const int numBucketPairs = bucketStart[bucket + 1] - bucketStart[bucket];
+			if (numBucketPairs == 0)
+				continue;
+			const SortedPair *bucketPairs = &sortedPairs[bucketStart[bucket]];
+			IntersectsBatchFunc func = intersectsBatchTable[typeA][typeB];
+			assume(func != 0);
+			if (func)
+				func(bucketPairs, numBucketPairs, outResults);
+			else
+				for(int i = 0; i < numBucketPairs; ++i)
+					outResults[bucketPairs[i].index] = false;
+		}
+}
+
+void NarrowphaseBatch::Distance(const GeomPair *pairs, int numPairs, float *outResults)
+{
+	SortByType(pairs, numPairs);
+	for(int typeA = 0; typeA < numGeomTypes; ++typeA)
+		for(int typeB = 0; typeB < numGeomTypes; ++typeB)
+		{
+			const int bucket = typeA * numGeomTypes + typeB;
+			const int numBucketPairs = bucketStart[bucket + 1] - bucketStart[bucket];
+			if (numBucketPairs == 0)
+				continue;
+			const SortedPair *bucketPairs = &sortedPairs[bucketStart[bucket]];
+			DistanceBatchFunc func = distanceBatchTable[typeA][typeB];
+			assume(func != 0);
+			if (func)
+				func(bucketPairs, numBucketPairs, outResults);
+			else
+				for(int i = 0; i < numBucketPairs; ++i)
+					outResults[bucketPairs[i].index] = FLOAT_NAN;
+		}
+}
+
+void NarrowphaseBatch::ClosestPoint(const GeomPair *pairs, int numPairs, vec *outResults)
+{
+	SortByType(pairs, numPairs);
+	for(int typeA = 0; typeA < numGeomTypes; ++typeA)
+		for(int typeB = 0; typeB < numGeomTypes; ++typeB)
+		{
+			const int bucket = typeA * numGeomTypes + typeB;
+			const int numBucketPairs = bucketStart[bucket + 1] - bucketStart[bucket];
+			if (numBucketPairs == 0)
+				continue;
+			const SortedPair *bucketPairs = &sortedPairs[bucketStart[bucket]];
+			ClosestPointBatchFunc func = closestPointBatchTable[typeA][typeB];
+			assume(func != 0);
+			if (func)
+				func(bucketPairs, numBucketPairs, outResults);
+			else
+				for(int i = 0; i < numBucketPairs; ++i)
+					outResults[bucketPairs[i].index] = vec::nan;
+		}
+}
+
+MATH_END_NAMESPACE
@@ -0,0 +1,119 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file Narrowphase.h
+	@author Jukka Jylanki
+	@brief Runtime dispatch of the Intersects, Distance and ClosestPoint queries between objects of any two geometry types. */
+#pragma once
+
+#include "../MathGeoLibFwd.h"
+#include "../Math/float3.h"
+#include "../Geometry/GeomType.h"
+
+#include <vector>
+
+MATH_BEGIN_NAMESPACE
+
+/// The number of enumerators in GeomType.
+static const int numGeomTypes = GTTriangle + 1;
+
+/// A type-erased reference to a geometry object.
+/** The narrowphase queries support the bounded object types AABB, Capsule, Frustum, LineSegment, OBB, Polygon, Polyhedron,
+	Sphere and Triangle. The Distance and ClosestPoint queries treat polygons and polyhedra as convex. GeomRef does not
+	own the object it refers to, so the object must outlive it. */
+struct GeomRef
+{
+	/// The type of the object.
+	GeomType type;
+	/// Points to an object of the class identified by type.
+	const void *object;
+
+	GeomRef(const AABB &aabb):type(GTAABB), object(&aabb) {}
+	GeomRef(const Capsule &capsule):type(GTCapsule), object(&capsule) {}
+	GeomRef(const Frustum &frustum):type(GTFrustum), object(&frustum) {}
+	GeomRef(const LineSegment &lineSegment):type(GTLineSegment), object(&lineSegment) {}
+	GeomRef(const OBB &obb):type(GTOBB), object(&obb) {}
+	GeomRef(const Polygon &polygon):type(GTPolygon), object(&polygon) {}
+	GeomRef(const Polyhedron &polyhedron):type(GTPolyhedron), object(&polyhedron) {}
+	GeomRef(const Sphere &sphere):type(GTSphere), object(&sphere) {}
+	GeomRef(const Triangle &triangle):type(GTTriangle), object(&triangle) {}
+
+	/// Returns true if the narrowphase queries support objects of this type.
+	bool IsSupported() const;
+};
+
+/// A pair of objects to test against each other in a batched narrowphase query.
+struct GeomPair
+{
+	GeomRef a;
+	GeomRef b;
+
+	GeomPair(const GeomRef &a_, const GeomRef &b_):a(a_), b(b_) {}
+};
+
+/// Tests whether the two given objects intersect.
+/** The test is dispatched through a function table indexed by the types of the objects to the corresponding Intersects()
+	member function of either object.
+	@return True if the objects intersect, false otherwise. If either object is of an unsupported type, returns false. */
+bool GeomIntersects(const GeomRef &a, const GeomRef &b);
+
+/// Computes the distance between the two given objects.
+/** Pairs for which a Distance() member function exists use it, and the remaining pairs use GJKDistance().
+	@return The distance between the objects, or 0 if they intersect. If either object is of an unsupported type, returns NaN. */
+float GeomDistance(const GeomRef &a, const GeomRef &b);
+
+/// Computes the point of the object a that is closest to the object b.
+/** Pairs for which a ClosestPoint() member function exists use it, and the remaining pairs use GJKDistance().
+	@return The closest point on a. If the objects intersect, this is a point common to both objects. If either object is
+		of an unsupported type, returns vec::nan. */
+vec GeomClosestPoint(const GeomRef &a, const GeomRef &b);
+
+/// Executes the narrowphase queries of a list of object pairs, grouped by the types of the objects.
+/** Dispatching each pair separately goes through an unpredictable indirect call, and the code of the query has to be
+	reloaded every time the types change. NarrowphaseBatch instead sorts the pairs into buckets by their type pair, and runs
+	each bucket in a loop that calls the query directly, so that it can be inlined. The results are written in the original
+	order of the pairs. Pairs that have an object of an unsupported type get the same results as in GeomIntersects(),
+	GeomDistance() and GeomClosestPoint().
+	The object keeps the memory used for sorting the pairs between calls, so reusing one instance avoids allocating memory
+	every frame. A single instance must not be used from several threads at the same time. */
+class NarrowphaseBatch
+{
+public:
+	/// Tests each pair with GeomIntersects(), and stores the result of the pair i to outResults[i].
+	void Intersects(const GeomPair *pairs, int numPairs, bool *outResults);
+
+	/// Computes GeomDistance() of each pair, and stores the result of the pair i to outResults[i].
+	void Distance(const GeomPair *pairs, int numPairs, float *outResults);
+
+	/// Computes GeomClosestPoint() of each pair, and stores the result of the pair i to outResults[i].
+	void ClosestPoint(const GeomPair *pairs, int numPairs, vec *outResults);
+
+	/// A pair of objects in the list sorted by type, along with the index of the pair in the original list.
+	struct SortedPair
+	{
+		const void *a;
+		const void *b;
+		int index;
+	};
+
+private:
+	/// Fills sortedPairs with the pairs sorted by their type pair, and bucketStart with the index of sortedPairs where each
+	/// type pair begins.
+	void SortByType(const GeomPair *pairs, int numPairs);
+
+	std::vector<SortedPair> sortedPairs;
+	int bucketStart[numGeomTypes * numGeomTypes + 1];
+};
+
+MATH_END_NAMESPACE
@@ -19,47 +19,317 @@
 
 #include "../MathGeoLibFwd.h"
 #include "../Math/float3.h"
+#include "../Geometry/AABB.h"
+#include "../Geometry/Frustum.h"
+#include "../Geometry/Polyhedron.h"
+
+#include <vector>
 
 MATH_BEGIN_NAMESPACE
 
+/// Specifies the maximum number of values that UniqueFaceNormals() and UniqueEdgeDirections() return for an object of type T.
+/** SATIntersect() stores the candidate axes of these types in fixed-size arrays on the stack. Polyhedron has no upper bound
+	for its number of faces, so it is not specialized here. Its axes are stored in buffers sized by the polyhedron instead,
+	see SATAxisArrays<Polyhedron>. */
+template<typename T>
+struct SATAxisCount;
+
+template<> struct SATAxisCount<AABB> { enum { faceNormals = 3, edgeDirections = 3 }; };
+template<> struct SATAxisCount<OBB> { enum { faceNormals = 3, edgeDirections = 3 }; };
+template<> struct SATAxisCount<Triangle> { enum { faceNormals = 4, edgeDirections = 3 }; };
+template<> struct SATAxisCount<Frustum> { enum { faceNormals = 5, edgeDirections = 6 }; };
+
+/// Provides the candidate separating axes and the projections of an object for a single SATIntersect() query.
+/** By default this calls the corresponding functions of the object. Types that would repeat costly work in each
+	call are specialized to do that work only once per query. */
+template<typename T>
+struct SATShape
+{
+	const T &object;
+
+	explicit SATShape(const T &object):object(object) {}
+
+	void ProjectToAxis(const vec &axis, float &outMin, float &outMax) const { object.ProjectToAxis(axis, outMin, outMax); }
+	int UniqueFaceNormals(vec *out) const { return object.UniqueFaceNormals(out); }
+	int UniqueEdgeDirections(vec *out) const { return object.UniqueEdgeDirections(out); }
+};
+
+/// AABB::ProjectToAxis() computes the center and the half-size of the box on each call, so this computes them only once.
+template<>
+struct SATShape<AABB>
+{
+	vec center;
+	vec halfSize;
+
+	explicit SATShape(const AABB &aabb):center(aabb.CenterPoint()), halfSize(aabb.HalfSize()) {}
+
+	void ProjectToAxis(const vec &axis, float &outMin, float &outMax) const
+	{
+		float r = Abs(halfSize.x * axis.x) + Abs(halfSize.y * axis.y) + Abs(halfSize.z * axis.z);
+		float c = Dot(axis, center);
+		outMin = c - r;
+		outMax = c + r;
+	}
+
+	int UniqueFaceNormals(vec *out) const
+	{
+		out[0] = DIR_VEC(1,0,0);
+		out[1] = DIR_VEC(0,1,0);
+		out[2] = DIR_VEC(0,0,1);
+		return 3;
+	}
+	int UniqueEdgeDirections(vec *out) const { return UniqueFaceNormals(out); }
+};
+
+/// Frustum::ProjectToAxis() computes all the corner points of the frustum on each call, and the face normals are computed from
+/// the frustum planes. This computes the corner points only once, and derives the axes from them.
+template<>
+struct SATShape<Frustum>
+{
+	/// The corner points in the order of Frustum::GetCornerPoints(): the near plane corners 0-3 and the far plane corners 4-7,
+	/// in the order (-x,-y), (+x,-y), (-x,+y), (+x,+y) in the local space of the frustum.
+	vec corners[8];
+	bool perspective;
+
+	explicit SATShape(const Frustum &frustum):perspective(frustum.Type() == PerspectiveFrustum) { frustum.GetCornerPoints(corners); }
+
+	void ProjectToAxis(const vec &axis, float &outMin, float &outMax) const
+	{
+		outMin = outMax = Dot(axis, corners[0]);
+		for(int i = 1; i < 8; ++i)
+		{
+			float d = Dot(axis, corners[i]);
+			outMin = Min(outMin, d);
+			outMax = Max(outMax, d);
+		}
+	}
+
+	// The same axes as Frustum::UniqueFaceNormals() and Frustum::UniqueEdgeDirections(), up to their sign and length.
+	int UniqueFaceNormals(vec *out) const
+	{
+		out[0] = Cross(corners[1] - corners[0], corners[2] - corners[0]);
+		out[1] = Cross(corners[2] - corners[0], corners[4] - corners[0]);
+		out[2] = Cross(corners[1] - corners[0], corners[4] - corners[0]);
+		if (!perspective)
+			return 3;
+		out[3] = Cross(corners[3] - corners[1], corners[5] - corners[1]);
+		out[4] = Cross(corners[3] - corners[2], corners[6] - corners[2]);
+		return 5;
+	}
+
+	int UniqueEdgeDirections(vec *out) const
+	{
+		out[0] = corners[1] - corners[0];
+		out[1] = corners[2] - corners[0];
+		out[2] = corners[4] - corners[0];
+		if (!perspective)
+			return 3;
+		out[3] = corners[5] - corners[1];
+		out[4] = corners[6] - corners[2];
+		out[5] = corners[7] - corners[3];
+		return 6;
+	}
+};
+
+/// Polyhedron has no UniqueFaceNormals() or UniqueEdgeDirections() functions, so this computes the axes from its faces.
+/** The axes are not deduplicated: each face gives one face normal, and each edge one edge direction. For polyhedra with many
+	faces, GJKIntersect() is considerably faster than SATIntersect(). */
+template<>
+struct SATShape<Polyhedron>
+{
+	const Polyhedron &object;
+
+	explicit SATShape(const Polyhedron &polyhedron):object(polyhedron) {}
+
+	void ProjectToAxis(const vec &axis, float &outMin, float &outMax) const { object.ProjectToAxis(axis, outMin, outMax); }
+
+	int MaxFaceNormals() const { return object.NumFaces(); }
+	int MaxEdgeDirections() const
+	{
+		int numHalfEdges = 0;
+		for(int i = 0; i < object.NumFaces(); ++i)
+			numHalfEdges += (int)object.f[i].v.size();
+		return numHalfEdges;
+	}
+
+	int UniqueFaceNormals(vec *out) const
+	{
+		for(int i = 0; i < object.NumFaces(); ++i)
+			out[i] = object.FaceNormal(i);
+		return object.NumFaces();
+	}
+
+	// In a closed polyhedron each edge is shared by two faces that traverse it in opposite directions, so taking the
+	// direction where the first vertex index is smaller lists each edge once.
+	int UniqueEdgeDirections(vec *out) const
+	{
+		int n = 0;
+		for(int i = 0; i < object.NumFaces(); ++i)
+		{
+			const std::vector<int> &face = object.f[i].v;
+			for(size_t j = 0, k = face.size() - 1; j < face.size(); k = j++)
+				if (face[k] < face[j])
+					out[n++] = object.v[face[j]] - object.v[face[k]];
+		}
+		return n;
+	}
+};
+
+/// Stores the candidate axes of an object for a single SATIntersect() query.
+/** The types that SATAxisCount is specialized for store their axes in fixed-size arrays on the stack. */
+template<typename T>
+struct SATAxisArrays
+{
+	vec faceNormals[SATAxisCount<T>::faceNormals];
+	vec edgeDirections[SATAxisCount<T>::edgeDirections];
+
+	explicit SATAxisArrays(const SATShape<T> &) {}
+
+	int MaxFaceNormals() const { return SATAxisCount<T>::faceNormals; }
+	int MaxEdgeDirections() const { return SATAxisCount<T>::edgeDirections; }
+};
+
+/// The axes of a Polyhedron are stored in heap buffers that are sized by the polyhedron, so this allocates memory.
+template<>
+struct SATAxisArrays<Polyhedron>
+{
+	std::vector<vec> faceNormalBuffer;
+	std::vector<vec> edgeDirectionBuffer;
+	vec *faceNormals;
+	vec *edgeDirections;
+
+	explicit SATAxisArrays(const SATShape<Polyhedron> &shape)
+	:faceNormalBuffer(Max(1, shape.MaxFaceNormals())), edgeDirectionBuffer(Max(1, shape.MaxEdgeDirections())),
+	faceNormals(&faceNormalBuffer[0]), edgeDirections(&edgeDirectionBuffer[0])
+	{
+	}
+
+	int MaxFaceNormals() const { return (int)faceNormalBuffer.size(); }
+	int MaxEdgeDirections() const { return (int)edgeDirectionBuffer.size(); }
+
+private:
+	SATAxisArrays(const SATAxisArrays &); // Not implemented, the pointers refer to the buffers of this object.
+	void operator =(const SATAxisArrays &); // Not implemented.
+};
+
+/// Stores the separating axis found by the previous SATIntersect() query between a pair of objects.
+/** When the objects move only a little between the queries, the axis that separated them in the previous query usually
+	still does, and SATIntersect(const A &, const B &, SATCache &) tests it first to return without testing the other axes.
+	Keep one SATCache per pair of objects, for example in the broadphase pair structure.
+	@see SATIntersect(const A &, const B &, SATCache &). */
+struct SATCache
+{
+	/// The index of the axis that separated the objects in the previous query, or -1 if they intersected or if there is
+	/// no previous query. The face normals of the first object come first, then the face normals of the second object, and
+	/// then the cross products of each edge direction of the first object with each edge direction of the second object.
+	int separatingAxis;
+
+	SATCache():separatingAxis(-1) {}
+
+	/// Forgets the previous query, so that the next query tests all the axes in the default order.
+	void Reset() { separatingAxis = -1; }
+};
+
+/// Returns true if the projections of the two objects to the given axis do not overlap.
 template<typename A, typename B>
-bool SATIntersect(const A &a, const B &b)
+bool SATSeparates(const SATShape<A> &a, const SATShape<B> &b, const vec &axis)
 {
-	vec normals[16];
-	int n = a.UniqueFaceNormals(normals);
-	assert(n <= 16); ///\todo Make this API safe.
-	for(int i = 0; i < n; ++i)
+	float amin, amax, bmin, bmax;
+	a.ProjectToAxis(axis, amin, amax);
+	b.ProjectToAxis(axis, bmin, bmax);
+	return amax < bmin || bmax < amin;
+}
+
+/// Returns the index of an axis that separates the two given objects, or -1 if they intersect.
+/** The axis with the index firstAxis is tested before the others. The indices are in the order that SATCache::separatingAxis
+	describes. An out-of-range firstAxis, such as -1, tests the axes in the default order. */
+template<typename A, typename B>
+int SATFindSeparatingAxis(const A &a, const B &b, int firstAxis)
+{
+	const SATShape<A> shapeA(a);
+	const SATShape<B> shapeB(b);
+	SATAxisArrays<A> axesA(shapeA);
+	SATAxisArrays<B> axesB(shapeB);
+	vec *faceNormalsA = axesA.faceNormals;
+	vec *faceNormalsB = axesB.faceNormals;
+	vec *edgesA = axesA.edgeDirections;
+	vec *edgesB = axesB.edgeDirections;
+
+	const int numFacesA = shapeA.UniqueFaceNormals(faceNormalsA);
+	const int numFacesB = shapeB.UniqueFaceNormals(faceNormalsB);
+	assume(numFacesA <= axesA.MaxFaceNormals());
+	assume(numFacesB <= axesB.MaxFaceNormals());
+	const int numFaceAxes = numFacesA + numFacesB;
+	// The edge directions are only needed when no face normal separates the objects, so they are fetched lazily.
+	int numEdgesA = -1;
+	int numEdgesB = -1;
+
+	if (firstAxis >= 0 && firstAxis < numFacesA)
 	{
-		float amin, amax, bmin, bmax;
-		a.ProjectToAxis(normals[i], amin, amax);
-		b.ProjectToAxis(normals[i], bmin, bmax);
-		if (amax < bmin || bmax < amin)
-			return false;
+		if (SATSeparates(shapeA, shapeB, faceNormalsA[firstAxis]))
+			return firstAxis;
 	}
-	n = b.UniqueFaceNormals(normals);
-	assert(n <= 16); ///\todo Make this API safe.
-	for(int i = 0; i < n; ++i)
+	else if (firstAxis >= numFacesA && firstAxis < numFaceAxes)
+	{
+		if (SATSeparates(shapeA, shapeB, faceNormalsB[firstAxis - numFacesA]))
+			return firstAxis;
+	}
+	else if (firstAxis >= numFaceAxes)
+	{
+		numEdgesA = shapeA.UniqueEdgeDirections(edgesA);
+		numEdgesB = shapeB.UniqueEdgeDirections(edgesB);
+		assume(numEdgesA <= axesA.MaxEdgeDirections());
+		assume(numEdgesB <= axesB.MaxEdgeDirections());
+		int edgePair = firstAxis - numFaceAxes;
+		if (edgePair < numEdgesA * numEdgesB && SATSeparates(shapeA, shapeB, Cross(edgesA[edgePair / numEdgesB], edgesB[edgePair % numEdgesB])))
+			return firstAxis;
+	}
+
+	for(int i = 0; i < numFacesA; ++i)
+		if (i != firstAxis && SATSeparates(shapeA, shapeB, faceNormalsA[i]))
+			return i;
+	for(int i = 0; i < numFacesB; ++i)
+		if (numFacesA + i != firstAxis && SATSeparates(shapeA, shapeB, faceNormalsB[i]))
+			return numFacesA + i;
+
+	if (numEdgesA < 0)
 	{
-		float amin, amax, bmin, bmax;
-		a.ProjectToAxis(normals[i], amin, amax);
-		b.ProjectToAxis(normals[i], bmin, bmax);
-		if (amax < bmin || bmax < amin)
-			return false;
+		numEdgesA = shapeA.UniqueEdgeDirections(edgesA);
+		numEdgesB = shapeB.UniqueEdgeDirections(edgesB);
+		assume(numEdgesA <= axesA.MaxEdgeDirections());
+		assume(numEdgesB <= axesB.MaxEdgeDirections());
 	}
-	vec normals2[16];
-	n = a.UniqueEdgeDirections(normals);
-	int m = b.UniqueEdgeDirections(normals2);
-	for(int i = 0; i < n; ++i)
-		for(int j = 0; j < m; ++j)
+	for(int i = 0; i < numEdgesA; ++i)
+		for(int j = 0; j < numEdgesB; ++j)
 		{
-			float amin, amax, bmin, bmax;
-			vec normal = Cross(normals[i], normals2[j]);
-			a.ProjectToAxis(normal, amin, amax);
-			b.ProjectToAxis(normal, bmin, bmax);
-			if (amax < bmin || bmax < amin)
-				return false;
+			int axis = numFaceAxes + i * numEdgesB + j;
+			if (axis != firstAxis && SATSeparates(shapeA, shapeB, Cross(edgesA[i], edgesB[j])))
+				return axis;
 		}
-	return true;
+	return -1;
+}
+
+/// Tests whether the two given convex objects intersect, using the separating axis theorem.
+/** This function works for the pairs of objects that implement the functions ProjectToAxis(), UniqueFaceNormals() and
+	UniqueEdgeDirections(), and for which SATAxisCount is specialized. It does not allocate memory for these types. Polyhedron
+	is also accepted, in which case the axes of the polyhedron are stored on the heap.
+	@see GJKIntersect(). */
+template<typename A, typename B>
+bool SATIntersect(const A &a, const B &b)
+{
+	return SATFindSeparatingAxis(a, b, -1) < 0;
+}
+
+/// Tests whether the two given convex objects intersect, starting from the separating axis cached in the given object.
+/** @param cache [in, out] The separating axis found by the previous query between these objects, which is updated with the
+		result of this query. Default-construct or Reset() the cache before the first query.
+	@return The same result as SATIntersect(a, b).
+	@see SATCache. */
+template<typename A, typename B>
+bool SATIntersect(const A &a, const B &b, SATCache &cache)
+{
+	cache.separatingAxis = SATFindSeparatingAxis(a, b, cache.separatingAxis);
+	return cache.separatingAxis < 0;
 }
 
 MATH_END_NAMESPACE
@@ -0,0 +1,180 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file ThreadPool.cpp
+	@author Jukka Jylanki
+	@brief Implementation of a lightweight pool of worker threads. */
+#include "ThreadPool.h"
+#include "../Math/myassert.h"
+
+#ifdef MATH_THREADS
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#endif
+
+MATH_BEGIN_NAMESPACE
+
+#ifdef MATH_THREADS
+
+struct ThreadPool::Impl
+{
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable workAvailable;
+	std::condition_variable workFinished;
+
+	// Incremented each time a new job is posted, so that the workers can tell a new job from a spurious wakeup.
+	unsigned int jobGeneration;
+	// The number of workers that have not yet finished the current job.
+	int numBusyWorkers;
+	bool quit;
+
+	ParallelForFunc func;
+	void *userData;
+	int numItems;
+	int chunkSize;
+	std::atomic<int> nextItem;
+
+	Impl():jobGeneration(0), numBusyWorkers(0), quit(false), func(0), userData(0), numItems(0), chunkSize(1), nextItem(0) {}
+
+	void RunChunks()
+	{
+		for(;;)
+		{
+			int begin = nextItem.fetch_add(chunkSize);
+			if (begin >= numItems)
+				return;
+			int end = (begin < numItems - chunkSize) ? begin + chunkSize : numItems;
+			func(userData, begin, end);
+		}
+	}
+
+	void WorkerMain()
+	{
+		unsigned int seenGeneration = 0;
+		for(;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				while(!quit && jobGeneration == seenGeneration)
+					workAvailable.wait(lock);
+				if (quit)
+					return;
+				seenGeneration = jobGeneration;
+			}
+
+			RunChunks();
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--numBusyWorkers == 0)
+				workFinished.notify_one();
+		}
+	}
+
+	static void WorkerEntryPoint(Impl *impl)
+	{
+		impl->WorkerMain();
+	}
+};
+
+ThreadPool::ThreadPool(int numThreads_)
+:impl(new Impl), numThreads(numThreads_ > 0 ? numThreads_ : HardwareConcurrency())
+{
+	for(int i = 1; i < numThreads; ++i)
+		impl->workers.push_back(std::thread(&Impl::WorkerEntryPoint, impl));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(impl->mutex);
+		impl->quit = true;
+	}
+	impl->workAvailable.notify_all();
+	for(size_t i = 0; i < impl->workers.size(); ++i)
+		impl->workers[i].join();
+	delete impl;
+}
+
+int ThreadPool::HardwareConcurrency()
+{
+	unsigned int n = std::thread::hardware_concurrency();
+	return n > 0 ? (int)n : 1;
+}
+
+void ThreadPool::ParallelFor(int numItems, int chunkSize, ParallelForFunc func, void *userData)
+{
+	assume(func);
+	if (numItems <= 0)
+		return;
+	if (chunkSize <= 0) // Aim for a few chunks per thread, so that the threads can balance the load between them.
+		chunkSize = numItems / (numThreads * 4) > 1 ? numItems / (numThreads * 4) : 1;
+
+	if (impl->workers.empty() || numItems <= chunkSize)
+	{
+		func(userData, 0, numItems);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(impl->mutex);
+		impl->func = func;
+		impl->userData = userData;
+		impl->numItems = numItems;
+		impl->chunkSize = chunkSize;
+		impl->nextItem = 0;
+		impl->numBusyWorkers = (int)impl->workers.size();
+		++impl->jobGeneration;
+	}
+	impl->workAvailable.notify_all();
+
+	impl->RunChunks();
+
+	std::unique_lock<std::mutex> lock(impl->mutex);
+	while(impl->numBusyWorkers > 0)
+		impl->workFinished.wait(lock);
+}
+
+#else
+
+struct ThreadPool::Impl {};
+
+ThreadPool::ThreadPool(int /*numThreads*/)
+:impl(0), numThreads(1)
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+}
+
+int ThreadPool::HardwareConcurrency()
+{
+	return 1;
+}
+
+void ThreadPool::ParallelFor(int numItems, int /*chunkSize*/, ParallelForFunc func, void *userData)
+{
+	assume(func);
+	if (numItems > 0)
+		func(userData, 0, numItems);
+}
+
+#endif
+
+MATH_END_NAMESPACE
@@ -0,0 +1,68 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file ThreadPool.h
+	@author Jukka Jylanki
+	@brief A lightweight pool of worker threads for running data-parallel loops. */
+#pragma once
+
+#include "../MathBuildConfig.h"
+#include "../Math/MathNamespace.h"
+
+MATH_BEGIN_NAMESPACE
+
+/// A fixed-size pool of worker threads that executes data-parallel for loops in chunks.
+/** The threads are created once in the constructor and sleep between jobs, so issuing a ParallelFor()
+	only costs a wakeup instead of a thread creation. Work is scheduled dynamically: each thread (including
+	the thread that called ParallelFor()) repeatedly grabs the next chunk of chunkSize items until the
+	whole range has been processed, which balances the load even if the cost per item varies.
+
+	If MATH_THREADS is not defined, the pool has no worker threads and ParallelFor() runs the whole range
+	on the calling thread.
+	@note ParallelFor() is not reentrant: do not call ParallelFor() on the same pool from inside the
+		work function, or from several threads at the same time. */
+class ThreadPool
+{
+public:
+	/// The work function signature. The function should process the items in the half-open range [begin, end[.
+	typedef void (*ParallelForFunc)(void *userData, int begin, int end);
+
+	/// Creates a thread pool.
+	/** @param numThreads The total number of threads to run jobs on, including the thread that calls ParallelFor().
+			Pass in 0 to use the number of hardware threads on the system. */
+	explicit ThreadPool(int numThreads = 0);
+	~ThreadPool();
+
+	/// Returns the total number of threads that ParallelFor() runs on, including the calling thread.
+	int NumThreads() const { return numThreads; }
+
+	/// Returns the number of threads the hardware can run concurrently, or 1 if this is not known.
+	static int HardwareConcurrency();
+
+	/// Calls func for the range [0, numItems[, split to chunks of chunkSize items, on all threads of this pool.
+	/** This function returns only after all the items have been processed.
+		@param chunkSize The number of items to process in a single call to func. Pass in 0 to choose a chunk size
+			automatically based on the number of items and threads. */
+	void ParallelFor(int numItems, int chunkSize, ParallelForFunc func, void *userData);
+
+private:
+	struct Impl;
+	Impl *impl;
+	int numThreads;
+
+	ThreadPool(const ThreadPool &); // Not implemented.
+	void operator =(const ThreadPool &); // Not implemented.
+};
+
+MATH_END_NAMESPACE
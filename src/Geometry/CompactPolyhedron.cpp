@@ -0,0 +1,207 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file CompactPolyhedron.cpp
+	@author Jukka Jylanki
+	@brief Implementation of the compressed sparse row form of a Polyhedron. */
+#include "CompactPolyhedron.h"
+#include "../Math/assume.h"
+#include "../Math/float3x3.h"
+#include "../Math/float3x4.h"
+#include "../Math/float4x4.h"
+#include "../Math/Quat.h"
+#include "Line.h"
+#include "Plane.h"
+#include "Polygon.h"
+#include "Triangle.h"
+
+MATH_BEGIN_NAMESPACE
+
+CompactPolyhedron::CompactPolyhedron()
+{
+	faceStart.push_back(0);
+}
+
+CompactPolyhedron::CompactPolyhedron(const Polyhedron &polyhedron)
+:v(polyhedron.v)
+{
+	size_t numIndices = 0;
+	for(size_t i = 0; i < polyhedron.f.size(); ++i)
+		numIndices += polyhedron.f[i].v.size();
+	faceIndices.reserve(numIndices);
+	faceStart.reserve(polyhedron.f.size() + 1);
+	faceStart.push_back(0);
+	for(size_t i = 0; i < polyhedron.f.size(); ++i)
+		AddFace(polyhedron.f[i]);
+}
+
+Polyhedron::Face CompactPolyhedron::Face(int faceIndex) const
+{
+	assume(faceIndex >= 0 && faceIndex < NumFaces());
+	Polyhedron::Face face;
+	face.v.assign(faceIndices.begin() + faceStart[faceIndex], faceIndices.begin() + faceStart[faceIndex+1]);
+	return face;
+}
+
+void CompactPolyhedron::AddFace(const int *indices, int numIndices)
+{
+	faceIndices.insert(faceIndices.end(), indices, indices + numIndices);
+	faceStart.push_back((int)faceIndices.size());
+}
+
+void CompactPolyhedron::AddFace(const Polyhedron::Face &face)
+{
+	faceIndices.insert(faceIndices.end(), face.v.begin(), face.v.end());
+	faceStart.push_back((int)faceIndices.size());
+}
+
+Polygon CompactPolyhedron::FacePolygon(int faceIndex) const
+{
+	assume(faceIndex >= 0 && faceIndex < NumFaces());
+	Polygon p;
+	const int numFaceVertices = NumFaceVertices(faceIndex);
+	p.p.reserve(numFaceVertices);
+	for(int i = faceStart[faceIndex]; i < faceStart[faceIndex+1]; ++i)
+		p.p.push_back(Vertex(faceIndices[i]));
+	return p;
+}
+
+Plane CompactPolyhedron::FacePlane(int faceIndex) const
+{
+	const int numFaceVertices = NumFaceVertices(faceIndex);
+	if (numFaceVertices == 0)
+		return Plane();
+	const int *face = FaceIndices(faceIndex);
+	if (numFaceVertices >= 3)
+		return Plane(v[face[0]], v[face[1]], v[face[2]]);
+	else if (numFaceVertices == 2)
+		return Plane(Line(v[face[0]], v[face[1]]), ((vec)v[face[0]]-(vec)v[face[1]]).Perpendicular());
+	else
+		return Plane(v[face[0]], DIR_VEC(0,1,0));
+}
+
+vec CompactPolyhedron::FaceNormal(int faceIndex) const
+{
+	const int numFaceVertices = NumFaceVertices(faceIndex);
+	if (numFaceVertices < 3)
+		return FacePlane(faceIndex).normal;
+	const int *face = FaceIndices(faceIndex);
+	if (numFaceVertices == 3)
+		return Cross((vec)v[face[1]] - (vec)v[face[0]], (vec)v[face[2]] - (vec)v[face[0]]).Normalized();
+
+	// Use Newell's method of computing the face normal for best stability, as in Polyhedron::FaceNormal().
+	float x = 0.f, y = 0.f, z = 0.f;
+	vec p0 = v[face[numFaceVertices-1]];
+	for(int i = 0; i < numFaceVertices; ++i)
+	{
+		vec p1 = v[face[i]];
+		x += (p0.y - p1.y) * (p0.z + p1.z); // Project on yz
+		y += (p0.z - p1.z) * (p0.x + p1.x); // Project on xz
+		z += (p0.x - p1.x) * (p0.y + p1.y); // Project on xy
+		p0 = p1;
+	}
+	return DIR_VEC(x, y, z).Normalized();
+}
+
+void CompactPolyhedron::Translate(const vec &offset)
+{
+	for(size_t i = 0; i < v.size(); ++i)
+		v[i] = (vec)v[i] + offset;
+}
+
+void CompactPolyhedron::Transform(const float3x3 &transform)
+{
+	if (!v.empty())
+		transform.BatchTransform((vec*)&v[0], (int)v.size());
+}
+
+void CompactPolyhedron::Transform(const float3x4 &transform)
+{
+	if (!v.empty())
+		transform.BatchTransformPos((vec*)&v[0], (int)v.size());
+}
+
+void CompactPolyhedron::Transform(const float4x4 &transform)
+{
+	for(size_t i = 0; i < v.size(); ++i)
+		v[i] = transform.MulPos(v[i]);
+}
+
+void CompactPolyhedron::Transform(const Quat &transform)
+{
+	for(size_t i = 0; i < v.size(); ++i)
+		v[i] = transform * v[i];
+}
+
+TriangleArray CompactPolyhedron::Triangulate() const
+{
+	TriangleArray outTriangleList;
+	// A face of n >= 3 vertices produces n-2 triangles.
+	size_t numTriangles = 0;
+	for(int i = 0; i < NumFaces(); ++i)
+		if (NumFaceVertices(i) >= 3)
+			numTriangles += NumFaceVertices(i) - 2;
+	outTriangleList.reserve(numTriangles);
+
+	for(int i = 0; i < NumFaces(); ++i)
+	{
+		const int numFaceVertices = NumFaceVertices(i);
+		if (numFaceVertices < 3)
+			continue;
+		const int *face = FaceIndices(i);
+		vec p0 = v[face[0]];
+		if (numFaceVertices > 3)
+		{
+			// A fan is only valid if the face is convex, that is, each corner turns to the same direction as the face
+			// normal.
+			vec normal = FaceNormal(i);
+			vec a = v[face[numFaceVertices-2]];
+			vec b = v[face[numFaceVertices-1]];
+			bool convex = true;
+			for(int j = 0; j < numFaceVertices && convex; ++j)
+			{
+				vec c = v[face[j]];
+				convex = Dot(Cross(b - a, c - b), normal) >= 0.f;
+				a = b;
+				b = c;
+			}
+			if (!convex)
+			{
+				TriangleArray tris = FacePolygon(i).Triangulate();
+				outTriangleList.insert(outTriangleList.end(), tris.begin(), tris.end());
+				continue;
+			}
+		}
+		vec p1 = v[face[1]];
+		for(int j = 2; j < numFaceVertices; ++j)
+		{
+			vec p2 = v[face[j]];
+			outTriangleList.push_back(Triangle(p0, p1, p2));
+			p1 = p2;
+		}
+	}
+	return outTriangleList;
+}
+
+Polyhedron CompactPolyhedron::ToPolyhedron() const
+{
+	Polyhedron p;
+	p.v = v;
+	p.f.resize(NumFaces());
+	for(int i = 0; i < NumFaces(); ++i)
+		p.f[i].v.assign(faceIndices.begin() + faceStart[i], faceIndices.begin() + faceStart[i+1]);
+	return p;
+}
+
+MATH_END_NAMESPACE
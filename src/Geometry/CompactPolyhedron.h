@@ -0,0 +1,111 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file CompactPolyhedron.h
+	@author Jukka Jylanki
+	@brief A Polyhedron that stores the indices of all its faces in a single array. */
+#pragma once
+
+#include "../MathGeoLibFwd.h"
+#include "../Math/float3.h"
+#include "Polyhedron.h"
+
+#include <vector>
+
+MATH_BEGIN_NAMESPACE
+
+/// Represents the same solid as a Polyhedron, with the faces stored in a compressed sparse row layout.
+/** Polyhedron stores each face in its own std::vector, so copying a polyhedron allocates memory once for each face, and
+	walking the faces follows a pointer for each face. CompactPolyhedron stores the vertex indices of all faces one after
+	another in the array faceIndices, and the offset where each face begins in the array faceStart. Copying it allocates
+	memory three times, and walking the faces reads consecutive memory.
+	Convert a Polyhedron to this form once, for example when loading a mesh, to copy, transform and triangulate it
+	repeatedly. The faces use the same conventions as Polyhedron::Face.
+	@see Polyhedron. */
+class CompactPolyhedron
+{
+public:
+	/// Specifies the vertices of this polyhedron.
+	VecArray v;
+
+	/// Specifies the vertex indices of all faces, one face after another.
+	std::vector<int> faceIndices;
+
+	/// Specifies the faces of this polyhedron. [similarOverload: faceIndices]
+	/** The vertex indices of the face i are faceIndices[faceStart[i]] to faceIndices[faceStart[i+1]-1]. This array has
+		one element more than there are faces, and its first element is always 0. */
+	std::vector<int> faceStart;
+
+	/// The default constructor creates a null polyhedron, with 0 vertices and 0 faces.
+	CompactPolyhedron();
+
+	/// Converts the given Polyhedron to the compact form.
+	explicit CompactPolyhedron(const Polyhedron &polyhedron);
+
+	/// Returns the number of vertices in this polyhedron.
+	int NumVertices() const { return (int)v.size(); }
+
+	/// Returns the number of faces in this polyhedron.
+	int NumFaces() const { return (int)faceStart.size() - 1; }
+
+	/// Returns the vertex with the given index.
+	vec Vertex(int vertexIndex) const { return v[vertexIndex]; }
+
+	/// Returns the number of vertices in the given face.
+	int NumFaceVertices(int faceIndex) const { return faceStart[faceIndex+1] - faceStart[faceIndex]; }
+
+	/// Returns a pointer to the NumFaceVertices(faceIndex) vertex indices of the given face.
+	const int *FaceIndices(int faceIndex) const { return &faceIndices[0] + faceStart[faceIndex]; }
+
+	/// Returns the vertex indices of the given face as a Polyhedron::Face.
+	/** This allocates memory for the face. Use FaceIndices() to access the indices in place. */
+	Polyhedron::Face Face(int faceIndex) const;
+
+	/// Appends a face to this polyhedron.
+	/** @param indices The vertex indices of the face, in counter-clockwise order as in Polyhedron::Face. */
+	void AddFace(const int *indices, int numIndices);
+	void AddFace(const Polyhedron::Face &face);
+
+	/// Returns a polygon representing the given face.
+	/** @see Polyhedron::FacePolygon(). */
+	Polygon FacePolygon(int faceIndex) const;
+
+	/// Returns the plane of the given face.
+	/** @see Polyhedron::FacePlane(). */
+	Plane FacePlane(int faceIndex) const;
+
+	/// Returns the normalized normal vector of the given face.
+	/** @see Polyhedron::FaceNormal(). */
+	vec FaceNormal(int faceIndex) const;
+
+	/// Translates this polyhedron in world space.
+	void Translate(const vec &offset);
+
+	/// Applies a transformation to this polyhedron.
+	void Transform(const float3x3 &transform);
+	void Transform(const float3x4 &transform);
+	void Transform(const float4x4 &transform);
+	void Transform(const Quat &transform);
+
+	/// Triangulates the faces of this polyhedron.
+	/** The convex faces are triangulated as fans from their first vertex, without allocating memory for each face. The
+		other faces are triangulated with Polygon::Triangulate().
+		@see Polyhedron::Triangulate(). */
+	TriangleArray Triangulate() const;
+
+	/// Converts this polyhedron to a Polyhedron.
+	Polyhedron ToPolyhedron() const;
+};
+
+MATH_END_NAMESPACE
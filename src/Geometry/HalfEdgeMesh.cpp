@@ -0,0 +1,175 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file HalfEdgeMesh.cpp
+	@author Jukka Jylanki
+	@brief Implementation of the half-edge connectivity structure of a Polyhedron. */
+#include "HalfEdgeMesh.h"
+#include <algorithm>
+#include "../Math/assume.h"
+#include "../Math/MathFunc.h"
+
+MATH_BEGIN_NAMESPACE
+
+HalfEdgeMesh::HalfEdgeMesh()
+:numBoundaryHalfEdges(0), hasDuplicateHalfEdges(false)
+{
+	faceHalfEdges.push_back(0);
+	outgoingStart.push_back(0);
+}
+
+HalfEdgeMesh::HalfEdgeMesh(const Polyhedron &polyhedron)
+{
+	Set(polyhedron);
+}
+
+void HalfEdgeMesh::Set(const Polyhedron &polyhedron)
+{
+	const int numVertices = polyhedron.NumVertices();
+	const int numFaces = polyhedron.NumFaces();
+
+	faceHalfEdges.resize(numFaces + 1);
+	int numHalfEdges = 0;
+	for(int i = 0; i < numFaces; ++i)
+	{
+		faceHalfEdges[i] = numHalfEdges;
+		numHalfEdges += (int)polyhedron.f[i].v.size();
+	}
+	faceHalfEdges[numFaces] = numHalfEdges;
+
+	halfEdges.resize(numHalfEdges);
+	outgoingStart.assign(numVertices + 1, 0);
+	for(int i = 0; i < numFaces; ++i)
+	{
+		const std::vector<int> &face = polyhedron.f[i].v;
+		if (face.empty())
+			continue;
+		HalfEdge *he = &halfEdges[0] + faceHalfEdges[i];
+		for(size_t j = 0; j < face.size(); ++j)
+		{
+			assume(face[j] >= 0 && face[j] < numVertices);
+			he[j].origin = face[j];
+			he[j].twin = -1;
+			he[j].face = i;
+			++outgoingStart[face[j] + 1];
+		}
+	}
+
+	// Bucket the half-edges by their origin vertex. The buckets keep the half-edges in increasing order.
+	for(int i = 0; i < numVertices; ++i)
+		outgoingStart[i+1] += outgoingStart[i];
+	outgoing.resize(numHalfEdges);
+	std::vector<int> fill(outgoingStart.begin(), outgoingStart.end() - 1);
+	for(int i = 0; i < numHalfEdges; ++i)
+		outgoing[fill[halfEdges[i].origin]++] = i;
+
+	// The twin of the half-edge a->b is found among the half-edges that start from b.
+	numBoundaryHalfEdges = 0;
+	hasDuplicateHalfEdges = false;
+	for(int i = 0; i < numHalfEdges; ++i)
+	{
+		const int a = halfEdges[i].origin;
+		const int b = Destination(i);
+		for(int j = outgoingStart[b]; j < outgoingStart[b+1]; ++j)
+			if (Destination(outgoing[j]) == a)
+			{
+				if (halfEdges[i].twin == -1)
+					halfEdges[i].twin = outgoing[j];
+				else
+					hasDuplicateHalfEdges = true;
+			}
+		if (halfEdges[i].twin == -1)
+			++numBoundaryHalfEdges;
+		// A half-edge that another half-edge duplicates makes the mesh non-manifold, even if it has no twin.
+		for(int j = outgoingStart[a]; j < outgoingStart[a+1] && !hasDuplicateHalfEdges; ++j)
+			if (outgoing[j] != i && Destination(outgoing[j]) == b)
+				hasDuplicateHalfEdges = true;
+	}
+}
+
+int HalfEdgeMesh::NumEdges() const
+{
+	int numEdges = 0;
+	for(int i = 0; i < NumHalfEdges(); ++i)
+		if (halfEdges[i].twin < i) // Count each pair of twins at the larger index, and each boundary half-edge once.
+			++numEdges;
+	return numEdges;
+}
+
+bool HalfEdgeMesh::IsConvex(const Polyhedron &polyhedron, float epsilon) const
+{
+	assume(polyhedron.NumVertices() == NumVertices());
+	assume(polyhedron.NumFaces() == NumFaces());
+	if (!IsClosed())
+		return false;
+
+	const vec *v = polyhedron.v.empty() ? 0 : (const vec *)&polyhedron.v[0];
+	std::vector<vec> faceNormals(NumFaces());
+	for(int i = 0; i < NumFaces(); ++i)
+		faceNormals[i] = polyhedron.FaceNormal(i);
+
+	for(int i = 0; i < NumHalfEdges(); ++i)
+	{
+		const int face = halfEdges[i].face;
+		const vec normal = faceNormals[face];
+		const vec origin = v[halfEdges[i].origin];
+
+		// The neighboring face bends away from this face at the edge if its vertex that follows the edge lies behind the
+		// plane of this face.
+		const int twin = halfEdges[i].twin;
+		if (Dot(normal, (vec)v[Destination(Next(twin))] - origin) > epsilon)
+			return false;
+
+		// The face is convex at the corner of the origin vertex if the next vertex does not lie to the right of the
+		// preceding edge, when looking against the face normal.
+		if (NumFaceVertices(face) > 3)
+		{
+			const vec edge = origin - (vec)v[halfEdges[Prev(i)].origin];
+			if (Dot(Cross(normal, edge), (vec)v[Destination(i)] - origin) < -epsilon * edge.Length())
+				return false;
+		}
+	}
+	return true;
+}
+
+std::vector<std::pair<int, int> > HalfEdgeMesh::EdgeIndices() const
+{
+	std::vector<std::pair<int, int> > edges;
+	edges.reserve(NumEdges());
+	for(int i = 0; i < NumHalfEdges(); ++i)
+		if (halfEdges[i].twin < i)
+		{
+			int a = halfEdges[i].origin;
+			int b = Destination(i);
+			edges.push_back(std::make_pair(Min(a, b), Max(a, b)));
+		}
+	std::sort(edges.begin(), edges.end());
+	// Duplicated half-edges in non-manifold meshes produce the same edge more than once.
+	edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+	return edges;
+}
+
+std::vector<std::vector<int> > HalfEdgeMesh::GenerateVertexAdjacencyData() const
+{
+	std::vector<std::vector<int> > adjacencyData(NumVertices());
+	for(int i = 0; i < NumVertices(); ++i)
+	{
+		adjacencyData[i].reserve(NumOutgoing(i));
+		for(int j = outgoingStart[i]; j < outgoingStart[i+1]; ++j)
+			adjacencyData[i].push_back(Destination(outgoing[j]));
+	}
+	return adjacencyData;
+}
+
+MATH_END_NAMESPACE
@@ -0,0 +1,142 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file HalfEdgeMesh.h
+	@author Jukka Jylanki
+	@brief The connectivity of a Polyhedron as a half-edge data structure. */
+#pragma once
+
+#include "../MathGeoLibFwd.h"
+#include "Polyhedron.h"
+
+#include <vector>
+#include <utility>
+
+MATH_BEGIN_NAMESPACE
+
+/// Stores the connectivity of the faces, edges and vertices of a Polyhedron for constant time neighbor queries.
+/** Each face of n vertices is split into n half-edges, which run along the boundary of the face in its winding order.
+	The half-edges of the face i are numbered consecutively in the order of the vertices of the face, starting from
+	FaceHalfEdge(i), so the half-edge k of the face runs from the vertex f[i].v[k] to the vertex f[i].v[(k+1)%n]. The
+	twin of a half-edge is the half-edge of the neighboring face that runs along the same edge in the opposite direction.
+	The Polyhedron functions IsClosed(), EdgeIndices() and GenerateVertexAdjacencyData() scan all faces to rediscover this
+	information each time. Build a HalfEdgeMesh once to answer the same queries repeatedly. The structure only stores
+	indices, so it stays valid when the vertices of the polyhedron move, but it must be rebuilt when the faces change.
+	@see Polyhedron. */
+class HalfEdgeMesh
+{
+public:
+	/// A directed edge along the boundary of a face.
+	struct HalfEdge
+	{
+		/// The index of the vertex this half-edge starts from.
+		int origin;
+		/// The index of the half-edge that runs along the same edge in the opposite direction, or -1 if no face uses the
+		/// edge in the opposite direction.
+		int twin;
+		/// The index of the face this half-edge belongs to.
+		int face;
+	};
+
+	/// Specifies the half-edges of all faces, one face after another.
+	std::vector<HalfEdge> halfEdges;
+
+	/// Specifies the index of the first half-edge of each face, followed by the total number of half-edges.
+	std::vector<int> faceHalfEdges;
+
+	/// The half-edges that start from the vertex i are outgoing[outgoingStart[i]] to outgoing[outgoingStart[i+1]-1].
+	std::vector<int> outgoingStart;
+	std::vector<int> outgoing;
+
+	/// The default constructor creates a mesh with no vertices and no faces.
+	HalfEdgeMesh();
+
+	/// Builds the half-edge structure of the given polyhedron.
+	/** The running time is linear to the number of half-edges, times the largest number of edges at a vertex. */
+	explicit HalfEdgeMesh(const Polyhedron &polyhedron);
+
+	/// Rebuilds the half-edge structure from the given polyhedron.
+	void Set(const Polyhedron &polyhedron);
+
+	int NumVertices() const { return (int)outgoingStart.size() - 1; }
+	int NumFaces() const { return (int)faceHalfEdges.size() - 1; }
+	int NumHalfEdges() const { return (int)halfEdges.size(); }
+
+	/// Returns the number of unique edges. An edge that two faces share is counted once.
+	int NumEdges() const;
+
+	/// Returns the index of the first half-edge of the given face.
+	int FaceHalfEdge(int faceIndex) const { return faceHalfEdges[faceIndex]; }
+
+	/// Returns the number of vertices, and half-edges, in the given face.
+	int NumFaceVertices(int faceIndex) const { return faceHalfEdges[faceIndex+1] - faceHalfEdges[faceIndex]; }
+
+	int Origin(int halfEdge) const { return halfEdges[halfEdge].origin; }
+	int Destination(int halfEdge) const { return halfEdges[Next(halfEdge)].origin; }
+	int Twin(int halfEdge) const { return halfEdges[halfEdge].twin; }
+	int Face(int halfEdge) const { return halfEdges[halfEdge].face; }
+
+	/// Returns the half-edge that follows the given half-edge on the boundary of its face.
+	int Next(int halfEdge) const
+	{
+		int face = halfEdges[halfEdge].face;
+		return halfEdge + 1 < faceHalfEdges[face+1] ? halfEdge + 1 : faceHalfEdges[face];
+	}
+
+	/// Returns the half-edge that precedes the given half-edge on the boundary of its face.
+	int Prev(int halfEdge) const
+	{
+		int face = halfEdges[halfEdge].face;
+		return halfEdge > faceHalfEdges[face] ? halfEdge - 1 : faceHalfEdges[face+1] - 1;
+	}
+
+	/// Returns the face on the other side of the edge of the given half-edge, or -1 if there is none.
+	int NeighborFace(int halfEdge) const { int twin = halfEdges[halfEdge].twin; return twin >= 0 ? halfEdges[twin].face : -1; }
+
+	/// Returns the number of half-edges that start from the given vertex.
+	int NumOutgoing(int vertexIndex) const { return outgoingStart[vertexIndex+1] - outgoingStart[vertexIndex]; }
+
+	/// Returns a pointer to the NumOutgoing(vertexIndex) indices of the half-edges that start from the given vertex.
+	const int *Outgoing(int vertexIndex) const { return &outgoing[0] + outgoingStart[vertexIndex]; }
+
+	/// Returns true if each half-edge has a twin, and no two half-edges run from the same vertex to the same vertex.
+	/** This is the same test as Polyhedron::IsClosed(), but runs in constant time. */
+	bool IsClosed() const { return numBoundaryHalfEdges == 0 && !hasDuplicateHalfEdges; }
+
+	/// Returns the number of half-edges that have no twin.
+	int NumBoundaryHalfEdges() const { return numBoundaryHalfEdges; }
+
+	/// Tests whether the given polyhedron, with the connectivity of this mesh, is convex.
+	/** Polyhedron::IsConvex() tests every vertex against every face, in O(V*F) time. This function tests only the local
+		convexity of each edge and of each face corner, in time linear to the number of half-edges: the mesh must be
+		closed, no vertex of a neighboring face may lie in front of the plane of a face, and each face must turn to the
+		same direction at each corner. This is equivalent to the global test unless the surface wraps around itself more
+		than once.
+		@param polyhedron The polyhedron this mesh was built from, or a transformed copy of it.
+		@param epsilon The distance a vertex may lie in front of a face plane. Polyhedron::IsConvex() uses 1e-2f. */
+	bool IsConvex(const Polyhedron &polyhedron, float epsilon = 1e-2f) const;
+
+	/// Returns the unique edges of the polyhedron as pairs of vertex indices (i, j) with i < j.
+	/** The edges are sorted in the same order as Polyhedron::EdgeIndices() returns them. */
+	std::vector<std::pair<int, int> > EdgeIndices() const;
+
+	/// Returns the same vertex adjacency structure as Polyhedron::GenerateVertexAdjacencyData().
+	std::vector<std::vector<int> > GenerateVertexAdjacencyData() const;
+
+private:
+	int numBoundaryHalfEdges;
+	bool hasDuplicateHalfEdges;
+};
+
+MATH_END_NAMESPACE
@@ -16,11 +16,15 @@
 	@author Jukka Jylnki
 	@brief Implementation for the Polyhedron geometry object. */
 #include "Polyhedron.h"
+#include "HalfEdgeMesh.h"
+#include <algorithm>
 #include <set>
 #include <map>
 #include <utility>
 #include <list>
+#include <queue>
 #include <sstream>
+#include <cmath>
 #include <stdlib.h>
 #include "../Math/assume.h"
 #include "../Math/MathFunc.h"
@@ -28,6 +32,7 @@
 #include "../Math/float3x4.h"
 #include "../Math/float4x4.h"
 #include "../Math/Quat.h"
+#include "../Math/simd.h"
 #include "AABB.h"
 #include "OBB.h"
 #include "Frustum.h"
@@ -40,18 +45,10 @@
 #include "Sphere.h"
 #include "Capsule.h"
 #include "../Algorithm/Random/LCG.h"
+#include "../Algorithm/ThreadPool.h"
+#include "../Algorithm/GJK.h"
 #include "../Time/Clock.h"
 
-#if __cplusplus > 199711L // Is C++11 or newer?
-#define HAS_UNORDERED_MAP
-#endif
-
-#ifdef HAS_UNORDERED_MAP
-#include <unordered_map>
-#else
-#include <map>
-#endif
-
 #ifdef MATH_GRAPHICSENGINE_INTEROP
 #include "VertexBuffer.h"
 #endif
@@ -617,38 +614,20 @@ void Polyhedron::FlipWindingOrder()
 
 bool Polyhedron::IsClosed() const
 {
-	std::set<std::pair<int, int> > uniqueEdges;
 	for(int i = 0; i < NumFaces(); ++i) // O(F)
 	{
 		if (f[i].v.empty())
 			continue;
 		assume1(FacePolygon(i).IsPlanar(), FacePolygon(i).SerializeToString());
 		assume(FacePolygon(i).IsSimple());
-		int x = f[i].v.back();
-		for(size_t j = 0; j < f[i].v.size(); ++j) // O(1)
-		{
-			int y = f[i].v[j];
-			if (uniqueEdges.find(std::make_pair(x, y)) != uniqueEdges.end()) // O(logE)
-			{
-				LOGW("The edge (%d,%d) is used twice. Polyhedron is not simple and closed!", x, y);
-				return false; // This edge is being used twice! Cannot be simple and closed.
-			}
-			uniqueEdges.insert(std::make_pair(x, y)); // O(logE)
-			x = y;
-		}
 	}
 
-	for(std::set<std::pair<int, int> >::iterator iter = uniqueEdges.begin();
-		iter != uniqueEdges.end(); ++iter)
+	HalfEdgeMesh mesh(*this);
+	if (!mesh.IsClosed())
 	{
-		std::pair<int, int> reverse = std::make_pair(iter->second, iter->first);
-		if (uniqueEdges.find(reverse) == uniqueEdges.end())
-		{
-			LOGW("The edge (%d,%d) does not exist. Polyhedron is not closed!", iter->second, iter->first);
-			return false;
-		}
+		LOGW("%d edges are used by one face only, or some edge is used twice. Polyhedron is not simple and closed!", mesh.NumBoundaryHalfEdges());
+		return false;
 	}
-
 	return true;
 }
 
@@ -1295,6 +1274,15 @@ bool Polyhedron::IntersectsConvex(const LineSegment &lineSegment) const
 	return ClipLineSegmentToConvexPolyhedron(lineSegment.a, lineSegment.b - lineSegment.a, tFirst, tLast);
 }
 
+bool Polyhedron::IntersectsConvex(const Polyhedron &polyhedron) const
+{
+	if (v.empty() || polyhedron.v.empty())
+		return false;
+	// Best: 25 usecs, against 136 msecs with Intersects(), for two hulls of 506 and 122 vertices. See the benchmark
+	// 'Polyhedron_IntersectsConvex_Polyhedron'.
+	return GJKIntersect(*this, polyhedron);
+}
+
 #if 0
 void Polyhedron::MergeConvex(const vec &point)
 {
@@ -1522,34 +1510,338 @@ void Polyhedron::MergeConvex(const vec &point)
 //	assert(IsConvex());
 }
 
+namespace
+{
+	/// A vertex created on an edge that crosses the clipping plane.
+	struct ClipEdgeVertex
+	{
+		int a, b; // The endpoints of the edge, a < b.
+		int index; // The index of the new vertex.
+	};
+
+	/// The temporary arrays of ClipConvexToPlane(). Clipping by several planes reuses the same storage.
+	struct ConvexClipScratch
+	{
+		std::vector<float> distances;
+		std::vector<int> newIndex;
+		std::vector<ClipEdgeVertex> edgeVertices;
+		std::vector<int> faceVertices;
+		std::vector<int> capNext;
+		VecArray newVertices;
+		/// Crossing points closer than this to an end of their edge are snapped to that vertex.
+		float snapDistance;
+	};
+
+	/// Returns the index of the vertex i in the clipped polyhedron, and adds the vertex when it is first used.
+	int ClipKeptVertex(const Polyhedron &p, ConvexClipScratch &s, int i)
+	{
+		if (s.newIndex[i] < 0)
+		{
+			s.newIndex[i] = (int)s.newVertices.size();
+			s.newVertices.push_back(p.v[i]);
+		}
+		return s.newIndex[i];
+	}
+
+	/// Returns the index of the vertex where the edge (a, b) crosses the plane, and adds the vertex when it is first used.
+	int ClipEdgeVertexIndex(const Polyhedron &p, ConvexClipScratch &s, int a, int b)
+	{
+		if (a > b)
+			Swap(a, b);
+		// Each crossing edge is visited by its two faces. There are few crossing edges, so a linear search is fast.
+		for(size_t i = 0; i < s.edgeVertices.size(); ++i)
+			if (s.edgeVertices[i].a == a && s.edgeVertices[i].b == b)
+				return s.edgeVertices[i].index;
+		const float t = s.distances[a] / (s.distances[a] - s.distances[b]);
+		const vec pt = p.v[a] + (p.v[b] - p.v[a]) * t;
+		// A crossing point right next to a vertex would leave a tiny edge in the clipped faces. Use the vertex instead,
+		// even if it lies just outside the plane.
+		ClipEdgeVertex e = { a, b, -1 };
+		if (pt.DistanceSq(p.v[a]) <= s.snapDistance * s.snapDistance)
+			e.index = ClipKeptVertex(p, s, a);
+		else if (pt.DistanceSq(p.v[b]) <= s.snapDistance * s.snapDistance)
+			e.index = ClipKeptVertex(p, s, b);
+		else
+		{
+			e.index = (int)s.newVertices.size();
+			s.newVertices.push_back(pt);
+		}
+		s.edgeVertices.push_back(e);
+		return e.index;
+	}
+
+	/// Appends the vertex to the face that is being clipped, unless it is already the last vertex of the face.
+	void ClipAddFaceVertex(ConvexClipScratch &s, int index)
+	{
+		if (s.faceVertices.empty() || s.faceVertices.back() != index)
+			s.faceVertices.push_back(index);
+	}
+
+	/// Clips the convex polyhedron p in place, keeping the part in the positive halfspace of the plane.
+	/** @return False if nothing was left of the polyhedron. */
+	bool ClipConvexToPlane(Polyhedron &p, const Plane &plane, ConvexClipScratch &s)
+	{
+		const int numVertices = p.NumVertices();
+		if (numVertices == 0)
+			return false;
+
+		// Classify the polyhedron first without storing the distances, so that a plane that does not cut it costs no
+		// allocations.
+		float minDistance = FLOAT_INF, maxDistance = -FLOAT_INF;
+		for(int i = 0; i < numVertices; ++i)
+		{
+			const float d = plane.SignedDistance(p.v[i]);
+			minDistance = Min(minDistance, d);
+			maxDistance = Max(maxDistance, d);
+		}
+		// Vertices within epsilon of the plane are treated as lying on it. They are kept, and bound the cap face.
+		const float maxAbsDistance = Max(Abs(minDistance), Abs(maxDistance));
+		const float epsilon = 1e-5f * maxAbsDistance;
+		s.snapDistance = 1e-5f * maxAbsDistance;
+		if (minDistance >= -epsilon) // No vertex is outside.
+			return true;
+		if (maxDistance <= epsilon) // No vertex is inside.
+		{
+			p.v.clear();
+			p.f.clear();
+			return false;
+		}
+
+		s.distances.resize(numVertices);
+		for(int i = 0; i < numVertices; ++i)
+		{
+			s.distances[i] = plane.SignedDistance(p.v[i]);
+			if (Abs(s.distances[i]) <= epsilon)
+				s.distances[i] = 0.f;
+		}
+
+		s.newIndex.assign(numVertices, -1);
+		s.edgeVertices.clear();
+		s.newVertices.clear();
+		s.capNext.clear();
+
+		// Clip each face polygon. Where a face leaves the kept side, it gets the new edge exit->entry along the plane. The
+		// cap face traverses the same edge in the opposite direction, so record entry->exit for it.
+		int numFaces = 0;
+		for(int i = 0; i < p.NumFaces(); ++i)
+		{
+			const std::vector<int> &face = p.f[i].v;
+			s.faceVertices.clear();
+			int exit = -1, entry = -1;
+			for(size_t j = 0, k = face.size() - 1; j < face.size(); k = j++)
+			{
+				const int a = face[k], b = face[j];
+				const float da = s.distances[a], db = s.distances[b];
+				if (db >= 0.f)
+				{
+					if (da < 0.f)
+					{
+						entry = (db == 0.f) ? ClipKeptVertex(p, s, b) : ClipEdgeVertexIndex(p, s, a, b);
+						ClipAddFaceVertex(s, entry);
+					}
+					ClipAddFaceVertex(s, ClipKeptVertex(p, s, b));
+				}
+				else if (da >= 0.f)
+				{
+					exit = (da == 0.f) ? ClipKeptVertex(p, s, a) : ClipEdgeVertexIndex(p, s, a, b);
+					ClipAddFaceVertex(s, exit);
+				}
+			}
+			while(s.faceVertices.size() > 1 && s.faceVertices.back() == s.faceVertices.front())
+				s.faceVertices.pop_back();
+			if (exit >= 0 && entry >= 0 && exit != entry)
+			{
+				if ((int)s.capNext.size() <= Max(exit, entry))
+					s.capNext.resize(Max(exit, entry) + 1, -1);
+				s.capNext[entry] = exit;
+			}
+			// A face that touches the plane only at a vertex or an edge is removed.
+			if (s.faceVertices.size() >= 3)
+				p.f[numFaces++].v.assign(s.faceVertices.begin(), s.faceVertices.end());
+		}
+
+		// Walk the loop of the cap face.
+		s.faceVertices.clear();
+		int start = 0;
+		while(start < (int)s.capNext.size() && s.capNext[start] < 0)
+			++start;
+		if (start < (int)s.capNext.size())
+		{
+			int cur = start;
+			do
+			{
+				s.faceVertices.push_back(cur);
+				cur = (cur < (int)s.capNext.size()) ? s.capNext[cur] : -1;
+			} while(cur >= 0 && cur != start && s.faceVertices.size() <= s.newVertices.size());
+			if (cur != start)
+				s.faceVertices.clear();
+		}
+
+		// The old vertex array becomes the scratch array of the next clip.
+		p.v.swap(s.newVertices);
+		if (s.faceVertices.size() < 3)
+		{
+			// The crossing edges did not form a single loop, because of vertices very close to the plane. Fall back to
+			// the hull of the clipped vertices.
+			p = Polyhedron::ConvexHull(p.v);
+			return !p.v.empty();
+		}
+		p.f.resize(numFaces + 1);
+		p.f[numFaces].v.assign(s.faceVertices.begin(), s.faceVertices.end());
+		return true;
+	}
+}
+
+bool Polyhedron::ClipConvex(const Plane &plane)
+{
+	ConvexClipScratch scratch;
+	return ClipConvexToPlane(*this, plane, scratch);
+}
+
+bool Polyhedron::ClipConvex(const Polyhedron &convexPolyhedron)
+{
+	if (&convexPolyhedron == this)
+		return !v.empty();
+
+	// Faces with less than three vertices do not define a plane, and are skipped. A clipping polyhedron without any
+	// proper face bounds no volume, so nothing is left.
+	int firstFace = 0;
+	while(firstFace < convexPolyhedron.NumFaces() && convexPolyhedron.f[firstFace].v.size() < 3)
+		++firstFace;
+	if (convexPolyhedron.v.empty() || firstFace == convexPolyhedron.NumFaces())
+	{
+		v.clear();
+		f.clear();
+		return false;
+	}
+
+	// The faces of the clipping polyhedron may be wound either way. Find the vertex farthest from the plane of the first
+	// face to see which side of its face planes the polyhedron lies on.
+	const Plane firstPlane(convexPolyhedron.v[convexPolyhedron.f[firstFace].v[0]], convexPolyhedron.FaceNormal(firstFace));
+	float farthest = 0.f;
+	for(int i = 0; i < convexPolyhedron.NumVertices(); ++i)
+	{
+		float d = firstPlane.SignedDistance(convexPolyhedron.v[i]);
+		if (Abs(d) > Abs(farthest))
+			farthest = d;
+	}
+	const bool outwardNormals = (farthest <= 0.f);
+
+	ConvexClipScratch scratch;
+	for(int i = firstFace; i < convexPolyhedron.NumFaces(); ++i)
+	{
+		if (convexPolyhedron.f[i].v.size() < 3)
+			continue;
+		// FaceNormal() is more accurate than FacePlane() for faces with many vertices, like the caps of clipped polyhedra.
+		Plane plane(convexPolyhedron.v[convexPolyhedron.f[i].v[0]], convexPolyhedron.FaceNormal(i));
+		if (outwardNormals)
+			plane.ReverseNormal();
+		if (!ClipConvexToPlane(*this, plane, scratch))
+			return false;
+	}
+	return true;
+}
+
 void Polyhedron::Translate(const vec &offset)
 {
 	for(size_t i = 0; i < v.size(); ++i)
 		v[i] = (vec)v[i] + offset;
 }
 
+namespace
+{
+	/// Computes dst[i] = transform * src[i] for the points i in [0, numPoints[. The arrays may be the same.
+	/** With SSE, the points are processed four at a time: they are transposed to one register per coordinate, so that
+		each output coordinate is three multiply-adds against the broadcast matrix elements, and then transposed back.
+		The fourth component of a point is passed through unchanged. */
+	void BatchTransformPos(const float3x4 &transform, const vec *src, vec *dst, int numPoints)
+	{
+		int i = 0;
+#if defined(MATH_AUTOMATIC_SSE) && defined(MATH_SSE)
+		const simd4f m00 = set1_ps(transform[0][0]), m01 = set1_ps(transform[0][1]), m02 = set1_ps(transform[0][2]), m03 = set1_ps(transform[0][3]);
+		const simd4f m10 = set1_ps(transform[1][0]), m11 = set1_ps(transform[1][1]), m12 = set1_ps(transform[1][2]), m13 = set1_ps(transform[1][3]);
+		const simd4f m20 = set1_ps(transform[2][0]), m21 = set1_ps(transform[2][1]), m22 = set1_ps(transform[2][2]), m23 = set1_ps(transform[2][3]);
+		for(; i + 4 <= numPoints; i += 4)
+		{
+			simd4f x = src[i].v, y = src[i+1].v, z = src[i+2].v, w = src[i+3].v;
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+			simd4f tx = madd_ps(m02, z, madd_ps(m01, y, madd_ps(m00, x, m03)));
+			simd4f ty = madd_ps(m12, z, madd_ps(m11, y, madd_ps(m10, x, m13)));
+			simd4f tz = madd_ps(m22, z, madd_ps(m21, y, madd_ps(m20, x, m23)));
+			_MM_TRANSPOSE4_PS(tx, ty, tz, w);
+			dst[i].v = tx;
+			dst[i+1].v = ty;
+			dst[i+2].v = tz;
+			dst[i+3].v = w;
+		}
+#endif
+		for(; i < numPoints; ++i)
+			dst[i] = transform.MulPos(src[i]);
+	}
+}
+
 void Polyhedron::Transform(const float3x3 &transform)
 {
-	if (!v.empty())
-		transform.BatchTransform((vec*)&v[0], (int)v.size());
+	TransformTo(transform, *this);
 }
 
 void Polyhedron::Transform(const float3x4 &transform)
 {
-	if (!v.empty())
-		transform.BatchTransformPos((vec*)&v[0], (int)v.size());
+	TransformTo(transform, *this);
 }
 
 void Polyhedron::Transform(const float4x4 &transform)
 {
-	for(size_t i = 0; i < v.size(); ++i)
-		v[i] = transform.MulPos(v[i]); ///\todo Add float4x4::BatchTransformPos.
+	TransformTo(transform, *this);
 }
 
 void Polyhedron::Transform(const Quat &transform)
 {
+	TransformTo(transform, *this);
+}
+
+void Polyhedron::TransformTo(const float3x3 &transform, Polyhedron &outPolyhedron) const
+{
+	TransformTo(float3x4(transform), outPolyhedron);
+}
+
+void Polyhedron::TransformTo(const float3x4 &transform, Polyhedron &outPolyhedron) const
+{
+	// Best: 1.351 usecs / 2702.78 ticks in-place for 1000 vertices, against 2.523 usecs with a per-vertex
+	// float3x4::MulPos() and 2.415 usecs with a per-vertex Quat multiply. See the benchmarks 'Polyhedron_Transform_float3x4'
+	// and 'Polyhedron_Transform_Quat'.
+	if (&outPolyhedron != this)
+	{
+		// Assigning to the existing vectors reuses their storage, so a destination that is used repeatedly
+		// stops allocating once it has grown to the size of the source.
+		outPolyhedron.v.resize(v.size());
+		outPolyhedron.f = f;
+	}
+	if (!v.empty())
+		BatchTransformPos(transform, &v[0], &outPolyhedron.v[0], (int)v.size());
+}
+
+void Polyhedron::TransformTo(const float4x4 &transform, Polyhedron &outPolyhedron) const
+{
+	// An affine matrix takes the batched path. Compare exactly, so that the results do not change for matrices with
+	// a tiny projective part.
+	if (transform[3][0] == 0.f && transform[3][1] == 0.f && transform[3][2] == 0.f && transform[3][3] == 1.f)
+	{
+		TransformTo(transform.Float3x4Part(), outPolyhedron);
+		return;
+	}
+	if (&outPolyhedron != this)
+	{
+		outPolyhedron.v.resize(v.size());
+		outPolyhedron.f = f;
+	}
 	for(size_t i = 0; i < v.size(); ++i)
-		v[i] = transform * v[i];
+		outPolyhedron.v[i] = transform.MulPos(v[i]);
+}
+
+void Polyhedron::TransformTo(const Quat &transform, Polyhedron &outPolyhedron) const
+{
+	TransformTo(float3x4(transform), outPolyhedron);
 }
 
 void Polyhedron::OrientNormalsOutsideConvex()
@@ -1581,17 +1873,6 @@ struct CHullHelp
 	std::list<int> livePlanes;
 };
 
-namespace
-{
-	struct hash_edge
-	{
-		size_t operator()(const std::pair<int, int> &e) const
-		{
-			return (e.first << 16) ^ e.second;
-		}
-	};
-}
-
 #if 0
 static bool ContainsAndRemove(std::vector<int> &arr, int val)
 {
@@ -1620,645 +1901,989 @@ Polyhedron Polyhedron::ConvexHull(const vec *pointArray, int numPoints)
 	return ConvexHull(pointArray, numPoints, rng);
 }
 
-//#define CONVEXHULL_VERBOSE
-#ifdef CONVEXHULL_VERBOSE
-#define C_LOG LOGI
-#else
-#define C_LOG(...) ((void)0)
-#endif
-
-//struct Tri { int v[3]; int faceIndex; };
-
-Polyhedron Polyhedron::ConvexHull(const vec *pointArray, int numPoints, LCG &rng)
+namespace
 {
-	C_LOG("RNG seed: %d", rng.lastNumber);
-	std::set<int> extremes;
-
-	Polyhedron p;
+	/// A triangle of the convex hull under construction.
+	struct HullFace
+	{
+		// The plane of the face is nx*x + ny*y + nz*z = d.
+		cs nx, ny, nz, d;
+		// The edge j runs from the vertex v[j] to the vertex v[(j+1)%3], and adj[j] is the face on the other side of it.
+		int v[3];
+		int adj[3];
+		// The points in front of this face are in the range [conflictBegin, conflictEnd) of the conflict pool.
+		int conflictBegin, conflictEnd;
+		// The point in front of this face that is farthest from it.
+		int farthest;
+		cs farthestDistance;
+		int visited;
+		bool alive;
+
+		int NumConflicts() const { return conflictEnd - conflictBegin; }
+	};
 
-	const cv dirs[] =
+	struct HullPoint
 	{
-		cv(-1, -1, -1, 0),
-		cv(1, 0, 0, 0),
-		cv(0, 1, 0, 0),
-		cv(0, 0, 1, 0),
+		cs x, y, z;
+	};
 
-		cv(1, 1, 0, 0), cv(1, 0, 1, 0), cv(0, 1, 1, 0),
-		cv(1, -1, 0, 0), cv(1, 0, -1, 0), cv(0, 1, -1, 0),
-		cv(1, 1, 1, 0), cv(-1, 1, 1, 0), cv(1, -1, 1, 0),
-		cv(1, 1, -1, 0)
+	/// An edge of the boundary of the set of faces a point sees, and the face on the other side of it.
+	struct HorizonEdge
+	{
+		int v0, v1;
+		int face; // The face that does not see the point.
+		int edge; // The index of the edge v1->v0 in that face.
 	};
 
-	for(size_t i = 0; i < ARRAY_LENGTH(dirs) && extremes.size() < 4; ++i)
+	/// Computes the signed distances of the points (x[i], y[i], z[i]), i = 0, ..., n-1, to the plane
+	/// nx*x + ny*y + nz*z = d.
+	void HullPlaneDistances(const cs *x, const cs *y, const cs *z, int n, cs nx, cs ny, cs nz, cs d, cs *outDistances)
 	{
-		int extremeI = 0;
-		cs largestD = -FLOAT_INF;
-		for(int j = 0; j < numPoints; ++j)
+		int i = 0;
+#if defined(MATH_CONVEXHULL_DOUBLE_PRECISION) && defined(MATH_AVX)
+		const __m256d vnx = _mm256_set1_pd(nx);
+		const __m256d vny = _mm256_set1_pd(ny);
+		const __m256d vnz = _mm256_set1_pd(nz);
+		const __m256d vd = _mm256_set1_pd(d);
+		for(; i + 4 <= n; i += 4)
 		{
-			cs d = dirs[i].Dot(DIR_TO_FLOAT4(pointArray[j]));
-			if (d > largestD)
-			{
-				largestD = d;
-				extremeI = j;
-			}
+			__m256d dist = _mm256_add_pd(_mm256_mul_pd(vnx, _mm256_loadu_pd(x + i)), _mm256_mul_pd(vny, _mm256_loadu_pd(y + i)));
+			dist = _mm256_add_pd(dist, _mm256_mul_pd(vnz, _mm256_loadu_pd(z + i)));
+			_mm256_storeu_pd(outDistances + i, _mm256_sub_pd(dist, vd));
+		}
+#elif defined(MATH_CONVEXHULL_DOUBLE_PRECISION) && defined(MATH_SSE2)
+		const simd2d vnx = set1_pd(nx);
+		const simd2d vny = set1_pd(ny);
+		const simd2d vnz = set1_pd(nz);
+		const simd2d vd = set1_pd(d);
+		for(; i + 2 <= n; i += 2)
+		{
+			simd2d dist = add_pd(mul_pd(vnx, loadu_pd(x + i)), mul_pd(vny, loadu_pd(y + i)));
+			dist = add_pd(dist, mul_pd(vnz, loadu_pd(z + i)));
+			storeu_pd(outDistances + i, sub_pd(dist, vd));
 		}
-		extremes.insert(extremeI);
+#endif
+		for(; i < n; ++i)
+			outDistances[i] = nx*x[i] + ny*y[i] + nz*z[i] - d;
 	}
 
-//	assume(extremes.size() >= 3);
-	if (extremes.size() < 3)
-		return p; // This might happen if there's NaNs in the vertex data, or duplicates.
+	/// Computes the convex hull of a point set with the Quickhull algorithm.
+	/** See C. Barber, D. Dobkin, H. Huhdanpaa, The Quickhull Algorithm for Convex Hulls, 1996.
+		The points in front of the faces are kept in structure-of-arrays form, so that the distances of many points to a
+		plane are computed with SIMD. Each point outside the hull is assigned to the one face it is farthest in front of,
+		and each step adds the farthest point of a face to the hull. */
+	class QuickHull
+	{
+	public:
+		QuickHull(const vec *pointArray, int numPoints);
+
+		/// Returns the number of dimensions the input points span: 3 if they have a volume, 2 if they are planar, 1 if
+		/// they are collinear and 0 if they are all the same point. Finds the initial simplex of that dimension.
+		int FindInitialSimplex();
+
+		/// Returns the convex hull of a point set that has a volume.
+		Polyhedron VolumeHull(LCG &rng);
 
-	// Handle degenerate case when the predefined directions did not find a nonzero volume.
-	if (extremes.size() == 3)
+		/// Returns the convex hull of a planar point set, as a polygon that has a face on both sides.
+		Polyhedron PlanarHull() const;
+
+		/// Tests whether the point q lies to the left of the line from o through p, by more than the epsilon.
+		bool IsLeftTurn(const std::pair<cs, cs> &o, const std::pair<cs, cs> &p, const std::pair<cs, cs> &q) const
+		{
+			const cs pX = p.first - o.first, pY = p.second - o.second;
+			const cs turn = pX * (q.second - o.second) - pY * (q.first - o.first);
+			return turn > 0 && turn*turn > epsilon*epsilon * (pX*pX + pY*pY);
+		}
+
+	private:
+		const vec *points;
+		int numPoints;
+		// The coordinates of the input points, in structure-of-arrays form for the passes over all points, and as
+		// triplets for accessing single points.
+		std::vector<cs> x, y, z;
+		std::vector<HullPoint> pointXYZ;
+		// Points closer than this to a face plane are considered to lie on the plane. The input coordinates are single
+		// precision, so this is proportional to their rounding error.
+		cs epsilon;
+		// The vertices of the initial simplex.
+		int simplex[4];
+
+		std::vector<HullFace> faces;
+		std::vector<int> freeFaces;
+
+		// The points in front of the faces. The points of the new faces of each step are appended to the end of the
+		// pool, and the pool is compacted when most of it belongs to removed faces.
+		std::vector<int> poolIndex;
+		std::vector<cs> poolX, poolY, poolZ;
+		int numLiveConflicts;
+
+		// Work arrays of each step.
+		struct SearchEntry { int face, edge, numEdges; };
+		std::vector<SearchEntry> searchStack;
+		std::vector<int> vertexVisited;
+		int visitColor;
+		std::vector<int> visibleFaces;
+		std::vector<HorizonEdge> horizon;
+		std::vector<int> newFaces;
+		std::vector<int> orphans;
+		std::vector<cs> orphanX, orphanY, orphanZ;
+		std::vector<cs> distances, bestDistance;
+		std::vector<int> bestFace;
+		std::vector<int> faceCounts;
+
+		void TrianglePlane(int v0, int v1, int v2, cs &outNX, cs &outNY, cs &outNZ, cs &outD) const;
+		cs Distance(const HullFace &face, int point) const { return face.nx*pointXYZ[point].x + face.ny*pointXYZ[point].y + face.nz*pointXYZ[point].z - face.d; }
+		int AddFace(int v0, int v1, int v2);
+		void AssignPoints(const int *indices, const cs *px, const cs *py, const cs *pz, int count);
+		void CompactConflictPool();
+		bool IsVisible(const HullFace &face, int edge, int eye) const;
+		bool FindHorizon(int face, int eye);
+		void AddPoint(int eye);
+		void RemoveConflict(int face, int point);
+		Polyhedron ToPolyhedron() const;
+	};
+
+	QuickHull::QuickHull(const vec *pointArray, int numPoints)
+	:points(pointArray), numPoints(numPoints), numLiveConflicts(0), visitColor(0)
 	{
-		std::set<int>::iterator iter = extremes.begin();
-		int v0 = *iter++;
-		int v1 = *iter++;
-		int v2 = *iter;
-		Plane plane(pointArray[v0], pointArray[v1], pointArray[v2]);
+		x.resize(numPoints);
+		y.resize(numPoints);
+		z.resize(numPoints);
+		pointXYZ.resize(numPoints);
+		vertexVisited.resize(numPoints);
+		cs maxX = 0, maxY = 0, maxZ = 0;
 		for(int i = 0; i < numPoints; ++i)
 		{
-			if (!plane.Contains(pointArray[i]))
-				extremes.insert(i);
-			if (extremes.size() >= 4)
-				break;
+			x[i] = pointXYZ[i].x = pointArray[i].x;
+			y[i] = pointXYZ[i].y = pointArray[i].y;
+			z[i] = pointXYZ[i].z = pointArray[i].z;
+			maxX = Max(maxX, Abs(x[i]));
+			maxY = Max(maxY, Abs(y[i]));
+			maxZ = Max(maxZ, Abs(z[i]));
 		}
+		epsilon = (cs)3 * (cs)FLT_EPSILON * (maxX + maxY + maxZ);
+	}
 
-		// The degenerate case when all vertices in the input data set are planar.
-		if (extremes.size() == 3)
+	int QuickHull::FindInitialSimplex()
+	{
+		const cs dirs[14][3] =
+		{
+			{ -1, -1, -1 }, { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 },
+			{ 1, 1, 0 }, { 1, 0, 1 }, { 0, 1, 1 },
+			{ 1, -1, 0 }, { 1, 0, -1 }, { 0, 1, -1 },
+			{ 1, 1, 1 }, { -1, 1, 1 }, { 1, -1, 1 },
+			{ 1, 1, -1 }
+		};
+
+		// The extreme points along fixed directions are good candidates for the first edge of the simplex.
+		int extremes[2*ARRAY_LENGTH(dirs)];
+		for(size_t i = 0; i < ARRAY_LENGTH(dirs); ++i)
 		{
-			p.v.push_back(pointArray[v0]);
-			p.v.push_back(pointArray[v1]);
-			p.v.push_back(pointArray[v2]);
+			cs minD = FLOAT_INF, maxD = -FLOAT_INF;
+			int minI = 0, maxI = 0;
+			for(int j = 0; j < numPoints; ++j)
+			{
+				cs dist = dirs[i][0]*x[j] + dirs[i][1]*y[j] + dirs[i][2]*z[j];
+				if (dist < minD) { minD = dist; minI = j; }
+				if (dist > maxD) { maxD = dist; maxI = j; }
+			}
+			extremes[2*i] = minI;
+			extremes[2*i+1] = maxI;
+		}
 
-			Face f;
-			f.v.push_back(0);
-			f.v.push_back(1);
-			f.v.push_back(2);
-			p.f.push_back(f);
-			f.v[0] = 2;
-			f.v[2] = 0;
-			p.f.push_back(f);
-			return p;
+		cs maxDistSq = 0;
+		simplex[0] = simplex[1] = 0;
+		for(size_t i = 0; i < ARRAY_LENGTH(extremes); ++i)
+			for(size_t j = i+1; j < ARRAY_LENGTH(extremes); ++j)
+			{
+				int a = extremes[i], b = extremes[j];
+				cs distSq = (x[a]-x[b])*(x[a]-x[b]) + (y[a]-y[b])*(y[a]-y[b]) + (z[a]-z[b])*(z[a]-z[b]);
+				if (distSq > maxDistSq)
+				{
+					maxDistSq = distSq;
+					simplex[0] = a;
+					simplex[1] = b;
+				}
+			}
+		if (maxDistSq <= epsilon*epsilon)
+			return 0;
+
+		// The third vertex is the point farthest from the line through the first two.
+		const int a = simplex[0], b = simplex[1];
+		const cs abX = x[b]-x[a], abY = y[b]-y[a], abZ = z[b]-z[a];
+		cs maxAreaSq = 0;
+		simplex[2] = a;
+		for(int i = 0; i < numPoints; ++i)
+		{
+			cs apX = x[i]-x[a], apY = y[i]-y[a], apZ = z[i]-z[a];
+			cs cX = abY*apZ - abZ*apY, cY = abZ*apX - abX*apZ, cZ = abX*apY - abY*apX;
+			cs areaSq = cX*cX + cY*cY + cZ*cZ;
+			if (areaSq > maxAreaSq)
+			{
+				maxAreaSq = areaSq;
+				simplex[2] = i;
+			}
 		}
+		if (maxAreaSq <= epsilon*epsilon*maxDistSq) // The distance from the line is |ab x ap| / |ab|.
+			return 1;
+
+		// The fourth vertex is the point farthest from the plane of the first three.
+		simplex[3] = simplex[2];
+		cs planeNX, planeNY, planeNZ, planeD;
+		TrianglePlane(simplex[0], simplex[1], simplex[2], planeNX, planeNY, planeNZ, planeD);
+		distances.resize(numPoints);
+		HullPlaneDistances(&x[0], &y[0], &z[0], numPoints, planeNX, planeNY, planeNZ, planeD, &distances[0]);
+		cs maxDist = 0;
+		for(int i = 0; i < numPoints; ++i)
+			if (Abs(distances[i]) > maxDist)
+			{
+				maxDist = Abs(distances[i]);
+				simplex[3] = i;
+			}
+		return maxDist > epsilon ? 3 : 2;
 	}
 
-	p.v.insert(p.v.end(), pointArray, pointArray + numPoints);
-
+	void QuickHull::TrianglePlane(int v0, int v1, int v2, cs &outNX, cs &outNY, cs &outNZ, cs &outD) const
 	{
-		std::set<int>::iterator iter = extremes.begin();
-		int v0 = *iter; ++iter;
-		int v1 = *iter; ++iter;
-		int v2 = *iter; ++iter;
-		int v3 = *iter;
-		assert(v0 < v1 && v1 < v2 && v2 < v3);
-		Swap(p.v[0], p.v[v0]);
-		Swap(p.v[1], p.v[v1]);
-		Swap(p.v[2], p.v[v2]);
-		Swap(p.v[3], p.v[v3]);
+		const HullPoint &a = pointXYZ[v0], &b = pointXYZ[v1], &c = pointXYZ[v2];
+		const cs e1X = b.x-a.x, e1Y = b.y-a.y, e1Z = b.z-a.z;
+		const cs e2X = c.x-a.x, e2Y = c.y-a.y, e2Z = c.z-a.z;
+		cs normalX = e1Y*e2Z - e1Z*e2Y, normalY = e1Z*e2X - e1X*e2Z, normalZ = e1X*e2Y - e1Y*e2X;
+		cs length = Sqrt(normalX*normalX + normalY*normalY + normalZ*normalZ);
+		// A face with collinear vertices gets a zero normal, so that no point is ever in front of it.
+		cs invLength = length > 0 ? (cs)1 / length : (cs)0;
+		outNX = normalX * invLength;
+		outNY = normalY * invLength;
+		outNZ = normalZ * invLength;
+		outD = outNX*a.x + outNY*a.y + outNZ*a.z;
 	}
 
-	// If the initial tetrahedron has zero volume, the whole input set is planar.
-	// In that case, we should solve a 2D convex hull problem.
-	cs volume = Abs((cv(DIR_TO_FLOAT4(p.v[0])) - cv(DIR_TO_FLOAT4(p.v[3]))).Dot((cv(DIR_TO_FLOAT4(p.v[1])) - cv(DIR_TO_FLOAT4(p.v[3]))).Cross(cv(DIR_TO_FLOAT4(p.v[2])) - cv(DIR_TO_FLOAT4(p.v[3]))))); // / 6.f; Div by six is not relevant here.
-	if (volume < 1e-6f)
+	int QuickHull::AddFace(int v0, int v1, int v2)
 	{
-		// TODO: Do 2D convex hull.
-		p.v.clear();
-		p.f.clear();
-		return p;
+		int face;
+		if (!freeFaces.empty())
+		{
+			face = freeFaces.back();
+			freeFaces.pop_back();
+		}
+		else
+		{
+			face = (int)faces.size();
+			faces.push_back(HullFace());
+			faces.back().visited = 0;
+		}
+		HullFace &f = faces[face];
+		TrianglePlane(v0, v1, v2, f.nx, f.ny, f.nz, f.d);
+		f.v[0] = v0; f.v[1] = v1; f.v[2] = v2;
+		f.adj[0] = f.adj[1] = f.adj[2] = -1;
+		f.conflictBegin = f.conflictEnd = 0;
+		f.farthest = -1;
+		f.farthestDistance = 0;
+		f.alive = true;
+		newFaces.push_back(face);
+		return face;
 	}
-	// For each face, maintain a list of its adjacent faces.
-//	std::vector<std::vector<int> > faceAdjacency(4);
-	// For each face, precompute its normal vector.
-	VecdArray faceNormals(4);
-
-	Face face;
-	face.v.resize(3);
-	face.v[0] = 0; face.v[1] = 1; face.v[2] = 2; p.f.push_back(face);
-	face.v[0] = 0; face.v[1] = 1; face.v[2] = 3; p.f.push_back(face);
-	face.v[0] = 0; face.v[1] = 2; face.v[2] = 3; p.f.push_back(face);
-	face.v[0] = 1; face.v[1] = 2; face.v[2] = 3; p.f.push_back(face);
-
-	// Ensure that the winding order of the generated tetrahedron is correct for each face.
-	if (p.FacePlane(0).SignedDistance(p.v[3]) > 0.f) p.f[0].FlipWindingOrder();
-	if (p.FacePlane(1).SignedDistance(p.v[2]) > 0.f) p.f[1].FlipWindingOrder();
-	if (p.FacePlane(2).SignedDistance(p.v[1]) > 0.f) p.f[2].FlipWindingOrder();
-	if (p.FacePlane(3).SignedDistance(p.v[0]) > 0.f) p.f[3].FlipWindingOrder();
-
-	assert(p.IsClosed());
-	assert(p.FaceIndicesValid());
-	assert(p.FacesAreNondegeneratePlanar());
-
-#ifdef CONVEXHULL_VERBOSE
-	p.DumpStructure();
-#endif
 
-//	faceAdjacency[0].push_back(1); faceAdjacency[0].push_back(2); faceAdjacency[0].push_back(3);
-//	faceAdjacency[1].push_back(2); faceAdjacency[1].push_back(3); faceAdjacency[1].push_back(0);
-//	faceAdjacency[2].push_back(1); faceAdjacency[2].push_back(3); faceAdjacency[2].push_back(0);
-//	faceAdjacency[3].push_back(1); faceAdjacency[3].push_back(2); faceAdjacency[3].push_back(0);
-	faceNormals[0] = cv(DIR_TO_FLOAT4(p.FaceNormal(0)));
-	faceNormals[1] = cv(DIR_TO_FLOAT4(p.FaceNormal(1)));
-	faceNormals[2] = cv(DIR_TO_FLOAT4(p.FaceNormal(2)));
-	faceNormals[3] = cv(DIR_TO_FLOAT4(p.FaceNormal(3)));
-
-#ifdef HAS_UNORDERED_MAP
-	std::unordered_map<std::pair<int, int>, int, hash_edge> edgesToFaces;
-#else
-	std::map<std::pair<int, int>, int> edgesToFaces;
-#endif
-	for(size_t i = 0; i < p.f.size(); ++i)
+	void QuickHull::AssignPoints(const int *indices, const cs *px, const cs *py, const cs *pz, int count)
 	{
-		const Polyhedron::Face &f = p.f[i];
-		int v0 = f.v.back();
-		for(size_t j = 0; j < f.v.size(); ++j)
+		if (count == 0)
+			return;
+		const int numNewFaces = (int)newFaces.size();
+		distances.resize(count);
+		bestDistance.assign(count, epsilon);
+		bestFace.assign(count, -1);
+		for(int i = 0; i < numNewFaces; ++i)
 		{
-			int v1 = f.v[j];
-			edgesToFaces[std::make_pair(v0, v1)] = (int)i;
-			v0 = v1;
+			const HullFace &f = faces[newFaces[i]];
+			HullPlaneDistances(px, py, pz, count, f.nx, f.ny, f.nz, f.d, &distances[0]);
+			for(int j = 0; j < count; ++j)
+				if (distances[j] > bestDistance[j])
+				{
+					bestDistance[j] = distances[j];
+					bestFace[j] = i;
+				}
 		}
-	}
-
-	// If a vertex of the input point set is on the positive side of a face of the partially built convex hull, we
-	// call the vertex to be in conflict with that face, because due to the position of that vertex, the given face cannot
-	// be a face of the final convex hull.
-
-	// For each face of the partial convex hull, maintain a 'conflict list'.
-	// The conflict list represents for each face of the so far built convex hull the list of vertices that conflict
-	// with that face. The list is not complete in the sense that a vertex is only listed with one (arbitrary) face that it
-	// conflicts with, and not all of them.
-	std::vector<std::vector<int> > conflictList(p.f.size());
 
-	// For each vertex, maintain a conflict list of faces as well.
-	std::vector<std::set<int> > conflictListVertices(p.v.size());
+		// Sort the points by their face with a counting sort, so that the points of each face are consecutive in the
+		// pool. The points that are not in front of any new face are inside the hull, and are dropped.
+		faceCounts.assign(numNewFaces + 1, 0);
+		for(int j = 0; j < count; ++j)
+			if (bestFace[j] >= 0)
+				++faceCounts[bestFace[j] + 1];
+		for(int i = 0; i < numNewFaces; ++i)
+			faceCounts[i+1] += faceCounts[i];
+		const int numAssigned = faceCounts[numNewFaces];
+		if (numAssigned == 0)
+			return;
 
-#ifdef MATH_CONVEXHULL_DOUBLE_PRECISION
-	const double inPlaneEpsilon = 1e-5;
-#else
-	const float inPlaneEpsilon = 1e-4f;
-#endif
+		if ((int)poolIndex.size() > 2 * numLiveConflicts + 1024)
+			CompactConflictPool();
+		const int poolSize = (int)poolIndex.size();
+		poolIndex.resize(poolSize + numAssigned);
+		poolX.resize(poolSize + numAssigned);
+		poolY.resize(poolSize + numAssigned);
+		poolZ.resize(poolSize + numAssigned);
+		for(int i = 0; i < numNewFaces; ++i)
+			faces[newFaces[i]].conflictBegin = faces[newFaces[i]].conflictEnd = poolSize + faceCounts[i];
+		for(int j = 0; j < count; ++j)
+		{
+			if (bestFace[j] < 0)
+				continue;
+			HullFace &f = faces[newFaces[bestFace[j]]];
+			const int k = f.conflictEnd++;
+			poolIndex[k] = indices[j];
+			poolX[k] = px[j];
+			poolY[k] = py[j];
+			poolZ[k] = pz[j];
+			if (bestDistance[j] > f.farthestDistance)
+			{
+				f.farthestDistance = bestDistance[j];
+				f.farthest = indices[j];
+			}
+		}
+		numLiveConflicts += numAssigned;
+	}
 
-	// Assign each remaining vertex (vertices 0-3 form the initial hull) to the initial conflict lists.
-	for(size_t j = 0; j < p.f.size(); ++j)
+	void QuickHull::CompactConflictPool()
 	{
-		cv pointOnFace = POINT_TO_FLOAT4(p.v[p.f[j].v[0]]);
-		for(size_t i = 4; i < p.v.size(); ++i)
+		std::vector<int> newIndex(numLiveConflicts);
+		std::vector<cs> newX(numLiveConflicts), newY(numLiveConflicts), newZ(numLiveConflicts);
+		int n = 0;
+		for(size_t i = 0; i < faces.size(); ++i)
 		{
-			cs d = cv(faceNormals[j]).Dot(cv(POINT_TO_FLOAT4(p.v[i])) - pointOnFace);
-			if (d > inPlaneEpsilon)
+			HullFace &f = faces[i];
+			const int begin = f.conflictBegin, end = f.conflictEnd;
+			f.conflictBegin = n;
+			for(int k = begin; k < end; ++k, ++n)
 			{
-				conflictList[j].push_back((int)i);
-				conflictListVertices[i].insert((int)j);
-				C_LOG("Vertex %d and face %d are in conflict.", (int)i, (int)j);
+				newIndex[n] = poolIndex[k];
+				newX[n] = poolX[k];
+				newY[n] = poolY[k];
+				newZ[n] = poolZ[k];
 			}
+			f.conflictEnd = n;
 		}
+		assert(n == numLiveConflicts);
+		poolIndex.swap(newIndex);
+		poolX.swap(newX);
+		poolY.swap(newY);
+		poolZ.swap(newZ);
 	}
 
-	std::vector<int> workStack;
-	if (!conflictList[0].empty()) workStack.push_back(0);
-	if (!conflictList[1].empty()) workStack.push_back(1);
-	if (!conflictList[2].empty()) workStack.push_back(2);
-	if (!conflictList[3].empty()) workStack.push_back(3);
-
-	std::set<int> conflictingVertices;
-	std::vector<std::pair<int, int> > boundaryEdges;
-	std::vector<int> faceVisitStack;
-
-	std::vector<int> hullVertices(4, 1);
-
-	// We need to perform flood fill searches across the faces to scan the interior faces vs border faces, so maintain
-	// an auxiliary data structure to store already visited faces.
-	std::vector<int> floodFillVisited(p.f.size());
-	int floodFillVisitColor = 1;
-//	p.DumpStructure();
-
-#ifdef CONVEXHULL_VERBOSE
-	for(size_t j = 0; j < p.f.size(); ++j)
-		if (!p.f[j].v.empty())
+	void QuickHull::RemoveConflict(int face, int point)
+	{
+		HullFace &f = faces[face];
+		int k = f.conflictBegin;
+		while(poolIndex[k] != point)
+			++k;
+		const int last = --f.conflictEnd;
+		poolIndex[k] = poolIndex[last];
+		poolX[k] = poolX[last];
+		poolY[k] = poolY[last];
+		poolZ[k] = poolZ[last];
+		--numLiveConflicts;
+
+		f.farthest = -1;
+		f.farthestDistance = 0;
+		for(k = f.conflictBegin; k < f.conflictEnd; ++k)
 		{
-			vec pointOnFace = p.v[p.f[j].v[0]];
-			for(size_t i = 0; i < p.v.size(); ++i)
+			cs dist = f.nx*poolX[k] + f.ny*poolY[k] + f.nz*poolZ[k] - f.d;
+			if (f.farthest == -1 || dist > f.farthestDistance)
 			{
-				float d = Dot((vec)p.v[i] - pointOnFace, faceNormals[j]);
-				if (d > inPlaneEpsilon)
-					LOG(MathLogWarningNoCallstack, "Vertex %d is at distance %f from face %d.", (int)i, d, (int)j);
-//				else
-//					LOGI("Vertex %d is at distance %f from face %d.", (int)i, d, (int)j);
+				f.farthest = poolIndex[k];
+				f.farthestDistance = dist;
 			}
 		}
-#endif
+	}
 
-	while(!workStack.empty())
-	{
-		// Choose a random plane in order to avoid a degenerate worst case processing.
-		int fIdx = rng.Int(0, (int)workStack.size() - 1);
-//		int f = workStack[fIdx];
-		int f = workStack.at(fIdx);
-		Swap(workStack[fIdx], workStack.back());
-		workStack.pop_back();
-		std::vector<int> &conflict = conflictList.at(f);
-//		std::vector<int> &conflict = conflictList[f];
-		if (conflict.empty())
-			continue;
+	bool QuickHull::IsVisible(const HullFace &face, int edge, int eye) const
+	{
+		const cs distance = Distance(face, eye);
+		if (distance > epsilon)
+			return true;
+		if (distance < -epsilon)
+			return false;
 
-		cv pointOnFace = POINT_TO_FLOAT4(p.v.at(p.f.at(f).v.at(0)));
-//		vec pointOnFace = p.v[p.f[f].v[0]];
-		// Find the most extreme conflicting vertex on this face.
-		cs extremeD = -FLOAT_INF;
-		int extremeCI = -1; // Index of the vertex in the conflict list.
-		int extremeI = -1; // Index of the vertex in the convex hull.
-		for(size_t i = 0; i < conflict.size(); ++i)
-		{
-			int vt = conflict.at(i);
-//			int vt = conflict[i];
-			if (vt < (int)hullVertices.size() && hullVertices[vt])
-				continue; // Robustness check: if this vertex is already part of the hull, ignore it.
-			cs d = cv(faceNormals[f]).Dot(cv(POINT_TO_FLOAT4(p.v[vt])) - pointOnFace);
-			if (d > extremeD)
+		// The eye point lies in the plane of the face, up to the epsilon. If the new face that would connect the eye point
+		// to the given edge is degenerate, or bends inwards from this face, remove this face as well. Otherwise such
+		// sliver faces would amplify the epsilon into large concavities.
+		const HullPoint &a = pointXYZ[face.v[(edge+1)%3]], &b = pointXYZ[face.v[edge]];
+		const HullPoint &c = pointXYZ[eye], &w = pointXYZ[face.v[(edge+2)%3]];
+		const cs e1X = b.x-a.x, e1Y = b.y-a.y, e1Z = b.z-a.z;
+		const cs e2X = c.x-a.x, e2Y = c.y-a.y, e2Z = c.z-a.z;
+		const cs normalX = e1Y*e2Z - e1Z*e2Y, normalY = e1Z*e2X - e1X*e2Z, normalZ = e1X*e2Y - e1Y*e2X;
+		const cs length = Sqrt(normalX*normalX + normalY*normalY + normalZ*normalZ);
+		if (length <= epsilon * Sqrt(e1X*e1X + e1Y*e1Y + e1Z*e1Z))
+			return true;
+		return normalX*(w.x-a.x) + normalY*(w.y-a.y) + normalZ*(w.z-a.z) > epsilon * length;
+	}
+
+	bool QuickHull::FindHorizon(int face, int eye)
+	{
+		// Search the faces that the eye point sees in depth-first order, walking the edges of each face in
+		// counterclockwise order. This produces the edges of the horizon in counterclockwise order as well.
+		++visitColor;
+		visibleFaces.clear();
+		horizon.clear();
+		std::vector<SearchEntry> &stack = searchStack;
+		SearchEntry root = { face, 0, 3 };
+		stack.push_back(root);
+		faces[face].visited = visitColor;
+		visibleFaces.push_back(face);
+		while(!stack.empty())
+		{
+			SearchEntry &top = stack.back();
+			if (top.numEdges == 0)
 			{
-				extremeD = d;
-				extremeCI = (int)i;
-				extremeI = vt;
+				stack.pop_back();
+				continue;
+			}
+			const int f = top.face;
+			const int j = top.edge;
+			top.edge = (j + 1) % 3;
+			--top.numEdges;
+
+			const int n = faces[f].adj[j];
+			HullFace &neighbor = faces[n];
+			if (neighbor.visited == visitColor)
+				continue; // The edge is between two visible faces.
+			int nEdge = 0;
+			while(neighbor.adj[nEdge] != f)
+				++nEdge;
+			if (IsVisible(neighbor, nEdge, eye))
+			{
+				neighbor.visited = visitColor;
+				visibleFaces.push_back(n);
+				// Continue from the edge that follows the edge the search came from.
+				SearchEntry e = { n, (nEdge + 1) % 3, 2 };
+				stack.push_back(e); // Invalidates 'top'.
+			}
+			else
+			{
+				HorizonEdge h = { faces[f].v[j], faces[f].v[(j+1)%3], n, nEdge };
+				horizon.push_back(h);
 			}
 		}
-		// Remove the most extreme conflicting vertex from the conflict list, because
-		// that vertex will become a part of the convex hull.
-		if (extremeCI == -1)
+
+		// Due to the epsilon in the visibility test, the visible faces may in rare cases not form a disc. Then the horizon
+		// is not a single simple loop, and the point cannot be added.
+		for(size_t i = 0; i < horizon.size(); ++i)
 		{
-			conflict.clear();
-			continue;
+			if (horizon[i].v1 != horizon[(i+1) % horizon.size()].v0 || vertexVisited[horizon[i].v0] == visitColor)
+				return false;
+			vertexVisited[horizon[i].v0] = visitColor;
 		}
-		Swap(conflict.at(extremeCI), conflict.back());
-//		Swap(conflict[extremeCI], conflict.back());
-		conflict.pop_back();
+		return true;
+	}
 
-//		if (extremeD <= ((Plane)facePlanes[f]).d + 1e-5f)
-		if (extremeD <= inPlaneEpsilon)
-			continue;
-		C_LOG("Verted %d is outside hull and will be added.", extremeI);
+	Polyhedron QuickHull::VolumeHull(LCG &rng)
+	{
+		// Wind the base triangle of the initial tetrahedron so that the apex is behind it.
+		int base[3] = { simplex[0], simplex[1], simplex[2] };
+		const int apex = simplex[3];
+		cs planeNX, planeNY, planeNZ, planeD;
+		TrianglePlane(base[0], base[1], base[2], planeNX, planeNY, planeNZ, planeD);
+		if (planeNX*x[apex] + planeNY*y[apex] + planeNZ*z[apex] > planeD)
+			Swap(base[1], base[2]);
+
+		newFaces.clear();
+		const int baseFace = AddFace(base[0], base[1], base[2]);
+		int sides[3];
+		for(int k = 0; k < 3; ++k)
+			sides[k] = AddFace(base[(k+1)%3], base[k], apex);
+		for(int k = 0; k < 3; ++k)
+		{
+			faces[baseFace].adj[k] = sides[k];
+			faces[sides[k]].adj[0] = baseFace;
+			faces[sides[k]].adj[1] = sides[(k+2)%3];
+			faces[sides[k]].adj[2] = sides[(k+1)%3];
+		}
 
-		std::set<int> &conflictingFaces = conflictListVertices[extremeI];
+		orphans.resize(numPoints);
+		for(int i = 0; i < numPoints; ++i)
+			orphans[i] = i;
+		AssignPoints(&orphans[0], &x[0], &y[0], &z[0], numPoints);
 
-//		floodFillVisited[f] = floodFillVisitColor;
-		floodFillVisited.at(f) = floodFillVisitColor;
-		faceVisitStack.push_back(f);
-		faceVisitStack.insert(faceVisitStack.end(), conflictingFaces.begin(), conflictingFaces.end());
-		for(std::set<int>::iterator iter = conflictingFaces.begin(); iter != conflictingFaces.end(); ++iter)
-			floodFillVisited.at(*iter) = floodFillVisitColor;
+		std::vector<int> workStack;
+		for(size_t i = 0; i < newFaces.size(); ++i)
+			if (faces[newFaces[i]].NumConflicts() > 0)
+				workStack.push_back(newFaces[i]);
 
-		while(!faceVisitStack.empty())
-//		for(std::set<int>::iterator iter = conflictingFaces.begin();
-//			iter != conflictingFaces.end(); ++iter)
+		while(!workStack.empty())
 		{
-			int fi = faceVisitStack.back();
-			faceVisitStack.pop_back();
-			conflictingVertices.insert(conflictList[fi].begin(), conflictList[fi].end());
-			conflictList.at(fi).clear();
-//			conflictList[fi].clear();
-
-			// Traverse through each edge of this face to detect whether this is an interior or a boundary face.
-			const Polyhedron::Face &pf = p.f.at(fi);
-
-			if (pf.v.empty())
+			// Choose a random face in order to avoid a degenerate worst case processing.
+			int fIdx = rng.Int(0, (int)workStack.size() - 1);
+			int f = workStack[fIdx];
+			Swap(workStack[fIdx], workStack.back());
+			workStack.pop_back();
+			if (!faces[f].alive || faces[f].NumConflicts() == 0)
 				continue;
 
-//			const Polyhedron::Face &f = p.f[fi];
-			int v0 = pf.v.back();
-			for(size_t j = 0; j < pf.v.size(); ++j)
+			const int eye = faces[f].farthest;
+			if (FindHorizon(f, eye))
 			{
-					int v1 = pf.v[j];
-				int adjFace = edgesToFaces[std::make_pair(v1, v0)];
-#ifdef CONVEXHULL_VERBOSE
-				p.DumpStructure();
-#endif
-				if (adjFace == -1 || p.f[adjFace].v.empty() || floodFillVisited[adjFace] == floodFillVisitColor)
-				{
-					v0 = v1;
-					continue; // The face does not exist anymore, or we have already visited it.
-				}
-				C_LOG("Traversing edge %d->%d which belongs to face %d, and edge %d->%d belongs to face %d",
-					v0, v1, edgesToFaces[std::make_pair(v0, v1)],
-					v1, v0, edgesToFaces[std::make_pair(v1, v0)]);
-				assert(edgesToFaces[std::make_pair(v0, v1)] == fi);
-				assert(adjFace != fi);
-
-				bool adjFaceIsInConflict = (conflictingFaces.find(adjFace) != conflictingFaces.end());
-
-//				LOGI("Edge %d->%d is adjacent face %d", v1, v0, adjFace);
-//				if (!p.f[adjFace].v.empty())
-//				{
-					cs d;
-					cv ptOnFace = POINT_TO_FLOAT4(p.v[p.f[adjFace].v[0]]);
-					d = cv(faceNormals[adjFace]).Dot(cv(POINT_TO_FLOAT4(p.v[extremeI])) - ptOnFace);
-//					if (((Plane)facePlanes[adjFace]).SignedDistance(p.v[extremeI]) > 1e-4f) // Is v0<->v1 an interior edge?
-//					bool containsVtx = ContainsAndRemove(conflictList[adjFace], extremeI);
-					if (d > inPlaneEpsilon)
-						adjFaceIsInConflict = true;
-//				}
-				if (adjFaceIsInConflict)
-				{
-					C_LOG("Neighbor face %d (%s) of face %d (%s) sees vertex %d and is in conflict. (d:%f, adjFaceIsInConflict: %d). Edge %d->%d must be an inner edge",
-						adjFace, p.f[adjFace].ToString().c_str(), fi, f.ToString().c_str(), extremeI, d, adjFaceIsInConflict, v0, v1);
-					if (floodFillVisited[adjFace] != floodFillVisitColor) // Add the neighboring face to the visit stack.
-					{
-						faceVisitStack.push_back(adjFace);
-//							floodFillVisited[adjFace] = floodFillVisitColor;
-						floodFillVisited.at(adjFace) = floodFillVisitColor;
-					}
-				}
-				else // v0<->v1 is a boundary edge.
-				{
-					C_LOG("Neighbor face %d (%s) of face %d (%s) does not see vertex %d. Edge %d->%d is then a boundary edge.", 
-						adjFace, p.f[adjFace].ToString().c_str(), fi, f.ToString().c_str(), extremeI, v0, v1);
-					boundaryEdges.push_back(std::make_pair(v0, v1));
-				}
-				v0 = v1;
+				AddPoint(eye);
+				for(size_t i = 0; i < newFaces.size(); ++i)
+					if (faces[newFaces[i]].NumConflicts() > 0)
+						workStack.push_back(newFaces[i]);
 			}
-
-			// Mark this face as deleted by setting its size to zero vertices. This is better than erasing the face immediately,
-			// as that incurs memory allocation and bookkeeping costs. The null faces are all removed at the very end in one pass.
-			//p.f[fi].v.clear();
-			int w0 = p.f.at(fi).v.back();
-			for(size_t i = 0; i < p.f[fi].v.size(); ++i)
+			else
 			{
-				int w1 = p.f[fi].v[i];
-				edgesToFaces[std::make_pair(w0, w1)] = -1;
-				w0 = w1;
+				// Leave out the point, which lies within a few epsilons of the hull.
+				RemoveConflict(f, eye);
+				if (faces[f].NumConflicts() > 0)
+					workStack.push_back(f);
 			}
-			p.f.at(fi).v.clear();
-			C_LOG("Face %d was removed since it was in conflict with vertex %d.", fi, extremeI);
 		}
-		++floodFillVisitColor;
+		return ToPolyhedron();
+	}
 
-		// Since we deleted a bunch of faces, remove those faces from the conflict lists of each vertex.
-		for(std::set<int>::iterator vi = conflictingVertices.begin(); vi != conflictingVertices.end(); ++vi)
+	void QuickHull::AddPoint(int eye)
+	{
+		// Remove the faces the eye point sees, and collect the points in front of them.
+		orphans.clear();
+		orphanX.clear();
+		orphanY.clear();
+		orphanZ.clear();
+		for(size_t i = 0; i < visibleFaces.size(); ++i)
 		{
-			int v = *vi;
-			if (v != extremeI)
-			{
-				for(std::set<int>::iterator fi = conflictingFaces.begin(); fi != conflictingFaces.end(); ++fi)
+			HullFace &f = faces[visibleFaces[i]];
+			for(int k = f.conflictBegin; k < f.conflictEnd; ++k)
+				if (poolIndex[k] != eye)
 				{
-					std::set<int>::iterator iter = conflictListVertices[v].find(*fi);
-					//assert(iter3 != conflictListVertices[*iter].end());
-					if (iter != conflictListVertices[v].end())
-					{
-						C_LOG("Vertex %d no longer with face %d, because the face was removed.", 
-							v, *fi);
-						conflictListVertices[v].erase(iter);
-					}
+					orphans.push_back(poolIndex[k]);
+					orphanX.push_back(poolX[k]);
+					orphanY.push_back(poolY[k]);
+					orphanZ.push_back(poolZ[k]);
 				}
-			}
+			numLiveConflicts -= f.NumConflicts();
+			f.conflictBegin = f.conflictEnd = 0;
+			f.alive = false;
+			freeFaces.push_back(visibleFaces[i]);
 		}
+		const int numOrphans = (int)orphans.size();
 
-		conflictingFaces.clear();
-
-		// Reconstruct the proper CCW order of the boundary. Note that it is possible to perform a search where the order
-		// would come out right from the above graph search without needing to sort, perhaps a todo for later.
-		for(size_t i = 0; i < boundaryEdges.size(); ++i)
-			for(size_t j = i+1; j < boundaryEdges.size(); ++j)
-				if (boundaryEdges[i].second == boundaryEdges[j].first)
-				{
-					Swap(boundaryEdges[i+1], boundaryEdges[j]);
-					break;
-				}
-#ifdef CONVEXHULL_VERBOSE
-		LOGI("New boundary:");
-		for(size_t i = 0; i < boundaryEdges.size(); ++i)
-			LOGI("%d->%d", (int)boundaryEdges[i].first, boundaryEdges[i].second);
-#endif
-
-		std::pair<int, int> prev = boundaryEdges.back();
-		for(size_t i = 0; i < boundaryEdges.size(); ++i)
+		// Connect each edge of the horizon to the eye point with a new face.
+		newFaces.clear();
+		const int numNewFaces = (int)horizon.size();
+		for(int i = 0; i < numNewFaces; ++i)
 		{
-			if (prev.second != boundaryEdges[i].first)
-			{
-				LOGE("Boundary is not connected: there should be edge %d-%d in the boundary!", prev.second, boundaryEdges[i].first);
-				assert(false);
-				return Polyhedron();
-			}
-			prev = boundaryEdges[i];
+			const HorizonEdge &h = horizon[i];
+			int f = AddFace(h.v0, h.v1, eye);
+			faces[f].adj[0] = h.face;
+			faces[h.face].adj[h.edge] = f;
+		}
+		for(int i = 0; i < numNewFaces; ++i)
+		{
+			HullFace &f = faces[newFaces[i]];
+			f.adj[1] = newFaces[(i+1) % numNewFaces];
+			f.adj[2] = newFaces[(i+numNewFaces-1) % numNewFaces];
 		}
 
-#if 0
-		std::vector<Tri> degenerateTris;
-#endif
+		if (numOrphans > 0)
+			AssignPoints(&orphans[0], &orphanX[0], &orphanY[0], &orphanZ[0], numOrphans);
+	}
 
-		size_t oldNumFaces = p.f.size();
-		// Create new faces to close the boundary.
-		for(size_t i = 0; i < boundaryEdges.size(); ++i)
+	Polyhedron QuickHull::ToPolyhedron() const
+	{
+		Polyhedron p;
+		p.f.reserve(faces.size() - freeFaces.size());
+		std::vector<int> vertexIndex(numPoints, -1);
+		std::vector<int> group(faces.size(), -1);
+		std::vector<int> members, stack, loop;
+		std::vector<std::pair<int, int> > boundary;
+		for(int f = 0; f < (int)faces.size(); ++f)
 		{
-			assert(face.v.size() == 3);
-			face.v[0] = boundaryEdges[i].first; face.v[1] = boundaryEdges[i].second; face.v[2] = extremeI; p.f.push_back(face);
+			if (!faces[f].alive || group[f] != -1)
+				continue;
 
-#if 0
-			// Test the dimensions of the new face.
-			cv a = POINT_TO_FLOAT4(p.v[face.v[0]]);
-			cv b = POINT_TO_FLOAT4(p.v[face.v[1]]);
-			cv c = POINT_TO_FLOAT4(p.v[face.v[2]]);
-			if (a.DistanceSq(b) < 1e-7f || a.DistanceSq(c) < 1e-7f || b.DistanceSq(c) < 1e-7f)
-				LOGW("Creating a degenerate face!");
-#endif
-			C_LOG("Added face %d with vertices %d-%d-%d", (int)p.f.size()-1, face.v[0], face.v[1], face.v[2]);
-			//vec faceNormal = p.FaceNormal(p.f.size()-1);
-			//cv faceNormal = (b-a).Cross(c-a);
-			//cs len = faceNormal.Normalize();
-			cv faceNormal = PolyFaceNormal(p, (int)p.f.size()-1);
-#if 0
-			if (len < 1e-3f || a.DistanceSq(b) < 1e-7f || a.DistanceSq(c) < 1e-7f || b.DistanceSq(c) < 1e-7f)
-			{
-				LOGW("Face has degenerate vertices %s, %s, %s! (normal was of len %f)", vec(p.v[face.v[0]]).ToString().c_str(), vec(p.v[face.v[1]]).ToString().c_str(), vec(p.v[face.v[2]]).ToString().c_str(), len);
-				Tri t;
-				t.v[0] = face.v[0];
-				t.v[1] = face.v[1];
-				t.v[2] = face.v[2];
-				t.faceIndex = (int)p.f.size()-1;
-				degenerateTris.push_back(t);
+			// Merge the neighboring faces that lie in the plane of this face, up to the epsilon, into one polygon. This
+			// removes the sliver triangles that coplanar input points would otherwise produce.
+			members.clear();
+			group[f] = f;
+			stack.push_back(f);
+			const HullFace &face = faces[f];
+			const bool hasNormal = face.nx != 0 || face.ny != 0 || face.nz != 0;
+			while(!stack.empty())
+			{
+				int g = stack.back();
+				stack.pop_back();
+				members.push_back(g);
+				for(int j = 0; j < 3 && hasNormal; ++j)
+				{
+					const int n = faces[g].adj[j];
+					const HullFace &neighbor = faces[n];
+					if (group[n] != -1 || face.nx*neighbor.nx + face.ny*neighbor.ny + face.nz*neighbor.nz < 0)
+						continue;
+					if (Abs(Distance(face, neighbor.v[0])) <= epsilon && Abs(Distance(face, neighbor.v[1])) <= epsilon
+						&& Abs(Distance(face, neighbor.v[2])) <= epsilon)
+					{
+						group[n] = f;
+						stack.push_back(n);
+					}
+				}
 			}
-#endif
-			assert(!faceNormal.IsZero() && faceNormal.IsFinite());
-			faceNormals.push_back(faceNormal);
-			assert(extremeI >= (int)hullVertices.size() || !hullVertices[extremeI]);
-			assert(edgesToFaces.find(std::make_pair(boundaryEdges[i].first, boundaryEdges[i].second))
-				== edgesToFaces.end() || edgesToFaces[std::make_pair(boundaryEdges[i].first, boundaryEdges[i].second)] == -1);
-			assert(edgesToFaces.find(std::make_pair(boundaryEdges[i].second, extremeI))
-				== edgesToFaces.end() || edgesToFaces[std::make_pair(boundaryEdges[i].second, extremeI)] == -1);
-			assert(edgesToFaces.find(std::make_pair(extremeI, boundaryEdges[i].first))
-				== edgesToFaces.end() || edgesToFaces[std::make_pair(extremeI, boundaryEdges[i].first)] == -1);
-
-			if (!(edgesToFaces.find(std::make_pair(boundaryEdges[i].first, boundaryEdges[i].second))
-				== edgesToFaces.end() || edgesToFaces[std::make_pair(boundaryEdges[i].first, boundaryEdges[i].second)] == -1)
-				|| !(edgesToFaces.find(std::make_pair(boundaryEdges[i].second, extremeI))
-				== edgesToFaces.end() || edgesToFaces[std::make_pair(boundaryEdges[i].second, extremeI)] == -1)
-			 || !(edgesToFaces.find(std::make_pair(extremeI, boundaryEdges[i].first))
-				== edgesToFaces.end() || edgesToFaces[std::make_pair(extremeI, boundaryEdges[i].first)] == -1))
-				LOGW("Convex hull computation failed!");
-
-			edgesToFaces[std::make_pair(boundaryEdges[i].first, boundaryEdges[i].second)] = (int)p.f.size()-1;
-			edgesToFaces[std::make_pair(boundaryEdges[i].second, extremeI)] = (int)p.f.size()-1;
-			edgesToFaces[std::make_pair(extremeI, boundaryEdges[i].first)] = (int)p.f.size()-1;
-//			LOGI("New face %d->%d->%d", face.v[0], face.v[1], face.v[2]);
-		}
-		boundaryEdges.clear();
-//		p.DumpStructure();
 
-#if 0
-		// Merge now degenerate faces.
-		for(size_t i = 0; i < degenerateTris.size(); ++i)
-		{
-			const Tri &t = degenerateTris[i];
-			vec center = vec(p.v[t.v[0]]) + vec(p.v[t.v[1]]) + vec(p.v[t.v[2]]) * (1.f / 3.f);
-			p.v[t.v[0]] = center;
-			p.v[t.v[1]] = center;
-			p.v[t.v[2]] = center;
-			LOGW("Made face %d degenerate.", t.faceIndex);
-//			p.f[t.faceIndex].v.clear();
-		}
-#endif
-		// Robustness: flag the new vertex as part of the convex hull.
-		if ((int)hullVertices.size() <= extremeI)
-			hullVertices.insert(hullVertices.end(), extremeI + 1 - hullVertices.size(), 0);
-		//hullVertices[extremeI] = true;
-		hullVertices.at(extremeI) = 1;
-
-		// Redistribute all conflicting points to the new faces.
-		conflictList.insert(conflictList.end(), p.f.size() - oldNumFaces, std::vector<int>());
-		floodFillVisited.insert(floodFillVisited.end(), p.f.size() - oldNumFaces, 0);
-		for(std::set<int>::iterator iter = conflictingVertices.begin(); iter != conflictingVertices.end(); ++iter)
-			for(size_t j = oldNumFaces; j < p.f.size(); ++j)
-			{
-				cv ptOnFace = POINT_TO_FLOAT4(p.v[p.f[j].v[0]]);
-				cs d = cv(faceNormals[j]).Dot(cv(POINT_TO_FLOAT4(p.v[*iter])) - ptOnFace);
-//				if (((Plane)facePlanes[j]).IsOnPositiveSide(p.v[*iter]) && (*iter >= (int)hullVertices.size() || !hullVertices[*iter]))
-				if (d > inPlaneEpsilon && (*iter >= (int)hullVertices.size() || !hullVertices[*iter]))
+			// Trace the boundary of the merged faces. If it is not a single loop, keep the triangles as they are.
+			loop.clear();
+			if (members.size() > 1)
+			{
+				boundary.clear();
+				for(size_t i = 0; i < members.size(); ++i)
+				{
+					const HullFace &m = faces[members[i]];
+					for(int j = 0; j < 3; ++j)
+						if (group[m.adj[j]] != f)
+							boundary.push_back(std::make_pair(m.v[j], m.v[(j+1)%3]));
+				}
+				std::sort(boundary.begin(), boundary.end());
+				int v = boundary[0].first;
+				do
+				{
+					loop.push_back(v);
+					std::vector<std::pair<int, int> >::const_iterator iter = std::lower_bound(boundary.begin(), boundary.end(), std::make_pair(v, -1));
+					if (iter == boundary.end() || iter->first != v || (iter+1 != boundary.end() && (iter+1)->first == v))
+						break;
+					v = iter->second;
+				} while(v != boundary[0].first && loop.size() <= boundary.size());
+				if (v != boundary[0].first || loop.size() != boundary.size())
+					loop.clear();
+			}
+
+			if (!loop.empty())
+			{
+				// Start the polygon from its most convex corner, since Polyhedron::FacePlane() uses the first three vertices.
+				// The faces may bend inwards by up to the epsilon, so the merged polygon can have reflex corners. Then keep
+				// the triangles instead.
+				const int n = (int)loop.size();
+				int start = 0;
+				cs maxAreaSq = -1;
+				bool convex = true;
+				for(int i = 0; i < n && convex; ++i)
 				{
-					conflictList.at(j).push_back(*iter);
-					conflictListVertices[*iter].insert((int)j);
-//				conflictList[j].push_back(*iter);
-					C_LOG("Vertex %d and face %d are in conflict.", (int)*iter, (int)j);
+					int v0 = loop[i], v1 = loop[(i+1)%n], v2 = loop[(i+2)%n];
+					cs e1X = x[v1]-x[v0], e1Y = y[v1]-y[v0], e1Z = z[v1]-z[v0];
+					cs e2X = x[v2]-x[v0], e2Y = y[v2]-y[v0], e2Z = z[v2]-z[v0];
+					cs cX = e1Y*e2Z - e1Z*e2Y, cY = e1Z*e2X - e1X*e2Z, cZ = e1X*e2Y - e1Y*e2X;
+					if (face.nx*cX + face.ny*cY + face.nz*cZ < -epsilon * Sqrt(e1X*e1X + e1Y*e1Y + e1Z*e1Z))
+						convex = false;
+					cs areaSq = cX*cX + cY*cY + cZ*cZ;
+					if (areaSq > maxAreaSq)
+					{
+						maxAreaSq = areaSq;
+						start = i;
+					}
 				}
+				if (!convex)
+					loop.clear();
+				else
+					std::rotate(loop.begin(), loop.begin() + start, loop.end());
 			}
 
-		conflictingVertices.clear();
+			if (!loop.empty())
+			{
+				p.f.push_back(Polyhedron::Face());
+				p.f.back().v = loop;
+			}
+			else
+				for(size_t i = 0; i < members.size(); ++i)
+				{
+					p.f.push_back(Polyhedron::Face());
+					p.f.back().v.assign(faces[members[i]].v, faces[members[i]].v + 3);
+				}
+		}
 
-#ifdef CONVEXHULL_VERBOSE
-	for(size_t j = 0; j < p.f.size(); ++j)
-		if (!p.f[j].v.empty())
+		// A point on an edge of the hull, like the midpoint of an edge of a box, is a vertex of only the two polygons that
+		// share the edge. Remove such points when they lie on the line between their neighbors in both polygons.
+		std::vector<int> numFaces(numPoints, 0), numStraightCorners(numPoints, 0);
+		for(size_t i = 0; i < p.f.size(); ++i)
+			for(size_t j = 0; j < p.f[i].v.size(); ++j)
+				++numFaces[p.f[i].v[j]];
+		for(size_t i = 0; i < p.f.size(); ++i)
 		{
-			vec pointOnFace = p.v[p.f[j].v[0]];
-			for(size_t i = 0; i < p.v.size(); ++i)
+			const std::vector<int> &v = p.f[i].v;
+			const int n = (int)v.size();
+			for(int j = 0; j < n && n > 3; ++j)
 			{
-				float d = Dot((vec)p.v[i] - pointOnFace, faceNormals[j]);
-				if (d > inPlaneEpsilon)
-					LOG(MathLogWarningNoCallstack, "Vertex %d is at distance %f from face %d.", (int)i, d, (int)j);
-//				else
-//					LOGI("Vertex %d is at distance %f from face %d.", (int)i, d, (int)j);
+				const int v0 = v[(j+n-1)%n], v1 = v[j], v2 = v[(j+1)%n];
+				if (numFaces[v1] != 2)
+					continue;
+				cs e1X = x[v2]-x[v0], e1Y = y[v2]-y[v0], e1Z = z[v2]-z[v0];
+				cs e2X = x[v1]-x[v0], e2Y = y[v1]-y[v0], e2Z = z[v1]-z[v0];
+				cs cX = e1Y*e2Z - e1Z*e2Y, cY = e1Z*e2X - e1X*e2Z, cZ = e1X*e2Y - e1Y*e2X;
+				if (cX*cX + cY*cY + cZ*cZ <= epsilon*epsilon * (e1X*e1X + e1Y*e1Y + e1Z*e1Z))
+					++numStraightCorners[v1];
 			}
 		}
-#endif
-		// Add new faces that still have conflicting vertices to the work stack for later processing.
-		// The algorithm will terminate once all faces are clear of conflicts.
-		assert(conflictList.size() == p.f.size());
-		for(size_t j = oldNumFaces; j < p.f.size(); ++j)
-			if (!conflictList.at(j).empty())
-//				if (!conflictList[j].empty())
-					workStack.push_back((int)j);
-//	p.DumpStructure();
+		for(size_t i = 0; i < p.f.size(); ++i)
+		{
+			std::vector<int> &v = p.f[i].v;
+			size_t n = 0;
+			for(size_t j = 0; j < v.size(); ++j)
+				if (numStraightCorners[v[j]] != 2)
+					v[n++] = v[j];
+			v.resize(n);
+		}
 
-#if 0
-		for (size_t i = 0; i < p.v.size() && i < hullVertices.size(); ++i)
-			if (hullVertices[i])
+		// Keep only the input points that are vertices of the hull.
+		for(size_t i = 0; i < p.f.size(); ++i)
+			for(size_t j = 0; j < p.f[i].v.size(); ++j)
 			{
-				for (size_t j = 0; j < p.f.size(); ++j)
+				int &v = p.f[i].v[j];
+				if (vertexIndex[v] == -1)
 				{
-					if (p.f[j].v.empty()) continue;
-					vec pointOnFace = p.v[p.f[j].v[0]];
-					float d = Dot((vec)p.v[i] - pointOnFace, faceNormals[j]);
-					assert(d <= 1e-1f);
+					vertexIndex[v] = (int)p.v.size();
+					p.v.push_back(points[v]);
 				}
+				v = vertexIndex[v];
 			}
-#endif
+		return p;
 	}
 
-//	p.DumpStructure();
+	Polyhedron QuickHull::PlanarHull() const
+	{
+		const int a = simplex[0], b = simplex[1], c = simplex[2];
+		cs planeNX, planeNY, planeNZ, planeD;
+		TrianglePlane(a, b, c, planeNX, planeNY, planeNZ, planeD);
+
+		// Project the points to an orthonormal basis (u, w) of the plane, where u x w is the plane normal, and compute
+		// the 2D convex hull of the projected points with Andrew's monotone chain algorithm.
+		cs uX = x[b]-x[a], uY = y[b]-y[a], uZ = z[b]-z[a];
+		const cs invLength = (cs)1 / Sqrt(uX*uX + uY*uY + uZ*uZ);
+		uX *= invLength; uY *= invLength; uZ *= invLength;
+		const cs wX = planeNY*uZ - planeNZ*uY, wY = planeNZ*uX - planeNX*uZ, wZ = planeNX*uY - planeNY*uX;
+		std::vector<std::pair<std::pair<cs, cs>, int> > projected(numPoints);
+		for(int i = 0; i < numPoints; ++i)
+			projected[i] = std::make_pair(std::make_pair(uX*x[i] + uY*y[i] + uZ*z[i], wX*x[i] + wY*y[i] + wZ*z[i]), i);
+		std::sort(projected.begin(), projected.end());
 
-#ifndef NDEBUG
-	for(size_t i = 0; i < conflictList.size(); ++i)
-		assert(conflictList[i].empty());
-#endif
+		std::vector<int> hull(2*numPoints);
+		int n = 0;
+		// The lower hull from left to right, then the upper hull from right to left, keeping only the points where the
+		// chain turns left by more than the epsilon.
+		for(int i = 0; i < numPoints; ++i)
+		{
+			while(n >= 2 && !IsLeftTurn(projected[hull[n-2]].first, projected[hull[n-1]].first, projected[i].first))
+				--n;
+			hull[n++] = i;
+		}
+		for(int i = numPoints-2, lowerSize = n+1; i >= 0; --i)
+		{
+			while(n >= lowerSize && !IsLeftTurn(projected[hull[n-2]].first, projected[hull[n-1]].first, projected[i].first))
+				--n;
+			hull[n++] = i;
+		}
+		--n; // The last point is the same as the first.
 
-#ifdef CONVEXHULL_VERBOSE
-	for(size_t j = 0; j < p.f.size(); ++j)
-		if (!p.f[j].v.empty())
+		Polyhedron p;
+		if (n < 3)
+			return p;
+		Polyhedron::Face face;
+		for(int i = 0; i < n; ++i)
 		{
-			vec pointOnFace = p.v[p.f[j].v[0]];
-			for(size_t i = 0; i < p.v.size(); ++i)
-			{
-				float d = Dot((vec)p.v[i] - pointOnFace, faceNormals[j]);
-				if (d > inPlaneEpsilon)
-					LOG(MathLogErrorNoCallstack, "Vertex %d is at distance %f from face %d.", (int)i, d, (int)j);
-				else
-					LOGI("Vertex %d is at distance %f from face %d.", (int)i, d, (int)j);
-			}
+			p.v.push_back(points[projected[hull[i]].second]);
+			face.v.push_back(i);
 		}
-#endif
+		p.f.push_back(face);
+		face.FlipWindingOrder();
+		p.f.push_back(face);
+		return p;
+	}
+}
 
-	p.RemoveDegenerateFaces();
-	p.RemoveRedundantVertices();
-//	p.DumpStructure();
+Polyhedron Polyhedron::ConvexHull(const vec *pointArray, int numPoints, LCG &rng)
+{
+	if (!pointArray || numPoints <= 0)
+		return Polyhedron();
+	for(int i = 0; i < numPoints; ++i)
+		if (!IsFinite(pointArray[i].x) || !IsFinite(pointArray[i].y) || !IsFinite(pointArray[i].z))
+			return Polyhedron();
+
+	QuickHull quickHull(pointArray, numPoints);
+	int dimension = quickHull.FindInitialSimplex();
+	if (dimension < 2)
+		return Polyhedron(); // All points are collinear, so the hull has no faces.
+	if (dimension == 2)
+		return quickHull.PlanarHull();
+
+	Polyhedron p = quickHull.VolumeHull(rng);
 
 	assume(p.IsClosed());
 	assume(p.FaceIndicesValid());
 	assume(p.EulerFormulaHolds());
 	assume(p.FacesAreNondegeneratePlanar());
-	assume(p.IsConvex());
+	assume(HalfEdgeMesh(p).IsConvex(p));
 
-#ifndef NDEBUG
-//	for(int i = 0; i < numPoints; ++i)
-//		assume1(p.ContainsConvex(pointArray[i]), p.Distance(pointArray[i]));
-
-#ifdef MATH_VEC_IS_FLOAT4
+#if !defined(NDEBUG) && defined(MATH_VEC_IS_FLOAT4)
 	for(size_t i = 0; i < p.v.size(); ++i)
 		assume1(p.v[i].w == 1.f && vec(p.v[i]).IsFinite(), vec(p.v[i]));
-#endif
 #endif
 
 	return p;
-#if 0
-	// For better performance, merge the remaining extreme points first.
-	for(; iter != extremes.end(); ++iter)
+}
+
+namespace
+{
+	// The 13 axes through the faces, edges and corners of a cube. The extreme points along both directions of each axis
+	// span a polytope that contains most of the interior points of a typical point cloud.
+	const int numCullAxes = 13;
+	const float cullAxes[numCullAxes][3] =
+	{
+		{ 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 },
+		{ 1, 1, 0 }, { 1, 0, 1 }, { 0, 1, 1 },
+		{ 1, -1, 0 }, { 1, 0, -1 }, { 0, 1, -1 },
+		{ 1, 1, 1 }, { -1, 1, 1 }, { 1, -1, 1 }, { 1, 1, -1 }
+	};
+
+	struct ParallelConvexHullJob
 	{
-		p.MergeConvex(pointArray[*iter]);
+		const vec *points;
+		int numPoints;
+		int pointsPerChunk;
 
-//		assert(p.FaceIndicesValid());
-//		assert(p.IsClosed());
-//		assert(p.FacesAreNondegeneratePlanar());
-//		assert(p.IsConvex());
+		// The indices of the minimum and maximum points along each cull axis, for each chunk.
+		std::vector<int> chunkExtremes;
+		std::vector<char> chunkIsFinite;
+
+		// The face planes of the hull of the extreme points, with the normals pointing out.
+		std::vector<float> planeNX, planeNY, planeNZ, planeD;
+		float epsilon;
+
+		// The vertices of the hull of the points of each chunk that were not culled.
+		std::vector<VecArray> chunkHullVertices;
+
+		int ChunkBegin(int chunk) const { return chunk * pointsPerChunk; }
+		int ChunkEnd(int chunk) const { return Min(numPoints, (chunk + 1) * pointsPerChunk); }
+	};
+
+	void FindChunkExtremes(void *userData, int begin, int end)
+	{
+		ParallelConvexHullJob &job = *(ParallelConvexHullJob*)userData;
+		for(int chunk = begin; chunk < end; ++chunk)
+		{
+			int *extremes = &job.chunkExtremes[chunk * 2 * numCullAxes];
+			float minD[numCullAxes], maxD[numCullAxes];
+			for(int j = 0; j < numCullAxes; ++j)
+			{
+				minD[j] = FLOAT_INF;
+				maxD[j] = -FLOAT_INF;
+				extremes[2*j] = extremes[2*j+1] = job.ChunkBegin(chunk);
+			}
+			bool isFinite = true;
+			for(int i = job.ChunkBegin(chunk); i < job.ChunkEnd(chunk); ++i)
+			{
+				const vec &pt = job.points[i];
+				isFinite = isFinite && IsFinite(pt.x) && IsFinite(pt.y) && IsFinite(pt.z);
+				for(int j = 0; j < numCullAxes; ++j)
+				{
+					float d = cullAxes[j][0]*pt.x + cullAxes[j][1]*pt.y + cullAxes[j][2]*pt.z;
+					if (d < minD[j]) { minD[j] = d; extremes[2*j] = i; }
+					if (d > maxD[j]) { maxD[j] = d; extremes[2*j+1] = i; }
+				}
+			}
+			job.chunkIsFinite[chunk] = isFinite;
+		}
 	}
 
-	// Merge all the rest of the points.
-	for(int j = 0; j < numPoints; ++j)
+	void ComputeChunkHulls(void *userData, int begin, int end)
 	{
-		if (extremes.find(j) != extremes.end())
-			continue; // The extreme points have already been merged.
-		p.MergeConvex(pointArray[j]);
+		ParallelConvexHullJob &job = *(ParallelConvexHullJob*)userData;
+		const int numPlanes = (int)job.planeD.size();
+		VecArray survivors;
+		for(int chunk = begin; chunk < end; ++chunk)
+		{
+			// Drop the points that lie strictly inside the hull of the extreme points. They cannot be vertices of the
+			// final hull.
+			survivors.clear();
+			for(int i = job.ChunkBegin(chunk); i < job.ChunkEnd(chunk); ++i)
+			{
+				const vec &pt = job.points[i];
+				int j = 0;
+				while(j < numPlanes && job.planeNX[j]*pt.x + job.planeNY[j]*pt.y + job.planeNZ[j]*pt.z - job.planeD[j] < -job.epsilon)
+					++j;
+				if (j < numPlanes || numPlanes == 0)
+					survivors.push_back(pt);
+			}
 
-//		assert(p.FaceIndicesValid());
-//		assert(p.IsClosed());
-//		mathassert(p.FacesAreNondegeneratePlanar());
-//		assert(p.IsConvex());
+			VecArray &vertices = job.chunkHullVertices[chunk];
+			if (survivors.empty())
+				vertices.clear();
+			else
+			{
+				Polyhedron hull = Polyhedron::ConvexHull(&survivors[0], (int)survivors.size());
+				vertices.swap(hull.v);
+				// Collinear and coincident points have no hull. Pass them on to the final hull as is.
+				if (vertices.empty())
+					vertices.swap(survivors);
+			}
+		}
+	}
+}
 
-//		if (p.f.size() > 5000)
-//			break;
+Polyhedron Polyhedron::ConvexHull(const vec *pointArray, int numPoints, ThreadPool &threadPool, int pointsPerChunk)
+{
+	if (!pointArray || numPoints <= 0)
+		return Polyhedron();
+
+	ParallelConvexHullJob job;
+	job.points = pointArray;
+	job.numPoints = numPoints;
+	if (pointsPerChunk <= 0)
+		pointsPerChunk = Max(16384, (numPoints + 4 * threadPool.NumThreads() - 1) / (4 * threadPool.NumThreads()));
+	job.pointsPerChunk = pointsPerChunk;
+	const int numChunks = (numPoints + pointsPerChunk - 1) / pointsPerChunk;
+
+	// Find the extreme points of the whole point cloud along the cull axes.
+	job.chunkExtremes.resize(numChunks * 2 * numCullAxes);
+	job.chunkIsFinite.resize(numChunks);
+	threadPool.ParallelFor(numChunks, 1, FindChunkExtremes, &job);
+	for(int chunk = 0; chunk < numChunks; ++chunk)
+		if (!job.chunkIsFinite[chunk])
+			return Polyhedron();
+	VecArray extremePoints;
+	for(int j = 0; j < 2 * numCullAxes; ++j)
+	{
+		const float sign = (j % 2 == 0) ? -1.f : 1.f;
+		const float *axis = cullAxes[j / 2];
+		int extreme = job.chunkExtremes[j];
+		float extremeD = sign * (axis[0]*pointArray[extreme].x + axis[1]*pointArray[extreme].y + axis[2]*pointArray[extreme].z);
+		for(int chunk = 1; chunk < numChunks; ++chunk)
+		{
+			int i = job.chunkExtremes[chunk * 2 * numCullAxes + j];
+			float d = sign * (axis[0]*pointArray[i].x + axis[1]*pointArray[i].y + axis[2]*pointArray[i].z);
+			if (d > extremeD)
+			{
+				extremeD = d;
+				extreme = i;
+			}
+		}
+		extremePoints.push_back(pointArray[extreme]);
 	}
 
-//	assert(p.FaceIndicesValid());
-//	assert(p.IsClosed());
-//	assert(p.IsConvex());
-	p.RemoveRedundantVertices();
-	return p;
-#endif
+	// The points inside the hull of the extreme points are culled. The margin covers the rounding error of the single
+	// precision planes, so that no point on the boundary of the final hull is lost.
+	Polyhedron cullHull = ConvexHull(extremePoints);
+	float maxAbs = 0.f;
+	for(size_t i = 0; i < extremePoints.size(); ++i)
+		maxAbs = Max(maxAbs, Abs(extremePoints[i].x) + Abs(extremePoints[i].y) + Abs(extremePoints[i].z));
+	job.epsilon = 8.f * FLT_EPSILON * maxAbs;
+	if (cullHull.NumFaces() > 2) // Planar hulls have two faces, and cannot cull anything.
+		for(int i = 0; i < cullHull.NumFaces(); ++i)
+		{
+			Plane plane = cullHull.FacePlane(i);
+			job.planeNX.push_back(plane.normal.x);
+			job.planeNY.push_back(plane.normal.y);
+			job.planeNZ.push_back(plane.normal.z);
+			job.planeD.push_back(plane.d);
+		}
+
+	// Compute the hulls of the chunks in parallel, and the final hull of the vertices of the chunk hulls.
+	job.chunkHullVertices.resize(numChunks);
+	threadPool.ParallelFor(numChunks, 1, ComputeChunkHulls, &job);
+	VecArray hullVertices;
+	for(int chunk = 0; chunk < numChunks; ++chunk)
+		hullVertices.insert(hullVertices.end(), job.chunkHullVertices[chunk].begin(), job.chunkHullVertices[chunk].end());
+	return ConvexHull(hullVertices);
 }
 
 /// See http://paulbourke.net/geometry/platonic/
@@ -2720,60 +3345,45 @@ int Polyhedron::MergeAdjacentPlanarFaces(bool snapVerticesToMergedPlanes, bool c
 	for(size_t i = 0; i < f.size(); ++i)
 		faceGroups[i] = (int)i;
 
+	// Each face is compared to the neighboring faces across the edges that have been visited before. The edges of each face
+	// are visited starting from the edge that ends at the first vertex of the face.
+	HalfEdgeMesh mesh(*this);
+	std::vector<bool> visited(mesh.NumHalfEdges(), false);
 	int numMerges = 0;
-	std::map<std::pair<int, int>, int> verticesToFaces;
 	for(size_t i = 0; i < f.size(); ++i)
 	{
-		Face &face = f[i];
-
-		int v0 = face.v.back();
-		for(size_t j = 0; j < face.v.size(); ++j)
+		const int firstHalfEdge = mesh.FaceHalfEdge((int)i);
+		const int numFaceEdges = mesh.NumFaceVertices((int)i);
+		for(int j = 0; j < numFaceEdges; ++j)
 		{
-			int v1 = face.v[j];
-			verticesToFaces[std::make_pair(v0, v1)] = (int)i;
-			std::map<std::pair<int, int>, int>::iterator neighbor = verticesToFaces.find(std::make_pair(v1, v0));
-			if (neighbor != verticesToFaces.end())
+			int he = firstHalfEdge + (j + numFaceEdges - 1) % numFaceEdges;
+			visited[he] = true;
+			int twin = mesh.Twin(he);
+			if (twin >= 0 && visited[twin])
 			{
-				int nf = neighbor->second;
-				if (!f[nf].v.empty())
+				int nf = mesh.Face(twin);
+				cv thisNormal = faceNormals[i];
+				cv nghbNormal = faceNormals[nf];
+				if (thisNormal.Dot(nghbNormal) >= 1.0 - angleEpsilon)
 				{
-					cv thisNormal = faceNormals[i];
-					cv nghbNormal = faceNormals[nf];
-					if (thisNormal.Dot(nghbNormal) >= 1.0 - angleEpsilon)
+					cs eNeg, ePos, nNeg, nPos;
+					PolyExtremeVertexOnFace(*this, (int)i, nghbNormal, eNeg, ePos);
+					PolyExtremeVertexOnFace(*this, nf, thisNormal, nNeg, nPos);
+					if (ePos - eNeg <= distanceEpsilon && nPos - nNeg <= distanceEpsilon)
 					{
-						cs eNeg, ePos, nNeg, nPos;
-						PolyExtremeVertexOnFace(*this, (int)i, nghbNormal, eNeg, ePos);
-//						PolyExtremeVertexOnFace(*this, nf, nghbNormal, nNeg, nPos);
-//						if (Max(ePos, nPos) - Min(eNeg, nNeg) <= distanceEpsilon)
-						PolyExtremeVertexOnFace(*this, nf, thisNormal, nNeg, nPos);
-						if (ePos - eNeg <= distanceEpsilon && nPos - nNeg <= distanceEpsilon)
-						{
-#if 0
-							LOGI("Face normal for i: %d (%s) is %s, face normal for nf: %d (%s) is %s. Extremes: %f to %f, and %f to %f. Extreme spread after merging: %f",
-								(int)i, f[i].ToString().c_str(), thisNormal.ToFloat4().ToString().c_str(), (int)nf, 
-								f[nf].ToString().c_str(),
-								nghbNormal.ToFloat4().ToString().c_str(),
-								eNeg, ePos, nNeg, nPos, Max(ePos, nPos) - Min(eNeg, nNeg));
-							for(size_t x = 0; x < f[i].v.size(); ++x)
-								LOGI("Vertex %d: %s", (int)x, vec(v[f[i].v[x]]).SerializeToString().c_str());
-							for(size_t x = 0; x < f[nf].v.size(); ++x)
-								LOGI("Vertex %d: %s", (int)x, vec(v[f[nf].v[x]]).SerializeToString().c_str());
-#endif
-							++numMerges;
-							// Merge this face to neighboring face.
-							int fg = (int)i;
-							while(faceGroups[fg] != fg)
-								fg = faceGroups[fg];
-							int nfgr = nf;
-							while(faceGroups[nfgr] != nfgr)
-								nfgr = faceGroups[nfgr];
-							faceGroups[fg] = nfgr;
-							break;
-						}
+						++numMerges;
+						// Merge this face to neighboring face.
+						int fg = (int)i;
+						while(faceGroups[fg] != fg)
+							fg = faceGroups[fg];
+						int nfgr = nf;
+						while(faceGroups[nfgr] != nfgr)
+							nfgr = faceGroups[nfgr];
+						faceGroups[fg] = nfgr;
+						break;
 					}
 				}
 			}
-			v0 = v1;
 		}
 	}
 
@@ -2974,6 +3584,743 @@ int Polyhedron::MergeAdjacentPlanarFaces(bool snapVerticesToMergedPlanes, bool c
 	return numMerges;
 }
 
+namespace
+{
+	/// The error quadric of Garland and Heckbert: the sum of the weighted squared distances of a point to a set of planes,
+	/// stored as the upper triangle of the symmetric 4x4 matrix of the quadratic form.
+	/** The quadrics are accumulated in double precision, since the sums of many nearly parallel planes are close to
+		singular, and the optimal collapse position is solved from them. */
+	struct ErrorQuadric
+	{
+		double xx, xy, xz, xw, yy, yz, yw, zz, zw, ww;
+
+		void SetZero()
+		{
+			xx = xy = xz = xw = yy = yz = yw = zz = zw = ww = 0.0;
+		}
+
+		/// Adds the plane ax + by + cz + d = 0, where (a, b, c) is normalized.
+		void AddPlane(double a, double b, double c, double d, double weight)
+		{
+			xx += weight*a*a; xy += weight*a*b; xz += weight*a*c; xw += weight*a*d;
+			yy += weight*b*b; yz += weight*b*c; yw += weight*b*d;
+			zz += weight*c*c; zw += weight*c*d;
+			ww += weight*d*d;
+		}
+
+		void Add(const ErrorQuadric &q)
+		{
+			xx += q.xx; xy += q.xy; xz += q.xz; xw += q.xw;
+			yy += q.yy; yz += q.yz; yw += q.yw;
+			zz += q.zz; zw += q.zw;
+			ww += q.ww;
+		}
+
+		double Error(const vec &p) const
+		{
+			const double x = p.x, y = p.y, z = p.z;
+			const double e = x*(xx*x + 2.0*(xy*y + xz*z + xw)) + y*(yy*y + 2.0*(yz*z + yw)) + z*(zz*z + 2.0*zw) + ww;
+			return Max(e, 0.0);
+		}
+
+		/// Computes the point that minimizes the error.
+		/** @return False if the minimum is not unique, which happens when the planes are (nearly) parallel to a common line. */
+		bool Minimize(vec &outPoint) const
+		{
+			// Solve the 3x3 system with Cramer's rule.
+			const double c00 = yy*zz - yz*yz, c01 = xz*yz - xy*zz, c02 = xy*yz - xz*yy;
+			const double det = xx*c00 + xy*c01 + xz*c02;
+			const double scale = Max(xx, yy, zz);
+			if (!(Abs(det) > 1e-9 * scale * scale * scale))
+				return false;
+			const double c11 = xx*zz - xz*xz, c12 = xy*xz - xx*yz, c22 = xx*yy - xy*xy;
+			const double invDet = -1.0 / det;
+			outPoint = POINT_VEC((float)((c00*xw + c01*yw + c02*zw) * invDet),
+			                     (float)((c01*xw + c11*yw + c12*zw) * invDet),
+			                     (float)((c02*xw + c12*yw + c22*zw) * invDet));
+			return true;
+		}
+	};
+
+	/// The number of candidate positions EdgeCollapseMesh considers for each edge collapse.
+	const int maxCollapsePositions = 5;
+
+	/// An entry of the priority queue of edge collapses.
+	struct EdgeCollapse
+	{
+		double cost;
+		int from, to;
+		/// The versions of the two vertices when the entry was queued. If either vertex has changed since, the entry is stale.
+		unsigned int fromVersion, toVersion;
+
+		/// Orders std::priority_queue to return the lowest cost first.
+		bool operator <(const EdgeCollapse &rhs) const { return cost > rhs.cost; }
+	};
+
+	/// A closed manifold triangle mesh stored as half-edges, which supports the edge collapse operation.
+	/** The connectivity is built with HalfEdgeMesh. The collapses then edit mutable copies of its origin and twin arrays.
+		The half-edge 3*t+k belongs to the triangle t, and runs from its vertex k to its vertex (k+1)%3. */
+	class EdgeCollapseMesh
+	{
+	public:
+		/// Builds the mesh from the given polyhedron, splitting its faces to triangle fans.
+		/** @return False if the faces of the polyhedron do not form a closed manifold surface, which the edge collapse
+			operation needs. */
+		bool Set(const Polyhedron &polyhedron, bool preserveConvexity);
+
+		/// Collapses the cheapest edges until at most maxVertices vertices remain, or no more edges can be collapsed.
+		void Simplify(int maxVertices);
+
+		/// Writes the remaining vertices and triangles to the given polyhedron.
+		void ToPolyhedron(Polyhedron &polyhedron) const;
+
+	private:
+		static int Next(int halfEdge) { return halfEdge % 3 == 2 ? halfEdge - 2 : halfEdge + 1; }
+		static int Prev(int halfEdge) { return halfEdge % 3 == 0 ? halfEdge + 2 : halfEdge - 1; }
+		int Destination(int halfEdge) const { return origin[Next(halfEdge)]; }
+
+		/// Returns the half-edge that runs from the vertex 'from' to the vertex 'to', or -1 if there is none.
+		int FindHalfEdge(int from, int to) const;
+
+		/// Returns true if the vertices of the edge have no common neighbors other than the two vertices opposite to the
+		/// edge, so that collapsing the edge keeps the surface manifold.
+		bool LinkConditionHolds(int halfEdge);
+
+		/// Returns the twin that the given half-edge will have after collapsing the given edge.
+		int TwinAfterCollapse(int halfEdge, int collapsedEdge) const;
+
+		/// Tests whether moving both vertices of the edge to newPosition keeps the triangles around it from flipping over,
+		/// and, if convexity is preserved, keeps all the edges around the new vertex convex.
+		bool CollapseIsValid(int halfEdge, const vec &newPosition) const;
+
+		/// Computes the positions the given edge may be collapsed to, sorted by increasing error.
+		/** @param outPositions [out] An array of maxCollapsePositions elements.
+			@param includeHullPosition If true and convexity is preserved, adds the result of MinimumVolumeHullPosition(),
+				which is the most expensive candidate to compute. */
+		int CollapsePositions(int from, int to, bool includeHullPosition, vec *outPositions, double *outCosts) const;
+
+		/// Computes the position that adds the least volume to the mesh when the given edge collapses to it, while
+		/// staying on or in front of the planes of all the triangles around the edge (Sander et al., "Progressive Hulls",
+		/// 2000). Collapsing a convex mesh to such a position keeps the old mesh inside the new one.
+		/** @return False if the edge has too many triangles around it, or no such position was found. */
+		bool MinimumVolumeHullPosition(int from, int to, vec &outPosition) const;
+
+		/// Finds the cheapest position the given edge can be collapsed to without breaking the mesh.
+		/** @return False if the edge cannot be collapsed to any of the candidate positions. */
+		bool CheapestValidPosition(int halfEdge, vec &outPosition, double &outCost) const;
+
+		/// Queues the collapse of the edge between the given vertices.
+		void QueueEdge(int from, int to);
+
+		/// Queues the collapses of all edges around the given vertex.
+		void QueueEdges(int vertex);
+
+		/// Replaces the queue with the collapses of all edges.
+		void QueueAllEdges();
+
+		/// Marks the vertices whose edges may have become collapsible when an edge collapsed to the given vertex.
+		void MarkNeighborsDirty(int vertex);
+		void MarkDirty(int vertex);
+
+		/// Requeues the blocked edges that have a dirty vertex, and clears the dirty marks.
+		void RequeueDirtyBlockedEdges();
+
+		/// Merges the origin of the half-edge to its destination, which moves to newPosition.
+		void Collapse(int halfEdge, const vec &newPosition);
+
+		std::vector<vec> positions;
+		std::vector<ErrorQuadric> quadrics;
+		/// An outgoing half-edge of each vertex, or -1 for the vertices that have been removed.
+		std::vector<int> vertexHalfEdge;
+		std::vector<unsigned int> vertexVersion;
+		std::vector<int> origin;
+		std::vector<int> twin;
+		std::vector<char> triangleAlive;
+		int numVertices;
+
+		/// +1 if the triangles are wound counterclockwise as seen from the outside, and -1 if clockwise.
+		float orientation;
+		bool preserveConvexity;
+		/// The distance a vertex may lie in front of the plane of a neighboring triangle before the edge between them is
+		/// considered concave.
+		float convexityEpsilon;
+
+		std::priority_queue<EdgeCollapse> queue;
+		/// Scratch space of LinkConditionHolds().
+		std::vector<unsigned int> visited;
+		unsigned int visitColor;
+		/// The edges that could not be collapsed when they were taken from the queue, as (from, to) pairs.
+		std::vector<std::pair<int, int> > blockedEdges;
+		/// The vertices whose neighborhood has changed since the blocked edges were last requeued.
+		std::vector<char> dirty;
+		std::vector<int> dirtyVertices;
+	};
+
+	bool EdgeCollapseMesh::Set(const Polyhedron &polyhedron, bool preserveConvexity_)
+	{
+		preserveConvexity = preserveConvexity_;
+		const int numInputVertices = polyhedron.NumVertices();
+
+		// Split the faces to triangle fans, so that the half-edges of the triangle t in the HalfEdgeMesh are 3*t to 3*t+2.
+		Polyhedron triangles;
+		triangles.v = polyhedron.v;
+		for(int i = 0; i < polyhedron.NumFaces(); ++i)
+		{
+			const std::vector<int> &face = polyhedron.f[i].v;
+			for(size_t j = 0; j < face.size(); ++j)
+				if (face[j] < 0 || face[j] >= numInputVertices)
+					return false;
+			for(size_t j = 2; j < face.size(); ++j)
+			{
+				Polyhedron::Face triangle;
+				triangle.v.push_back(face[0]);
+				triangle.v.push_back(face[j-1]);
+				triangle.v.push_back(face[j]);
+				triangles.f.push_back(triangle);
+			}
+		}
+		if (triangles.f.empty())
+			return false;
+
+		// Each directed edge must occur exactly once, and have a twin.
+		HalfEdgeMesh mesh(triangles);
+		if (!mesh.IsClosed())
+			return false;
+		const int numHalfEdges = mesh.NumHalfEdges();
+		origin.resize(numHalfEdges);
+		twin.resize(numHalfEdges);
+		for(int i = 0; i < numHalfEdges; ++i)
+		{
+			if (mesh.Origin(i) == mesh.Destination(i))
+				return false;
+			origin[i] = mesh.Origin(i);
+			twin[i] = mesh.Twin(i);
+		}
+
+		// Each vertex must have a single fan of triangles around it, so that the fan can be walked from any of its half-edges.
+		vertexHalfEdge.assign(numInputVertices, -1);
+		numVertices = 0;
+		for(int i = 0; i < numInputVertices; ++i)
+		{
+			const int numOutgoing = mesh.NumOutgoing(i);
+			if (numOutgoing == 0)
+				continue;
+			++numVertices;
+			vertexHalfEdge[i] = mesh.Outgoing(i)[0];
+			int fanSize = 0;
+			int h = vertexHalfEdge[i];
+			do
+			{
+				++fanSize;
+				h = twin[Prev(h)];
+			} while(h != vertexHalfEdge[i] && fanSize <= numOutgoing);
+			if (fanSize != numOutgoing)
+				return false;
+		}
+
+		positions.assign(triangles.v.begin(), triangles.v.end());
+		vertexVersion.assign(numInputVertices, 0);
+		blockedEdges.clear();
+		dirty.assign(numInputVertices, 0);
+		dirtyVertices.clear();
+		triangleAlive.assign(numHalfEdges / 3, 1);
+		visited.assign(numInputVertices, 0);
+		visitColor = 0;
+
+		// Each vertex starts with the planes of the triangles around it, weighted by their areas, so that the error of a
+		// collapse measures the volume it adds or removes rather than the number of triangles it affects.
+		quadrics.resize(numInputVertices);
+		for(int i = 0; i < numInputVertices; ++i)
+			quadrics[i].SetZero();
+		AABB aabb;
+		aabb.SetNegativeInfinity();
+		double signedVolume = 0.0;
+		for(int t = 0; t < numHalfEdges / 3; ++t)
+		{
+			const vec &a = positions[origin[3*t]];
+			const vec &b = positions[origin[3*t+1]];
+			const vec &c = positions[origin[3*t+2]];
+			aabb.Enclose(a);
+			aabb.Enclose(b);
+			aabb.Enclose(c);
+			const double nx = ((double)b.y - a.y) * ((double)c.z - a.z) - ((double)b.z - a.z) * ((double)c.y - a.y);
+			const double ny = ((double)b.z - a.z) * ((double)c.x - a.x) - ((double)b.x - a.x) * ((double)c.z - a.z);
+			const double nz = ((double)b.x - a.x) * ((double)c.y - a.y) - ((double)b.y - a.y) * ((double)c.x - a.x);
+			signedVolume += nx * a.x + ny * a.y + nz * a.z;
+			const double length = std::sqrt(nx*nx + ny*ny + nz*nz);
+			if (length > 0.0)
+			{
+				const double d = -(nx * a.x + ny * a.y + nz * a.z) / length;
+				const double area = 0.5 * length;
+				for(int k = 0; k < 3; ++k)
+					quadrics[origin[3*t+k]].AddPlane(nx / length, ny / length, nz / length, d, area);
+			}
+		}
+		if (!aabb.IsFinite())
+			return false;
+		orientation = signedVolume >= 0.0 ? 1.f : -1.f;
+		convexityEpsilon = 1e-5f * aabb.Size().Length();
+
+		return true;
+	}
+
+	int EdgeCollapseMesh::FindHalfEdge(int from, int to) const
+	{
+		const int first = vertexHalfEdge[from];
+		int h = first;
+		do
+		{
+			if (Destination(h) == to)
+				return h;
+			h = twin[Prev(h)];
+		} while(h != first);
+		return -1;
+	}
+
+	bool EdgeCollapseMesh::LinkConditionHolds(int halfEdge)
+	{
+		const int from = origin[halfEdge];
+		const int to = Destination(halfEdge);
+		const int a = origin[Prev(halfEdge)];
+		const int b = origin[Prev(twin[halfEdge])];
+		if (a == b)
+			return false;
+
+		++visitColor;
+		int h = vertexHalfEdge[from];
+		do
+		{
+			visited[Destination(h)] = visitColor;
+			h = twin[Prev(h)];
+		} while(h != vertexHalfEdge[from]);
+
+		h = vertexHalfEdge[to];
+		do
+		{
+			const int w = Destination(h);
+			if (visited[w] == visitColor && w != a && w != b)
+				return false;
+			h = twin[Prev(h)];
+		} while(h != vertexHalfEdge[to]);
+		return true;
+	}
+
+	int EdgeCollapseMesh::TwinAfterCollapse(int halfEdge, int collapsedEdge) const
+	{
+		// The two triangles of the edge disappear, and the outer half-edges of each of them become twins of each other.
+		const int t = twin[halfEdge];
+		const int t0 = collapsedEdge / 3;
+		const int t1 = twin[collapsedEdge] / 3;
+		if (t / 3 != t0 && t / 3 != t1)
+			return t;
+		const int next = Next(t);
+		const int prev = Prev(t);
+		// The half-edge runs along one of the two other edges of a disappearing triangle. Its new twin is the outer
+		// half-edge of the third edge of that triangle, which is the one that does not lie on the collapsed edge.
+		if (next == collapsedEdge || next == twin[collapsedEdge])
+			return twin[prev];
+		else
+			return twin[next];
+	}
+
+	bool EdgeCollapseMesh::CollapseIsValid(int halfEdge, const vec &newPosition) const
+	{
+		const int from = origin[halfEdge];
+		const int to = Destination(halfEdge);
+		const int t0 = halfEdge / 3;
+		const int t1 = twin[halfEdge] / 3;
+
+		// Walk the triangles around both vertices, skipping the two that disappear.
+		for(int side = 0; side < 2; ++side)
+		{
+			const int vertex = side == 0 ? from : to;
+			const int first = vertexHalfEdge[vertex];
+			int h = first;
+			do
+			{
+				const int t = h / 3;
+				if (t != t0 && t != t1)
+				{
+					const int hNext = Next(h);
+					const int hPrev = Prev(h);
+					const vec &p1 = positions[origin[hNext]];
+					const vec &p2 = positions[origin[hPrev]];
+					const vec oldNormal = Cross(p1 - positions[vertex], p2 - positions[vertex]);
+					const vec newNormal = Cross(p1 - newPosition, p2 - newPosition);
+					if (!(Dot(oldNormal, newNormal) > 0.f))
+						return false;
+
+					if (preserveConvexity)
+					{
+						// The vertex across each edge of the triangle must lie behind the plane of the triangle.
+						const float length = newNormal.Length();
+						if (!(length > 0.f))
+							return false;
+						const vec normal = newNormal * (orientation / length);
+						const int edges[3] = { h, hNext, hPrev };
+						for(int k = 0; k < 3; ++k)
+						{
+							const int across = origin[Prev(TwinAfterCollapse(edges[k], halfEdge))];
+							const vec &p = (across == from || across == to) ? newPosition : positions[across];
+							if (Dot(normal, p - newPosition) > convexityEpsilon)
+								return false;
+						}
+					}
+				}
+				h = twin[Prev(h)];
+			} while(h != first);
+		}
+		return true;
+	}
+
+	int EdgeCollapseMesh::CollapsePositions(int from, int to, bool includeHullPosition, vec *outPositions, double *outCosts) const
+	{
+		ErrorQuadric q = quadrics[from];
+		q.Add(quadrics[to]);
+
+		const vec &a = positions[from];
+		const vec &b = positions[to];
+		int n = 0;
+		outPositions[n++] = a;
+		outPositions[n++] = b;
+		outPositions[n++] = (a + b) * 0.5f;
+		// Nearly singular quadrics can place the optimum far away from the edge. Such positions would create spikes.
+		vec optimum;
+		if (q.Minimize(optimum) && optimum.IsFinite() && optimum.DistanceSq(outPositions[2]) <= a.DistanceSq(b))
+			outPositions[n++] = optimum;
+		// The midpoint and the endpoints of an edge of a convex mesh are usually not valid, since they make the mesh
+		// concave, so add a position that keeps the mesh convex.
+		if (includeHullPosition && preserveConvexity && MinimumVolumeHullPosition(from, to, optimum) && optimum.DistanceSq(outPositions[2]) <= a.DistanceSq(b))
+			outPositions[n++] = optimum;
+
+		for(int i = 0; i < n; ++i)
+			outCosts[i] = q.Error(outPositions[i]);
+		// Insertion sort of the few candidates.
+		for(int i = 1; i < n; ++i)
+			for(int j = i; j > 0 && outCosts[j] < outCosts[j-1]; --j)
+			{
+				Swap(outCosts[j], outCosts[j-1]);
+				Swap(outPositions[j], outPositions[j-1]);
+			}
+		return n;
+	}
+
+	bool EdgeCollapseMesh::MinimumVolumeHullPosition(int from, int to, vec &outPosition) const
+	{
+		// The solution lies at the intersection of three of the planes. The mesh simplifies mostly around vertices of
+		// degree six, so enumerating all the triples is cheaper than a general linear program solver.
+		const int maxPlanes = 20;
+		vec normals[maxPlanes];
+		float offsets[maxPlanes];
+		int numPlanes = 0;
+		// The volume between the new triangles and the old ones is linear in the new position, with the sum of the
+		// area-weighted normals of the old triangles as the gradient.
+		vec volumeGradient = vec::zero;
+		for(int side = 0; side < 2; ++side)
+		{
+			const int vertex = side == 0 ? from : to;
+			const int first = vertexHalfEdge[vertex];
+			int h = first;
+			do
+			{
+				// The triangles on the edge are around both vertices, and are added only once.
+				if (side == 0 || (origin[Next(h)] != from && origin[Prev(h)] != from))
+				{
+					const vec &p0 = positions[vertex];
+					const vec areaNormal = Cross(positions[origin[Next(h)]] - p0, positions[origin[Prev(h)]] - p0) * orientation;
+					const float length = areaNormal.Length();
+					if (length > 0.f)
+					{
+						volumeGradient += areaNormal;
+						const vec normal = areaNormal / length;
+						const float offset = Dot(normal, p0);
+						// Faces split to triangles give several copies of the same plane. Only one is needed.
+						int i = 0;
+						while(i < numPlanes && !(Dot(normals[i], normal) > 1.f - 1e-5f && Abs(offsets[i] - offset) <= convexityEpsilon))
+							++i;
+						if (i == numPlanes)
+						{
+							if (numPlanes == maxPlanes)
+								return false;
+							normals[numPlanes] = normal;
+							offsets[numPlanes] = offset;
+							++numPlanes;
+						}
+					}
+				}
+				h = twin[Prev(h)];
+			} while(h != first);
+		}
+
+		// The intersection point of the planes i, j and k is (o_i * n_j x n_k + o_j * n_k x n_i + o_k * n_i x n_j) / det.
+		// Precompute the cross products of each pair, and their projections to the gradient, so that the volume of each
+		// triple can be compared before solving its intersection point.
+		vec cross[maxPlanes][maxPlanes];
+		float crossGradient[maxPlanes][maxPlanes];
+		for(int i = 0; i < numPlanes; ++i)
+			for(int j = i+1; j < numPlanes; ++j)
+			{
+				cross[i][j] = Cross(normals[i], normals[j]);
+				crossGradient[i][j] = Dot(cross[i][j], volumeGradient);
+			}
+
+		float bestVolume = FLOAT_INF;
+		for(int i = 0; i < numPlanes; ++i)
+			for(int j = i+1; j < numPlanes; ++j)
+				for(int k = j+1; k < numPlanes; ++k)
+				{
+					const float det = Dot(cross[i][j], normals[k]);
+					if (Abs(det) < 1e-3f)
+						continue; // The planes are nearly parallel to a common line.
+					const float volume = (offsets[i] * crossGradient[j][k] - offsets[j] * crossGradient[i][k] + offsets[k] * crossGradient[i][j]) / det;
+					if (!(volume < bestVolume))
+						continue;
+					const vec pt = (offsets[i] * cross[j][k] - offsets[j] * cross[i][k] + offsets[k] * cross[i][j]) / det;
+					int l = 0;
+					while(l < numPlanes && Dot(normals[l], pt) >= offsets[l] - convexityEpsilon)
+						++l;
+					if (l == numPlanes)
+					{
+						bestVolume = volume;
+						outPosition = POINT_VEC(pt.x, pt.y, pt.z);
+					}
+				}
+		return bestVolume != FLOAT_INF;
+	}
+
+	bool EdgeCollapseMesh::CheapestValidPosition(int halfEdge, vec &outPosition, double &outCost) const
+	{
+		// No position has a lower error than the optimum of the quadric, which is usually the cheapest candidate. Only
+		// if it is not valid can MinimumVolumeHullPosition() give a better position, so it is computed only then.
+		const int numPasses = preserveConvexity ? 2 : 1;
+		for(int pass = 0; pass < numPasses; ++pass)
+		{
+			vec collapsePositions[maxCollapsePositions];
+			double costs[maxCollapsePositions];
+			const int numPositions = CollapsePositions(origin[halfEdge], Destination(halfEdge), pass == 1, collapsePositions, costs);
+			for(int i = 0; i < numPositions; ++i)
+				if (CollapseIsValid(halfEdge, collapsePositions[i]))
+				{
+					if (i > 0 && pass + 1 < numPasses)
+						break;
+					outPosition = collapsePositions[i];
+					outCost = costs[i];
+					return true;
+				}
+		}
+		return false;
+	}
+
+	void EdgeCollapseMesh::QueueEdge(int from, int to)
+	{
+		vec collapsePositions[maxCollapsePositions];
+		double costs[maxCollapsePositions];
+		CollapsePositions(from, to, false, collapsePositions, costs);
+		EdgeCollapse collapse = { costs[0], from, to, vertexVersion[from], vertexVersion[to] };
+		queue.push(collapse);
+	}
+
+	void EdgeCollapseMesh::QueueEdges(int vertex)
+	{
+		const int first = vertexHalfEdge[vertex];
+		int h = first;
+		do
+		{
+			QueueEdge(vertex, Destination(h));
+			h = twin[Prev(h)];
+		} while(h != first);
+	}
+
+	void EdgeCollapseMesh::QueueAllEdges()
+	{
+		while(!queue.empty())
+			queue.pop();
+		for(int i = 0; i < (int)origin.size(); ++i)
+			if (triangleAlive[i / 3] && origin[i] < Destination(i))
+				QueueEdge(origin[i], Destination(i));
+	}
+
+	void EdgeCollapseMesh::MarkDirty(int vertex)
+	{
+		if (!dirty[vertex])
+		{
+			dirty[vertex] = 1;
+			dirtyVertices.push_back(vertex);
+		}
+	}
+
+	void EdgeCollapseMesh::MarkNeighborsDirty(int vertex)
+	{
+		// The link condition and the flip test of an edge look at the triangles around its two vertices, so only the edges
+		// of the neighbors change. The convexity test also looks at the vertices across the edges of those triangles, so
+		// it needs the neighbors of the neighbors as well.
+		const int first = vertexHalfEdge[vertex];
+		int h = first;
+		do
+		{
+			const int neighbor = Destination(h);
+			MarkDirty(neighbor);
+			if (preserveConvexity)
+			{
+				int h2 = vertexHalfEdge[neighbor];
+				do
+				{
+					MarkDirty(Destination(h2));
+					h2 = twin[Prev(h2)];
+				} while(h2 != vertexHalfEdge[neighbor]);
+			}
+			h = twin[Prev(h)];
+		} while(h != first);
+	}
+
+	void EdgeCollapseMesh::RequeueDirtyBlockedEdges()
+	{
+		// A blocked edge whose vertices have the same neighborhood as when it was blocked would be blocked again.
+		size_t numKept = 0;
+		for(size_t i = 0; i < blockedEdges.size(); ++i)
+		{
+			const std::pair<int, int> &edge = blockedEdges[i];
+			if (vertexHalfEdge[edge.first] == -1 || vertexHalfEdge[edge.second] == -1)
+				continue;
+			if (dirty[edge.first] || dirty[edge.second])
+				QueueEdge(edge.first, edge.second);
+			else
+				blockedEdges[numKept++] = edge;
+		}
+		blockedEdges.resize(numKept);
+		for(size_t i = 0; i < dirtyVertices.size(); ++i)
+			dirty[dirtyVertices[i]] = 0;
+		dirtyVertices.clear();
+	}
+
+	void EdgeCollapseMesh::Collapse(int halfEdge, const vec &newPosition)
+	{
+		const int from = origin[halfEdge];
+		const int to = Destination(halfEdge);
+		const int opposite = twin[halfEdge];
+		const int a = origin[Prev(halfEdge)];
+		const int b = origin[Prev(opposite)];
+
+		// The outer half-edges of the two disappearing triangles.
+		const int toA = twin[Prev(halfEdge)]; // Runs from 'from' to a, and will run from 'to' to a.
+		const int aTo = twin[Next(halfEdge)];
+		const int bFrom = twin[Next(opposite)]; // Runs from b to 'from', and will run from b to 'to'.
+		const int toB = twin[Prev(opposite)];
+
+		int h = halfEdge;
+		do
+		{
+			origin[h] = to;
+			h = twin[Prev(h)];
+		} while(h != halfEdge);
+
+		twin[toA] = aTo;
+		twin[aTo] = toA;
+		twin[bFrom] = toB;
+		twin[toB] = bFrom;
+		vertexHalfEdge[to] = toA;
+		vertexHalfEdge[a] = aTo;
+		vertexHalfEdge[b] = bFrom;
+		vertexHalfEdge[from] = -1;
+		triangleAlive[halfEdge / 3] = 0;
+		triangleAlive[opposite / 3] = 0;
+
+		positions[to] = newPosition;
+		quadrics[to].Add(quadrics[from]);
+		++vertexVersion[to];
+		++vertexVersion[from];
+		--numVertices;
+	}
+
+	void EdgeCollapseMesh::Simplify(int maxVertices)
+	{
+		// A tetrahedron is the smallest closed surface.
+		maxVertices = Max(maxVertices, 4);
+		QueueAllEdges();
+		for(;;)
+		{
+			while(numVertices > maxVertices && !queue.empty())
+			{
+				EdgeCollapse collapse = queue.top();
+				queue.pop();
+				if (vertexHalfEdge[collapse.from] == -1 || vertexHalfEdge[collapse.to] == -1
+					|| vertexVersion[collapse.from] != collapse.fromVersion || vertexVersion[collapse.to] != collapse.toVersion)
+					continue; // Stale entry.
+
+				const int h = FindHalfEdge(collapse.from, collapse.to);
+				if (h == -1)
+					continue;
+
+				vec position;
+				double cost;
+				if (!LinkConditionHolds(h) || !CheapestValidPosition(h, position, cost))
+				{
+					blockedEdges.push_back(std::make_pair(collapse.from, collapse.to));
+					continue;
+				}
+
+				// If the cheapest position is not allowed, the collapse costs more than it was queued with, and other
+				// edges may now be cheaper.
+				if (cost > collapse.cost)
+				{
+					collapse.cost = cost;
+					queue.push(collapse);
+					continue;
+				}
+
+				Collapse(h, position);
+				QueueEdges(collapse.to);
+				MarkNeighborsDirty(collapse.to);
+			}
+			if (numVertices <= maxVertices)
+				break;
+
+			// An edge that cannot be collapsed is dropped from the queue, but it may become collapsible when the edges
+			// around it collapse. Requeue only the blocked edges whose neighborhood has changed since.
+			RequeueDirtyBlockedEdges();
+			if (queue.empty())
+				break;
+		}
+	}
+
+	void EdgeCollapseMesh::ToPolyhedron(Polyhedron &polyhedron) const
+	{
+		std::vector<int> newIndex(vertexHalfEdge.size(), -1);
+		polyhedron.v.clear();
+		for(size_t i = 0; i < vertexHalfEdge.size(); ++i)
+			if (vertexHalfEdge[i] != -1)
+			{
+				newIndex[i] = (int)polyhedron.v.size();
+				polyhedron.v.push_back(positions[i]);
+			}
+		polyhedron.f.clear();
+		for(size_t t = 0; t < triangleAlive.size(); ++t)
+			if (triangleAlive[t])
+			{
+				Polyhedron::Face face;
+				for(int k = 0; k < 3; ++k)
+					face.v.push_back(newIndex[origin[3*t+k]]);
+				polyhedron.f.push_back(face);
+			}
+	}
+}
+
+int Polyhedron::Simplify(int maxVertices, bool preserveConvexity)
+{
+	const int numVerticesBefore = NumVertices();
+	if (numVerticesBefore <= maxVertices)
+		return 0;
+
+	// Best: 9.187 msecs / 1.83739e+07 ticks for reducing a 506-vertex hull to 32 vertices, which brings GJKIntersect() against
+	// an OBB from 5.267 usecs down to 810 nsecs. See the benchmarks 'Polyhedron_Simplify_506' and 'GJKIntersect_OBB_Polyhedron32'.
+	EdgeCollapseMesh mesh;
+	if (!mesh.Set(*this, preserveConvexity))
+		return 0;
+	mesh.Simplify(maxVertices);
+	mesh.ToPolyhedron(*this);
+	return numVerticesBefore - NumVertices();
+}
+
 std::vector<std::vector<int> > Polyhedron::GenerateVertexAdjacencyData() const
 {
 	std::vector<std::vector<int> > adjacencyData;
@@ -3161,6 +4508,19 @@ std::string Polyhedron::ToString() const
 	return ss.str();
 }
 
+std::string Polyhedron::SerializeToString() const
+{
+	std::stringstream ss;
+	ss << "Polyhedron(v:";
+	for(size_t i = 0; i < v.size(); ++i)
+		ss << (i != 0 ? ",(" : "(") << v[i].SerializeToString() << ")";
+	ss << " f:";
+	for(size_t i = 0; i < f.size(); ++i)
+		ss << (i != 0 ? ",(" : "(") << f[i].ToString() << ")";
+	ss << ")";
+	return ss.str();
+}
+
 void Polyhedron::DumpStructure() const
 {
 	LOGI("Polyhedron volume: %f", Volume());
@@ -3261,29 +4621,29 @@ void Polyhedron::ToLineList(VertexBuffer &vb) const
 
 Polyhedron operator *(const float3x3 &transform, const Polyhedron &polyhedron)
 {
-	Polyhedron p(polyhedron);
-	p.Transform(transform);
+	Polyhedron p;
+	polyhedron.TransformTo(transform, p);
 	return p;
 }
 
 Polyhedron operator *(const float3x4 &transform, const Polyhedron &polyhedron)
 {
-	Polyhedron p(polyhedron);
-	p.Transform(transform);
+	Polyhedron p;
+	polyhedron.TransformTo(transform, p);
 	return p;
 }
 
 Polyhedron operator *(const float4x4 &transform, const Polyhedron &polyhedron)
 {
-	Polyhedron p(polyhedron);
-	p.Transform(transform);
+	Polyhedron p;
+	polyhedron.TransformTo(transform, p);
 	return p;
 }
 
 Polyhedron operator *(const Quat &transform, const Polyhedron &polyhedron)
 {
-	Polyhedron p(polyhedron);
-	p.Transform(transform);
+	Polyhedron p;
+	polyhedron.TransformTo(transform, p);
 	return p;
 }
 
@@ -255,13 +255,33 @@ public:
 	/// @return The number of faces that were removed by merging.
 	int MergeAdjacentPlanarFaces(bool snapVerticesToMergedPlanes, bool conservativeEnclose = true, float angleEpsilon = 1e-16f, float distanceEpsilon = 1e-8f);
 
+	/// Reduces the number of vertices of this polyhedron by collapsing edges, in the order of the quadric error metric.
+	/** Each vertex stores the sum of the squared distances to the planes of the faces around it (Garland and Heckbert,
+		"Surface Simplification Using Quadric Error Metrics", 1997). The edges are kept in a priority queue by the error of
+		collapsing them to the position that minimizes the sum of the quadrics of their endpoints. The cheapest edge is
+		collapsed first, until at most maxVertices vertices remain. Collapses that would make the surface non-manifold or
+		flip a face over are skipped. This is useful for reducing detailed hulls to cheaper collision proxies, since the
+		cost of GJK and SAT queries grows with the number of vertices.
+		@param maxVertices The number of vertices to reduce the polyhedron to. Values below 4 are treated as 4.
+		@param preserveConvexity If true, an edge is only collapsed to a position that keeps all edges convex, so a convex
+			polyhedron stays convex. If the optimal position is not convex, the edge is collapsed to the position that adds
+			the least volume while staying outside the planes of the faces around the edge (Sander et al., "Progressive
+			Hulls", 2000), so the result tends to grow rather than shrink. The result may keep more than maxVertices
+			vertices, if no edge can be collapsed without making the polyhedron concave.
+		@note The faces must form a closed manifold surface, or this function does nothing. The faces are split to
+			triangles, and the vertices that no face uses are removed.
+		@return The number of vertices that were removed.
+		@see MergeAdjacentPlanarFaces(), RemoveRedundantVertices(). */
+	int Simplify(int maxVertices, bool preserveConvexity = false);
+
 	/// Returns true if this polyhedron has 0 vertices and 0 faces.
 	/** @see FaceIndicesValid(), IsClosed(), IsConvex(). */
 	bool IsNull() const { return v.empty() && f.empty(); }
 
 	/// Returns true if this polyhedron is closed and does not have any gaps.
 	/** \note This function performs a quick check, which might not be complete.
-		The running time is O(FlogE) ~ O(VlogV).
+		The running time is O(E*D), where D is the largest number of edges at a vertex. To test the same polyhedron
+		repeatedly, build a HalfEdgeMesh of it once and call HalfEdgeMesh::IsClosed().
 		@see FaceIndicesValid(), IsClosed(), IsConvex(). */
 	bool IsClosed() const;
 
@@ -269,7 +289,7 @@ public:
 //	bool IsConnected() const;
 
 	/// Returns true if this polyhedron is convex.
-	/** The running time is O(F*V) ~ O(V^2).
+	/** The running time is O(F*V) ~ O(V^2). HalfEdgeMesh::IsConvex() performs a local test in linear time.
 		@see FaceIndicesValid(), IsClosed(), IsConvex().*/
 	bool IsConvex() const;
 
@@ -394,6 +414,9 @@ public:
 	/// Tests whether this <b>convex</b> polyhedron and the given object intersect.
 	/** This function is exactly like Intersects(), but this version assumes that this polyhedron is convex,
 		and uses a faster method of testing the intersection.
+		The Polyhedron version assumes that both polyhedra are convex, and runs the GJK algorithm on them in
+		O(V1 + V2) time per iteration, instead of testing the edges of each polyhedron against the faces of the other.
+		To test the same convex polyhedra many times, build a ConvexPolyhedron of each, and pass them to GJKIntersect().
 		@return True if an intersection occurs or one of the objects is contained inside the other, false otherwise.
 		@note This function assumes that this polyhedron is closed and the edges are not self-intersecting.
 		@see Contains(), ContainsConvex(), ClosestPoint(), ClosestPointConvex(), Distance(), Intersects().
@@ -401,9 +424,27 @@ public:
 	bool IntersectsConvex(const Line &line) const;
 	bool IntersectsConvex(const Ray &ray) const;
 	bool IntersectsConvex(const LineSegment &lineSegment) const;
+	bool IntersectsConvex(const Polyhedron &polyhedron) const;
 
 	void MergeConvex(const vec &point);
 
+	/// Clips this <b>convex</b> polyhedron against the given plane.
+	/** This function removes the part of this polyhedron which lies in the negative halfspace of the plane, like
+		Plane::Clip() does for line segments, and closes the cut with a new face that lies on the plane. The clipping
+		operation is performed in-place in O(V + F) time. The vertex and face arrays are reused, so that clipping an
+		already allocated polyhedron allocates only a few small temporary arrays. The vertices are classified against
+		the plane before any of these arrays are created, so if the plane does not cut this polyhedron, this function
+		returns without allocating anything.
+		The Polyhedron version computes the intersection of the two convex polyhedra, by clipping this polyhedron
+		against each face plane of the given polyhedron in turn, so that the part outside it is removed. The faces of the
+		given polyhedron may be wound in either order, as long as they are wound consistently.
+		@return False if the whole polyhedron was clipped away, in which case this polyhedron is left empty. True if
+			something remains.
+		@note Vertices closer than a small epsilon to the plane are considered to lie on it, and are kept as is.
+		@see Plane::Clip(), IntersectsConvex(). */
+	bool ClipConvex(const Plane &plane);
+	bool ClipConvex(const Polyhedron &convexPolyhedron);
+
 	/// Translates this Polyhedron in world space.
 	/** @param offset The amount of displacement to apply to this Polyhedron, in world space coordinates.
 		@see Transform(). */
@@ -411,18 +452,42 @@ public:
 
 	/// Applies a transformation to this Polyhedron.
 	/** This function operates in-place.
-		@see Translate(), classes float3x3, float3x4, float4x4, Quat. */
+		@see Translate(), TransformTo(), classes float3x3, float3x4, float4x4, Quat. */
 	void Transform(const float3x3 &transform);
 	void Transform(const float3x4 &transform);
 	void Transform(const float4x4 &transform);
 	void Transform(const Quat &transform);
 
+	/// Writes a transformed copy of this Polyhedron to the given Polyhedron.
+	/** The vertices are transformed in batches, and the faces are copied over. The storage of outPolyhedron is reused,
+		so when the same destination is used to instance many polyhedra of similar size, this function does not
+		allocate memory once the destination has grown large enough.
+		@param outPolyhedron [out] Receives the transformed polyhedron. This may be this Polyhedron itself, in which
+			case this function is the same as Transform().
+		@see Transform(). */
+	void TransformTo(const float3x3 &transform, Polyhedron &outPolyhedron) const;
+	void TransformTo(const float3x4 &transform, Polyhedron &outPolyhedron) const;
+	void TransformTo(const float4x4 &transform, Polyhedron &outPolyhedron) const;
+	void TransformTo(const Quat &transform, Polyhedron &outPolyhedron) const;
+
 	/// Creates a Polyhedron object that represents the convex hull of the given point array.
-	/// \todo This function is strongly WIP!
+	/** The hull is computed with the Quickhull algorithm. Faces that are coplanar up to a small epsilon are merged into
+		convex polygons, and points that lie on the faces or edges of the hull are not returned as vertices.
+		If the points lie on a plane, the result is a convex polygon with one face on each side. If the points are
+		collinear or coincide, or the array contains non-finite points, an empty polyhedron is returned.
+		@param rng The random number generator that picks the order in which the faces of the hull are expanded. */
 	static Polyhedron ConvexHull(const VecArray &points) { return !points.empty() ? ConvexHull((const vec*)&points[0], (int)points.size()) : Polyhedron(); }
 	static Polyhedron ConvexHull(const VecArray &points, LCG &rng) { return !points.empty() ? ConvexHull((const vec*)&points[0], (int)points.size(), rng) : Polyhedron(); }
 	static Polyhedron ConvexHull(const vec *pointArray, int numPoints);
 	static Polyhedron ConvexHull(const vec *pointArray, int numPoints, LCG &rng);
+	/// Computes the convex hull of the given point array on multiple threads.
+	/** The points are split to chunks of pointsPerChunk consecutive points. First, the extreme points along 26 fixed
+		directions are searched for, and the points inside the hull of these extreme points are culled. Then the hulls
+		of the remaining points of each chunk are computed in parallel, and the result is the hull of the vertices of
+		these partial hulls.
+		@param pointsPerChunk The number of points in each chunk. Pass in 0 to choose automatically based on the number
+			of points and threads. */
+	static Polyhedron ConvexHull(const vec *pointArray, int numPoints, ThreadPool &threadPool, int pointsPerChunk = 0);
 
 	static Polyhedron Tetrahedron(const vec &centerPos = POINT_VEC_SCALAR(0.f), float scale = 1.f, bool ccwIsFrontFacing = true);
 	static Polyhedron Octahedron(const vec &centerPos = POINT_VEC_SCALAR(0.f), float scale = 1.f, bool ccwIsFrontFacing = true);
@@ -458,6 +523,9 @@ public:
 	TriangleArray Triangulate() const;
 
 	std::string ToString() const;
+	/// Returns the vertices and the faces of this polyhedron in a string of form "Polyhedron(v:(x,y,z),(x,y,z),... f:(0, 1, 2),...)".
+	/** The GJK functions include this string in their diagnostic messages. */
+	std::string SerializeToString() const;
 	void DumpStructure() const;
 
 #ifdef MATH_GRAPHICSENGINE_INTEROP
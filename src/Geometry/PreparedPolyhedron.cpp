@@ -0,0 +1,315 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file PreparedPolyhedron.cpp
+	@author Jukka Jylanki
+	@brief Implementation of the point containment accelerator for closed polyhedra. */
+#include "PreparedPolyhedron.h"
+#include "../Math/assume.h"
+#include "../Math/MathFunc.h"
+#include "../Algorithm/ThreadPool.h"
+
+MATH_BEGIN_NAMESPACE
+
+namespace
+{
+	/// Returns true if the point (ay, az) comes before the point (by, bz) in lexicographic order.
+	inline bool LessYZ(float ay, float az, float by, float bz)
+	{
+		return ay < by || (ay == by && az < bz);
+	}
+
+	/// Tests which side of the directed edge a->b the point p lies on the YZ plane. Returns true if p is on the left
+	/// side, i.e. if the triangle (a, b, p) is counterclockwise. A point exactly on the line is on the left if b comes
+	/// after a in lexicographic order.
+	/** The same expression is evaluated for both directions of an edge, with the endpoints in lexicographic order, so
+		the result for b->a is always the exact opposite of the result for a->b, regardless of rounding and of
+		whether the compiler contracts the expression to fused multiply-adds. Two triangles that share an edge
+		therefore never both claim, or both reject, a ray that passes through the edge.
+		@param e [out] Receives the signed area of the triangle (a, b, p) times two. */
+	inline bool EdgeSide(float ay, float az, float by, float bz, float py, float pz, float &e)
+	{
+		if (LessYZ(ay, az, by, bz))
+		{
+			e = (ay - py) * (bz - pz) - (az - pz) * (by - py);
+			return e >= 0.f;
+		}
+		else
+		{
+			e = (by - py) * (az - pz) - (bz - pz) * (ay - py);
+			bool side = e < 0.f;
+			e = -e;
+			return side;
+		}
+	}
+
+	/// Computes the Y extents of the part of the triangle with the vertices (ys[i], zs[i]) that lies between zLo and zHi.
+	/** @return False if no part of the triangle lies between zLo and zHi. */
+	bool SlabExtentY(const float *ys, const float *zs, float zLo, float zHi, float &outMinY, float &outMaxY)
+	{
+		outMinY = FLOAT_INF;
+		outMaxY = -FLOAT_INF;
+		for(int i = 0, j = 2; i < 3; j = i++)
+		{
+			if (zs[i] >= zLo && zs[i] <= zHi)
+			{
+				outMinY = Min(outMinY, ys[i]);
+				outMaxY = Max(outMaxY, ys[i]);
+			}
+			// Add the points where the edge j->i crosses the boundaries of the slab.
+			const float zBounds[2] = { zLo, zHi };
+			for(int k = 0; k < 2; ++k)
+				if ((zs[i] < zBounds[k]) != (zs[j] < zBounds[k]))
+				{
+					const float y = ys[j] + (ys[i] - ys[j]) * ((zBounds[k] - zs[j]) / (zs[i] - zs[j]));
+					outMinY = Min(outMinY, y);
+					outMaxY = Max(outMaxY, y);
+				}
+		}
+		return outMinY <= outMaxY;
+	}
+
+	struct ContainsManyJob
+	{
+		const PreparedPolyhedron *polyhedron;
+		const vec *points;
+		int numPoints;
+		u32 *outBits;
+	};
+
+	/// Computes the result words [beginWord, endWord[ of ContainsMany().
+	void ContainsWords(const PreparedPolyhedron &polyhedron, const vec *points, int numPoints, u32 *outBits, int beginWord, int endWord)
+	{
+		for(int word = beginWord; word < endWord; ++word)
+		{
+			const int begin = word * 32;
+			const int end = Min(begin + 32, numPoints);
+			u32 bits = 0;
+			for(int i = begin; i < end; ++i)
+				if (polyhedron.Contains(points[i]))
+					bits |= 1u << (i - begin);
+			outBits[word] = bits;
+		}
+	}
+
+	void ContainsManyJobFunc(void *userData, int beginWord, int endWord)
+	{
+		const ContainsManyJob &job = *(const ContainsManyJob *)userData;
+		ContainsWords(*job.polyhedron, job.points, job.numPoints, job.outBits, beginWord, endWord);
+	}
+}
+
+PreparedPolyhedron::PreparedPolyhedron()
+:numTriangles(0),
+minX(0.f), minY(0.f), minZ(0.f), maxX(-1.f), maxY(-1.f), maxZ(-1.f),
+numCellsY(1), numCellsZ(1), invCellSizeY(0.f), invCellSizeZ(0.f)
+{
+	cellStart.resize(2, 0);
+}
+
+PreparedPolyhedron::PreparedPolyhedron(const Polyhedron &polyhedron)
+{
+	Set(polyhedron);
+}
+
+void PreparedPolyhedron::Set(const Polyhedron &polyhedron)
+{
+	*this = PreparedPolyhedron();
+
+	// Split the faces to triangle fans. The triangles keep the winding order of the faces, which gives their
+	// orientation on the YZ plane.
+	for(size_t i = 0; i < polyhedron.f.size(); ++i)
+	{
+		const std::vector<int> &face = polyhedron.f[i].v;
+		for(size_t j = 2; j < face.size(); ++j)
+		{
+			const vec &a = polyhedron.v[face[0]];
+			const vec &b = polyhedron.v[face[j-1]];
+			const vec &c = polyhedron.v[face[j]];
+			SurfaceTriangle t = { a.x, a.y, a.z, b.x, b.y, b.z, c.x, c.y, c.z, Max(a.x, b.x, c.x) };
+			triangles.push_back(t);
+		}
+	}
+	minX = minY = minZ = FLOAT_INF;
+	maxX = maxY = maxZ = -FLOAT_INF;
+	for(size_t i = 0; i < polyhedron.v.size(); ++i)
+	{
+		const vec &pt = polyhedron.v[i];
+		minX = Min(minX, pt.x); minY = Min(minY, pt.y); minZ = Min(minZ, pt.z);
+		maxX = Max(maxX, pt.x); maxY = Max(maxY, pt.y); maxZ = Max(maxZ, pt.z);
+	}
+	if (triangles.empty() || !(MATH_NS::IsFinite(minX) && MATH_NS::IsFinite(minY) && MATH_NS::IsFinite(minZ)
+		&& MATH_NS::IsFinite(maxX) && MATH_NS::IsFinite(maxY) && MATH_NS::IsFinite(maxZ)))
+	{
+		*this = PreparedPolyhedron();
+		return;
+	}
+	numTriangles = (int)triangles.size();
+
+	// Aim for square cells and about as many cells as there are triangles. A ray from a point then usually tests only
+	// the few triangles stacked in front of and behind the point.
+	const float sizeY = maxY - minY;
+	const float sizeZ = maxZ - minZ;
+	const int maxCellsPerAxis = 1024;
+	if (sizeY > 0.f && sizeZ > 0.f)
+	{
+		const float cellSize = Sqrt(sizeY * sizeZ / (float)numTriangles);
+		numCellsY = Clamp((int)Ceil(sizeY / cellSize), 1, maxCellsPerAxis);
+		numCellsZ = Clamp((int)Ceil(sizeZ / cellSize), 1, maxCellsPerAxis);
+		invCellSizeY = numCellsY / sizeY;
+		invCellSizeZ = numCellsZ / sizeZ;
+	}
+
+	// List each triangle in all the cells it overlaps, in compressed sparse row form. Each row of cells between the Z
+	// extents of the triangle gets the cells between the Y extents of the part of the triangle inside the row. The
+	// rows and the Y extents are widened by a small margin, since CellY() and CellZ() round the coordinates of the
+	// query point differently than the extents are computed here.
+	const int numCells = numCellsY * numCellsZ;
+	const float cellSizeY = (invCellSizeY > 0.f) ? 1.f / invCellSizeY : 0.f;
+	const float cellSizeZ = (invCellSizeZ > 0.f) ? 1.f / invCellSizeZ : 0.f;
+	const float marginY = 1e-3f * cellSizeY;
+	const float marginZ = 1e-3f * cellSizeZ;
+	std::vector<int> cellCounts(numCells + 1, 0);
+	for(int pass = 0; pass < 2; ++pass)
+	{
+		for(int i = 0; i < numTriangles; ++i)
+		{
+			const SurfaceTriangle &t = triangles[i];
+			const float ys[3] = { t.ay, t.by, t.cy };
+			const float zs[3] = { t.az, t.bz, t.cz };
+			const int z0 = CellZ(Min(t.az, t.bz, t.cz)), z1 = CellZ(Max(t.az, t.bz, t.cz));
+			for(int z = z0; z <= z1; ++z)
+			{
+				int y0 = CellY(Min(t.ay, t.by, t.cy)), y1 = CellY(Max(t.ay, t.by, t.cy));
+				if (z0 != z1)
+				{
+					const float zLo = minZ + z * cellSizeZ - marginZ;
+					const float zHi = minZ + (z + 1) * cellSizeZ + marginZ;
+					float rowMinY, rowMaxY;
+					if (!SlabExtentY(ys, zs, zLo, zHi, rowMinY, rowMaxY))
+						continue;
+					y0 = CellY(rowMinY - marginY);
+					y1 = CellY(rowMaxY + marginY);
+				}
+				for(int y = y0; y <= y1; ++y)
+				{
+					const int cell = z * numCellsY + y;
+					if (pass == 0)
+						++cellCounts[cell];
+					else
+						cellTriangles[cellCounts[cell]++] = i;
+				}
+			}
+		}
+		if (pass == 0)
+		{
+			cellStart.resize(numCells + 1);
+			int sum = 0;
+			for(int cell = 0; cell < numCells; ++cell)
+			{
+				cellStart[cell] = sum;
+				sum += cellCounts[cell];
+				cellCounts[cell] = cellStart[cell];
+			}
+			cellStart[numCells] = sum;
+			cellTriangles.resize(sum);
+		}
+	}
+}
+
+int PreparedPolyhedron::CellY(float y) const
+{
+	return Clamp((int)((y - minY) * invCellSizeY), 0, numCellsY - 1);
+}
+
+int PreparedPolyhedron::CellZ(float z) const
+{
+	return Clamp((int)((z - minZ) * invCellSizeZ), 0, numCellsZ - 1);
+}
+
+int PreparedPolyhedron::Crossing(const SurfaceTriangle &tri, const vec &point)
+{
+	// The ray crosses the triangle if the point is on the same side of all three edges on the YZ plane. The side
+	// gives the orientation of the triangle as seen from the -X direction.
+	float eAB, eBC, eCA;
+	const bool sAB = EdgeSide(tri.ay, tri.az, tri.by, tri.bz, point.y, point.z, eAB);
+	const bool sBC = EdgeSide(tri.by, tri.bz, tri.cy, tri.cz, point.y, point.z, eBC);
+	if (sAB != sBC)
+		return 0;
+	const bool sCA = EdgeSide(tri.cy, tri.cz, tri.ay, tri.az, point.y, point.z, eCA);
+	if (sAB != sCA)
+		return 0;
+
+	// The edge functions are the barycentric coordinates of the crossing point, scaled by twice the signed area of
+	// the triangle, so this is the distance along the ray to the crossing point scaled by the same factor.
+	const float t = eBC * (tri.ax - point.x) + eCA * (tri.bx - point.x) + eAB * (tri.cx - point.x);
+	if (sAB)
+		return t > 0.f ? 1 : 0;
+	else
+		return t < 0.f ? -1 : 0;
+}
+
+bool PreparedPolyhedron::Contains(const vec &point) const
+{
+	// Best: 158.600 nsecs / 317.043 ticks, against 384.078 usecs with Polyhedron::Contains() on a non-convex mesh of
+	// 1000 triangles. See the benchmarks 'PreparedPolyhedron_Contains_VoxelCenter' and 'Polyhedron_Contains_VoxelCenter'.
+	// The negated comparisons also reject NaNs.
+	if (!(point.x >= minX && point.x <= maxX && point.y >= minY && point.y <= maxY && point.z >= minZ && point.z <= maxZ))
+		return false;
+
+	const int cell = CellZ(point.z) * numCellsY + CellY(point.y);
+	const SurfaceTriangle *t = triangles.empty() ? 0 : &triangles[0];
+	const int *indices = cellTriangles.empty() ? 0 : &cellTriangles[0];
+	int windingNumber = 0;
+	for(int i = cellStart[cell]; i < cellStart[cell+1]; ++i)
+	{
+		const SurfaceTriangle &tri = t[indices[i]];
+		if (tri.maxX > point.x)
+			windingNumber += Crossing(tri, point);
+	}
+	return windingNumber != 0;
+}
+
+void PreparedPolyhedron::ContainsMany(const vec *points, int numPoints, u32 *outBits) const
+{
+	assume(points || numPoints <= 0);
+	assume(outBits || numPoints <= 0);
+	if (numPoints <= 0)
+		return;
+	ContainsWords(*this, points, numPoints, outBits, 0, (numPoints + 31) / 32);
+}
+
+void PreparedPolyhedron::ContainsMany(const vec *points, int numPoints, u32 *outBits, ThreadPool &threadPool, int pointsPerChunk) const
+{
+	assume(points || numPoints <= 0);
+	assume(outBits || numPoints <= 0);
+	if (numPoints <= 0)
+		return;
+
+	const int numWords = (numPoints + 31) / 32;
+	int wordsPerChunk;
+	if (pointsPerChunk <= 0)
+		wordsPerChunk = Max(8, (numWords + 4 * threadPool.NumThreads() - 1) / (4 * threadPool.NumThreads()));
+	else
+		wordsPerChunk = (pointsPerChunk + 31) / 32;
+
+	ContainsManyJob job;
+	job.polyhedron = this;
+	job.points = points;
+	job.numPoints = numPoints;
+	job.outBits = outBits;
+	threadPool.ParallelFor(numWords, wordsPerChunk, ContainsManyJobFunc, &job);
+}
+
+MATH_END_NAMESPACE
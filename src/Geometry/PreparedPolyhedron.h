@@ -0,0 +1,113 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file PreparedPolyhedron.h
+	@author Jukka Jylanki
+	@brief A closed Polyhedron preprocessed for fast point containment queries. */
+#pragma once
+
+#include "../MathGeoLibFwd.h"
+#include "../Math/float3.h"
+#include "../Math/MathTypes.h"
+#include "Polyhedron.h"
+
+#include <vector>
+
+MATH_BEGIN_NAMESPACE
+
+/// A closed, possibly concave Polyhedron preprocessed for fast point containment queries.
+/** Polyhedron::Contains() casts a ray through the center of a face and tests it against all faces, and picks another ray
+	if it passes too close to an edge. This object triangulates the faces once, and sorts the triangles to the cells of a 2D
+	grid on the YZ plane. Each cell lists the triangles whose projection overlaps it, so a long diagonal triangle is listed
+	only in the cells along it, not in all the cells of its bounding rectangle. A query casts a ray from the point towards
+	+X, and only tests the triangles in the grid cell of the point. The query computes the winding number of the surface
+	around the point: the triangles the ray crosses in front of the point are counted by the sign of their orientation on
+	the YZ plane.
+	The crossing tests are watertight. When the ray passes exactly through an edge or a vertex, a fixed tie-breaking rule
+	assigns the crossing to exactly one of the triangles that share the edge, so no ray needs to be retried. This makes
+	the result well defined for all points that do not lie on the surface.
+	The object stores copies of the vertex positions, so it must be rebuilt if the polyhedron changes.
+	@note The polyhedron must be closed, and its faces must be planar polygons that are wound consistently.
+	@see Polyhedron::Contains(). */
+class PreparedPolyhedron
+{
+public:
+	/// The default constructor creates a PreparedPolyhedron that contains no points.
+	PreparedPolyhedron();
+
+	/// Preprocesses the given closed polyhedron.
+	explicit PreparedPolyhedron(const Polyhedron &polyhedron);
+
+	/// Replaces the polyhedron with the given closed polyhedron.
+	void Set(const Polyhedron &polyhedron);
+
+	/// Returns the number of triangles the faces of the polyhedron were split to.
+	int NumTriangles() const { return numTriangles; }
+
+	/// Tests if the given point is inside the polyhedron.
+	/** The result for points that lie on the surface of the polyhedron is arbitrary.
+		@see ContainsMany(), Polyhedron::Contains(). */
+	bool Contains(const vec &point) const;
+
+	/// Tests a batch of points for containment.
+	/** @param outBits [out] Receives the results, one bit per point: the bit (i%32) of outBits[i/32] is set if the point i
+			is inside the polyhedron. This array must have room for (numPoints+31)/32 elements. The unused bits of the last
+			element are cleared. */
+	void ContainsMany(const vec *points, int numPoints, u32 *outBits) const;
+
+	/// Tests a batch of points for containment on all threads of the given thread pool.
+	/** The points are processed in chunks of pointsPerChunk consecutive points, which the threads pick up one at a time.
+		The results are identical to the single-threaded version of this function.
+		@param pointsPerChunk The number of points a thread processes at a time. This is rounded up to a multiple of 32,
+			so that the threads write to separate elements of outBits. Pass in 0 to choose automatically. */
+	void ContainsMany(const vec *points, int numPoints, u32 *outBits, ThreadPool &threadPool, int pointsPerChunk = 0) const;
+
+private:
+	/// A triangle of the surface. The vertices are stored in the winding order of the face the triangle came from.
+	struct SurfaceTriangle
+	{
+		float ax, ay, az;
+		float bx, by, bz;
+		float cx, cy, cz;
+		/// The largest X coordinate of the vertices. A ray that starts farther along +X cannot cross the triangle.
+		float maxX;
+	};
+
+	/// Returns the winding number contribution of the given triangle to the point: +1 or -1 if the +X ray from the point
+	/// crosses the triangle, depending on the orientation of the triangle, and 0 otherwise.
+	static int Crossing(const SurfaceTriangle &tri, const vec &point);
+
+	/// Returns the column or the row of the grid cell that contains the given coordinate. The result is clamped to the grid.
+	int CellY(float y) const;
+	int CellZ(float z) const;
+
+	int numTriangles;
+
+	/// The bounding box of the polyhedron. The grid spans its YZ extents.
+	float minX, minY, minZ, maxX, maxY, maxZ;
+	/// The number of grid cells along Y and Z, and the reciprocal of the cell size along Y and Z.
+	int numCellsY, numCellsZ;
+	float invCellSizeY, invCellSizeZ;
+
+	/// The triangle fans of the faces, in the order of the faces.
+	std::vector<SurfaceTriangle> triangles;
+
+	/// The indices of the triangles that overlap the cell (y, z) are cellTriangles[cellStart[i]] to
+	/// cellTriangles[cellStart[i+1]-1], where i = z*numCellsY + y. A triangle that overlaps several cells is listed in
+	/// each of them.
+	std::vector<int> cellStart;
+	std::vector<int> cellTriangles;
+};
+
+MATH_END_NAMESPACE
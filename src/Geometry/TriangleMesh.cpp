@@ -18,14 +18,19 @@
 #include "TriangleMesh.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
 #include "../Math/float3.h"
 #include "Triangle.h"
 #include "Ray.h"
+#include "Sphere.h"
+#include "Capsule.h"
+#include "LineSegment.h"
 #include "Polyhedron.h"
 #include "../MathGeoLibFwd.h"
 #include "../Math/MathConstants.h"
 #include "../Math/myassert.h"
 #include "../../tests/SystemInfo.h"
+#include "../Algorithm/ThreadPool.h"
 
 #include <vector>
 
@@ -168,24 +173,18 @@ SIMDCapability DetectSIMDCapability()
 const int simdCapability = DetectSIMDCapability();
 
 TriangleMesh::TriangleMesh()
-:data(0), numTriangles(0), vertexSizeBytes(0)
-#ifdef _DEBUG
-, vertexDataLayout(0)
-#endif
+:data(0), numTriangles(0), vertexSizeBytes(0), vertexDataLayout(0), ownsData(true)
 {
 
 }
 
 TriangleMesh::~TriangleMesh()
 {
-	AlignedFree(data);
+	ReleaseVertexBuffer();
 }
 
 TriangleMesh::TriangleMesh(const TriangleMesh &rhs)
-:data(0), numTriangles(0), vertexSizeBytes(0)
-#ifdef _DEBUG
-, vertexDataLayout(0)
-#endif
+:data(0), numTriangles(0), vertexSizeBytes(0), vertexDataLayout(0), ownsData(true)
 {
 	*this = rhs;
 }
@@ -195,10 +194,14 @@ TriangleMesh &TriangleMesh::operator =(const TriangleMesh &rhs)
 	if (this == &rhs)
 		return *this;
 
-#ifdef _DEBUG
-	vertexDataLayout = rhs.vertexDataLayout;
-#endif
+	if (!rhs.ownsData) // Copies of a view refer to the same external data.
+	{
+		SetView(rhs.data, rhs.numTriangles, rhs.vertexSizeBytes, rhs.vertexDataLayout);
+		return *this;
+	}
+
 	ReallocVertexBuffer(rhs.numTriangles, rhs.vertexSizeBytes);
+	vertexDataLayout = rhs.vertexDataLayout;
 	memcpy(data, rhs.data, numTriangles*3*vertexSizeBytes);
 
 	return *this;
@@ -230,81 +233,423 @@ void TriangleMesh::Set(const float *triangleMesh, int numTris, int vtxSizeBytes)
 		SetAoS(triangleMesh, numTris, vtxSizeBytes);
 }
 
+// The ray intersection functions pick the kernel by the layout the data is stored in, not by simdCapability: a view or
+// a file view may be in a different layout than Set() would have chosen for this CPU. A SoA layout that has no kernel in
+// this build is intersected one triangle at a time by IntersectRay_TriangleIndex_UV_CPP(). The plane layouts can only be
+// intersected by their kernels.
 float TriangleMesh::IntersectRay(const Ray &ray) const
 {
-#ifndef MATH_AUTOMATIC_SSE // TODO: Restore support for this when MATH_AUTOMATIC_SSE is defined!
-#ifdef MATH_AVX
-	if (simdCapability == SIMD_AVX)
-		return IntersectRay_AVX(ray);
-#endif
+	switch(vertexDataLayout)
+	{
 #ifdef MATH_SSE41
-	if (simdCapability == SIMD_SSE41)
-		return IntersectRay_SSE41(ray);
-#endif
-#ifdef MATH_SSE2
-	if (simdCapability == SIMD_SSE2)
-		return IntersectRay_SSE2(ray);
+	case 1: return IntersectRay_SSE41(ray);
+	case 3: return IntersectRay_Planes_SSE41(ray);
+#elif defined(MATH_SSE2)
+	case 1: return IntersectRay_SSE2(ray);
+	case 3: return IntersectRay_Planes_SSE2(ray);
 #endif
+#ifdef MATH_AVX
+	case 2: return IntersectRay_AVX(ray);
+	case 4: return IntersectRay_Planes_AVX(ray);
 #endif
-	int triangleIndex;
-	float u, v;
-	return IntersectRay_TriangleIndex_UV_CPP(ray, triangleIndex, u, v);
+	default:
+	{
+		int triangleIndex;
+		float u, v;
+		return IntersectRay_TriangleIndex_UV_CPP(ray, triangleIndex, u, v);
+	}
+	}
 }
 
 float TriangleMesh::IntersectRay_TriangleIndex(const Ray &ray, int &outTriangleIndex) const
 {
-#ifndef MATH_AUTOMATIC_SSE // TODO: Restore support for this when MATH_AUTOMATIC_SSE is defined!
-#ifdef MATH_AVX
-	if (simdCapability == SIMD_AVX)
-		return IntersectRay_TriangleIndex_AVX(ray, outTriangleIndex);
-#endif
+	switch(vertexDataLayout)
+	{
 #ifdef MATH_SSE41
-	if (simdCapability == SIMD_SSE41)
-		return IntersectRay_TriangleIndex_SSE41(ray, outTriangleIndex);
-#endif
-#ifdef MATH_SSE2
-	if (simdCapability == SIMD_SSE2)
-		return IntersectRay_TriangleIndex_SSE2(ray, outTriangleIndex);
+	case 1: return IntersectRay_TriangleIndex_SSE41(ray, outTriangleIndex);
+	case 3: return IntersectRay_Planes_TriangleIndex_SSE41(ray, outTriangleIndex);
+#elif defined(MATH_SSE2)
+	case 1: return IntersectRay_TriangleIndex_SSE2(ray, outTriangleIndex);
+	case 3: return IntersectRay_Planes_TriangleIndex_SSE2(ray, outTriangleIndex);
 #endif
+#ifdef MATH_AVX
+	case 2: return IntersectRay_TriangleIndex_AVX(ray, outTriangleIndex);
+	case 4: return IntersectRay_Planes_TriangleIndex_AVX(ray, outTriangleIndex);
 #endif
-	float u, v;
-	return IntersectRay_TriangleIndex_UV_CPP(ray, outTriangleIndex, u, v);
+	default:
+	{
+		float u, v;
+		return IntersectRay_TriangleIndex_UV_CPP(ray, outTriangleIndex, u, v);
+	}
+	}
 }
 
 float TriangleMesh::IntersectRay_TriangleIndex_UV(const Ray &ray, int &outTriangleIndex, float &outU, float &outV) const
 {
-#ifndef MATH_AUTOMATIC_SSE // TODO: Restore support for this when MATH_AUTOMATIC_SSE is defined!
+	switch(vertexDataLayout)
+	{
+#ifdef MATH_SSE41
+	case 1: return IntersectRay_TriangleIndex_UV_SSE41(ray, outTriangleIndex, outU, outV);
+	case 3: return IntersectRay_Planes_TriangleIndex_UV_SSE41(ray, outTriangleIndex, outU, outV);
+#elif defined(MATH_SSE2)
+	case 1: return IntersectRay_TriangleIndex_UV_SSE2(ray, outTriangleIndex, outU, outV);
+	case 3: return IntersectRay_Planes_TriangleIndex_UV_SSE2(ray, outTriangleIndex, outU, outV);
+#endif
 #ifdef MATH_AVX
-	if (simdCapability == SIMD_AVX)
-		return IntersectRay_TriangleIndex_UV_AVX(ray, outTriangleIndex, outU, outV);
+	case 2: return IntersectRay_TriangleIndex_UV_AVX(ray, outTriangleIndex, outU, outV);
+	case 4: return IntersectRay_Planes_TriangleIndex_UV_AVX(ray, outTriangleIndex, outU, outV);
 #endif
+	default: return IntersectRay_TriangleIndex_UV_CPP(ray, outTriangleIndex, outU, outV);
+	}
+}
+
+void TriangleMesh::IntersectRays(const Ray *rays, int numRays, float *outDistances, int *outTriangleIndices) const
+{
+	assume(rays || numRays == 0);
+	assume(outDistances || numRays == 0);
+	for(int i = 0; i < numRays; ++i)
+	{
+		int triangleIndex = -1;
+		outDistances[i] = IntersectRay_TriangleIndex(rays[i], triangleIndex);
+		if (outTriangleIndices)
+			outTriangleIndices[i] = triangleIndex;
+	}
+}
+
+struct IntersectRaysJob
+{
+	const TriangleMesh *mesh;
+	const Ray *rays;
+	float *outDistances;
+	int *outTriangleIndices;
+};
+
+static void IntersectRaysChunk(void *userData, int begin, int end)
+{
+	const IntersectRaysJob *job = reinterpret_cast<const IntersectRaysJob *>(userData);
+	job->mesh->IntersectRays(job->rays + begin, end - begin, job->outDistances + begin,
+		job->outTriangleIndices ? job->outTriangleIndices + begin : 0);
+}
+
+void TriangleMesh::IntersectRays(const Ray *rays, int numRays, float *outDistances, int *outTriangleIndices, ThreadPool &threadPool, int raysPerChunk) const
+{
+	IntersectRaysJob job = { this, rays, outDistances, outTriangleIndices };
+	threadPool.ParallelFor(numRays, raysPerChunk, IntersectRaysChunk, &job);
+}
+
+vec TriangleMesh::ClosestPoint(const vec &point, int *outTriangleIndex) const
+{
+	vec closestPoint;
+	int triangleIndex;
+	ClosestPoint_TriangleIndex(point, closestPoint, triangleIndex);
+	if (outTriangleIndex)
+		*outTriangleIndex = triangleIndex;
+	return closestPoint;
+}
+
+float TriangleMesh::Distance(const vec &point) const
+{
+	vec closestPoint;
+	int triangleIndex;
+	return ClosestPoint_TriangleIndex(point, closestPoint, triangleIndex);
+}
+
+float TriangleMesh::ClosestPoint_TriangleIndex(const vec &point, vec &outClosestPoint, int &outTriangleIndex) const
+{
+	switch(vertexDataLayout)
+	{
+	case 3: case 4: // The plane layouts do not store the vertices.
+		outClosestPoint = vec::nan;
+		outTriangleIndex = -1;
+		return FLOAT_INF;
 #ifdef MATH_SSE41
-	if (simdCapability == SIMD_SSE41)
-		return IntersectRay_TriangleIndex_UV_SSE41(ray, outTriangleIndex, outU, outV);
+	case 1: return ClosestPoint_SSE41(point, outClosestPoint, outTriangleIndex);
+#elif defined(MATH_SSE2)
+	case 1: return ClosestPoint_SSE2(point, outClosestPoint, outTriangleIndex);
+#endif
+#ifdef MATH_AVX
+	case 2: return ClosestPoint_AVX(point, outClosestPoint, outTriangleIndex);
 #endif
+	default: return ClosestPoint_CPP(point, outClosestPoint, outTriangleIndex);
+	}
+}
+
+/// Computes the contact normal of a swept sphere or capsule, given as the line segment axis moved to the time of impact.
+static vec SweepContactNormal(const TriangleMesh &mesh, const LineSegment &axis, const vec &motion, const vec &contactPoint, int triangleIndex)
+{
+	vec normal = axis.ClosestPoint(contactPoint) - contactPoint;
+	if (normal.LengthSq() > 1e-12f * Max(1.f, contactPoint.LengthSq()))
+		return normal.Normalized();
+
+	// The axis passes through the contact point, so the shape initially intersects the mesh. Use the face normal instead.
+	normal = mesh.GetTriangle(triangleIndex).NormalCCW();
+	return normal.Dot(motion) > 0.f ? -normal : normal;
+}
+
+float TriangleMesh::SweepSphere(const Sphere &sphere, const vec &motion, vec &outContactPoint, vec &outContactNormal, int &outTriangleIndex) const
+{
+	float t;
+	switch(vertexDataLayout)
+	{
+	case 3: case 4: // The plane layouts do not store the vertices.
+		t = FLOAT_INF;
+		outContactPoint = vec::nan;
+		outTriangleIndex = -1;
+		break;
 #ifdef MATH_SSE2
-	if (simdCapability == SIMD_SSE2)
-		return IntersectRay_TriangleIndex_UV_SSE2(ray, outTriangleIndex, outU, outV);
+	case 1: t = SweepSphere_SSE2(sphere, motion, outContactPoint, outTriangleIndex); break;
 #endif
+#ifdef MATH_AVX
+	case 2: t = SweepSphere_AVX(sphere, motion, outContactPoint, outTriangleIndex); break;
 #endif
+	default: t = SweepSphere_CPP(sphere, motion, outContactPoint, outTriangleIndex); break;
+	}
+	if (outTriangleIndex < 0)
+	{
+		outContactNormal = vec::nan;
+		return FLOAT_INF;
+	}
+	vec center = sphere.pos + t * motion;
+	outContactNormal = SweepContactNormal(*this, LineSegment(center, center), motion, outContactPoint, outTriangleIndex);
+	return t;
+}
 
-	return IntersectRay_TriangleIndex_UV_CPP(ray, outTriangleIndex, outU, outV);
+float TriangleMesh::SweepCapsule(const Capsule &capsule, const vec &motion, vec &outContactPoint, vec &outContactNormal, int &outTriangleIndex) const
+{
+	float t;
+	switch(vertexDataLayout)
+	{
+	case 3: case 4: // The plane layouts do not store the vertices.
+		t = FLOAT_INF;
+		outContactPoint = vec::nan;
+		outTriangleIndex = -1;
+		break;
+#ifdef MATH_SSE2
+	case 1: t = SweepCapsule_SSE2(capsule, motion, outContactPoint, outTriangleIndex); break;
+#endif
+#ifdef MATH_AVX
+	case 2: t = SweepCapsule_AVX(capsule, motion, outContactPoint, outTriangleIndex); break;
+#endif
+	default: t = SweepCapsule_CPP(capsule, motion, outContactPoint, outTriangleIndex); break;
+	}
+	if (outTriangleIndex < 0)
+	{
+		outContactNormal = vec::nan;
+		return FLOAT_INF;
+	}
+	outContactNormal = SweepContactNormal(*this, LineSegment(capsule.l.a + t * motion, capsule.l.b + t * motion), motion, outContactPoint, outTriangleIndex);
+	return t;
+}
+
+Triangle TriangleMesh::GetTriangle(int triangleIndex) const
+{
+	assume(triangleIndex >= 0 && triangleIndex < numTriangles);
+	if (vertexDataLayout > 2) // The plane layouts do not store the vertices.
+		return Triangle(vec::nan, vec::nan, vec::nan);
+	if (vertexDataLayout == 0) // AoS
+	{
+		const u8 *tri = reinterpret_cast<const u8*>(data) + triangleIndex * 3 * vertexSizeBytes;
+		return Triangle(POINT_VEC(*reinterpret_cast<const float3*>(tri)),
+			POINT_VEC(*reinterpret_cast<const float3*>(tri + vertexSizeBytes)),
+			POINT_VEC(*reinterpret_cast<const float3*>(tri + 2 * vertexSizeBytes)));
+	}
+
+	// SoA4/SoA8: Each block of simdWidth triangles stores the x, y and z channels of v0, v1, v2 one after another.
+	const int simdWidth = (vertexDataLayout == 1) ? 4 : 8;
+	const float *block = data + (triangleIndex / simdWidth) * 9 * simdWidth + triangleIndex % simdWidth;
+	vec v[3];
+	for(int i = 0; i < 3; ++i)
+		v[i] = POINT_VEC(block[(3*i)*simdWidth], block[(3*i+1)*simdWidth], block[(3*i+2)*simdWidth]);
+#ifdef SOA_HAS_EDGES
+	v[1] += DIR_VEC(v[0].x, v[0].y, v[0].z);
+	v[2] += DIR_VEC(v[0].x, v[0].y, v[0].z);
+#endif
+	return Triangle(v[0], v[1], v[2]);
 }
 
 void TriangleMesh::ReallocVertexBuffer(int numTris, int vertexSizeBytes_)
 {
-	AlignedFree(data);
+	ReleaseVertexBuffer();
 	vertexSizeBytes = vertexSizeBytes_;
 	data = (float*)AlignedMalloc(numTris * 3 * vertexSizeBytes, 32);
 	numTriangles = numTris;
+	ownsData = true;
+}
+
+void TriangleMesh::ReleaseVertexBuffer()
+{
+	if (ownsData)
+		AlignedFree(data);
+	data = 0;
+	numTriangles = 0;
+	vertexSizeBytes = 0;
+	vertexDataLayout = 0;
+	ownsData = true;
+}
+
+void TriangleMesh::SetView(const float *vertexData, int numTris, int vtxSizeBytes, int layout)
+{
+	ReleaseVertexBuffer();
+	data = const_cast<float*>(vertexData); // A view is never written to.
+	numTriangles = numTris;
+	vertexSizeBytes = vtxSizeBytes;
+	vertexDataLayout = layout;
+	ownsData = false;
+}
+
+bool TriangleMesh::SetAoSView(const float *vertexData, int numTris, int vtxSizeBytes)
+{
+	if (((uintptr_t)vertexData & 0x3) != 0 || vtxSizeBytes < (int)(3*sizeof(float)) || vtxSizeBytes % 4 != 0 || numTris < 0)
+	{
+		ReleaseVertexBuffer();
+		return false;
+	}
+	SetView(vertexData, numTris, vtxSizeBytes, 0); // AoS
+	return true;
+}
+
+bool TriangleMesh::SetSoA4View(const float *soaData, int numTris)
+{
+	if (((uintptr_t)soaData & 0xF) != 0 || numTris % 4 != 0 || numTris < 0)
+	{
+		ReleaseVertexBuffer();
+		return false;
+	}
+	SetView(soaData, numTris, 3*sizeof(float), 1); // SoA4
+	return true;
+}
+
+bool TriangleMesh::SetSoA8View(const float *soaData, int numTris)
+{
+	if (((uintptr_t)soaData & 0x1F) != 0 || numTris % 8 != 0 || numTris < 0)
+	{
+		ReleaseVertexBuffer();
+		return false;
+	}
+	SetView(soaData, numTris, 3*sizeof(float), 2); // SoA8
+	return true;
+}
+
+// The header of the files written by TriangleMesh::SaveSoAFile(). The header is 32 bytes, so that the SoA blocks
+// that follow it stay 32-byte aligned.
+struct SoAFileHeader
+{
+	u32 magic;
+	u32 version;
+	u32 simdWidth;
+	u32 numTriangles; // Including the padding triangles.
+	u32 flags;
+	u32 reserved[3];
+};
+
+static const u32 soaFileMagic = 0x4D54474D; // "MGTM" in little-endian byte order.
+static const u32 soaFileVersion = 1;
+static const u32 soaFileHasEdges = 1; // Set if the blocks store the edges v1-v0 and v2-v0 instead of v1 and v2, see SOA_HAS_EDGES.
+
+#ifdef SOA_HAS_EDGES
+static const u32 soaFileFlags = soaFileHasEdges;
+#else
+static const u32 soaFileFlags = 0;
+#endif
+
+// Writes the given triangle in SoA form, where the triangles are grouped in blocks of simdWidth triangles,
+// and each block stores v0x v0y v0z v1x v1y v1z v2x v2y v2z, each channel simdWidth floats wide.
+// With SOA_HAS_EDGES, the edges v1-v0 and v2-v0 are stored in place of v1 and v2.
+static void SetTriangleSoA(float *o, int triangleIndex, int simdWidth, const float3 &v0, const float3 &v1, const float3 &v2)
+{
+#ifdef SOA_HAS_EDGES
+	const float3 p1 = v1 - v0;
+	const float3 p2 = v2 - v0;
+#else
+	const float3 &p1 = v1;
+	const float3 &p2 = v2;
+#endif
+	const float channels[9] = { v0.x, v0.y, v0.z, p1.x, p1.y, p1.z, p2.x, p2.y, p2.z };
+
+	o += (size_t)(triangleIndex / simdWidth) * 9 * simdWidth + (triangleIndex % simdWidth);
+	for(int i = 0; i < 9; ++i)
+		o[i*simdWidth] = channels[i];
+}
+
+bool TriangleMesh::SaveSoAFile(const char *filename, const float *vertexData, int numTris, int vtxSizeBytes, int simdWidth)
+{
+	assume(simdWidth == 4 || simdWidth == 8);
+	assume(vtxSizeBytes % 4 == 0);
+	assume(numTris >= 0);
+	if (simdWidth != 4 && simdWidth != 8)
+		return false;
+
+	if (numTris < 0)
+		return false;
+
+	// Compute the sizes in size_t, int arithmetic overflows for large meshes.
+	const size_t numPaddedTris = ((size_t)numTris + simdWidth - 1) / simdWidth * simdWidth;
+	if (numPaddedTris > 0x7FFFFFFF)
+		return false; // The triangle indices below are ints.
+	const size_t blockSizeBytes = numPaddedTris * 9 * sizeof(float);
+	float *blocks = (float*)AlignedMalloc(blockSizeBytes > 0 ? blockSizeBytes : 1, 32);
+	if (!blocks)
+		return false;
+
+	const size_t vertexSizeFloats = (size_t)vtxSizeBytes / 4;
+	for(int i = 0; i < numTris; ++i)
+	{
+		const float *v0 = vertexData + (size_t)i * 3 * vertexSizeFloats;
+		const float *v1 = v0 + vertexSizeFloats;
+		const float *v2 = v1 + vertexSizeFloats;
+		SetTriangleSoA(blocks, i, simdWidth, float3(v0[0], v0[1], v0[2]), float3(v1[0], v1[1], v1[2]), float3(v2[0], v2[1], v2[2]));
+	}
+	// Pad with the same degenerate triangles as Set(const Polyhedron &) does.
+	const float3 degen = float3::FromScalar(-FLOAT_INF);
+	for(int i = numTris; i < (int)numPaddedTris; ++i)
+		SetTriangleSoA(blocks, i, simdWidth, degen, degen, degen);
+
+	SoAFileHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = soaFileMagic;
+	header.version = soaFileVersion;
+	header.simdWidth = (u32)simdWidth;
+	header.numTriangles = (u32)numPaddedTris;
+	header.flags = soaFileFlags;
+
+	bool success = false;
+	FILE *handle = fopen(filename, "wb");
+	if (handle)
+	{
+		success = fwrite(&header, sizeof(header), 1, handle) == 1;
+		if (success && blockSizeBytes > 0)
+			success = fwrite(blocks, blockSizeBytes, 1, handle) == 1;
+		success = (fclose(handle) == 0) && success;
+	}
+	AlignedFree(blocks);
+	return success;
+}
+
+bool TriangleMesh::SetSoAFileView(const void *fileData, size_t fileSizeBytes)
+{
+	ReleaseVertexBuffer();
+	if (!fileData || fileSizeBytes < sizeof(SoAFileHeader))
+		return false;
+
+	const SoAFileHeader *header = reinterpret_cast<const SoAFileHeader*>(fileData);
+	if (header->magic != soaFileMagic || header->version != soaFileVersion || header->flags != soaFileFlags)
+		return false;
+	if ((header->simdWidth != 4 && header->simdWidth != 8) || header->numTriangles > 0x7FFFFFFFu / 36u)
+		return false;
+	if (fileSizeBytes != sizeof(SoAFileHeader) + (size_t)header->numTriangles * 9 * sizeof(float))
+		return false;
+
+	const float *blocks = reinterpret_cast<const float*>(header + 1);
+	if (header->simdWidth == 4)
+		return SetSoA4View(blocks, (int)header->numTriangles);
+	else
+		return SetSoA8View(blocks, (int)header->numTriangles);
 }
 
 void TriangleMesh::SetAoS(const float *vertexData, int numTris, int vtxSizeBytes)
 {
 	ReallocVertexBuffer(numTris, vtxSizeBytes);
-#ifdef _DEBUG
 	vertexDataLayout = 0; // AoS
-#endif
 
 	memcpy(data, vertexData, numTris * 3 * vtxSizeBytes);
 }
@@ -312,116 +657,133 @@ void TriangleMesh::SetAoS(const float *vertexData, int numTris, int vtxSizeBytes
 void TriangleMesh::SetSoA4(const float *vertexData, int numTris, int vtxSizeBytes)
 {
 	ReallocVertexBuffer(numTris, 3*sizeof(float));
-#ifdef _DEBUG
 	vertexDataLayout = 1; // SoA4
-#endif
 
 	assert(vtxSizeBytes % 4 == 0);
 	int vertexSizeFloats = vtxSizeBytes / 4;
-	int triangleSizeFloats = vertexSizeFloats * 3;
 	assert(numTris % 4 == 0); // We must have an evenly divisible amount of triangles, so that the SoA swizzling succeeds.
 
 	// From (xyz xyz xyz) (xyz xyz xyz) (xyz xyz xyz) (xyz xyz xyz)
 	// To xxxx yyyy zzzz xxxx yyyy zzzz xxxx yyyy zzzz
-
-	float *o = data;
-	for(int i = 0; i + 4 <= numTris; i += 4) // 4 triangles at a time
-	{
-		for (int j = 0; j < 3; ++j) // v0,v1,v2
-		{
-			const float *src = vertexData;
-			for (int k = 0; k < 3; ++k) // x,y,z
-			{
-				*o++ = src[0];
-				*o++ = src[triangleSizeFloats];
-				*o++ = src[2 * triangleSizeFloats];
-				*o++ = src[3 * triangleSizeFloats];
-				++src;
-			}
-			vertexData += vertexSizeFloats;
-		}
-		vertexData += 3 * triangleSizeFloats;
-	}
-
-#ifdef SOA_HAS_EDGES
-	o = data;
-	for(int i = 0; i + 4 <= numTris; i += 4)
+	for(int i = 0; i < numTris; ++i)
 	{
-		for(int j = 12; j < 24; ++j)
-			o[j] -= o[j-12];
-		for(int j = 24; j < 36; ++j)
-			o[j] -= o[j-24];
-		o += 36;
+		const float *v0 = vertexData;
+		const float *v1 = v0 + vertexSizeFloats;
+		const float *v2 = v1 + vertexSizeFloats;
+		SetTriangleSoA(data, i, 4, float3(v0[0], v0[1], v0[2]), float3(v1[0], v1[1], v1[2]), float3(v2[0], v2[1], v2[2]));
+		vertexData += 3 * vertexSizeFloats;
 	}
-#endif
 }
 
 void TriangleMesh::SetSoA8(const float *vertexData, int numTris, int vtxSizeBytes)
 {
 	ReallocVertexBuffer(numTris, 3*sizeof(float));
-#ifdef _DEBUG
 	vertexDataLayout = 2; // SoA8
-#endif
 
 	assert(vtxSizeBytes % 4 == 0);
 	int vertexSizeFloats = vtxSizeBytes / 4;
-	int triangleSizeFloats = vertexSizeFloats * 3;
 	assert(numTris % 8 == 0); // We must have an evenly divisible amount of triangles, so that the SoA swizzling succeeds.
 
 	// From (xyz xyz xyz) (xyz xyz xyz) (xyz xyz xyz) (xyz xyz xyz) (xyz xyz xyz) (xyz xyz xyz) (xyz xyz xyz) (xyz xyz xyz)
 	// To xxxxxxxx yyyyyyyy zzzzzzzz xxxxxxxx yyyyyyyy zzzzzzzz xxxxxxxx yyyyyyyy zzzzzzzz
+	for(int i = 0; i < numTris; ++i)
+	{
+		const float *v0 = vertexData;
+		const float *v1 = v0 + vertexSizeFloats;
+		const float *v2 = v1 + vertexSizeFloats;
+		SetTriangleSoA(data, i, 8, float3(v0[0], v0[1], v0[2]), float3(v1[0], v1[1], v1[2]), float3(v2[0], v2[1], v2[2]));
+		vertexData += 3 * vertexSizeFloats;
+	}
+}
+
+// Computes the plane equations of the given triangle and writes them out in SoA form, where the triangles
+// are grouped in blocks of simdWidth triangles, and each block stores n0x n0y n0z d0 n1x n1y n1z d1 n2x n2y n2z d2,
+// each channel simdWidth floats wide.
+static void SetTrianglePlanesSoA(float *o, int triangleIndex, int simdWidth, const float3 &v0, const float3 &v1, const float3 &v2)
+{
+	float3 e1 = v1 - v0;
+	float3 e2 = v2 - v0;
+	float3 n0 = Cross(e1, e2);
+	float n0LengthSq = n0.LengthSq(); // For degenerate triangles, this becomes zero and the triangle will be filled with NaNs, which will never report a hit.
+	float3 n1 = Cross(e2, n0) / n0LengthSq;
+	float3 n2 = Cross(n0, e1) / n0LengthSq;
+	const float planes[12] = { n0.x, n0.y, n0.z, Dot(n0, v0), n1.x, n1.y, n1.z, -Dot(n1, v0), n2.x, n2.y, n2.z, -Dot(n2, v0) };
+
+	o += (triangleIndex / simdWidth) * 12 * simdWidth + (triangleIndex % simdWidth);
+	for(int i = 0; i < 12; ++i)
+		o[i*simdWidth] = planes[i];
+}
+
+void TriangleMesh::SetSoA4Planes(const float *vertexData, int numTris, int vtxSizeBytes)
+{
+	ReallocVertexBuffer(numTris, 4*sizeof(float));
+	vertexDataLayout = 3; // SoA4Planes
+
+	assert(vtxSizeBytes % 4 == 0);
+	int vertexSizeFloats = vtxSizeBytes / 4;
+	assert(numTris % 4 == 0); // We must have an evenly divisible amount of triangles, so that the SoA swizzling succeeds.
 
-	float *o = data;
-	for(int i = 0; i + 8 <= numTris; i += 8) // 8 triangles at a time.
+	// From (xyz xyz xyz) (xyz xyz xyz) (xyz xyz xyz) (xyz xyz xyz)
+	// To n0x*4 n0y*4 n0z*4 d0*4 n1x*4 n1y*4 n1z*4 d1*4 n2x*4 n2y*4 n2z*4 d2*4
+	for(int i = 0; i < numTris; ++i)
 	{
-		for (int j = 0; j < 3; ++j) // v0, v1, v2
-		{
-			const float *src = vertexData;
-			for (int k = 0; k < 3; ++k) // x,y,z
-			{
-				*o++ = src[0];
-				*o++ = src[triangleSizeFloats];
-				*o++ = src[2 * triangleSizeFloats];
-				*o++ = src[3 * triangleSizeFloats];
-				*o++ = src[4 * triangleSizeFloats];
-				*o++ = src[5 * triangleSizeFloats];
-				*o++ = src[6 * triangleSizeFloats];
-				*o++ = src[7 * triangleSizeFloats];
-				++src;
-			}
-			vertexData += vertexSizeFloats;
-		}
-		vertexData += 7 * triangleSizeFloats;
+		const float *v0 = vertexData;
+		const float *v1 = v0 + vertexSizeFloats;
+		const float *v2 = v1 + vertexSizeFloats;
+		SetTrianglePlanesSoA(data, i, 4, float3(v0[0], v0[1], v0[2]), float3(v1[0], v1[1], v1[2]), float3(v2[0], v2[1], v2[2]));
+		vertexData += 3 * vertexSizeFloats;
 	}
+}
 
-#ifdef SOA_HAS_EDGES
-	o = data;
-	for(int i = 0; i + 8 <= numTris; i += 8)
+void TriangleMesh::SetSoA8Planes(const float *vertexData, int numTris, int vtxSizeBytes)
+{
+	ReallocVertexBuffer(numTris, 4*sizeof(float));
+	vertexDataLayout = 4; // SoA8Planes
+
+	assert(vtxSizeBytes % 4 == 0);
+	int vertexSizeFloats = vtxSizeBytes / 4;
+	assert(numTris % 8 == 0); // We must have an evenly divisible amount of triangles, so that the SoA swizzling succeeds.
+
+	// From (xyz xyz xyz) (xyz xyz xyz) (xyz xyz xyz) (xyz xyz xyz) (xyz xyz xyz) (xyz xyz xyz) (xyz xyz xyz) (xyz xyz xyz)
+	// To n0x*8 n0y*8 n0z*8 d0*8 n1x*8 n1y*8 n1z*8 d1*8 n2x*8 n2y*8 n2z*8 d2*8
+	for(int i = 0; i < numTris; ++i)
 	{
-		for(int j = 24; j < 48; ++j)
-			o[j] -= o[j-24];
-		for(int j = 48; j < 72; ++j)
-			o[j] -= o[j-48];
-		o += 72;
+		const float *v0 = vertexData;
+		const float *v1 = v0 + vertexSizeFloats;
+		const float *v2 = v1 + vertexSizeFloats;
+		SetTrianglePlanesSoA(data, i, 8, float3(v0[0], v0[1], v0[2]), float3(v1[0], v1[1], v1[2]), float3(v2[0], v2[1], v2[2]));
+		vertexData += 3 * vertexSizeFloats;
 	}
-#endif
 }
 
 float TriangleMesh::IntersectRay_TriangleIndex_UV_CPP(const Ray &ray, int &outTriangleIndex, float &outU, float &outV) const
 {
 	assert(sizeof(float3) == 3*sizeof(float));
-	assert(sizeof(Triangle) == 3*sizeof(vec));
-#ifdef _DEBUG
-	assert(vertexDataLayout == 0); // Must be AoS structured!
-#endif
+	assume(vertexDataLayout <= 2); // The plane layouts do not store the vertices.
 
 	float nearestD = FLOAT_INF;
 
-	const Triangle *tris = reinterpret_cast<const Triangle*>(data);
+	// Step by vertexSizeBytes: an AoS view may have any stride, which need not be sizeof(vec).
+	const u8 *tri = reinterpret_cast<const u8*>(data);
 	for(int i = 0; i < numTriangles; ++i)
 	{
+		vec a, b, c;
+		if (vertexDataLayout == 0) // AoS
+		{
+			a = POINT_VEC(*reinterpret_cast<const float3*>(tri));
+			b = POINT_VEC(*reinterpret_cast<const float3*>(tri + vertexSizeBytes));
+			c = POINT_VEC(*reinterpret_cast<const float3*>(tri + 2 * vertexSizeBytes));
+			tri += 3 * vertexSizeBytes;
+		}
+		else // SoA4 or SoA8 in a build that has no SIMD kernel for the layout.
+		{
+			Triangle t = GetTriangle(i);
+			a = t.a;
+			b = t.b;
+			c = t.c;
+		}
 		float u, v;
-		float d = Triangle::IntersectLineTri(ray.pos, ray.dir, tris->a, tris->b, tris->c, u, v);
+		float d = Triangle::IntersectLineTri(ray.pos, ray.dir, a, b, c, u, v);
 		if (d >= 0.f && d < nearestD)
 		{
 			nearestD = d;
@@ -429,12 +791,32 @@ float TriangleMesh::IntersectRay_TriangleIndex_UV_CPP(const Ray &ray, int &outTr
 			outV = v;
 			outTriangleIndex = i;
 		}
-		++tris;
 	}
 
 	return nearestD;
 }
 
+float TriangleMesh::ClosestPoint_CPP(const vec &point, vec &outClosestPoint, int &outTriangleIndex) const
+{
+	float nearestDSq = FLOAT_INF;
+	outClosestPoint = vec::nan;
+	outTriangleIndex = -1;
+
+	for(int i = 0; i < numTriangles; ++i)
+	{
+		vec pt = GetTriangle(i).ClosestPoint(point);
+		float dSq = pt.DistanceSq(point);
+		if (dSq < nearestDSq)
+		{
+			nearestDSq = dSq;
+			outClosestPoint = pt;
+			outTriangleIndex = i;
+		}
+	}
+
+	return Sqrt(nearestDSq);
+}
+
 MATH_END_NAMESPACE
 
 #ifdef MATH_SSE2
@@ -478,3 +860,72 @@ MATH_END_NAMESPACE
 #define MATH_GEN_UV
 #include "TriangleMesh_IntersectRay_AVX.inl"
 #endif
+
+#ifdef MATH_SSE2
+#define MATH_GEN_SSE2
+#include "TriangleMesh_IntersectRay_Planes_SSE.inl"
+
+#define MATH_GEN_SSE2
+#define MATH_GEN_TRIANGLEINDEX
+#include "TriangleMesh_IntersectRay_Planes_SSE.inl"
+
+#define MATH_GEN_SSE2
+#define MATH_GEN_TRIANGLEINDEX
+#define MATH_GEN_UV
+#include "TriangleMesh_IntersectRay_Planes_SSE.inl"
+#endif
+
+#ifdef MATH_SSE41
+#define MATH_GEN_SSE41
+#include "TriangleMesh_IntersectRay_Planes_SSE.inl"
+
+#define MATH_GEN_SSE41
+#define MATH_GEN_TRIANGLEINDEX
+#include "TriangleMesh_IntersectRay_Planes_SSE.inl"
+
+#define MATH_GEN_SSE41
+#define MATH_GEN_TRIANGLEINDEX
+#define MATH_GEN_UV
+#include "TriangleMesh_IntersectRay_Planes_SSE.inl"
+#endif
+
+#ifdef MATH_AVX
+#define MATH_GEN_AVX
+#include "TriangleMesh_IntersectRay_Planes_AVX.inl"
+
+#define MATH_GEN_AVX
+#define MATH_GEN_TRIANGLEINDEX
+#include "TriangleMesh_IntersectRay_Planes_AVX.inl"
+
+#define MATH_GEN_AVX
+#define MATH_GEN_TRIANGLEINDEX
+#define MATH_GEN_UV
+#include "TriangleMesh_IntersectRay_Planes_AVX.inl"
+#endif
+
+#ifdef MATH_SSE2
+#define MATH_GEN_SSE2
+#include "TriangleMesh_ClosestPoint_SSE.inl"
+#endif
+
+#ifdef MATH_SSE41
+#define MATH_GEN_SSE41
+#include "TriangleMesh_ClosestPoint_SSE.inl"
+#endif
+
+#ifdef MATH_AVX
+#define MATH_GEN_AVX
+#include "TriangleMesh_ClosestPoint_AVX.inl"
+#endif
+
+#include "TriangleMesh_Sweep.inl"
+
+#ifdef MATH_SSE2
+#define MATH_GEN_SSE2
+#include "TriangleMesh_Sweep.inl"
+#endif
+
+#ifdef MATH_AVX
+#define MATH_GEN_AVX
+#include "TriangleMesh_Sweep.inl"
+#endif
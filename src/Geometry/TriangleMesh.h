@@ -47,38 +47,155 @@ public:
 	float IntersectRay_TriangleIndex(const Ray &ray, int &outTriangleIndex) const;
 	float IntersectRay_TriangleIndex_UV(const Ray &ray, int &outTriangleIndex, float &outU, float &outV) const;
 
+	/// Intersects a batch of rays against this mesh.
+	/** @param outDistances [out] An array of numRays elements that receives the distance along each ray to the nearest hit,
+			or FLOAT_INF if the ray does not hit the mesh.
+		@param outTriangleIndices [out] If not null, an array of numRays elements that receives the index of the nearest
+			triangle hit by each ray, or -1 if the ray does not hit the mesh. */
+	void IntersectRays(const Ray *rays, int numRays, float *outDistances, int *outTriangleIndices = 0) const;
+	/// Intersects a batch of rays against this mesh, distributing the rays to the threads of the given thread pool.
+	/** The rays are processed in chunks of raysPerChunk consecutive rays, which the threads pick up one at a time. The results
+		are identical to the single-threaded version of this function.
+		@param raysPerChunk The number of rays a thread processes at a time. Pass in 0 to choose automatically. */
+	void IntersectRays(const Ray *rays, int numRays, float *outDistances, int *outTriangleIndices, ThreadPool &threadPool, int raysPerChunk = 64) const;
+
+	/// Computes the closest point on this mesh to the given point.
+	/** @param outTriangleIndex [out] If not null, receives the index of the triangle the closest point lies on, or -1 if the mesh is empty.
+		@return The closest point on this mesh, or vec::nan if the mesh is empty.
+		@see ClosestPoint_TriangleIndex(), Distance(). */
+	vec ClosestPoint(const vec &point, int *outTriangleIndex = 0) const;
+	/// Computes the distance between this mesh and the given point.
+	/** @return The distance to the closest point of this mesh, or FLOAT_INF if the mesh is empty. */
+	float Distance(const vec &point) const;
+	/// Computes the closest point on this mesh to the given point, using the SIMD kernel that matches the layout the mesh was set in.
+	/** The precomputed plane layouts of SetSoA4Planes() and SetSoA8Planes() do not store the triangle vertices, and cannot be queried.
+		For these layouts, this function returns FLOAT_INF, with outClosestPoint set to vec::nan and outTriangleIndex to -1.
+		@param outClosestPoint [out] Receives the closest point on this mesh, or vec::nan if the mesh is empty.
+		@param outTriangleIndex [out] Receives the index of the triangle the closest point lies on, or -1 if the mesh is empty.
+		@return The distance between the given point and outClosestPoint. */
+	float ClosestPoint_TriangleIndex(const vec &point, vec &outClosestPoint, int &outTriangleIndex) const;
+
+	/// Sweeps the given sphere along the given motion vector, and computes the first contact with this mesh.
+	/** The sphere is moved from sphere.pos to sphere.pos + motion.
+		@param outContactPoint [out] Receives the first point of this mesh the sphere touches, or vec::nan if there is no contact.
+		@param outContactNormal [out] Receives the unit contact normal at the time of impact, pointing from the mesh towards the
+			sphere, or vec::nan if there is no contact.
+		@param outTriangleIndex [out] Receives the index of the triangle that is touched first, or -1 if there is no contact.
+		@return The time of impact as a fraction of the motion vector in the range [0, 1], or FLOAT_INF if the sphere does not
+			touch this mesh during the motion. If the sphere initially intersects the mesh, 0 is returned. The precomputed
+			plane layouts do not store the triangle vertices, and always return FLOAT_INF.
+		@see SweepCapsule(). */
+	float SweepSphere(const Sphere &sphere, const vec &motion, vec &outContactPoint, vec &outContactNormal, int &outTriangleIndex) const;
+	/// Sweeps the given capsule along the given motion vector, and computes the first contact with this mesh.
+	/** The parameters and the return value have the same meaning as in SweepSphere(). @see SweepSphere(). */
+	float SweepCapsule(const Capsule &capsule, const vec &motion, vec &outContactPoint, vec &outContactNormal, int &outTriangleIndex) const;
+
+	/// Returns the triangle at the given index.
+	/** This function is not available for the precomputed plane layouts, which do not store the triangle vertices. For these
+		layouts, a triangle with NaN vertices is returned. */
+	Triangle GetTriangle(int triangleIndex) const;
+	int NumTriangles() const { return numTriangles; }
+
 	void SetAoS(const float *vertexData, int numTriangles, int vertexSizeBytes);
 	void SetSoA4(const float *vertexData, int numTriangles, int vertexSizeBytes);
 	void SetSoA8(const float *vertexData, int numTriangles, int vertexSizeBytes);
 
+	/// Specifies the vertex data of this triangle mesh in a precomputed plane equation form for faster ray intersection.
+	/** Instead of storing the (v0, v1-v0, v2-v0) triplets of SetSoA4() and SetSoA8(), each triangle is stored as three planes:
+		the triangle plane (n0, d0), and two planes (n1, d1) and (n2, d2) that directly compute the barycentric U and V
+		coordinates of a point on the triangle plane. This takes 12 floats per triangle instead of 9, but saves all
+		the cross products from the ray-triangle test.
+		See "J. Havel, A. Herout. Yet Faster Ray-Triangle Intersection (Using SSE4). IEEE TVCG 2010."
+		IntersectRay() and its variants intersect this layout with the IntersectRay_Planes_*() kernels.
+		@note Degenerate (zero area) triangles never report a hit. */
+	void SetSoA4Planes(const float *vertexData, int numTriangles, int vertexSizeBytes);
+	void SetSoA8Planes(const float *vertexData, int numTriangles, int vertexSizeBytes);
+
+	/// Makes this mesh refer to externally owned vertex data in the AoS layout, without copying it.
+	/** The caller must keep the data alive and unmodified for as long as this mesh, or any copy of it, refers to the data.
+		Copies of a view refer to the same data.
+		@return False if the data is not 4-byte aligned or vertexSizeBytes is invalid, in which case this mesh is left empty.
+		@see SetSoA4View(), SetSoA8View(), IsView(). */
+	bool SetAoSView(const float *vertexData, int numTriangles, int vertexSizeBytes);
+	/// Makes this mesh refer to externally owned vertex data that is already in the layout produced by SetSoA4(), without copying it.
+	/** The data must be 16-byte aligned, and numTriangles must be a multiple of 4.
+		@return False if the data does not satisfy these requirements, in which case this mesh is left empty. */
+	bool SetSoA4View(const float *soaData, int numTriangles);
+	/// Makes this mesh refer to externally owned vertex data that is already in the layout produced by SetSoA8(), without copying it.
+	/** The data must be 32-byte aligned, and numTriangles must be a multiple of 8.
+		@return False if the data does not satisfy these requirements, in which case this mesh is left empty. */
+	bool SetSoA8View(const float *soaData, int numTriangles);
+	/// Returns true if this mesh refers to externally owned vertex data instead of a copy of its own.
+	bool IsView() const { return !ownsData; }
+
+	/// Converts the given AoS triangle data to the SoA4 or SoA8 layout and writes it to the given file.
+	/** The file starts with a 32-byte header, followed by the SoA blocks. When the file is loaded or memory mapped at
+		a 32-byte aligned address, SetSoAFileView() can use the blocks in place. The triangle count is padded up to a
+		multiple of simdWidth with degenerate triangles, which never report a hit.
+		@param simdWidth Either 4 for the SoA4 layout or 8 for the SoA8 layout.
+		@return True on success, false if the file could not be written. */
+	static bool SaveSoAFile(const char *filename, const float *vertexData, int numTriangles, int vertexSizeBytes, int simdWidth);
+	/// Makes this mesh refer to the contents of a file written by SaveSoAFile(), without copying it.
+	/** @return False if the data is not a valid SoA file of this build, or is not suitably aligned, in which case this mesh is left empty. */
+	bool SetSoAFileView(const void *fileData, size_t fileSizeBytes);
+
 	float IntersectRay_TriangleIndex_UV_CPP(const Ray &ray, int &outTriangleIndex, float &outU, float &outV) const;
+	/// Computes the closest point on this mesh one triangle at a time. Works with the AoS, SoA4 and SoA8 layouts.
+	float ClosestPoint_CPP(const vec &point, vec &outClosestPoint, int &outTriangleIndex) const;
+	/// Computes the first contact of a swept sphere or capsule one triangle at a time. Works with the AoS, SoA4 and SoA8 layouts.
+	/** @return The time of impact, or FLOAT_INF if there is no contact. The contact normal is computed by SweepSphere() and SweepCapsule(). */
+	float SweepSphere_CPP(const Sphere &sphere, const vec &motion, vec &outContactPoint, int &outTriangleIndex) const;
+	float SweepCapsule_CPP(const Capsule &capsule, const vec &motion, vec &outContactPoint, int &outTriangleIndex) const;
 
 #ifdef MATH_SSE2
 	float IntersectRay_SSE2(const Ray &ray) const;
 	float IntersectRay_TriangleIndex_SSE2(const Ray &ray, int &outTriangleIndex) const;
 	float IntersectRay_TriangleIndex_UV_SSE2(const Ray &ray, int &outTriangleIndex, float &outU, float &outV) const;
+
+	float IntersectRay_Planes_SSE2(const Ray &ray) const;
+	float IntersectRay_Planes_TriangleIndex_SSE2(const Ray &ray, int &outTriangleIndex) const;
+	float IntersectRay_Planes_TriangleIndex_UV_SSE2(const Ray &ray, int &outTriangleIndex, float &outU, float &outV) const;
+
+	float ClosestPoint_SSE2(const vec &point, vec &outClosestPoint, int &outTriangleIndex) const;
+	float SweepSphere_SSE2(const Sphere &sphere, const vec &motion, vec &outContactPoint, int &outTriangleIndex) const;
+	float SweepCapsule_SSE2(const Capsule &capsule, const vec &motion, vec &outContactPoint, int &outTriangleIndex) const;
 #endif
 
 #ifdef MATH_SSE41
 	float IntersectRay_SSE41(const Ray &ray) const;
 	float IntersectRay_TriangleIndex_SSE41(const Ray &ray, int &outTriangleIndex) const;
 	float IntersectRay_TriangleIndex_UV_SSE41(const Ray &ray, int &outTriangleIndex, float &outU, float &outV) const;
+
+	float IntersectRay_Planes_SSE41(const Ray &ray) const;
+	float IntersectRay_Planes_TriangleIndex_SSE41(const Ray &ray, int &outTriangleIndex) const;
+	float IntersectRay_Planes_TriangleIndex_UV_SSE41(const Ray &ray, int &outTriangleIndex, float &outU, float &outV) const;
+
+	float ClosestPoint_SSE41(const vec &point, vec &outClosestPoint, int &outTriangleIndex) const;
 #endif
 
 #ifdef MATH_AVX
 	float IntersectRay_AVX(const Ray &ray) const;
 	float IntersectRay_TriangleIndex_AVX(const Ray &ray, int &outTriangleIndex) const;
 	float IntersectRay_TriangleIndex_UV_AVX(const Ray &ray, int &outTriangleIndex, float &outU, float &outV) const;
+
+	float IntersectRay_Planes_AVX(const Ray &ray) const;
+	float IntersectRay_Planes_TriangleIndex_AVX(const Ray &ray, int &outTriangleIndex) const;
+	float IntersectRay_Planes_TriangleIndex_UV_AVX(const Ray &ray, int &outTriangleIndex, float &outU, float &outV) const;
+
+	float ClosestPoint_AVX(const vec &point, vec &outClosestPoint, int &outTriangleIndex) const;
+	float SweepSphere_AVX(const Sphere &sphere, const vec &motion, vec &outContactPoint, int &outTriangleIndex) const;
+	float SweepCapsule_AVX(const Capsule &capsule, const vec &motion, vec &outContactPoint, int &outTriangleIndex) const;
 #endif
 
 private:
-	float *data; // This is always allocated to tightly-packed numTriangles*3*vertexSizeBytes bytes.
+	float *data; // Unless this mesh is a view, this is always allocated to tightly-packed numTriangles*3*vertexSizeBytes bytes.
 	int numTriangles;
 	int vertexSizeBytes;
-#ifdef _DEBUG
-	int vertexDataLayout; // 0 - AoS, 1 - SoA4, 2 - SoA8
-#endif
+	int vertexDataLayout; // 0 - AoS, 1 - SoA4, 2 - SoA8, 3 - SoA4Planes, 4 - SoA8Planes
+	bool ownsData; // If false, data points to memory owned by the caller, and is never written to or freed.
 	void ReallocVertexBuffer(int numTriangles, int vertexSizeBytes);
+	void SetView(const float *vertexData, int numTriangles, int vertexSizeBytes, int vertexDataLayout);
+	void ReleaseVertexBuffer();
 };
 
 MATH_END_NAMESPACE
@@ -0,0 +1,191 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file TriangleMesh_ClosestPoint_AVX.inl
+	@author Jukka Jylanki
+	@brief AVX implementation of the point-mesh closest point query for the SoA8 data layout. */
+
+#include "../Math/SSEMath.h"
+
+MATH_BEGIN_NAMESPACE
+
+// Selects with bitwise operations instead of _mm256_blendv_ps, since GCC rewrites blends of comparison masks
+// into integer vector operations, and without AVX2 falls back to extracting and testing each lane separately.
+#define BLEND_PS256(a, b, mask) _mm256_or_ps(_mm256_and_ps((mask), (b)), _mm256_andnot_ps((mask), (a)))
+
+float TriangleMesh::ClosestPoint_AVX(const vec &point, vec &outClosestPoint, int &outTriangleIndex) const
+{
+	assert(vertexDataLayout == 2); // Must be SoA8 structured!
+
+	__m256 nearestDSq = _mm256_set1_ps(FLOAT_INF);
+	__m256 nearestX = _mm256_setzero_ps();
+	__m256 nearestY = _mm256_setzero_ps();
+	__m256 nearestZ = _mm256_setzero_ps();
+	__m256 nearestIndex = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+	const __m256 pX = _mm256_set1_ps(point.x);
+	const __m256 pY = _mm256_set1_ps(point.y);
+	const __m256 pZ = _mm256_set1_ps(point.z);
+
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.f);
+
+	assert(((uintptr_t)data & 0x1F) == 0);
+
+	const float *tris = reinterpret_cast<const float*>(data);
+
+	for(int i = 0; i+8 <= numTriangles; i += 8)
+	{
+		__m256 ax = _mm256_load_ps(tris);
+		__m256 ay = _mm256_load_ps(tris+8);
+		__m256 az = _mm256_load_ps(tris+16);
+
+		__m256 abx = _mm256_load_ps(tris+24);
+		__m256 aby = _mm256_load_ps(tris+32);
+		__m256 abz = _mm256_load_ps(tris+40);
+
+		__m256 acx = _mm256_load_ps(tris+48);
+		__m256 acy = _mm256_load_ps(tris+56);
+		__m256 acz = _mm256_load_ps(tris+64);
+
+#ifndef SOA_HAS_EDGES
+		abx = _mm256_sub_ps(abx, ax);
+		aby = _mm256_sub_ps(aby, ay);
+		abz = _mm256_sub_ps(abz, az);
+		acx = _mm256_sub_ps(acx, ax);
+		acy = _mm256_sub_ps(acy, ay);
+		acz = _mm256_sub_ps(acz, az);
+#endif
+
+		__m256 apx = _mm256_sub_ps(pX, ax);
+		__m256 apy = _mm256_sub_ps(pY, ay);
+		__m256 apz = _mm256_sub_ps(pZ, az);
+
+		// The Voronoi region tests of Ericson, Real-Time Collision Detection, p. 141, evaluated for all eight triangles at once.
+		// Since bp = ap - ab and cp = ap - ac, the dot products d3..d6 are derived from d1, d2 and the edge dot products.
+		__m256 d1 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(abx, apx), _mm256_mul_ps(aby, apy)), _mm256_mul_ps(abz, apz));
+		__m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(acx, apx), _mm256_mul_ps(acy, apy)), _mm256_mul_ps(acz, apz));
+		__m256 abab = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(abx, abx), _mm256_mul_ps(aby, aby)), _mm256_mul_ps(abz, abz));
+		__m256 acac = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(acx, acx), _mm256_mul_ps(acy, acy)), _mm256_mul_ps(acz, acz));
+		__m256 abac = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(abx, acx), _mm256_mul_ps(aby, acy)), _mm256_mul_ps(abz, acz));
+		__m256 d3 = _mm256_sub_ps(d1, abab);
+		__m256 d4 = _mm256_sub_ps(d2, abac);
+		__m256 d5 = _mm256_sub_ps(d1, abac);
+		__m256 d6 = _mm256_sub_ps(d2, acac);
+
+		__m256 va = _mm256_sub_ps(_mm256_mul_ps(d3, d6), _mm256_mul_ps(d5, d4));
+		__m256 vb = _mm256_sub_ps(_mm256_mul_ps(d5, d2), _mm256_mul_ps(d1, d6));
+		__m256 vc = _mm256_sub_ps(_mm256_mul_ps(d1, d4), _mm256_mul_ps(d3, d2));
+
+		// The closest point is a + (sNum*ab + tNum*ac) / denom. Start from the face interior, and override with the edge and vertex
+		// regions in the reverse order of the scalar code, so that the region that the scalar code would pick first wins.
+		// Selecting the numerators and the denominator first lets all regions share a single division.
+		__m256 sNum = vb;
+		__m256 tNum = vc;
+		__m256 denom = _mm256_add_ps(_mm256_add_ps(va, vb), vc);
+
+		// Edge BC.
+		__m256 d43 = _mm256_sub_ps(d4, d3);
+		__m256 d56 = _mm256_sub_ps(d5, d6);
+		__m256 mask = _mm256_and_ps(_mm256_cmp_ps(va, zero, _CMP_LE_OQ), _mm256_and_ps(_mm256_cmp_ps(d43, zero, _CMP_GE_OQ), _mm256_cmp_ps(d56, zero, _CMP_GE_OQ)));
+		sNum = BLEND_PS256(sNum, d56, mask);
+		tNum = BLEND_PS256(tNum, d43, mask);
+		denom = BLEND_PS256(denom, _mm256_add_ps(d43, d56), mask);
+
+		// Edge AC.
+		mask = _mm256_and_ps(_mm256_cmp_ps(vb, zero, _CMP_LE_OQ), _mm256_and_ps(_mm256_cmp_ps(d2, zero, _CMP_GE_OQ), _mm256_cmp_ps(d6, zero, _CMP_LE_OQ)));
+		sNum = _mm256_andnot_ps(mask, sNum);
+		tNum = BLEND_PS256(tNum, d2, mask);
+		denom = BLEND_PS256(denom, _mm256_sub_ps(d2, d6), mask);
+
+		// Vertex C.
+		mask = _mm256_and_ps(_mm256_cmp_ps(d6, zero, _CMP_GE_OQ), _mm256_cmp_ps(d5, d6, _CMP_LE_OQ));
+		sNum = _mm256_andnot_ps(mask, sNum);
+		tNum = BLEND_PS256(tNum, one, mask);
+		denom = BLEND_PS256(denom, one, mask);
+
+		// Edge AB.
+		mask = _mm256_and_ps(_mm256_cmp_ps(vc, zero, _CMP_LE_OQ), _mm256_and_ps(_mm256_cmp_ps(d1, zero, _CMP_GE_OQ), _mm256_cmp_ps(d3, zero, _CMP_LE_OQ)));
+		sNum = BLEND_PS256(sNum, d1, mask);
+		tNum = _mm256_andnot_ps(mask, tNum);
+		denom = BLEND_PS256(denom, _mm256_sub_ps(d1, d3), mask);
+
+		// Vertex B.
+		mask = _mm256_and_ps(_mm256_cmp_ps(d3, zero, _CMP_GE_OQ), _mm256_cmp_ps(d4, d3, _CMP_LE_OQ));
+		sNum = BLEND_PS256(sNum, one, mask);
+		tNum = _mm256_andnot_ps(mask, tNum);
+		denom = BLEND_PS256(denom, one, mask);
+
+		// Vertex A.
+		mask = _mm256_and_ps(_mm256_cmp_ps(d1, zero, _CMP_LE_OQ), _mm256_cmp_ps(d2, zero, _CMP_LE_OQ));
+		sNum = _mm256_andnot_ps(mask, sNum);
+		tNum = _mm256_andnot_ps(mask, tNum);
+		denom = BLEND_PS256(denom, one, mask);
+
+		__m256 recipDenom = _mm256_div_ps(one, denom);
+		__m256 s = _mm256_mul_ps(sNum, recipDenom);
+		__m256 t = _mm256_mul_ps(tNum, recipDenom);
+
+		__m256 qx = _mm256_add_ps(ax, _mm256_add_ps(_mm256_mul_ps(s, abx), _mm256_mul_ps(t, acx)));
+		__m256 qy = _mm256_add_ps(ay, _mm256_add_ps(_mm256_mul_ps(s, aby), _mm256_mul_ps(t, acy)));
+		__m256 qz = _mm256_add_ps(az, _mm256_add_ps(_mm256_mul_ps(s, abz), _mm256_mul_ps(t, acz)));
+
+		__m256 dx = _mm256_sub_ps(pX, qx);
+		__m256 dy = _mm256_sub_ps(pY, qy);
+		__m256 dz = _mm256_sub_ps(pZ, qz);
+		__m256 dSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+
+		// Degenerate triangles produce NaNs, which fail this comparison and never become the nearest point.
+		__m256 in = _mm256_cmp_ps(dSq, nearestDSq, _CMP_LT_OQ);
+		nearestDSq = BLEND_PS256(nearestDSq, dSq, in);
+		nearestX = BLEND_PS256(nearestX, qx, in);
+		nearestY = BLEND_PS256(nearestY, qy, in);
+		nearestZ = BLEND_PS256(nearestZ, qz, in);
+		nearestIndex = BLEND_PS256(nearestIndex, _mm256_castsi256_ps(_mm256_set1_epi32(i)), in);
+
+		tris += 72;
+	}
+
+	float ds[8];
+	float xs[8];
+	float ys[8];
+	float zs[8];
+	u32 idx[8];
+	_mm256_storeu_ps(ds, nearestDSq);
+	_mm256_storeu_ps(xs, nearestX);
+	_mm256_storeu_ps(ys, nearestY);
+	_mm256_storeu_ps(zs, nearestZ);
+	_mm256_storeu_si256((__m256i*)idx, _mm256_castps_si256(nearestIndex));
+
+	float smallestDSq = FLOAT_INF;
+	outClosestPoint = vec::nan;
+	outTriangleIndex = -1;
+	for(int i = 0; i < 8; ++i)
+		if (ds[i] < smallestDSq)
+		{
+			smallestDSq = ds[i];
+			outClosestPoint = POINT_VEC(xs[i], ys[i], zs[i]);
+			outTriangleIndex = idx[i]+i;
+		}
+
+	return Sqrt(smallestDSq);
+}
+
+#undef BLEND_PS256
+
+#ifdef MATH_GEN_AVX
+#undef MATH_GEN_AVX
+#endif
+
+MATH_END_NAMESPACE
@@ -0,0 +1,193 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file TriangleMesh_ClosestPoint_SSE.inl
+	@author Jukka Jylanki
+	@brief SSE implementation of the point-mesh closest point query for the SoA4 data layout. */
+MATH_BEGIN_NAMESPACE
+
+#ifdef MATH_GEN_SSE41
+#define BLEND_PS(a, b, mask) _mm_blendv_ps((a), (b), (mask))
+#else
+#define BLEND_PS(a, b, mask) _mm_or_ps(_mm_and_ps((mask), (b)), _mm_andnot_ps((mask), (a)))
+#endif
+
+#if defined(MATH_GEN_SSE2)
+float TriangleMesh::ClosestPoint_SSE2(const vec &point, vec &outClosestPoint, int &outTriangleIndex) const
+#elif defined(MATH_GEN_SSE41)
+float TriangleMesh::ClosestPoint_SSE41(const vec &point, vec &outClosestPoint, int &outTriangleIndex) const
+#endif
+{
+	assert(vertexDataLayout == 1); // Must be SoA4 structured!
+
+	__m128 nearestDSq = _mm_set1_ps(FLOAT_INF);
+	__m128 nearestX = _mm_setzero_ps();
+	__m128 nearestY = _mm_setzero_ps();
+	__m128 nearestZ = _mm_setzero_ps();
+	__m128i nearestIndex = _mm_set1_epi32(-1);
+
+	const __m128 pX = _mm_set1_ps(point.x);
+	const __m128 pY = _mm_set1_ps(point.y);
+	const __m128 pZ = _mm_set1_ps(point.z);
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.f);
+
+	assert(((uintptr_t)data & 0xF) == 0);
+
+	const float *tris = reinterpret_cast<const float*>(data);
+
+	for(int i = 0; i+4 <= numTriangles; i += 4)
+	{
+		__m128 ax = _mm_load_ps(tris);
+		__m128 ay = _mm_load_ps(tris+4);
+		__m128 az = _mm_load_ps(tris+8);
+
+		__m128 abx = _mm_load_ps(tris+12);
+		__m128 aby = _mm_load_ps(tris+16);
+		__m128 abz = _mm_load_ps(tris+20);
+
+		__m128 acx = _mm_load_ps(tris+24);
+		__m128 acy = _mm_load_ps(tris+28);
+		__m128 acz = _mm_load_ps(tris+32);
+
+#ifndef SOA_HAS_EDGES
+		abx = _mm_sub_ps(abx, ax);
+		aby = _mm_sub_ps(aby, ay);
+		abz = _mm_sub_ps(abz, az);
+		acx = _mm_sub_ps(acx, ax);
+		acy = _mm_sub_ps(acy, ay);
+		acz = _mm_sub_ps(acz, az);
+#endif
+
+		__m128 apx = _mm_sub_ps(pX, ax);
+		__m128 apy = _mm_sub_ps(pY, ay);
+		__m128 apz = _mm_sub_ps(pZ, az);
+
+		// The Voronoi region tests of Ericson, Real-Time Collision Detection, p. 141, evaluated for all four triangles at once.
+		// Since bp = ap - ab and cp = ap - ac, the dot products d3..d6 are derived from d1, d2 and the edge dot products.
+		__m128 d1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(abx, apx), _mm_mul_ps(aby, apy)), _mm_mul_ps(abz, apz));
+		__m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(acx, apx), _mm_mul_ps(acy, apy)), _mm_mul_ps(acz, apz));
+		__m128 abab = _mm_add_ps(_mm_add_ps(_mm_mul_ps(abx, abx), _mm_mul_ps(aby, aby)), _mm_mul_ps(abz, abz));
+		__m128 acac = _mm_add_ps(_mm_add_ps(_mm_mul_ps(acx, acx), _mm_mul_ps(acy, acy)), _mm_mul_ps(acz, acz));
+		__m128 abac = _mm_add_ps(_mm_add_ps(_mm_mul_ps(abx, acx), _mm_mul_ps(aby, acy)), _mm_mul_ps(abz, acz));
+		__m128 d3 = _mm_sub_ps(d1, abab);
+		__m128 d4 = _mm_sub_ps(d2, abac);
+		__m128 d5 = _mm_sub_ps(d1, abac);
+		__m128 d6 = _mm_sub_ps(d2, acac);
+
+		__m128 va = _mm_sub_ps(_mm_mul_ps(d3, d6), _mm_mul_ps(d5, d4));
+		__m128 vb = _mm_sub_ps(_mm_mul_ps(d5, d2), _mm_mul_ps(d1, d6));
+		__m128 vc = _mm_sub_ps(_mm_mul_ps(d1, d4), _mm_mul_ps(d3, d2));
+
+		// The closest point is a + (sNum*ab + tNum*ac) / denom. Start from the face interior, and override with the edge and vertex
+		// regions in the reverse order of the scalar code, so that the region that the scalar code would pick first wins.
+		// Selecting the numerators and the denominator first lets all regions share a single division.
+		__m128 sNum = vb;
+		__m128 tNum = vc;
+		__m128 denom = _mm_add_ps(_mm_add_ps(va, vb), vc);
+
+		// Edge BC.
+		__m128 d43 = _mm_sub_ps(d4, d3);
+		__m128 d56 = _mm_sub_ps(d5, d6);
+		__m128 mask = _mm_and_ps(_mm_cmple_ps(va, zero), _mm_and_ps(_mm_cmpge_ps(d43, zero), _mm_cmpge_ps(d56, zero)));
+		sNum = BLEND_PS(sNum, d56, mask);
+		tNum = BLEND_PS(tNum, d43, mask);
+		denom = BLEND_PS(denom, _mm_add_ps(d43, d56), mask);
+
+		// Edge AC.
+		mask = _mm_and_ps(_mm_cmple_ps(vb, zero), _mm_and_ps(_mm_cmpge_ps(d2, zero), _mm_cmple_ps(d6, zero)));
+		sNum = _mm_andnot_ps(mask, sNum);
+		tNum = BLEND_PS(tNum, d2, mask);
+		denom = BLEND_PS(denom, _mm_sub_ps(d2, d6), mask);
+
+		// Vertex C.
+		mask = _mm_and_ps(_mm_cmpge_ps(d6, zero), _mm_cmple_ps(d5, d6));
+		sNum = _mm_andnot_ps(mask, sNum);
+		tNum = BLEND_PS(tNum, one, mask);
+		denom = BLEND_PS(denom, one, mask);
+
+		// Edge AB.
+		mask = _mm_and_ps(_mm_cmple_ps(vc, zero), _mm_and_ps(_mm_cmpge_ps(d1, zero), _mm_cmple_ps(d3, zero)));
+		sNum = BLEND_PS(sNum, d1, mask);
+		tNum = _mm_andnot_ps(mask, tNum);
+		denom = BLEND_PS(denom, _mm_sub_ps(d1, d3), mask);
+
+		// Vertex B.
+		mask = _mm_and_ps(_mm_cmpge_ps(d3, zero), _mm_cmple_ps(d4, d3));
+		sNum = BLEND_PS(sNum, one, mask);
+		tNum = _mm_andnot_ps(mask, tNum);
+		denom = BLEND_PS(denom, one, mask);
+
+		// Vertex A.
+		mask = _mm_and_ps(_mm_cmple_ps(d1, zero), _mm_cmple_ps(d2, zero));
+		sNum = _mm_andnot_ps(mask, sNum);
+		tNum = _mm_andnot_ps(mask, tNum);
+		denom = BLEND_PS(denom, one, mask);
+
+		__m128 recipDenom = _mm_div_ps(one, denom);
+		__m128 s = _mm_mul_ps(sNum, recipDenom);
+		__m128 t = _mm_mul_ps(tNum, recipDenom);
+
+		__m128 qx = _mm_add_ps(ax, _mm_add_ps(_mm_mul_ps(s, abx), _mm_mul_ps(t, acx)));
+		__m128 qy = _mm_add_ps(ay, _mm_add_ps(_mm_mul_ps(s, aby), _mm_mul_ps(t, acy)));
+		__m128 qz = _mm_add_ps(az, _mm_add_ps(_mm_mul_ps(s, abz), _mm_mul_ps(t, acz)));
+
+		__m128 dx = _mm_sub_ps(pX, qx);
+		__m128 dy = _mm_sub_ps(pY, qy);
+		__m128 dz = _mm_sub_ps(pZ, qz);
+		__m128 dSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+		// Degenerate triangles produce NaNs, which fail this comparison and never become the nearest point.
+		__m128 in = _mm_cmplt_ps(dSq, nearestDSq);
+		nearestDSq = BLEND_PS(nearestDSq, dSq, in);
+		nearestX = BLEND_PS(nearestX, qx, in);
+		nearestY = BLEND_PS(nearestY, qy, in);
+		nearestZ = BLEND_PS(nearestZ, qz, in);
+		nearestIndex = _mm_castps_si128(BLEND_PS(_mm_castsi128_ps(nearestIndex), _mm_castsi128_ps(_mm_set1_epi32(i)), in));
+
+		tris += 36;
+	}
+
+	float4 d = nearestDSq;
+	float4 x = nearestX;
+	float4 y = nearestY;
+	float4 z = nearestZ;
+	u32 idx[4];
+	_mm_storeu_si128((__m128i*)idx, nearestIndex);
+
+	float smallestDSq = FLOAT_INF;
+	outClosestPoint = vec::nan;
+	outTriangleIndex = -1;
+	for(int i = 0; i < 4; ++i)
+		if (d[i] < smallestDSq)
+		{
+			smallestDSq = d[i];
+			outClosestPoint = POINT_VEC(x[i], y[i], z[i]);
+			outTriangleIndex = idx[i]+i;
+		}
+
+	return Sqrt(smallestDSq);
+}
+
+#undef BLEND_PS
+
+#ifdef MATH_GEN_SSE2
+#undef MATH_GEN_SSE2
+#endif
+#ifdef MATH_GEN_SSE41
+#undef MATH_GEN_SSE41
+#endif
+
+MATH_END_NAMESPACE
@@ -0,0 +1,165 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file TriangleMesh_IntersectRay_Planes_AVX.inl
+	@author Jukka Jylanki
+	@brief AVX implementation of ray-mesh intersection routines for the precomputed triangle plane data layout. */
+
+#include "../Math/SSEMath.h"
+
+MATH_BEGIN_NAMESPACE
+
+#if !defined(MATH_GEN_TRIANGLEINDEX)
+float TriangleMesh::IntersectRay_Planes_AVX(const Ray &ray) const
+#elif defined(MATH_GEN_TRIANGLEINDEX) && !defined(MATH_GEN_UV)
+float TriangleMesh::IntersectRay_Planes_TriangleIndex_AVX(const Ray &ray, int &outTriangleIndex) const
+#elif defined(MATH_GEN_TRIANGLEINDEX) && defined(MATH_GEN_UV)
+float TriangleMesh::IntersectRay_Planes_TriangleIndex_UV_AVX(const Ray &ray, int &outTriangleIndex, float &outU, float &outV) const
+#endif
+{
+#ifdef _DEBUG
+	assert(vertexDataLayout == 4); // Must be SoA8Planes structured!
+#endif
+
+	__m256 nearestD = _mm256_set1_ps(inf);
+#ifdef MATH_GEN_UV
+	__m256 nearestU = _mm256_set1_ps(inf);
+	__m256 nearestV = _mm256_set1_ps(inf);
+#endif
+#ifdef MATH_GEN_TRIANGLEINDEX
+	__m256i nearestIndex = _mm256_set1_epi32(-1);
+#endif
+
+	const __m256 lX = _mm256_broadcast_ss(&ray.pos.x);
+	const __m256 lY = _mm256_broadcast_ss(&ray.pos.y);
+	const __m256 lZ = _mm256_broadcast_ss(&ray.pos.z);
+
+	const __m256 dX = _mm256_broadcast_ss(&ray.dir.x);
+	const __m256 dY = _mm256_broadcast_ss(&ray.dir.y);
+	const __m256 dZ = _mm256_broadcast_ss(&ray.dir.z);
+
+	const __m256 epsilon = _mm256_set1_ps(1e-4f);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.f);
+
+	assert(((uintptr_t)data & 0x1F) == 0);
+
+	const float *tris = reinterpret_cast<const float*>(data);
+
+	for(int i = 0; i+8 <= numTriangles; i += 8)
+	{
+		__m256 n0x = _mm256_load_ps(tris);
+		__m256 n0y = _mm256_load_ps(tris+8);
+		__m256 n0z = _mm256_load_ps(tris+16);
+		__m256 d0 = _mm256_load_ps(tris+24);
+
+		// det = Dot(dir, n0). If det < 0, intersecting frontfacing tri, > 0, intersecting backfacing tri, 0, parallel to plane.
+		__m256 det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dX, n0x), _mm256_mul_ps(dY, n0y)), _mm256_mul_ps(dZ, n0z));
+
+		// Scaled distance along the ray to the triangle plane: t*det = d0 - Dot(pos, n0).
+		__m256 tdet = _mm256_sub_ps(d0, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lX, n0x), _mm256_mul_ps(lY, n0y)), _mm256_mul_ps(lZ, n0z)));
+
+		__m256 recipDet = _mm256_rcp_ps(det);
+
+		// The point of intersection with the triangle plane, scaled by det: pos*det + dir*t*det.
+		__m256 px = _mm256_add_ps(_mm256_mul_ps(lX, det), _mm256_mul_ps(dX, tdet));
+		__m256 py = _mm256_add_ps(_mm256_mul_ps(lY, det), _mm256_mul_ps(dY, tdet));
+		__m256 pz = _mm256_add_ps(_mm256_mul_ps(lZ, det), _mm256_mul_ps(dZ, tdet));
+
+		// Output barycentric u
+		__m256 n1x = _mm256_load_ps(tris+32);
+		__m256 n1y = _mm256_load_ps(tris+40);
+		__m256 n1z = _mm256_load_ps(tris+48);
+		__m256 d1 = _mm256_load_ps(tris+56);
+		__m256 u = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, n1x), _mm256_mul_ps(py, n1y)), _mm256_add_ps(_mm256_mul_ps(pz, n1z), _mm256_mul_ps(det, d1)));
+		u = _mm256_mul_ps(u, recipDet);
+
+		// Output barycentric v
+		__m256 n2x = _mm256_load_ps(tris+64);
+		__m256 n2y = _mm256_load_ps(tris+72);
+		__m256 n2z = _mm256_load_ps(tris+80);
+		__m256 d2 = _mm256_load_ps(tris+88);
+		__m256 v = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, n2x), _mm256_mul_ps(py, n2y)), _mm256_add_ps(_mm256_mul_ps(pz, n2z), _mm256_mul_ps(det, d2)));
+		v = _mm256_mul_ps(v, recipDet);
+
+		// Output signed distance from ray to triangle.
+		__m256 t = _mm256_mul_ps(tdet, recipDet);
+
+		// Compute the mask of lanes that hit, instead of the lanes that miss, so that the NaNs of degenerate triangles get rejected.
+		__m256 in = _mm256_cmp_ps(abs_ps256(det), epsilon, _CMP_GT_OQ);
+		in = _mm256_and_ps(in, _mm256_cmp_ps(u, zero, _CMP_GE_OQ));
+		in = _mm256_and_ps(in, _mm256_cmp_ps(v, zero, _CMP_GE_OQ));
+		in = _mm256_and_ps(in, _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ));
+		in = _mm256_and_ps(in, _mm256_cmp_ps(t, zero, _CMP_GE_OQ));
+		in = _mm256_and_ps(in, _mm256_cmp_ps(t, nearestD, _CMP_LT_OQ));
+
+		// The mask 'in' now contains 0xFF in all indices which are better than previous, and
+		// 0x00 in indices which are worse.
+#ifdef MATH_GEN_TRIANGLEINDEX
+		__m256i hitIndex = _mm256_set1_epi32(i);
+		nearestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(nearestIndex), _mm256_castsi256_ps(hitIndex), in));
+#endif
+
+#ifdef MATH_GEN_UV
+		nearestU = _mm256_blendv_ps(nearestU, u, in);
+		nearestV = _mm256_blendv_ps(nearestV, v, in);
+#endif
+
+		nearestD = _mm256_blendv_ps(nearestD, t, in);
+
+		tris += 96;
+	}
+
+	float ds[8];
+	_mm256_storeu_ps(ds, nearestD);
+#ifdef MATH_GEN_UV
+	float su[8];
+	float sv[8];
+	_mm256_storeu_ps(su, nearestU);
+	_mm256_storeu_ps(sv, nearestV);
+#endif
+
+#ifdef MATH_GEN_TRIANGLEINDEX
+	u32 ds2[8];
+	_mm256_storeu_si256((__m256i*)ds2, nearestIndex);
+#endif
+
+	float smallestT = FLOAT_INF;
+	for(int i = 0; i < 8; ++i)
+		if (ds[i] < smallestT)
+		{
+			smallestT = ds[i];
+#ifdef MATH_GEN_TRIANGLEINDEX
+			outTriangleIndex = ds2[i]+i;
+#endif
+#ifdef MATH_GEN_UV
+			outU = su[i];
+			outV = sv[i];
+#endif
+		}
+
+	return smallestT;
+}
+
+#ifdef MATH_GEN_AVX
+#undef MATH_GEN_AVX
+#endif
+#ifdef MATH_GEN_TRIANGLEINDEX
+#undef MATH_GEN_TRIANGLEINDEX
+#endif
+#ifdef MATH_GEN_UV
+#undef MATH_GEN_UV
+#endif
+
+MATH_END_NAMESPACE
@@ -0,0 +1,184 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file TriangleMesh_IntersectRay_Planes_SSE.inl
+	@author Jukka Jylanki
+	@brief SSE implementation of ray-mesh intersection routines for the precomputed triangle plane data layout. */
+MATH_BEGIN_NAMESPACE
+
+#if defined(MATH_GEN_SSE2) && !defined(MATH_GEN_TRIANGLEINDEX)
+float TriangleMesh::IntersectRay_Planes_SSE2(const Ray &ray) const
+#elif defined(MATH_GEN_SSE2) && defined(MATH_GEN_TRIANGLEINDEX) && !defined(MATH_GEN_UV)
+float TriangleMesh::IntersectRay_Planes_TriangleIndex_SSE2(const Ray &ray, int &outTriangleIndex) const
+#elif defined(MATH_GEN_SSE2) && defined(MATH_GEN_TRIANGLEINDEX) && defined(MATH_GEN_UV)
+float TriangleMesh::IntersectRay_Planes_TriangleIndex_UV_SSE2(const Ray &ray, int &outTriangleIndex, float &outU, float &outV) const
+#elif defined(MATH_GEN_SSE41) && !defined(MATH_GEN_TRIANGLEINDEX)
+float TriangleMesh::IntersectRay_Planes_SSE41(const Ray &ray) const
+#elif defined(MATH_GEN_SSE41) && defined(MATH_GEN_TRIANGLEINDEX) && !defined(MATH_GEN_UV)
+float TriangleMesh::IntersectRay_Planes_TriangleIndex_SSE41(const Ray &ray, int &outTriangleIndex) const
+#elif defined(MATH_GEN_SSE41) && defined(MATH_GEN_TRIANGLEINDEX) && defined(MATH_GEN_UV)
+float TriangleMesh::IntersectRay_Planes_TriangleIndex_UV_SSE41(const Ray &ray, int &outTriangleIndex, float &outU, float &outV) const
+#endif
+{
+#ifdef _DEBUG
+	assert(vertexDataLayout == 3); // Must be SoA4Planes structured!
+#endif
+
+	__m128 nearestD = _mm_set1_ps(inf);
+#ifdef MATH_GEN_UV
+	__m128 nearestU = _mm_set1_ps(inf);
+	__m128 nearestV = _mm_set1_ps(inf);
+#endif
+#ifdef MATH_GEN_TRIANGLEINDEX
+	__m128i nearestIndex = _mm_set1_epi32(-1);
+#endif
+
+	const __m128 lX = _mm_load1_ps(&ray.pos.x);
+	const __m128 lY = _mm_load1_ps(&ray.pos.y);
+	const __m128 lZ = _mm_load1_ps(&ray.pos.z);
+
+	const __m128 dX = _mm_load1_ps(&ray.dir.x);
+	const __m128 dY = _mm_load1_ps(&ray.dir.y);
+	const __m128 dZ = _mm_load1_ps(&ray.dir.z);
+
+	const __m128 epsilon = _mm_set1_ps(1e-4f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.f);
+
+	const __m128 sign_mask = _mm_set1_ps(-0.f); // -0.f = 1 << 31
+
+	assert(((uintptr_t)data & 0xF) == 0);
+
+	const float *tris = reinterpret_cast<const float*>(data);
+
+	for(int i = 0; i+4 <= numTriangles; i += 4)
+	{
+		__m128 n0x = _mm_load_ps(tris);
+		__m128 n0y = _mm_load_ps(tris+4);
+		__m128 n0z = _mm_load_ps(tris+8);
+		__m128 d0 = _mm_load_ps(tris+12);
+
+		// det = Dot(dir, n0). If det < 0, intersecting frontfacing tri, > 0, intersecting backfacing tri, 0, parallel to plane.
+		__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dX, n0x), _mm_mul_ps(dY, n0y)), _mm_mul_ps(dZ, n0z));
+
+		// Scaled distance along the ray to the triangle plane: t*det = d0 - Dot(pos, n0).
+		__m128 tdet = _mm_sub_ps(d0, _mm_add_ps(_mm_add_ps(_mm_mul_ps(lX, n0x), _mm_mul_ps(lY, n0y)), _mm_mul_ps(lZ, n0z)));
+
+		__m128 recipDet = _mm_rcp_ps(det);
+
+		// The point of intersection with the triangle plane, scaled by det: pos*det + dir*t*det.
+		__m128 px = _mm_add_ps(_mm_mul_ps(lX, det), _mm_mul_ps(dX, tdet));
+		__m128 py = _mm_add_ps(_mm_mul_ps(lY, det), _mm_mul_ps(dY, tdet));
+		__m128 pz = _mm_add_ps(_mm_mul_ps(lZ, det), _mm_mul_ps(dZ, tdet));
+
+		// Output barycentric u
+		__m128 n1x = _mm_load_ps(tris+16);
+		__m128 n1y = _mm_load_ps(tris+20);
+		__m128 n1z = _mm_load_ps(tris+24);
+		__m128 d1 = _mm_load_ps(tris+28);
+		__m128 u = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, n1x), _mm_mul_ps(py, n1y)), _mm_add_ps(_mm_mul_ps(pz, n1z), _mm_mul_ps(det, d1)));
+		u = _mm_mul_ps(u, recipDet);
+
+		// Output barycentric v
+		__m128 n2x = _mm_load_ps(tris+32);
+		__m128 n2y = _mm_load_ps(tris+36);
+		__m128 n2z = _mm_load_ps(tris+40);
+		__m128 d2 = _mm_load_ps(tris+44);
+		__m128 v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, n2x), _mm_mul_ps(py, n2y)), _mm_add_ps(_mm_mul_ps(pz, n2z), _mm_mul_ps(det, d2)));
+		v = _mm_mul_ps(v, recipDet);
+
+		// Output signed distance from ray to triangle.
+		__m128 t = _mm_mul_ps(tdet, recipDet);
+
+		// Compute the mask of lanes that hit, instead of the lanes that miss, so that the NaNs of degenerate triangles get rejected.
+		__m128 absdet = _mm_andnot_ps(sign_mask, det);
+		__m128 in = _mm_cmpgt_ps(absdet, epsilon);
+		in = _mm_and_ps(in, _mm_cmpge_ps(u, zero));
+		in = _mm_and_ps(in, _mm_cmpge_ps(v, zero));
+		in = _mm_and_ps(in, _mm_cmple_ps(_mm_add_ps(u, v), one));
+		in = _mm_and_ps(in, _mm_cmpge_ps(t, zero));
+		in = _mm_and_ps(in, _mm_cmplt_ps(t, nearestD));
+
+		// The mask 'in' now contains 0xFF in all indices which are better than previous, and
+		// 0x00 in indices which are worse.
+
+#ifdef MATH_GEN_SSE41
+		nearestD = _mm_blendv_ps(nearestD, t, in);
+#else
+		// If SSE 4.1 is not available:
+		nearestD = _mm_or_ps(_mm_and_ps(in, t), _mm_andnot_ps(in, nearestD));
+#endif
+
+#ifdef MATH_GEN_UV
+#ifdef MATH_GEN_SSE41
+		nearestU = _mm_blendv_ps(nearestU, u, in);
+		nearestV = _mm_blendv_ps(nearestV, v, in);
+#else
+		nearestU = _mm_or_ps(_mm_and_ps(in, u), _mm_andnot_ps(in, nearestU));
+		nearestV = _mm_or_ps(_mm_and_ps(in, v), _mm_andnot_ps(in, nearestV));
+#endif
+#endif
+
+#ifdef MATH_GEN_TRIANGLEINDEX
+		__m128i hitIndex = _mm_set1_epi32(i);
+#ifdef MATH_GEN_SSE41
+		nearestIndex = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(nearestIndex), _mm_castsi128_ps(hitIndex), in));
+#else
+		nearestIndex = _mm_or_si128(_mm_and_si128(_mm_castps_si128(in), hitIndex), _mm_andnot_si128(_mm_castps_si128(in), nearestIndex));
+#endif
+#endif
+
+		tris += 48;
+	}
+
+	float4 d = nearestD;
+#ifdef MATH_GEN_UV
+	float4 u = nearestU;
+	float4 v = nearestV;
+#endif
+#ifdef MATH_GEN_TRIANGLEINDEX
+	u32 idx[4];
+	_mm_storeu_si128((__m128i*)idx, nearestIndex);
+#endif
+	float smallestT = FLOAT_INF;
+	for(int i = 0; i < 4; ++i)
+		if (d[i] < smallestT)
+		{
+			smallestT = d[i];
+#ifdef MATH_GEN_TRIANGLEINDEX
+			outTriangleIndex = idx[i]+i;
+#endif
+#ifdef MATH_GEN_UV
+			outU = u[i];
+			outV = v[i];
+#endif
+		}
+
+	return smallestT;
+}
+
+#ifdef MATH_GEN_SSE2
+#undef MATH_GEN_SSE2
+#endif
+#ifdef MATH_GEN_SSE41
+#undef MATH_GEN_SSE41
+#endif
+#ifdef MATH_GEN_TRIANGLEINDEX
+#undef MATH_GEN_TRIANGLEINDEX
+#endif
+#ifdef MATH_GEN_UV
+#undef MATH_GEN_UV
+#endif
+
+MATH_END_NAMESPACE
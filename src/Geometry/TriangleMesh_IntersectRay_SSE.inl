@@ -35,7 +35,7 @@ float TriangleMesh::IntersectRay_TriangleIndex_UV_SSE41(const Ray &ray, int &out
 //	TRACESTART(RayTriMeshIntersectSSE);
 
 	assert(sizeof(float3) == 3*sizeof(float));
-	assert(sizeof(Triangle) == 3*sizeof(float3));
+	assert(sizeof(Triangle) == 3*sizeof(vec));
 #ifdef _DEBUG
 	assert(vertexDataLayout == 1); // Must be SoA4 structured!
 #endif
@@ -0,0 +1,553 @@
+/* Copyright Jukka Jylanki
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License. */
+
+/** @file TriangleMesh_Sweep.inl
+	@author Jukka Jylanki
+	@brief Swept sphere and swept capsule queries against a triangle mesh.
+
+	This file is included once for each of the scalar (no MATH_GEN_x defined), SSE2 (MATH_GEN_SSE2) and
+	AVX (MATH_GEN_AVX) versions. The scalar version processes one triangle at a time from any layout,
+	and the SIMD versions process 4 or 8 triangles at a time from the SoA4 or SoA8 layouts.
+
+	A sphere of radius r that moves along the vector d first touches a triangle either on the face,
+	on one of the three edges or on one of the three vertices. Each of these features is tested as a ray
+	cast from the sphere center against the feature inflated by r: a slab, a cylinder or a sphere.
+	A capsule additionally touches the triangle vertices with the cylindrical part of the capsule,
+	and the triangle edges with the capsule axis. */
+
+#if defined(MATH_GEN_AVX)
+
+#define SW_WIDTH 8
+#define SW_V __m256
+#define SW_M __m256
+#define SW_I __m256i
+#define SW_SUFFIX(name) name##_AVX
+#define SW_SET1(x) _mm256_set1_ps((x))
+#define SW_SET1I(x) _mm256_set1_epi32((x))
+#define SW_ADD(a, b) _mm256_add_ps((a), (b))
+#define SW_SUB(a, b) _mm256_sub_ps((a), (b))
+#define SW_MUL(a, b) _mm256_mul_ps((a), (b))
+#define SW_DIV(a, b) _mm256_div_ps((a), (b))
+#define SW_SQRT(x) _mm256_sqrt_ps((x))
+#define SW_MAX(a, b) _mm256_max_ps((a), (b))
+#define SW_ABS(x) _mm256_andnot_ps(_mm256_set1_ps(-0.f), (x))
+#define SW_XORSIGN(x, s) _mm256_xor_ps((x), _mm256_and_ps((s), _mm256_set1_ps(-0.f))) // Negates x in the lanes where s is negative.
+#define SW_LT(a, b) _mm256_cmp_ps((a), (b), _CMP_LT_OQ)
+#define SW_LE(a, b) _mm256_cmp_ps((a), (b), _CMP_LE_OQ)
+#define SW_GE(a, b) _mm256_cmp_ps((a), (b), _CMP_GE_OQ)
+#define SW_AND(a, b) _mm256_and_ps((a), (b))
+#define SW_OR(a, b) _mm256_or_ps((a), (b))
+// Selects with bitwise operations instead of _mm256_blendv_ps, see TriangleMesh_ClosestPoint_AVX.inl.
+#define SW_SELECT(a, b, mask) _mm256_or_ps(_mm256_and_ps((mask), (b)), _mm256_andnot_ps((mask), (a)))
+#define SW_SELECTI(a, b, mask) _mm256_castps_si256(SW_SELECT(_mm256_castsi256_ps((a)), _mm256_castsi256_ps((b)), (mask)))
+
+#elif defined(MATH_GEN_SSE2)
+
+#define SW_WIDTH 4
+#define SW_V __m128
+#define SW_M __m128
+#define SW_I __m128i
+#define SW_SUFFIX(name) name##_SSE2
+#define SW_SET1(x) _mm_set1_ps((x))
+#define SW_SET1I(x) _mm_set1_epi32((x))
+#define SW_ADD(a, b) _mm_add_ps((a), (b))
+#define SW_SUB(a, b) _mm_sub_ps((a), (b))
+#define SW_MUL(a, b) _mm_mul_ps((a), (b))
+#define SW_DIV(a, b) _mm_div_ps((a), (b))
+#define SW_SQRT(x) _mm_sqrt_ps((x))
+#define SW_MAX(a, b) _mm_max_ps((a), (b))
+#define SW_ABS(x) _mm_andnot_ps(_mm_set1_ps(-0.f), (x))
+#define SW_XORSIGN(x, s) _mm_xor_ps((x), _mm_and_ps((s), _mm_set1_ps(-0.f))) // Negates x in the lanes where s is negative.
+#define SW_LT(a, b) _mm_cmplt_ps((a), (b))
+#define SW_LE(a, b) _mm_cmple_ps((a), (b))
+#define SW_GE(a, b) _mm_cmpge_ps((a), (b))
+#define SW_AND(a, b) _mm_and_ps((a), (b))
+#define SW_OR(a, b) _mm_or_ps((a), (b))
+#define SW_SELECT(a, b, mask) _mm_or_ps(_mm_and_ps((mask), (b)), _mm_andnot_ps((mask), (a)))
+#define SW_SELECTI(a, b, mask) _mm_castps_si128(SW_SELECT(_mm_castsi128_ps((a)), _mm_castsi128_ps((b)), (mask)))
+
+#else
+
+#define SW_WIDTH 1
+#define SW_V float
+#define SW_M bool
+#define SW_I int
+#define SW_SUFFIX(name) name##_CPP
+#define SW_SET1(x) (x)
+#define SW_SET1I(x) (x)
+#define SW_ADD(a, b) ((a) + (b))
+#define SW_SUB(a, b) ((a) - (b))
+#define SW_MUL(a, b) ((a) * (b))
+#define SW_DIV(a, b) ((a) / (b))
+#define SW_SQRT(x) Sqrt((x))
+#define SW_MAX(a, b) Max((a), (b))
+#define SW_ABS(x) Abs((x))
+#define SW_XORSIGN(x, s) ((s) < 0.f ? -(x) : (x))
+#define SW_LT(a, b) ((a) < (b))
+#define SW_LE(a, b) ((a) <= (b))
+#define SW_GE(a, b) ((a) >= (b))
+#define SW_AND(a, b) ((a) && (b))
+#define SW_OR(a, b) ((a) || (b))
+#define SW_SELECT(a, b, mask) ((mask) ? (b) : (a))
+#define SW_SELECTI(a, b, mask) ((mask) ? (b) : (a))
+
+#endif
+
+#define SW_VEC SW_SUFFIX(SweepVec)
+#define SW_HIT SW_SUFFIX(SweepHit)
+
+MATH_BEGIN_NAMESPACE
+
+/// A SIMD vector of 3D points or direction vectors, one per triangle.
+struct SW_VEC
+{
+	SW_V x, y, z;
+};
+
+/// Tracks the earliest contact found so far in each lane.
+struct SW_HIT
+{
+	SW_V t;
+	SW_VEC point;
+	SW_I index;
+};
+
+static FORCE_INLINE SW_VEC SW_SUFFIX(SweepVecSet1)(const vec &v)
+{
+	SW_VEC r = { SW_SET1(v.x), SW_SET1(v.y), SW_SET1(v.z) };
+	return r;
+}
+
+static FORCE_INLINE SW_VEC SW_SUFFIX(SweepAdd)(const SW_VEC &a, const SW_VEC &b)
+{
+	SW_VEC r = { SW_ADD(a.x, b.x), SW_ADD(a.y, b.y), SW_ADD(a.z, b.z) };
+	return r;
+}
+
+static FORCE_INLINE SW_VEC SW_SUFFIX(SweepSub)(const SW_VEC &a, const SW_VEC &b)
+{
+	SW_VEC r = { SW_SUB(a.x, b.x), SW_SUB(a.y, b.y), SW_SUB(a.z, b.z) };
+	return r;
+}
+
+static FORCE_INLINE SW_VEC SW_SUFFIX(SweepScale)(const SW_VEC &a, SW_V s)
+{
+	SW_VEC r = { SW_MUL(a.x, s), SW_MUL(a.y, s), SW_MUL(a.z, s) };
+	return r;
+}
+
+/// Returns a + b*s.
+static FORCE_INLINE SW_VEC SW_SUFFIX(SweepMulAdd)(const SW_VEC &a, const SW_VEC &b, SW_V s)
+{
+	SW_VEC r = { SW_ADD(a.x, SW_MUL(b.x, s)), SW_ADD(a.y, SW_MUL(b.y, s)), SW_ADD(a.z, SW_MUL(b.z, s)) };
+	return r;
+}
+
+static FORCE_INLINE SW_V SW_SUFFIX(SweepDot)(const SW_VEC &a, const SW_VEC &b)
+{
+	return SW_ADD(SW_ADD(SW_MUL(a.x, b.x), SW_MUL(a.y, b.y)), SW_MUL(a.z, b.z));
+}
+
+static FORCE_INLINE SW_VEC SW_SUFFIX(SweepCross)(const SW_VEC &a, const SW_VEC &b)
+{
+	SW_VEC r = { SW_SUB(SW_MUL(a.y, b.z), SW_MUL(a.z, b.y)),
+	             SW_SUB(SW_MUL(a.z, b.x), SW_MUL(a.x, b.z)),
+	             SW_SUB(SW_MUL(a.x, b.y), SW_MUL(a.y, b.x)) };
+	return r;
+}
+
+/// Records a contact at time t and the given point in the lanes where valid is set and the contact is earlier than the previous one.
+/** NaN times, produced by degenerate triangles, fail the comparison and are never recorded. */
+static FORCE_INLINE void SW_SUFFIX(SweepRecord)(SW_HIT &hit, SW_V t, SW_M valid, const SW_VEC &point, SW_I index)
+{
+	SW_M in = SW_AND(valid, SW_AND(SW_LE(t, SW_SET1(1.f)), SW_LT(t, hit.t)));
+	hit.t = SW_SELECT(hit.t, t, in);
+	hit.point.x = SW_SELECT(hit.point.x, point.x, in);
+	hit.point.y = SW_SELECT(hit.point.y, point.y, in);
+	hit.point.z = SW_SELECT(hit.point.z, point.z, in);
+	hit.index = SW_SELECTI(hit.index, index, in);
+}
+
+/// Computes the time when a sphere of radius r at center o moving along d first touches the point p.
+/** Returns 0 if the sphere initially contains the point. dd is Dot(d, d). */
+static FORCE_INLINE SW_V SW_SUFFIX(SweepSpherePoint)(const SW_VEC &o, const SW_VEC &d, SW_V dd, SW_V rSq, const SW_VEC &p, SW_M &outValid)
+{
+	SW_VEC m = SW_SUFFIX(SweepSub)(o, p);
+	SW_V b = SW_SUFFIX(SweepDot)(m, d);
+	SW_V c = SW_SUB(SW_SUFFIX(SweepDot)(m, m), rSq);
+	SW_V disc = SW_SUB(SW_MUL(b, b), SW_MUL(dd, c));
+	SW_V zero = SW_SET1(0.f);
+	SW_M overlap = SW_LE(c, zero);
+	outValid = SW_OR(overlap, SW_AND(SW_LT(b, zero), SW_GE(disc, zero)));
+	SW_V t = SW_DIV(SW_SUB(SW_SUB(zero, b), SW_SQRT(SW_MAX(disc, zero))), dd);
+	return SW_SELECT(t, zero, overlap);
+}
+
+/// Computes the time when a sphere of radius r at center o moving along d first touches the segment p + s*e, 0 <= s <= 1, on the segment interior.
+/** Returns 0 if the sphere initially overlaps the segment interior. Outputs the segment parameter s of the contact point in outS. */
+static FORCE_INLINE SW_V SW_SUFFIX(SweepSphereSegment)(const SW_VEC &o, const SW_VEC &d, SW_V dd, SW_V rSq, const SW_VEC &p, const SW_VEC &e, SW_M &outValid, SW_V &outS)
+{
+	// Solve for |m + t*d|^2 = r^2 in the plane perpendicular to e, where m = o - p. All terms are scaled by Dot(e, e).
+	SW_VEC m = SW_SUFFIX(SweepSub)(o, p);
+	SW_V ee = SW_SUFFIX(SweepDot)(e, e);
+	SW_V me = SW_SUFFIX(SweepDot)(m, e);
+	SW_V de = SW_SUFFIX(SweepDot)(d, e);
+	SW_V a = SW_SUB(SW_MUL(ee, dd), SW_MUL(de, de));
+	SW_V b = SW_SUB(SW_MUL(ee, SW_SUFFIX(SweepDot)(m, d)), SW_MUL(me, de));
+	SW_V c = SW_SUB(SW_MUL(ee, SW_SUB(SW_SUFFIX(SweepDot)(m, m), rSq)), SW_MUL(me, me));
+	SW_V disc = SW_SUB(SW_MUL(b, b), SW_MUL(a, c));
+	SW_V zero = SW_SET1(0.f);
+	SW_M overlap = SW_LE(c, zero);
+	SW_V t = SW_DIV(SW_SUB(SW_SUB(zero, b), SW_SQRT(SW_MAX(disc, zero))), a);
+	t = SW_SELECT(t, zero, overlap);
+	outS = SW_DIV(SW_ADD(me, SW_MUL(t, de)), ee);
+	outValid = SW_AND(SW_OR(overlap, SW_AND(SW_LT(b, zero), SW_GE(disc, zero))),
+	                  SW_AND(SW_GE(outS, zero), SW_LE(outS, SW_SET1(1.f))));
+	return t;
+}
+
+/// Precomputed per-triangle data for the face tests.
+struct SW_SUFFIX(SweepFace)
+{
+	SW_VEC n; // Unnormalized triangle normal Cross(ab, ac).
+	SW_VEC u1; // Cross(ac, n). Dot(p - a, u1) / Dot(n, n) gives the barycentric coordinate of p along ab.
+	SW_VEC u2; // Cross(n, ab). Dot(p - a, u2) / Dot(n, n) gives the barycentric coordinate of p along ac.
+	SW_V invNN; // 1 / Dot(n, n).
+	SW_V nLength; // |n|.
+};
+
+static FORCE_INLINE SW_SUFFIX(SweepFace) SW_SUFFIX(SweepFaceSetup)(const SW_VEC &ab, const SW_VEC &ac)
+{
+	SW_SUFFIX(SweepFace) f;
+	f.n = SW_SUFFIX(SweepCross)(ab, ac);
+	f.u1 = SW_SUFFIX(SweepCross)(ac, f.n);
+	f.u2 = SW_SUFFIX(SweepCross)(f.n, ab);
+	SW_V nn = SW_SUFFIX(SweepDot)(f.n, f.n);
+	f.invNN = SW_DIV(SW_SET1(1.f), nn);
+	f.nLength = SW_SQRT(nn);
+	return f;
+}
+
+/// Computes the barycentric coordinates of the projection of w = p - a on the triangle plane, and returns whether the projection lies inside the triangle.
+static FORCE_INLINE SW_M SW_SUFFIX(SweepInsideTriangle)(const SW_SUFFIX(SweepFace) &f, const SW_VEC &w, SW_V &outU, SW_V &outV)
+{
+	outU = SW_MUL(SW_SUFFIX(SweepDot)(w, f.u1), f.invNN);
+	outV = SW_MUL(SW_SUFFIX(SweepDot)(w, f.u2), f.invNN);
+	SW_V zero = SW_SET1(0.f);
+	return SW_AND(SW_AND(SW_GE(outU, zero), SW_GE(outV, zero)), SW_LE(SW_ADD(outU, outV), SW_SET1(1.f)));
+}
+
+/// Tests a sphere of radius r at center o moving along d against the face interior of the triangles.
+static FORCE_INLINE void SW_SUFFIX(SweepSphereFace)(SW_HIT &hit, SW_I index, const SW_VEC &o, const SW_VEC &d, SW_V r,
+	const SW_VEC &a, const SW_VEC &ab, const SW_VEC &ac, const SW_SUFFIX(SweepFace) &f)
+{
+	// Flip the normal to point towards the side of the sphere center, so that the sphere approaches the plane from the positive side.
+	SW_VEC w = SW_SUFFIX(SweepSub)(o, a);
+	SW_V dist = SW_SUFFIX(SweepDot)(w, f.n);
+	SW_V dn = SW_XORSIGN(SW_SUFFIX(SweepDot)(d, f.n), dist);
+	dist = SW_ABS(dist);
+	SW_V rn = SW_MUL(r, f.nLength);
+	SW_V zero = SW_SET1(0.f);
+	SW_M overlap = SW_LE(dist, rn);
+	SW_V t = SW_SELECT(SW_DIV(SW_SUB(dist, rn), SW_SUB(zero, dn)), zero, overlap);
+	SW_M valid = SW_OR(overlap, SW_LT(dn, zero));
+
+	SW_V u, v;
+	valid = SW_AND(valid, SW_SUFFIX(SweepInsideTriangle)(f, SW_SUFFIX(SweepMulAdd)(w, d, t), u, v));
+	SW_VEC point = SW_SUFFIX(SweepMulAdd)(SW_SUFFIX(SweepMulAdd)(a, ab, u), ac, v);
+	SW_SUFFIX(SweepRecord)(hit, t, valid, point, index);
+}
+
+/// Tests a sphere of radius r at center o moving along d against the edges and the vertices of the triangles.
+static FORCE_INLINE void SW_SUFFIX(SweepSphereEdgesAndVertices)(SW_HIT &hit, SW_I index, const SW_VEC &o, const SW_VEC &d, SW_V dd, SW_V rSq,
+	const SW_VEC &a, const SW_VEC &b, const SW_VEC &c, const SW_VEC &ab, const SW_VEC &ac, const SW_VEC &bc)
+{
+	SW_M valid;
+	SW_V s;
+	SW_V t = SW_SUFFIX(SweepSphereSegment)(o, d, dd, rSq, a, ab, valid, s);
+	SW_SUFFIX(SweepRecord)(hit, t, valid, SW_SUFFIX(SweepMulAdd)(a, ab, s), index);
+	t = SW_SUFFIX(SweepSphereSegment)(o, d, dd, rSq, a, ac, valid, s);
+	SW_SUFFIX(SweepRecord)(hit, t, valid, SW_SUFFIX(SweepMulAdd)(a, ac, s), index);
+	t = SW_SUFFIX(SweepSphereSegment)(o, d, dd, rSq, b, bc, valid, s);
+	SW_SUFFIX(SweepRecord)(hit, t, valid, SW_SUFFIX(SweepMulAdd)(b, bc, s), index);
+
+	t = SW_SUFFIX(SweepSpherePoint)(o, d, dd, rSq, a, valid);
+	SW_SUFFIX(SweepRecord)(hit, t, valid, a, index);
+	t = SW_SUFFIX(SweepSpherePoint)(o, d, dd, rSq, b, valid);
+	SW_SUFFIX(SweepRecord)(hit, t, valid, b, index);
+	t = SW_SUFFIX(SweepSpherePoint)(o, d, dd, rSq, c, valid);
+	SW_SUFFIX(SweepRecord)(hit, t, valid, c, index);
+}
+
+/// Tests the axis p0 + s*e of a capsule of radius r moving along d against the triangle edge q + u*f on the interiors of both segments.
+/** At the first contact the closest points of the two segments are separated by r along the common normal Cross(e, f). */
+static FORCE_INLINE void SW_SUFFIX(SweepAxisEdge)(SW_HIT &hit, SW_I index, const SW_VEC &p0, const SW_VEC &e, const SW_VEC &d, SW_V r,
+	const SW_VEC &q, const SW_VEC &f)
+{
+	SW_VEC n = SW_SUFFIX(SweepCross)(e, f);
+	SW_VEC w0 = SW_SUFFIX(SweepSub)(p0, q);
+	SW_V dist = SW_SUFFIX(SweepDot)(w0, n);
+	SW_V dn = SW_XORSIGN(SW_SUFFIX(SweepDot)(d, n), dist);
+	dist = SW_ABS(dist);
+	SW_V nn = SW_SUFFIX(SweepDot)(n, n);
+	SW_V rn = SW_MUL(r, SW_SQRT(nn));
+	SW_V zero = SW_SET1(0.f);
+	SW_V one = SW_SET1(1.f);
+	SW_M overlap = SW_LE(dist, rn);
+	SW_V t = SW_SELECT(SW_DIV(SW_SUB(dist, rn), SW_SUB(zero, dn)), zero, overlap);
+	SW_M valid = SW_OR(overlap, SW_LT(dn, zero));
+
+	// Find the closest points p0 + t*d + s*e and q + u*f of the two lines at time t.
+	SW_VEC w = SW_SUFFIX(SweepMulAdd)(w0, d, t);
+	SW_V ee = SW_SUFFIX(SweepDot)(e, e);
+	SW_V ef = SW_SUFFIX(SweepDot)(e, f);
+	SW_V ff = SW_SUFFIX(SweepDot)(f, f);
+	SW_V ew = SW_SUFFIX(SweepDot)(e, w);
+	SW_V fw = SW_SUFFIX(SweepDot)(f, w);
+	SW_V s = SW_DIV(SW_SUB(SW_MUL(ef, fw), SW_MUL(ff, ew)), nn);
+	SW_V u = SW_DIV(SW_SUB(SW_MUL(ee, fw), SW_MUL(ef, ew)), nn);
+	valid = SW_AND(valid, SW_AND(SW_AND(SW_GE(s, zero), SW_LE(s, one)), SW_AND(SW_GE(u, zero), SW_LE(u, one))));
+	SW_SUFFIX(SweepRecord)(hit, t, valid, SW_SUFFIX(SweepMulAdd)(q, f, u), index);
+}
+
+/// Tests whether the axis p0 + s*e of a capsule initially passes through the triangles, and records a contact at time 0 if so.
+static FORCE_INLINE void SW_SUFFIX(SweepAxisCrossing)(SW_HIT &hit, SW_I index, const SW_VEC &p0, const SW_VEC &e,
+	const SW_VEC &a, const SW_SUFFIX(SweepFace) &f)
+{
+	SW_VEC w0 = SW_SUFFIX(SweepSub)(p0, a);
+	SW_V h0 = SW_SUFFIX(SweepDot)(w0, f.n);
+	SW_V h1 = SW_ADD(h0, SW_SUFFIX(SweepDot)(e, f.n));
+	SW_V zero = SW_SET1(0.f);
+	SW_M crosses = SW_OR(SW_AND(SW_LE(h0, zero), SW_GE(h1, zero)), SW_AND(SW_GE(h0, zero), SW_LE(h1, zero)));
+	SW_V s = SW_DIV(h0, SW_SUB(h0, h1));
+	SW_VEC w = SW_SUFFIX(SweepMulAdd)(w0, e, s);
+	SW_V u, v;
+	SW_M valid = SW_AND(crosses, SW_SUFFIX(SweepInsideTriangle)(f, w, u, v));
+	SW_SUFFIX(SweepRecord)(hit, zero, valid, SW_SUFFIX(SweepAdd)(a, w), index);
+}
+
+static FORCE_INLINE void SW_SUFFIX(SweepSphereTriangles)(SW_HIT &hit, SW_I index, const SW_VEC &o, const SW_VEC &d, SW_V dd, SW_V r, SW_V rSq,
+	const SW_VEC &a, const SW_VEC &ab, const SW_VEC &ac)
+{
+	SW_VEC b = SW_SUFFIX(SweepAdd)(a, ab);
+	SW_VEC c = SW_SUFFIX(SweepAdd)(a, ac);
+	SW_VEC bc = SW_SUFFIX(SweepSub)(ac, ab);
+	SW_SUFFIX(SweepFace) f = SW_SUFFIX(SweepFaceSetup)(ab, ac);
+	SW_SUFFIX(SweepSphereFace)(hit, index, o, d, r, a, ab, ac, f);
+	SW_SUFFIX(SweepSphereEdgesAndVertices)(hit, index, o, d, dd, rSq, a, b, c, ab, ac, bc);
+}
+
+static FORCE_INLINE void SW_SUFFIX(SweepCapsuleTriangles)(SW_HIT &hit, SW_I index, const SW_VEC &p0, const SW_VEC &p1, const SW_VEC &e,
+	const SW_VEC &d, const SW_VEC &negD, SW_V dd, SW_V r, SW_V rSq, const SW_VEC &a, const SW_VEC &ab, const SW_VEC &ac)
+{
+	SW_VEC b = SW_SUFFIX(SweepAdd)(a, ab);
+	SW_VEC c = SW_SUFFIX(SweepAdd)(a, ac);
+	SW_VEC bc = SW_SUFFIX(SweepSub)(ac, ab);
+	SW_SUFFIX(SweepFace) f = SW_SUFFIX(SweepFaceSetup)(ab, ac);
+
+	SW_SUFFIX(SweepAxisCrossing)(hit, index, p0, e, a, f);
+
+	// The spherical end caps against all the triangle features.
+	SW_SUFFIX(SweepSphereFace)(hit, index, p0, d, r, a, ab, ac, f);
+	SW_SUFFIX(SweepSphereFace)(hit, index, p1, d, r, a, ab, ac, f);
+	SW_SUFFIX(SweepSphereEdgesAndVertices)(hit, index, p0, d, dd, rSq, a, b, c, ab, ac, bc);
+	SW_SUFFIX(SweepSphereEdgesAndVertices)(hit, index, p1, d, dd, rSq, a, b, c, ab, ac, bc);
+
+	// The cylindrical part against the triangle vertices: a vertex moving along -d against the capsule axis.
+	SW_M valid;
+	SW_V s;
+	SW_V t = SW_SUFFIX(SweepSphereSegment)(a, negD, dd, rSq, p0, e, valid, s);
+	SW_SUFFIX(SweepRecord)(hit, t, valid, a, index);
+	t = SW_SUFFIX(SweepSphereSegment)(b, negD, dd, rSq, p0, e, valid, s);
+	SW_SUFFIX(SweepRecord)(hit, t, valid, b, index);
+	t = SW_SUFFIX(SweepSphereSegment)(c, negD, dd, rSq, p0, e, valid, s);
+	SW_SUFFIX(SweepRecord)(hit, t, valid, c, index);
+
+	// The cylindrical part against the triangle edges.
+	SW_SUFFIX(SweepAxisEdge)(hit, index, p0, e, d, r, a, ab);
+	SW_SUFFIX(SweepAxisEdge)(hit, index, p0, e, d, r, a, ac);
+	SW_SUFFIX(SweepAxisEdge)(hit, index, p0, e, d, r, b, bc);
+}
+
+#if SW_WIDTH > 1
+/// Loads the v0 and edge vectors of SW_WIDTH triangles from a SoA4 or SoA8 block.
+static FORCE_INLINE void SW_SUFFIX(SweepLoadTriangles)(const float *tris, SW_VEC &a, SW_VEC &ab, SW_VEC &ac)
+{
+#ifdef MATH_GEN_AVX
+#define SW_LOAD(ptr) _mm256_load_ps((ptr))
+#else
+#define SW_LOAD(ptr) _mm_load_ps((ptr))
+#endif
+	a.x = SW_LOAD(tris); a.y = SW_LOAD(tris + SW_WIDTH); a.z = SW_LOAD(tris + 2*SW_WIDTH);
+	ab.x = SW_LOAD(tris + 3*SW_WIDTH); ab.y = SW_LOAD(tris + 4*SW_WIDTH); ab.z = SW_LOAD(tris + 5*SW_WIDTH);
+	ac.x = SW_LOAD(tris + 6*SW_WIDTH); ac.y = SW_LOAD(tris + 7*SW_WIDTH); ac.z = SW_LOAD(tris + 8*SW_WIDTH);
+#undef SW_LOAD
+#ifndef SOA_HAS_EDGES
+	ab = SW_SUFFIX(SweepSub)(ab, a);
+	ac = SW_SUFFIX(SweepSub)(ac, a);
+#endif
+}
+
+/// Finds the earliest contact over all lanes.
+static float SW_SUFFIX(SweepReduce)(const SW_HIT &hit, vec &outContactPoint, int &outTriangleIndex)
+{
+	float t[SW_WIDTH], x[SW_WIDTH], y[SW_WIDTH], z[SW_WIDTH];
+	u32 idx[SW_WIDTH];
+#ifdef MATH_GEN_AVX
+	_mm256_storeu_ps(t, hit.t);
+	_mm256_storeu_ps(x, hit.point.x);
+	_mm256_storeu_ps(y, hit.point.y);
+	_mm256_storeu_ps(z, hit.point.z);
+	_mm256_storeu_si256((__m256i*)idx, hit.index);
+#else
+	_mm_storeu_ps(t, hit.t);
+	_mm_storeu_ps(x, hit.point.x);
+	_mm_storeu_ps(y, hit.point.y);
+	_mm_storeu_ps(z, hit.point.z);
+	_mm_storeu_si128((__m128i*)idx, hit.index);
+#endif
+	float smallestT = FLOAT_INF;
+	for(int i = 0; i < SW_WIDTH; ++i)
+		if (t[i] < smallestT)
+		{
+			smallestT = t[i];
+			outContactPoint = POINT_VEC(x[i], y[i], z[i]);
+			outTriangleIndex = idx[i] + i;
+		}
+	return smallestT;
+}
+#endif
+
+float TriangleMesh::SW_SUFFIX(SweepSphere)(const Sphere &sphere, const vec &motion, vec &outContactPoint, int &outTriangleIndex) const
+{
+	const SW_VEC o = SW_SUFFIX(SweepVecSet1)(sphere.pos);
+	const SW_VEC d = SW_SUFFIX(SweepVecSet1)(motion);
+	const SW_V dd = SW_SET1(motion.x*motion.x + motion.y*motion.y + motion.z*motion.z);
+	const SW_V r = SW_SET1(sphere.r);
+	const SW_V rSq = SW_SET1(sphere.r * sphere.r);
+
+	SW_HIT hit;
+	hit.t = SW_SET1(FLOAT_INF);
+	hit.point = SW_SUFFIX(SweepVecSet1)(vec::zero);
+	hit.index = SW_SET1I(-1);
+	outContactPoint = vec::nan;
+	outTriangleIndex = -1;
+
+#if SW_WIDTH > 1
+	assert(vertexDataLayout == SW_WIDTH/4); // Must be SoA4 or SoA8 structured!
+	const float *tris = reinterpret_cast<const float*>(data);
+	for(int i = 0; i+SW_WIDTH <= numTriangles; i += SW_WIDTH, tris += 9*SW_WIDTH)
+	{
+		SW_VEC a, ab, ac;
+		SW_SUFFIX(SweepLoadTriangles)(tris, a, ab, ac);
+		SW_SUFFIX(SweepSphereTriangles)(hit, SW_SET1I(i), o, d, dd, r, rSq, a, ab, ac);
+	}
+	return SW_SUFFIX(SweepReduce)(hit, outContactPoint, outTriangleIndex);
+#else
+	for(int i = 0; i < numTriangles; ++i)
+	{
+		Triangle tri = GetTriangle(i);
+		SW_VEC a = SW_SUFFIX(SweepVecSet1)(tri.a);
+		SW_VEC ab = SW_SUFFIX(SweepVecSet1)(tri.b - tri.a);
+		SW_VEC ac = SW_SUFFIX(SweepVecSet1)(tri.c - tri.a);
+		SW_SUFFIX(SweepSphereTriangles)(hit, i, o, d, dd, r, rSq, a, ab, ac);
+	}
+	if (hit.index >= 0)
+	{
+		outContactPoint = POINT_VEC(hit.point.x, hit.point.y, hit.point.z);
+		outTriangleIndex = hit.index;
+	}
+	return hit.t;
+#endif
+}
+
+float TriangleMesh::SW_SUFFIX(SweepCapsule)(const Capsule &capsule, const vec &motion, vec &outContactPoint, int &outTriangleIndex) const
+{
+	const SW_VEC p0 = SW_SUFFIX(SweepVecSet1)(capsule.l.a);
+	const SW_VEC p1 = SW_SUFFIX(SweepVecSet1)(capsule.l.b);
+	const SW_VEC e = SW_SUFFIX(SweepSub)(p1, p0);
+	const SW_VEC d = SW_SUFFIX(SweepVecSet1)(motion);
+	const SW_VEC negD = SW_SUFFIX(SweepVecSet1)(-motion);
+	const SW_V dd = SW_SET1(motion.x*motion.x + motion.y*motion.y + motion.z*motion.z);
+	const SW_V r = SW_SET1(capsule.r);
+	const SW_V rSq = SW_SET1(capsule.r * capsule.r);
+
+	SW_HIT hit;
+	hit.t = SW_SET1(FLOAT_INF);
+	hit.point = SW_SUFFIX(SweepVecSet1)(vec::zero);
+	hit.index = SW_SET1I(-1);
+	outContactPoint = vec::nan;
+	outTriangleIndex = -1;
+
+#if SW_WIDTH > 1
+	assert(vertexDataLayout == SW_WIDTH/4); // Must be SoA4 or SoA8 structured!
+	const float *tris = reinterpret_cast<const float*>(data);
+	for(int i = 0; i+SW_WIDTH <= numTriangles; i += SW_WIDTH, tris += 9*SW_WIDTH)
+	{
+		SW_VEC a, ab, ac;
+		SW_SUFFIX(SweepLoadTriangles)(tris, a, ab, ac);
+		SW_SUFFIX(SweepCapsuleTriangles)(hit, SW_SET1I(i), p0, p1, e, d, negD, dd, r, rSq, a, ab, ac);
+	}
+	return SW_SUFFIX(SweepReduce)(hit, outContactPoint, outTriangleIndex);
+#else
+	for(int i = 0; i < numTriangles; ++i)
+	{
+		Triangle tri = GetTriangle(i);
+		SW_VEC a = SW_SUFFIX(SweepVecSet1)(tri.a);
+		SW_VEC ab = SW_SUFFIX(SweepVecSet1)(tri.b - tri.a);
+		SW_VEC ac = SW_SUFFIX(SweepVecSet1)(tri.c - tri.a);
+		SW_SUFFIX(SweepCapsuleTriangles)(hit, i, p0, p1, e, d, negD, dd, r, rSq, a, ab, ac);
+	}
+	if (hit.index >= 0)
+	{
+		outContactPoint = POINT_VEC(hit.point.x, hit.point.y, hit.point.z);
+		outTriangleIndex = hit.index;
+	}
+	return hit.t;
+#endif
+}
+
+MATH_END_NAMESPACE
+
+#undef SW_VEC
+#undef SW_HIT
+#undef SW_WIDTH
+#undef SW_V
+#undef SW_M
+#undef SW_I
+#undef SW_SUFFIX
+#undef SW_SET1
+#undef SW_SET1I
+#undef SW_ADD
+#undef SW_SUB
+#undef SW_MUL
+#undef SW_DIV
+#undef SW_SQRT
+#undef SW_MAX
+#undef SW_ABS
+#undef SW_XORSIGN
+#undef SW_LT
+#undef SW_LE
+#undef SW_GE
+#undef SW_AND
+#undef SW_OR
+#undef SW_SELECT
+#undef SW_SELECTI
+
+#ifdef MATH_GEN_SSE2
+#undef MATH_GEN_SSE2
+#endif
+#ifdef MATH_GEN_AVX
+#undef MATH_GEN_AVX
+#endif
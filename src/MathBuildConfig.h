@@ -79,6 +79,13 @@
 #define MATH_ENABLE_STL_SUPPORT
 #endif
 
+// If MATH_THREADS is defined, ThreadPool runs the work of ParallelFor() on multiple threads using
+// the C++11 <thread> library. Otherwise all parallel algorithms run sequentially on the calling thread.
+// Define MATH_NO_THREADS to force the sequential behavior.
+#if !defined(MATH_THREADS) && !defined(MATH_NO_THREADS) && !defined(__EMSCRIPTEN__) && (__cplusplus > 199711L || (defined(_MSC_VER) && _MSC_VER >= 1700))
+#define MATH_THREADS
+#endif
+
 // If MATH_TINYXML_INTEROP is defined, MathGeoLib integrates with TinyXML to provide
 // serialization and deserialization to XML for the data structures.
 #ifndef MATH_TINYXML_INTEROP
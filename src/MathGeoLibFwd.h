@@ -78,10 +78,13 @@ class PBVolume;
 class AABB;
 class Capsule;
 class Circle;
+class CompactPolyhedron;
 class Cone;
+class ConvexPolyhedron;
 class Cylinder;
 class Ellipsoid;
 class Frustum;
+class HalfEdgeMesh;
 struct HitInfo;
 class Line;
 class LineSegment;
@@ -90,6 +93,7 @@ class Plane;
 class Polygon;
 class Polyhedron;
 class Polynomial;
+class PreparedPolyhedron;
 class Quat;
 class Ray;
 class Sphere;
@@ -98,6 +102,7 @@ class Torus;
 class ScaleOp;
 class Triangle;
 class LCG;
+class ThreadPool;
 
 struct float4_storage;
 
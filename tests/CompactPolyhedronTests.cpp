@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/MathGeoLib.h"
+#include "../src/Math/myassert.h"
+#include "TestRunner.h"
+#include "TestData.h"
+#include "../src/Geometry/CompactPolyhedron.h"
+#include "ObjectGenerators.h"
+
+MATH_IGNORE_UNUSED_VARS_WARNING
+
+static float TotalArea(const TriangleArray &triangles)
+{
+	float area = 0.f;
+	for(size_t i = 0; i < triangles.size(); ++i)
+		area += Triangle(triangles[i]).Area();
+	return area;
+}
+
+RANDOMIZED_TEST(CompactPolyhedron_Conversion)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Polyhedron p = RandomPolyhedronContainingPoint(pt);
+	CompactPolyhedron c(p);
+	assert(c.NumVertices() == p.NumVertices());
+	assert(c.NumFaces() == p.NumFaces());
+	for(int i = 0; i < p.NumFaces(); ++i)
+	{
+		assert(c.NumFaceVertices(i) == (int)p.f[i].v.size());
+		assert(c.Face(i).v == p.f[i].v);
+		for(int j = 0; j < c.NumFaceVertices(i); ++j)
+			assert(c.FaceIndices(i)[j] == p.f[i].v[j]);
+		assert2(c.FaceNormal(i).Equals(p.FaceNormal(i), 1e-3f), c.FaceNormal(i), p.FaceNormal(i));
+		assert(c.FacePlane(i).Equals(p.FacePlane(i), 1e-3f));
+	}
+
+	Polyhedron p2 = c.ToPolyhedron();
+	assert(p2.NumFaces() == p.NumFaces());
+	for(int i = 0; i < p.NumVertices(); ++i)
+		assert(p2.Vertex(i).Equals(p.Vertex(i)));
+	for(int i = 0; i < p.NumFaces(); ++i)
+		assert(p2.f[i].v == p.f[i].v);
+}
+
+RANDOMIZED_TEST(CompactPolyhedron_Transform)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Polyhedron p = RandomPolyhedronContainingPoint(pt);
+	CompactPolyhedron c(p);
+	float3x4 tm = float3x4::FromTRS(float3::RandomBox(rng, -SCALE, SCALE), Quat::RandomRotation(rng), float3(2.f, 0.5f, 1.f));
+	p.Transform(tm);
+	c.Transform(tm);
+	for(int i = 0; i < p.NumVertices(); ++i)
+		assert(c.Vertex(i).Equals(p.Vertex(i)));
+}
+
+RANDOMIZED_TEST(CompactPolyhedron_Triangulate)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Polyhedron p = RandomPolyhedronContainingPoint(pt);
+	CompactPolyhedron c(p);
+	TriangleArray tris = c.Triangulate();
+	TriangleArray expected = p.Triangulate();
+	assert2(tris.size() == expected.size(), (int)tris.size(), (int)expected.size());
+	float area = TotalArea(tris);
+	float expectedArea = p.SurfaceArea();
+	assert2(EqualRel(area, expectedArea, 1e-3f), area, expectedArea);
+}
+
+// A face that is not convex cannot be triangulated as a fan.
+UNIQUE_TEST(CompactPolyhedron_TriangulateConcaveFace)
+{
+	CompactPolyhedron c;
+	c.v.push_back(POINT_VEC(0.f, 0.f, 0.f));
+	c.v.push_back(POINT_VEC(2.f, 0.f, 0.f));
+	c.v.push_back(POINT_VEC(2.f, 1.f, 0.f));
+	c.v.push_back(POINT_VEC(1.f, 1.f, 0.f));
+	c.v.push_back(POINT_VEC(1.f, 2.f, 0.f));
+	c.v.push_back(POINT_VEC(0.f, 2.f, 0.f));
+	// Start the face from the reflex corner, so that a fan from the first vertex would cover the notch.
+	const int face[] = { 3, 4, 5, 0, 1, 2 };
+	c.AddFace(face, 6);
+	TriangleArray tris = c.Triangulate();
+	assert(tris.size() == 4);
+	float area = TotalArea(tris);
+	assert1(EqualAbs(area, 3.f, 1e-4f), area);
+}
+
+// The hull has 506 vertices and 528 faces.
+struct CompactPolyhedronBenchmarkData
+{
+	Polyhedron polyhedron;
+	CompactPolyhedron compact;
+
+	CompactPolyhedronBenchmarkData()
+	{
+		polyhedron = EllipsoidPolyhedron(POINT_VEC_SCALAR(0.f), DIR_VEC(10.f, 6.f, 8.f), 21, 24);
+		compact = CompactPolyhedron(polyhedron);
+	}
+};
+
+BENCHMARK(Polyhedron_Copy, "Copy a 528-face Polyhedron")
+{
+	static const CompactPolyhedronBenchmarkData compactPolyhedronData;
+	Polyhedron copy = compactPolyhedronData.polyhedron;
+	TestData::dummyResultInt += copy.NumFaces();
+}
+BENCHMARK_END
+
+BENCHMARK(CompactPolyhedron_Copy, "Copy a 528-face CompactPolyhedron")
+{
+	static const CompactPolyhedronBenchmarkData compactPolyhedronData;
+	CompactPolyhedron copy = compactPolyhedronData.compact;
+	TestData::dummyResultInt += copy.NumFaces();
+}
+BENCHMARK_END
+
+BENCHMARK(Polyhedron_Triangulate, "Polyhedron::Triangulate() of a 528-face hull")
+{
+	static const CompactPolyhedronBenchmarkData compactPolyhedronData;
+	TestData::dummyResultInt += (int)compactPolyhedronData.polyhedron.Triangulate().size();
+}
+BENCHMARK_END
+
+BENCHMARK(CompactPolyhedron_Triangulate, "CompactPolyhedron::Triangulate() of a 528-face hull")
+{
+	static const CompactPolyhedronBenchmarkData compactPolyhedronData;
+	TestData::dummyResultInt += (int)compactPolyhedronData.compact.Triangulate().size();
+}
+BENCHMARK_END
@@ -0,0 +1,257 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/MathGeoLib.h"
+#include "../src/Math/myassert.h"
+#include "TestRunner.h"
+#include "TestData.h"
+#include "../src/Algorithm/ContactManifold.h"
+#include "../src/Algorithm/GJK.h"
+#include "ObjectGenerators.h"
+
+MATH_IGNORE_UNUSED_VARS_WARNING
+
+// Checks that each contact point lies on the surface of b, and that moving it by its depth along the normal reaches a.
+template<typename A, typename B>
+static void CheckContactManifold(const A &a, const B &b, const ContactManifold &m)
+{
+	const float tolerance = 1e-2f;
+	assert1(m.numPoints >= 1 && m.numPoints <= ContactManifold::maxPoints, m.numPoints);
+	assert1(m.normal.IsNormalized(), m.normal);
+	for(int i = 0; i < m.numPoints; ++i)
+	{
+		assert2(m.depths[i] >= 0.f, i, m.depths[i]);
+		assert3(b.Distance(m.points[i]) <= tolerance, i, m.points[i], b.Distance(m.points[i]));
+		vec pointA = m.points[i] + m.normal * m.depths[i];
+		assert3(a.Distance(pointA) <= tolerance, i, pointA, a.Distance(pointA));
+		MARK_UNUSED(pointA);
+	}
+}
+
+UNIQUE_TEST(ContactManifoldOBBOBBFace)
+{
+	OBB a(AABB(POINT_VEC(-1.f, -1.f, -1.f), POINT_VEC(1.f, 1.f, 1.f)));
+	OBB b(AABB(POINT_VEC(-0.5f, -0.5f, 0.9f), POINT_VEC(0.5f, 0.5f, 1.9f)));
+	ContactManifold m;
+	bool intersects = ComputeContactManifold(a, b, m);
+	assert(intersects);
+	assert1(m.normal.Equals(DIR_VEC(0.f, 0.f, 1.f)), m.normal);
+	assert1(m.numPoints == 4, m.numPoints);
+	for(int i = 0; i < m.numPoints; ++i)
+	{
+		assert2(EqualAbs(m.depths[i], 0.1f, 1e-4f), i, m.depths[i]);
+		assert2(EqualAbs(m.points[i].z, 0.9f, 1e-4f), i, m.points[i]);
+		assert2(EqualAbs(Abs(m.points[i].x), 0.5f, 1e-4f) && EqualAbs(Abs(m.points[i].y), 0.5f, 1e-4f), i, m.points[i]);
+	}
+	CheckContactManifold(a, b, m);
+	MARK_UNUSED(intersects);
+}
+
+// The bottom face of b is rotated 45 degrees, so clipping it against the top face of a gives an octagon, which is reduced to four points.
+UNIQUE_TEST(ContactManifoldOBBOBBReducedFace)
+{
+	OBB a(AABB(POINT_VEC(-1.f, -1.f, -1.f), POINT_VEC(1.f, 1.f, 1.f)));
+	OBB b = AABB(POINT_VEC(-1.f, -1.f, -1.f), POINT_VEC(1.f, 1.f, 1.f)).Transform(Quat::RotateZ(pi / 4.f));
+	b.Translate(DIR_VEC(0.f, 0.f, 1.9f));
+	ContactManifold m;
+	bool intersects = ComputeContactManifold(a, b, m);
+	assert(intersects);
+	assert1(m.normal.Equals(DIR_VEC(0.f, 0.f, 1.f)), m.normal);
+	assert1(m.numPoints == 4, m.numPoints);
+	for(int i = 0; i < m.numPoints; ++i)
+	{
+		assert2(EqualAbs(m.depths[i], 0.1f, 1e-4f), i, m.depths[i]);
+		for(int j = 0; j < i; ++j)
+			assert3(m.points[i].Distance(m.points[j]) > 0.5f, i, j, m.points[i]);
+	}
+	CheckContactManifold(a, b, m);
+	MARK_UNUSED(intersects);
+}
+
+// The OBBs are rotated 45 degrees about perpendicular axes, so that an edge of a crosses an edge of b.
+UNIQUE_TEST(ContactManifoldOBBOBBEdge)
+{
+	OBB a = AABB(POINT_VEC(-1.f, -1.f, -1.f), POINT_VEC(1.f, 1.f, 1.f)).Transform(Quat::RotateX(pi / 4.f));
+	OBB b = AABB(POINT_VEC(-1.f, -1.f, -1.f), POINT_VEC(1.f, 1.f, 1.f)).Transform(Quat::RotateZ(pi / 4.f));
+	b.Translate(DIR_VEC(0.f, 2.f * Sqrt(2.f) - 0.01f, 0.f));
+	ContactManifold m;
+	bool intersects = ComputeContactManifold(a, b, m);
+	assert(intersects);
+	assert1(m.normal.Equals(DIR_VEC(0.f, 1.f, 0.f), 1e-3f), m.normal);
+	assert1(m.numPoints == 1, m.numPoints);
+	assert1(EqualAbs(m.depths[0], 0.01f, 1e-4f), m.depths[0]);
+	assert1(m.points[0].Equals(POINT_VEC(0.f, Sqrt(2.f) - 0.01f, 0.f), 1e-4f), m.points[0]);
+	CheckContactManifold(a, b, m);
+	MARK_UNUSED(intersects);
+}
+
+UNIQUE_TEST(ContactManifoldOBBTriangleFace)
+{
+	OBB a(AABB(POINT_VEC(-1.f, -1.f, -0.1f), POINT_VEC(1.f, 1.f, 1.9f)));
+	Triangle b(POINT_VEC(-10.f, -10.f, 0.f), POINT_VEC(10.f, -10.f, 0.f), POINT_VEC(0.f, 10.f, 0.f));
+	ContactManifold m;
+	bool intersects = ComputeContactManifold(a, b, m);
+	assert(intersects);
+	assert1(m.normal.Equals(DIR_VEC(0.f, 0.f, -1.f)), m.normal);
+	assert1(m.numPoints == 4, m.numPoints);
+	for(int i = 0; i < m.numPoints; ++i)
+	{
+		assert2(EqualAbs(m.depths[i], 0.1f, 1e-4f), i, m.depths[i]);
+		assert2(EqualAbs(m.points[i].z, 0.f, 1e-4f), i, m.points[i]);
+	}
+	CheckContactManifold(a, b, m);
+	MARK_UNUSED(intersects);
+}
+
+UNIQUE_TEST(ContactManifoldCapsuleOBBLying)
+{
+	Capsule a(POINT_VEC(-0.5f, 0.f, 1.2f), POINT_VEC(0.5f, 0.f, 1.2f), 0.3f);
+	OBB b(AABB(POINT_VEC(-1.f, -1.f, -1.f), POINT_VEC(1.f, 1.f, 1.f)));
+	ContactManifold m;
+	bool intersects = ComputeContactManifold(a, b, m);
+	assert(intersects);
+	assert1(m.normal.Equals(DIR_VEC(0.f, 0.f, -1.f)), m.normal);
+	assert1(m.numPoints == 2, m.numPoints);
+	for(int i = 0; i < m.numPoints; ++i)
+	{
+		assert2(EqualAbs(m.depths[i], 0.1f, 1e-4f), i, m.depths[i]);
+		assert2(m.points[i].Equals(POINT_VEC(i == 0 ? -0.5f : 0.5f, 0.f, 1.f), 1e-4f), i, m.points[i]);
+	}
+	CheckContactManifold(a, b, m);
+
+	a.Translate(DIR_VEC(0.f, 0.f, 0.2f));
+	intersects = ComputeContactManifold(a, b, m);
+	assert(!intersects);
+	MARK_UNUSED(intersects);
+}
+
+// The line segment of the capsule penetrates the top face of the OBB.
+UNIQUE_TEST(ContactManifoldCapsuleOBBDeep)
+{
+	Capsule a(POINT_VEC(0.f, 0.f, 0.5f), POINT_VEC(0.f, 0.f, 3.f), 0.2f);
+	OBB b(AABB(POINT_VEC(-1.f, -1.f, -1.f), POINT_VEC(1.f, 1.f, 1.f)));
+	ContactManifold m;
+	bool intersects = ComputeContactManifold(a, b, m);
+	assert(intersects);
+	assert1(m.normal.Equals(DIR_VEC(0.f, 0.f, -1.f)), m.normal);
+	assert1(m.numPoints == 1, m.numPoints);
+	assert1(EqualAbs(m.depths[0], 0.7f, 1e-4f), m.depths[0]);
+	assert1(m.points[0].Equals(POINT_VEC(0.f, 0.f, 1.f), 1e-4f), m.points[0]);
+	CheckContactManifold(a, b, m);
+	MARK_UNUSED(intersects);
+}
+
+RANDOMIZED_TEST(ContactManifoldOBBOBB)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	OBB a = RandomOBBContainingPoint(pt, 10.f);
+	OBB b = RandomOBBContainingPoint(pt, 10.f);
+	ContactManifold m;
+	bool intersects = ComputeContactManifold(a, b, m);
+	assert(intersects);
+	CheckContactManifold(a, b, m);
+
+	Plane p(pt, vec::RandomDir(rng));
+	a = RandomOBBInHalfspace(p, 10.f);
+	p.ReverseNormal();
+	b = RandomOBBInHalfspace(p, 10.f);
+	intersects = ComputeContactManifold(a, b, m);
+	assert(!intersects);
+	MARK_UNUSED(intersects);
+}
+
+RANDOMIZED_TEST(ContactManifoldOBBTriangle)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	OBB a = RandomOBBContainingPoint(pt, 10.f);
+	Triangle b = RandomTriangleContainingPoint(pt);
+	ContactManifold m;
+	bool intersects = ComputeContactManifold(a, b, m);
+	assert(intersects);
+	CheckContactManifold(a, b, m);
+
+	Plane p(pt, vec::RandomDir(rng));
+	a = RandomOBBInHalfspace(p, 10.f);
+	p.ReverseNormal();
+	b = RandomTriangleInHalfspace(p);
+	intersects = ComputeContactManifold(a, b, m);
+	assert(!intersects);
+	MARK_UNUSED(intersects);
+}
+
+RANDOMIZED_TEST(ContactManifoldCapsuleOBB)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Capsule a = RandomCapsuleContainingPoint(pt);
+	OBB b = RandomOBBContainingPoint(pt, 10.f);
+	ContactManifold m;
+	bool intersects = ComputeContactManifold(a, b, m);
+	assert(intersects);
+	CheckContactManifold(a, b, m);
+
+	Plane p(pt, vec::RandomDir(rng));
+	a = RandomCapsuleInHalfspace(p);
+	p.ReverseNormal();
+	b = RandomOBBInHalfspace(p, 10.f);
+	intersects = ComputeContactManifold(a, b, m);
+	assert(!intersects);
+	MARK_UNUSED(intersects);
+}
+
+static const int numContactBenchmarkPairs = 128;
+
+// The benchmark objects are generated from a fixed seed with a local LCG, so that all runs time the same objects. The
+// second OBB of each pair is moved so that it rests on the first one with a small penetration, which is the common case
+// for a rigid body solver.
+struct ContactBenchmarkData
+{
+	OBB obb[numContactBenchmarkPairs];
+	OBB obb2[numContactBenchmarkPairs];
+	Capsule capsule[numContactBenchmarkPairs];
+
+	ContactBenchmarkData()
+	{
+		LCG lcg(4567);
+		for(int i = 0; i < numContactBenchmarkPairs; ++i)
+		{
+			vec n = vec::RandomDir(lcg);
+			AABB aabb(POINT_VEC_SCALAR(-lcg.Float(0.5f, 5.f)), POINT_VEC_SCALAR(lcg.Float(0.5f, 5.f)));
+			obb[i] = aabb.Transform(Quat::RandomRotation(lcg));
+			obb2[i] = aabb.Transform(Quat::RandomRotation(lcg));
+			obb2[i].pos += obb[i].ExtremePoint(n) - obb2[i].ExtremePoint(-n) - n * 0.05f;
+			vec a = obb[i].ExtremePoint(n) + n * 0.45f;
+			capsule[i] = Capsule(a, a + vec::RandomDir(lcg).Cross(n) * lcg.Float(1.f, 5.f), 0.5f);
+		}
+	}
+};
+
+BENCHMARK(ComputeContactManifold_OBBOBB, "ComputeContactManifold(OBB, OBB)")
+{
+	static const ContactBenchmarkData contactData;
+	int j = i % numContactBenchmarkPairs;
+	ContactManifold m;
+	if (ComputeContactManifold(contactData.obb[j], contactData.obb2[j], m))
+		TestData::dummyResultInt += m.numPoints;
+}
+BENCHMARK_END
+
+BENCHMARK(GJKPenetration_OBBOBB_Resting, "GJKPenetration(OBB, OBB) on resting pairs, for comparison")
+{
+	static const ContactBenchmarkData contactData;
+	int j = i % numContactBenchmarkPairs;
+	vec normal, pa, pb;
+	float depth;
+	if (GJKPenetration(contactData.obb[j], contactData.obb2[j], normal, depth, pa, pb))
+		++TestData::dummyResultInt;
+}
+BENCHMARK_END
+
+BENCHMARK(ComputeContactManifold_CapsuleOBB, "ComputeContactManifold(Capsule, OBB)")
+{
+	static const ContactBenchmarkData contactData;
+	int j = i % numContactBenchmarkPairs;
+	ContactManifold m;
+	if (ComputeContactManifold(contactData.capsule[j], contactData.obb[j], m))
+		TestData::dummyResultInt += m.numPoints;
+}
+BENCHMARK_END
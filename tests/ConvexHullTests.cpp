@@ -0,0 +1,272 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/MathGeoLib.h"
+#include "../src/Math/myassert.h"
+#include "TestRunner.h"
+#include "TestData.h"
+#include "../src/Geometry/HalfEdgeMesh.h"
+#include "ObjectGenerators.h"
+
+MATH_IGNORE_UNUSED_VARS_WARNING
+
+static void AssertIsHullOf(const Polyhedron &hull, const VecArray &points)
+{
+	assert(hull.IsClosed());
+	assert(hull.FaceIndicesValid());
+	assert(hull.EulerFormulaHolds());
+	assert(hull.FacesAreNondegeneratePlanar());
+	assert(HalfEdgeMesh(hull).IsConvex(hull));
+	// Same as Polyhedron::ContainsConvex(), without its O(V*F) convexity check in debug builds.
+	std::vector<Plane> planes;
+	for(int i = 0; i < hull.NumFaces(); ++i)
+		planes.push_back(hull.FacePlane(i));
+	for(size_t i = 0; i < points.size(); ++i)
+		for(size_t j = 0; j < planes.size(); ++j)
+			assert2(planes[j].SignedDistance(points[i]) <= 1e-3f, (int)i, planes[j].SignedDistance(points[i]));
+}
+
+RANDOMIZED_TEST(Polyhedron_ConvexHull_SphereSurface)
+{
+	vec center = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	VecArray points;
+	for(int i = 0; i < 500; ++i)
+		points.push_back(Sphere::RandomPointOnSurface(rng, center, SCALE));
+	Polyhedron hull = Polyhedron::ConvexHull(points);
+	AssertIsHullOf(hull, points);
+	// Points on the surface of a sphere are all in convex position.
+	assert1(hull.NumVertices() > 450, hull.NumVertices());
+}
+
+RANDOMIZED_TEST(Polyhedron_ConvexHull_BoxVolume)
+{
+	vec minPoint = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	AABB box(minPoint, minPoint + vec::RandomBox(rng, DIR_VEC_SCALAR(1.f), DIR_VEC_SCALAR(SCALE)));
+	VecArray points;
+	for(int i = 0; i < 200; ++i)
+		points.push_back(box.RandomPointInside(rng));
+	for(int i = 0; i < 8; ++i)
+		points.push_back(box.CornerPoint(i));
+	Polyhedron hull = Polyhedron::ConvexHull(points);
+	AssertIsHullOf(hull, points);
+	assert1(hull.NumVertices() == 8, hull.NumVertices());
+	assert1(hull.NumFaces() == 6, hull.NumFaces());
+	assert2(EqualRel(hull.Volume(), box.Volume(), 1e-3f), hull.Volume(), box.Volume());
+}
+
+// Points on the faces and edges of a box, and duplicated corners, lie on the hull planes, so they must not produce
+// vertices or sliver faces.
+UNIQUE_TEST(Polyhedron_ConvexHull_BoxSurface)
+{
+	LCG lcg(42);
+	AABB box(POINT_VEC(-2.f, -1.f, -3.f), POINT_VEC(2.f, 1.f, 3.f));
+	VecArray points;
+	for(int i = 0; i < 8; ++i)
+	{
+		points.push_back(box.CornerPoint(i));
+		points.push_back(box.CornerPoint(i));
+	}
+	for(int i = 0; i < 300; ++i)
+		points.push_back(box.RandomPointOnSurface(lcg));
+	for(int i = 0; i < 12; ++i)
+		points.push_back(box.Edge(i).GetPoint(0.5f));
+	Polyhedron hull = Polyhedron::ConvexHull(points);
+	AssertIsHullOf(hull, points);
+	assert1(hull.NumVertices() == 8, hull.NumVertices());
+	assert1(hull.NumFaces() == 6, hull.NumFaces());
+	assert1(EqualAbs(hull.Volume(), box.Volume(), 1e-3f), hull.Volume());
+}
+
+RANDOMIZED_TEST(Polyhedron_ConvexHull_Planar)
+{
+	vec center = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Quat rot = Quat::RandomRotation(rng);
+	const vec u = rot * DIR_VEC(1.f, 0.f, 0.f);
+	const vec w = rot * DIR_VEC(0.f, 1.f, 0.f);
+	VecArray points;
+	for(int i = 0; i < 4; ++i)
+		points.push_back(center + u * ((i & 1) ? SCALE : -SCALE) + w * ((i & 2) ? SCALE : -SCALE));
+	for(int i = 0; i < 200; ++i)
+		points.push_back(center + u * rng.Float(-0.9f, 0.9f) * SCALE + w * rng.Float(-0.9f, 0.9f) * SCALE);
+	Polyhedron hull = Polyhedron::ConvexHull(points);
+
+	// A planar point set produces a polygon with a face on both sides.
+	assert1(hull.NumFaces() == 2, hull.NumFaces());
+	assert1(hull.NumVertices() == 4, hull.NumVertices());
+	assert(hull.IsClosed());
+	assert(hull.f[0].v.size() == 4);
+	assert(hull.FaceNormal(0).Equals(-hull.FaceNormal(1), 1e-3f));
+	for(size_t i = 0; i < points.size(); ++i)
+		assert1(hull.FacePolygon(0).Distance(points[i]) < 1e-2f, hull.FacePolygon(0).Distance(points[i]));
+}
+
+UNIQUE_TEST(Polyhedron_ConvexHull_Collinear)
+{
+	VecArray points;
+	for(int i = 0; i < 10; ++i)
+		points.push_back(POINT_VEC(1.f + i, 2.f + 2.f*i, 3.f - i));
+	Polyhedron hull = Polyhedron::ConvexHull(points);
+	assert(hull.IsNull());
+
+	points.clear();
+	points.push_back(POINT_VEC(1.f, 2.f, 3.f));
+	points.push_back(POINT_VEC(1.f, 2.f, 3.f));
+	hull = Polyhedron::ConvexHull(points);
+	assert(hull.IsNull());
+}
+
+RANDOMIZED_TEST(Polyhedron_ConvexHull_Parallel_MixedCloud)
+{
+	vec center = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	VecArray points;
+	for(int i = 0; i < 2000; ++i)
+		points.push_back(vec::RandomBox(rng, center - DIR_VEC_SCALAR(SCALE), center + DIR_VEC_SCALAR(SCALE)));
+	for(int i = 0; i < 500; ++i)
+		points.push_back(Sphere::RandomPointOnSurface(rng, center, 1.5f * SCALE));
+
+	ThreadPool pool(rng.Int(1, 4));
+	Polyhedron hull = Polyhedron::ConvexHull(&points[0], (int)points.size(), pool, rng.Int(1, 700));
+	AssertIsHullOf(hull, points);
+	Polyhedron serialHull = Polyhedron::ConvexHull(points);
+	assert2(EqualRel(hull.Volume(), serialHull.Volume(), 1e-4f), hull.Volume(), serialHull.Volume());
+}
+
+UNIQUE_TEST(Polyhedron_ConvexHull_Parallel_Degenerate)
+{
+	ThreadPool pool(2);
+	VecArray points;
+	for(int i = 0; i < 100; ++i)
+		points.push_back(POINT_VEC(1.f + i, 2.f + 2.f*i, 3.f - i));
+	assert(Polyhedron::ConvexHull(&points[0], (int)points.size(), pool, 16).IsNull());
+
+	points.clear();
+	for(int i = 0; i < 100; ++i)
+		points.push_back(POINT_VEC((float)(i % 10), (float)(i / 10), 5.f));
+	Polyhedron hull = Polyhedron::ConvexHull(&points[0], (int)points.size(), pool, 16);
+	assert1(hull.NumFaces() == 2, hull.NumFaces());
+	assert1(hull.NumVertices() == 4, hull.NumVertices());
+
+	points.push_back(POINT_VEC(0.f, FLOAT_NAN, 0.f));
+	assert(Polyhedron::ConvexHull(&points[0], (int)points.size(), pool, 16).IsNull());
+}
+
+const int numConvexHullBenchmarkPoints = 100000;
+
+struct ConvexHullBenchmarkData
+{
+	VecArray sphereSurface;
+	VecArray cubeVolume;
+	VecArray planar;
+
+	ConvexHullBenchmarkData()
+	{
+		LCG lcg(123);
+		for(int i = 0; i < numConvexHullBenchmarkPoints; ++i)
+		{
+			sphereSurface.push_back(Sphere::RandomPointOnSurface(lcg, POINT_VEC_SCALAR(0.f), SCALE));
+			cubeVolume.push_back(vec::RandomBox(lcg, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE)));
+			float x = lcg.Float(-SCALE, SCALE);
+			float y = lcg.Float(-SCALE, SCALE);
+			planar.push_back(POINT_VEC(x, y, 0.5f * x - 0.25f * y));
+		}
+	}
+};
+
+BENCHMARK(Polyhedron_ConvexHull_SphereSurface1K, "Polyhedron::ConvexHull of 1000 points on a sphere")
+{
+	static const ConvexHullBenchmarkData convexHullData;
+	TestData::dummyResultInt += Polyhedron::ConvexHull(&convexHullData.sphereSurface[0], 1000).NumFaces();
+}
+BENCHMARK_END
+
+BENCHMARK_ITERS(Polyhedron_ConvexHull_SphereSurface100K, 3, 1, "Polyhedron::ConvexHull of 100000 points on a sphere")
+{
+	static const ConvexHullBenchmarkData convexHullData;
+	TestData::dummyResultInt += Polyhedron::ConvexHull(convexHullData.sphereSurface).NumFaces();
+}
+BENCHMARK_ITERS_END
+
+BENCHMARK(Polyhedron_ConvexHull_CubeVolume1K, "Polyhedron::ConvexHull of 1000 points inside a cube")
+{
+	static const ConvexHullBenchmarkData convexHullData;
+	TestData::dummyResultInt += Polyhedron::ConvexHull(&convexHullData.cubeVolume[0], 1000).NumFaces();
+}
+BENCHMARK_END
+
+BENCHMARK_ITERS(Polyhedron_ConvexHull_CubeVolume100K, 3, 1, "Polyhedron::ConvexHull of 100000 points inside a cube")
+{
+	static const ConvexHullBenchmarkData convexHullData;
+	TestData::dummyResultInt += Polyhedron::ConvexHull(convexHullData.cubeVolume).NumFaces();
+}
+BENCHMARK_ITERS_END
+
+BENCHMARK(Polyhedron_ConvexHull_Planar1K, "Polyhedron::ConvexHull of 1000 points on a plane")
+{
+	static const ConvexHullBenchmarkData convexHullData;
+	TestData::dummyResultInt += Polyhedron::ConvexHull(&convexHullData.planar[0], 1000).NumFaces();
+}
+BENCHMARK_END
+
+BENCHMARK_ITERS(Polyhedron_ConvexHull_Planar100K, 3, 1, "Polyhedron::ConvexHull of 100000 points on a plane")
+{
+	static const ConvexHullBenchmarkData convexHullData;
+	TestData::dummyResultInt += Polyhedron::ConvexHull(convexHullData.planar).NumFaces();
+}
+BENCHMARK_ITERS_END
+
+const int numParallelConvexHullBenchmarkPoints = 1000000;
+
+static const VecArray &ParallelConvexHullBenchmarkPoints()
+{
+	static VecArray points;
+	if (points.empty())
+	{
+		LCG lcg(123);
+		for(int i = 0; i < numParallelConvexHullBenchmarkPoints; ++i)
+			points.push_back(vec::RandomBox(lcg, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE)));
+	}
+	return points;
+}
+
+static void BenchmarkParallelConvexHull(int numThreads)
+{
+	const VecArray &points = ParallelConvexHullBenchmarkPoints();
+	TestData::dummyResultInt += Polyhedron::ConvexHull(&points[0], (int)points.size(), TestData::BenchmarkThreadPool(numThreads)).NumFaces();
+}
+
+BENCHMARK_ITERS(Polyhedron_ConvexHull_CubeVolume1M, 3, 1, "Polyhedron::ConvexHull of 1M points inside a cube")
+{
+	TestData::dummyResultInt += Polyhedron::ConvexHull(ParallelConvexHullBenchmarkPoints()).NumFaces();
+}
+BENCHMARK_ITERS_END
+
+BENCHMARK_ITERS(Polyhedron_ConvexHull_Parallel_CubeVolume1M_1Thread, 3, 1, "Parallel Polyhedron::ConvexHull of 1M points inside a cube on 1 thread")
+{
+	BenchmarkParallelConvexHull(1);
+}
+BENCHMARK_ITERS_END
+
+BENCHMARK_ITERS(Polyhedron_ConvexHull_Parallel_CubeVolume1M_2Threads, 3, 1, "Parallel Polyhedron::ConvexHull of 1M points inside a cube on 2 threads")
+{
+	BenchmarkParallelConvexHull(2);
+}
+BENCHMARK_ITERS_END
+
+BENCHMARK_ITERS(Polyhedron_ConvexHull_Parallel_CubeVolume1M_4Threads, 3, 1, "Parallel Polyhedron::ConvexHull of 1M points inside a cube on 4 threads")
+{
+	BenchmarkParallelConvexHull(4);
+}
+BENCHMARK_ITERS_END
+
+BENCHMARK_ITERS(Polyhedron_ConvexHull_Parallel_CubeVolume1M_8Threads, 3, 1, "Parallel Polyhedron::ConvexHull of 1M points inside a cube on 8 threads")
+{
+	BenchmarkParallelConvexHull(8);
+}
+BENCHMARK_ITERS_END
+
+BENCHMARK_ITERS(Polyhedron_ConvexHull_Parallel_SphereSurface100K_4Threads, 3, 1, "Parallel Polyhedron::ConvexHull of 100000 points on a sphere on 4 threads")
+{
+	static const ConvexHullBenchmarkData convexHullData;
+	TestData::dummyResultInt += Polyhedron::ConvexHull(&convexHullData.sphereSurface[0], numConvexHullBenchmarkPoints, TestData::BenchmarkThreadPool(4)).NumFaces();
+}
+BENCHMARK_ITERS_END
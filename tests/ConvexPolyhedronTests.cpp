@@ -0,0 +1,379 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/MathGeoLib.h"
+#include "../src/Math/myassert.h"
+#include "TestRunner.h"
+#include "TestData.h"
+#include "../src/Geometry/ConvexPolyhedron.h"
+#include "../src/Algorithm/GJK.h"
+#include "ObjectGenerators.h"
+
+MATH_IGNORE_UNUSED_VARS_WARNING
+
+Polyhedron EllipsoidPolyhedron(const vec &center, const vec &radii, int numRings, int numSegments)
+{
+	Polyhedron p;
+	p.v.push_back(center + DIR_VEC(0.f, radii.y, 0.f));
+	for(int r = 0; r < numRings; ++r)
+	{
+		float phi = pi * (r + 1) / (numRings + 1);
+		for(int s = 0; s < numSegments; ++s)
+		{
+			float theta = 2.f * pi * s / numSegments;
+			p.v.push_back(center + DIR_VEC(radii.x * Sin(phi) * Cos(theta), radii.y * Cos(phi), radii.z * Sin(phi) * Sin(theta)));
+		}
+	}
+	p.v.push_back(center - DIR_VEC(0.f, radii.y, 0.f));
+
+	const int bottom = p.NumVertices() - 1;
+	for(int s = 0; s < numSegments; ++s)
+	{
+		int s1 = (s + 1) % numSegments;
+		Polyhedron::Face top;
+		top.v.push_back(0);
+		top.v.push_back(1 + s1);
+		top.v.push_back(1 + s);
+		p.f.push_back(top);
+		for(int r = 0; r + 1 < numRings; ++r)
+		{
+			Polyhedron::Face quad;
+			quad.v.push_back(1 + r * numSegments + s);
+			quad.v.push_back(1 + r * numSegments + s1);
+			quad.v.push_back(1 + (r + 1) * numSegments + s1);
+			quad.v.push_back(1 + (r + 1) * numSegments + s);
+			p.f.push_back(quad);
+		}
+		Polyhedron::Face bottomFace;
+		bottomFace.v.push_back(1 + (numRings - 1) * numSegments + s);
+		bottomFace.v.push_back(1 + (numRings - 1) * numSegments + s1);
+		bottomFace.v.push_back(bottom);
+		p.f.push_back(bottomFace);
+	}
+	return p;
+}
+
+Polyhedron RandomEllipsoidPolyhedron(LCG &lcg, const vec &center)
+{
+	vec radii = DIR_VEC(lcg.Float(1.f, 10.f), lcg.Float(1.f, 10.f), lcg.Float(1.f, 10.f));
+	Polyhedron p = EllipsoidPolyhedron(POINT_VEC_SCALAR(0.f), radii, 21, 24);
+	p.Transform(Quat::RandomRotation(lcg));
+	p.Translate(center - POINT_VEC_SCALAR(0.f));
+	return p;
+}
+
+UNIQUE_TEST(ConvexPolyhedron_EllipsoidPolyhedronIsConvex)
+{
+	Polyhedron p = EllipsoidPolyhedron(POINT_VEC_SCALAR(0.f), DIR_VEC(3.f, 2.f, 1.f), 21, 24);
+	assert(p.NumVertices() == 506);
+	assert(p.IsClosed());
+	assert(p.IsConvex());
+	assert(p.Contains(POINT_VEC_SCALAR(0.f)));
+}
+
+RANDOMIZED_TEST(ConvexPolyhedron_ExtremePoint)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Polyhedron p = rng.Int(0, 1) ? RandomPolyhedronContainingPoint(pt) : RandomEllipsoidPolyhedron(rng, pt);
+	ConvexPolyhedron c(p);
+	assert(c.NumVertices() == p.NumVertices());
+
+	// Consecutive directions are sometimes close to each other, as in GJK, and sometimes unrelated.
+	vec dir = vec::RandomDir(rng);
+	for(int i = 0; i < 20; ++i)
+	{
+		dir = rng.Int(0, 1) ? (dir + vec::RandomDir(rng, 0.1f)).Normalized() : vec::RandomDir(rng);
+		float d, expected;
+		vec e = c.ExtremePoint(dir, d);
+		p.ExtremePoint(dir, expected);
+		assert3(EqualAbs(d, expected, 1e-3f), d, expected, dir);
+		assert2(EqualAbs(Dot(e, dir), d, 1e-3f), Dot(e, dir), d);
+
+		float minD, maxD;
+		c.ProjectToAxis(dir, minD, maxD);
+		float expectedMin, expectedMax;
+		p.ProjectToAxis(dir, expectedMin, expectedMax);
+		assert2(EqualAbs(minD, expectedMin, 1e-3f), minD, expectedMin);
+		assert2(EqualAbs(maxD, expectedMax, 1e-3f), maxD, expectedMax);
+	}
+}
+
+RANDOMIZED_TEST(ConvexPolyhedron_Transform)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Polyhedron p = RandomEllipsoidPolyhedron(rng, pt);
+	ConvexPolyhedron c(p);
+	float3x4 tm = float3x4::FromTRS(float3::RandomBox(rng, -SCALE, SCALE), Quat::RandomRotation(rng), float3(2.f, 0.5f, 1.f));
+	p.Transform(tm);
+	c.Transform(tm);
+	for(int i = 0; i < 10; ++i)
+	{
+		vec dir = vec::RandomDir(rng);
+		float d, expected;
+		c.ExtremePoint(dir, d);
+		p.ExtremePoint(dir, expected);
+		assert2(EqualAbs(d, expected, 1e-3f), d, expected);
+	}
+}
+
+// The points are spread evenly on a randomly oriented spiral over the sphere, and jittered radially. Independent random
+// points would every now and then land so close to each other that the debug checks of Polyhedron::ConvexHull() consider
+// the resulting faces degenerate.
+Polyhedron RandomSpherePointHull(LCG &lcg, int numPoints)
+{
+	const float goldenAngle = pi * (3.f - Sqrt(5.f));
+	const float phase = lcg.Float(0.f, 2.f * pi);
+	Quat rot = Quat::RandomRotation(lcg);
+	VecArray points;
+	for(int i = 0; i < numPoints; ++i)
+	{
+		float y = 1.f - (2.f * i + 1.f) / numPoints;
+		float r = Sqrt(1.f - y * y);
+		float theta = phase + goldenAngle * i;
+		vec dir = DIR_VEC(r * Cos(theta), y, r * Sin(theta));
+		points.push_back(POINT_VEC_SCALAR(0.f) + rot * dir * lcg.Float(9.9f, 10.f));
+	}
+	return Polyhedron::ConvexHull(points);
+}
+
+RANDOMIZED_TEST(ConvexPolyhedron_ExtremeVertexHierarchical)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Polyhedron p;
+	switch(rng.Int(0, 2))
+	{
+	case 0: p = RandomPolyhedronContainingPoint(pt); break;
+	case 1: p = RandomEllipsoidPolyhedron(rng, pt); break;
+	default: p = RandomSpherePointHull(rng, rng.Int(20, 1000)); break;
+	}
+	ConvexPolyhedron c(p);
+	assert(c.NumHierarchyLevels() == 0);
+	c.BuildHierarchy();
+	if (p.NumVertices() > 2 * ConvexPolyhedron::maxVerticesForLinearSearch)
+		assert1(c.NumHierarchyLevels() > 0, p.NumVertices());
+
+	// The hierarchy stays valid under affine transforms, like the adjacency structure.
+	if (rng.Int(0, 1))
+	{
+		float3x4 tm = float3x4::FromTRS(float3::RandomBox(rng, -SCALE, SCALE), Quat::RandomRotation(rng), float3(2.f, 0.5f, 1.f));
+		p.Transform(tm);
+		c.Transform(tm);
+	}
+
+	for(int i = 0; i < 20; ++i)
+	{
+		vec dir = vec::RandomDir(rng);
+		float d, expected;
+		int e = c.ExtremeVertexHierarchical(dir, d);
+		p.ExtremePoint(dir, expected);
+		assert3(EqualAbs(d, expected, 1e-3f), d, expected, c.NumHierarchyLevels());
+		assert2(EqualAbs(Dot(c.Vertex(e), dir), d, 1e-3f), Dot(c.Vertex(e), dir), d);
+		assert(c.ExtremeVertexHierarchical(dir) == e);
+	}
+	assert(ConvexPolyhedron().ExtremeVertexHierarchical(DIR_VEC(1.f, 0.f, 0.f)) == -1);
+
+	// Set() drops the hierarchy, and the queries fall back to searching all vertices.
+	c.Set(p);
+	assert(c.NumHierarchyLevels() == 0);
+	vec dir = vec::RandomDir(rng);
+	float d, expected;
+	c.ExtremeVertexHierarchical(dir, d);
+	p.ExtremePoint(dir, expected);
+	assert2(EqualAbs(d, expected, 1e-3f), d, expected);
+}
+
+RANDOMIZED_TEST(ConvexPolyhedron_GJK)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Polyhedron p = RandomEllipsoidPolyhedron(rng, pt);
+	ConvexPolyhedron c(p);
+
+	OBB inside = RandomOBBContainingPoint(pt, 5.f);
+	assert(GJKIntersect(inside, c));
+	assert(GJKIntersect(c, inside));
+
+	// Place an OBB outside the ellipsoid across its supporting plane in a random direction.
+	vec n = vec::RandomDir(rng);
+	OBB outside = RandomOBBContainingPoint(POINT_VEC_SCALAR(0.f), 5.f);
+	outside.pos += p.ExtremePoint(n) + n * rng.Float(1e-1f, 10.f) - outside.ExtremePoint(-n);
+	assert(!GJKIntersect(outside, c));
+	assert(!GJKIntersect(c, outside));
+
+	float d = GJKDistance(outside, c);
+	float expected = GJKDistance(outside, p);
+	assert2(EqualAbs(d, expected, 1e-2f), d, expected);
+}
+
+static const int numConvexPolyhedronBenchmarkPairs = 32;
+
+// Each OBB straddles the supporting plane of the hull in a random direction, so about half of the pairs intersect.
+struct ConvexPolyhedronBenchmarkData
+{
+	Polyhedron hull;
+	ConvexPolyhedron convexHull;
+	OBB hullBox;
+	OBB obb[numConvexPolyhedronBenchmarkPairs];
+
+	ConvexPolyhedronBenchmarkData()
+	{
+		LCG lcg(3456);
+		hull = EllipsoidPolyhedron(POINT_VEC_SCALAR(0.f), DIR_VEC(10.f, 6.f, 8.f), 21, 24);
+		convexHull.Set(hull);
+		hullBox = OBB(hull.MinimalEnclosingAABB());
+		for(int i = 0; i < numConvexPolyhedronBenchmarkPairs; ++i)
+		{
+			vec n = vec::RandomDir(lcg);
+			AABB aabb(POINT_VEC_SCALAR(-lcg.Float(0.5f, 5.f)), POINT_VEC_SCALAR(lcg.Float(0.5f, 5.f)));
+			obb[i] = aabb.Transform(Quat::RandomRotation(lcg));
+			obb[i].pos += hull.ExtremePoint(n) + n * lcg.Float(-1.f, 1.f) - obb[i].CenterPoint();
+		}
+	}
+};
+
+BENCHMARK(GJKIntersect_OBB_Polyhedron506, "GJKIntersect(OBB, Polyhedron) with a 506-vertex hull")
+{
+	static const ConvexPolyhedronBenchmarkData convexPolyhedronData;
+	int j = i % numConvexPolyhedronBenchmarkPairs;
+	TestData::dummyResultInt += GJKIntersect(convexPolyhedronData.obb[j], convexPolyhedronData.hull) ? 1 : 0;
+}
+BENCHMARK_END
+
+BENCHMARK(GJKIntersect_OBB_ConvexPolyhedron506, "GJKIntersect(OBB, ConvexPolyhedron) with a 506-vertex hull")
+{
+	static const ConvexPolyhedronBenchmarkData convexPolyhedronData;
+	int j = i % numConvexPolyhedronBenchmarkPairs;
+	TestData::dummyResultInt += GJKIntersect(convexPolyhedronData.obb[j], convexPolyhedronData.convexHull) ? 1 : 0;
+}
+BENCHMARK_END
+
+BENCHMARK(GJKIntersect_OBB_OBBHull, "GJKIntersect(OBB, OBB) with the OBB of the 506-vertex hull")
+{
+	static const ConvexPolyhedronBenchmarkData convexPolyhedronData;
+	int j = i % numConvexPolyhedronBenchmarkPairs;
+	TestData::dummyResultInt += GJKIntersect(convexPolyhedronData.obb[j], convexPolyhedronData.hullBox) ? 1 : 0;
+}
+BENCHMARK_END
+
+static const int numExtremeVertexBenchmarkDirections = 256;
+
+// Directions that are unrelated to each other, so the hill climbing searches cannot benefit from a warm start.
+struct ExtremeVertexBenchmarkData
+{
+	Polyhedron hull;
+	ConvexPolyhedron convexHull;
+	vec dir[numExtremeVertexBenchmarkDirections];
+
+	ExtremeVertexBenchmarkData()
+	{
+		LCG lcg(5678);
+		hull = RandomSpherePointHull(lcg, 4000);
+		convexHull.Set(hull);
+		convexHull.BuildHierarchy();
+		for(int i = 0; i < numExtremeVertexBenchmarkDirections; ++i)
+			dir[i] = vec::RandomDir(lcg);
+	}
+};
+
+BENCHMARK(Polyhedron_ExtremeVertex_4000, "Polyhedron::ExtremeVertex() of the hull of 4000 points in random directions")
+{
+	static const ExtremeVertexBenchmarkData extremeVertexData;
+	TestData::dummyResultInt += extremeVertexData.hull.ExtremeVertex(extremeVertexData.dir[i % numExtremeVertexBenchmarkDirections]);
+}
+BENCHMARK_END
+
+BENCHMARK(ConvexPolyhedron_ExtremeVertex_4000, "ConvexPolyhedron::ExtremeVertex() of the hull of 4000 points in random directions")
+{
+	static const ExtremeVertexBenchmarkData extremeVertexData;
+	TestData::dummyResultInt += extremeVertexData.convexHull.ExtremeVertex(extremeVertexData.dir[i % numExtremeVertexBenchmarkDirections]);
+}
+BENCHMARK_END
+
+BENCHMARK(ConvexPolyhedron_ExtremeVertexHierarchical_4000, "ConvexPolyhedron::ExtremeVertexHierarchical() of the hull of 4000 points in random directions")
+{
+	static const ExtremeVertexBenchmarkData extremeVertexData;
+	TestData::dummyResultInt += extremeVertexData.convexHull.ExtremeVertexHierarchical(extremeVertexData.dir[i % numExtremeVertexBenchmarkDirections]);
+}
+BENCHMARK_END
+
+BENCHMARK_ITERS(ConvexPolyhedron_Set_4000, 3, 1, "ConvexPolyhedron::Set() with the hull of 4000 points")
+{
+	static const ExtremeVertexBenchmarkData extremeVertexData;
+	ConvexPolyhedron c(extremeVertexData.hull);
+	TestData::dummyResultInt += c.NumNeighbors(0);
+}
+BENCHMARK_ITERS_END
+
+BENCHMARK_ITERS(ConvexPolyhedron_BuildHierarchy_4000, 3, 1, "ConvexPolyhedron::Set() and BuildHierarchy() with the hull of 4000 points")
+{
+	static const ExtremeVertexBenchmarkData extremeVertexData;
+	ConvexPolyhedron c(extremeVertexData.hull);
+	c.BuildHierarchy();
+	TestData::dummyResultInt += c.NumHierarchyLevels();
+}
+BENCHMARK_ITERS_END
+
+RANDOMIZED_TEST(Polyhedron_IntersectsConvex_Polyhedron)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Polyhedron a = RandomEllipsoidPolyhedron(rng, pt);
+	Polyhedron b = RandomEllipsoidPolyhedron(rng, POINT_VEC_SCALAR(0.f));
+
+	// Move b across the supporting plane of a in a random direction, and compare against the edge-based test.
+	vec n = vec::RandomDir(rng);
+	b.Translate(a.ExtremePoint(n) + n * rng.Float(-2.f, 2.f) - b.ExtremePoint(-n));
+	bool intersects = a.Intersects(b);
+	assert2(a.IntersectsConvex(b) == intersects, a.IntersectsConvex(b), intersects);
+	assert2(b.IntersectsConvex(a) == intersects, b.IntersectsConvex(a), intersects);
+
+	assert(a.IntersectsConvex(a));
+	assert(!a.IntersectsConvex(Polyhedron()));
+}
+
+// Each small hull straddles the supporting plane of the large hull in a random direction.
+struct PolyhedronPairBenchmarkData
+{
+	Polyhedron hull;
+	Polyhedron small[numConvexPolyhedronBenchmarkPairs];
+
+	PolyhedronPairBenchmarkData()
+	{
+		LCG lcg(4567);
+		hull = EllipsoidPolyhedron(POINT_VEC_SCALAR(0.f), DIR_VEC(10.f, 6.f, 8.f), 21, 24);
+		for(int i = 0; i < numConvexPolyhedronBenchmarkPairs; ++i)
+		{
+			vec n = vec::RandomDir(lcg);
+			small[i] = EllipsoidPolyhedron(POINT_VEC_SCALAR(0.f), DIR_VEC(3.f, 4.f, 5.f), 10, 12);
+			small[i].Transform(Quat::RandomRotation(lcg));
+			small[i].Translate(hull.ExtremePoint(n) + n * lcg.Float(-1.f, 1.f) - small[i].ExtremePoint(-n));
+		}
+	}
+};
+
+BENCHMARK_ITERS(Polyhedron_Intersects_Polyhedron, 3, numConvexPolyhedronBenchmarkPairs, "Polyhedron::Intersects(Polyhedron) with hulls of 506 and 122 vertices")
+{
+	static const PolyhedronPairBenchmarkData polyhedronPairData;
+	TestData::dummyResultInt += polyhedronPairData.hull.Intersects(polyhedronPairData.small[i]) ? 1 : 0;
+}
+BENCHMARK_ITERS_END
+
+BENCHMARK(Polyhedron_IntersectsConvex_Polyhedron, "Polyhedron::IntersectsConvex(Polyhedron) with hulls of 506 and 122 vertices")
+{
+	static const PolyhedronPairBenchmarkData polyhedronPairData;
+	int j = i % numConvexPolyhedronBenchmarkPairs;
+	TestData::dummyResultInt += polyhedronPairData.hull.IntersectsConvex(polyhedronPairData.small[j]) ? 1 : 0;
+}
+BENCHMARK_END
+
+BENCHMARK(GJKIntersect_OBB_Polyhedron32, "GJKIntersect(OBB, Polyhedron) with the 506-vertex hull simplified to 32 vertices")
+{
+	static const ConvexPolyhedronBenchmarkData convexPolyhedronData;
+	static Polyhedron proxy;
+	if (proxy.IsNull())
+	{
+		proxy = convexPolyhedronData.hull;
+		proxy.Simplify(32, true);
+	}
+	int j = i % numConvexPolyhedronBenchmarkPairs;
+	TestData::dummyResultInt += GJKIntersect(convexPolyhedronData.obb[j], proxy) ? 1 : 0;
+}
+BENCHMARK_END
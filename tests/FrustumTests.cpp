@@ -6,6 +6,8 @@
 #include "TestRunner.h"
 #include "TestData.h"
 #include "../src/Geometry/PBVolume.h"
+#include "../src/Algorithm/GJK.h"
+#include "../src/Algorithm/SAT.h"
 #include "ObjectGenerators.h"
 
 MATH_IGNORE_UNUSED_VARS_WARNING
@@ -154,6 +156,29 @@ UNIQUE_TEST(Frustum_Corners)
 	}
 }
 
+UNIQUE_TEST(Frustum_Corners_PoseAndFovOnly)
+{
+	// The corners do not depend on the projective space or the handedness, so they are defined before SetKind() is called.
+	Frustum f;
+	f.SetKind(FrustumSpaceInvalid, FrustumHandednessInvalid);
+	f.SetFrame(POINT_VEC(1.f, 2.f, 3.f), DIR_VEC(0.f, 0.f, -1.f), DIR_VEC(0.f, 1.f, 0.f));
+	f.SetPerspective(pi/2.f, pi/2.f);
+	f.SetViewPlaneDistances(1.f, 100.f);
+	vec corners[8];
+	f.GetCornerPoints(corners);
+
+	Frustum g = f;
+	g.SetKind(FrustumSpaceGL, FrustumLeftHanded);
+	vec expected[8];
+	g.GetCornerPoints(expected);
+	for(int i = 0; i < 8; ++i)
+	{
+		assert1(corners[i].IsFinite(), corners[i]);
+		assert2(corners[i].Equals(expected[i], 1e-3f), corners[i], expected[i]);
+	}
+	assert(corners[0].Equals(POINT_VEC(2.f, 1.f, 2.f), 1e-3f));
+}
+
 // Tests that whatever can be unprojected projects back to the same location on the Frustum 2D plane.
 UNIQUE_TEST(Frustum_Project_Unproject_Symmetry)
 {
@@ -634,3 +659,117 @@ BENCHMARK(Frustum_ClosestPoint_Point, "Frustum::ClosestPoint(point)")
 #endif
 }
 BENCHMARK_END;
+
+// Sweeps a box through a frustum, and compares the specialized intersection tests to the generic separating axis test.
+RANDOMIZED_TEST(Frustum_Intersects_AABB_OBB)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Frustum f = RandomFrustumContainingPoint(rng, pt);
+	AABB a = RandomAABBContainingPoint(pt, 10.f);
+	OBB b = RandomOBBContainingPoint(pt, 10.f);
+	vec offset = vec::RandomDir(rng) * 2.f * SCALE;
+	a.Translate(offset);
+	b.Translate(offset);
+	const int numSteps = 20;
+	for(int i = 0; i < numSteps; ++i)
+	{
+		assert2(f.Intersects(a) == SATIntersect(f, a), i, GJKDistance(f, a));
+		assert2(f.Intersects(b) == SATIntersect(f, b), i, GJKDistance(f, b));
+		a.Translate(offset * (-2.f / numSteps));
+		b.Translate(offset * (-2.f / numSteps));
+	}
+}
+
+RANDOMIZED_TEST(Frustum_Intersects_Sphere)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Frustum f = RandomFrustumContainingPoint(rng, pt);
+	Sphere s(pt + vec::RandomDir(rng) * rng.Float(0.f, 2.f * SCALE), rng.Float(0.1f, 20.f));
+	float d = f.ToPolyhedron().Distance(s.pos); // This is known to be correct.
+	if (d > s.r + 1e-2f)
+		assert2(!f.Intersects(s), d, s.r);
+	else if (d < s.r - 1e-2f)
+		assert2(f.Intersects(s), d, s.r);
+	assert(f.Intersects(Sphere(f.CenterPoint(), 0.f)));
+}
+
+// The objects are generated from a fixed seed with a local LCG, so that all runs time the same objects. The objects are
+// placed around the frustum, so that about half of them intersect it.
+struct FrustumIntersectsBenchmarkData
+{
+	static const int numPairs = 128;
+	Frustum frustum[numPairs];
+	AABB aabb[numPairs];
+	OBB obb[numPairs];
+	Sphere sphere[numPairs];
+
+	FrustumIntersectsBenchmarkData()
+	{
+		LCG lcg(2345);
+		for(int i = 0; i < numPairs; ++i)
+		{
+			vec pt = vec::RandomBox(lcg, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+			frustum[i] = RandomFrustumContainingPoint(lcg, pt);
+			vec center = pt + vec::RandomDir(lcg) * lcg.Float(0.f, SCALE);
+			vec halfSize = vec::RandomBox(lcg, DIR_VEC_SCALAR(1.f), DIR_VEC_SCALAR(10.f));
+			aabb[i] = AABB(center - halfSize, center + halfSize);
+			obb[i] = aabb[i].Transform(Quat::RandomRotation(lcg));
+			obb[i].pos = center;
+			sphere[i] = Sphere(center, halfSize.x);
+		}
+	}
+};
+
+BENCHMARK(Frustum_Intersects_AABB, "Frustum::Intersects(AABB)")
+{
+	static const FrustumIntersectsBenchmarkData frustumIntersectsData;
+	int j = i % FrustumIntersectsBenchmarkData::numPairs;
+	if (frustumIntersectsData.frustum[j].Intersects(frustumIntersectsData.aabb[j]))
+		++dummyResultInt;
+}
+BENCHMARK_END
+
+BENCHMARK(Frustum_Intersects_AABB_GJK, "GJKIntersect(Frustum, AABB)")
+{
+	static const FrustumIntersectsBenchmarkData frustumIntersectsData;
+	int j = i % FrustumIntersectsBenchmarkData::numPairs;
+	if (GJKIntersect(frustumIntersectsData.frustum[j], frustumIntersectsData.aabb[j]))
+		++dummyResultInt;
+}
+BENCHMARK_END
+
+BENCHMARK(Frustum_Intersects_OBB, "Frustum::Intersects(OBB)")
+{
+	static const FrustumIntersectsBenchmarkData frustumIntersectsData;
+	int j = i % FrustumIntersectsBenchmarkData::numPairs;
+	if (frustumIntersectsData.frustum[j].Intersects(frustumIntersectsData.obb[j]))
+		++dummyResultInt;
+}
+BENCHMARK_END
+
+BENCHMARK(Frustum_Intersects_OBB_GJK, "GJKIntersect(Frustum, OBB)")
+{
+	static const FrustumIntersectsBenchmarkData frustumIntersectsData;
+	int j = i % FrustumIntersectsBenchmarkData::numPairs;
+	if (GJKIntersect(frustumIntersectsData.frustum[j], frustumIntersectsData.obb[j]))
+		++dummyResultInt;
+}
+BENCHMARK_END
+
+BENCHMARK(Frustum_Intersects_Sphere, "Frustum::Intersects(Sphere)")
+{
+	static const FrustumIntersectsBenchmarkData frustumIntersectsData;
+	int j = i % FrustumIntersectsBenchmarkData::numPairs;
+	if (frustumIntersectsData.frustum[j].Intersects(frustumIntersectsData.sphere[j]))
+		++dummyResultInt;
+}
+BENCHMARK_END
+
+BENCHMARK(Frustum_Intersects_Sphere_GJK, "GJKIntersect(Frustum, Sphere)")
+{
+	static const FrustumIntersectsBenchmarkData frustumIntersectsData;
+	int j = i % FrustumIntersectsBenchmarkData::numPairs;
+	if (GJKIntersect(frustumIntersectsData.frustum[j], frustumIntersectsData.sphere[j]))
+		++dummyResultInt;
+}
+BENCHMARK_END
@@ -4,7 +4,10 @@
 #include "../src/MathGeoLib.h"
 #include "../src/Math/myassert.h"
 #include "TestRunner.h"
+#include "TestData.h"
 #include "../src/Algorithm/GJK.h"
+#include "../src/Algorithm/GJKBatch.h"
+#include "../src/Algorithm/SAT.h"
 #include "ObjectGenerators.h"
 
 MATH_IGNORE_UNUSED_VARS_WARNING
@@ -569,3 +572,971 @@ RANDOMIZED_TEST(GJKTriangleTriangleNoIntersect)
 	Triangle b = RandomTriangleInHalfspace(p);
 	assert(!GJKIntersect(a, b));
 }
+
+// The objects of the randomized tests span a few hundred units, where the distances computed in single precision by GJK and by
+// the per-shape Distance() functions differ by up to a few hundredths.
+static const float gjkDistanceEps = 5e-4f * SCALE;
+
+// Verifies that d and the witness points pa and pb returned by GJKDistance() are consistent.
+template<typename A, typename B>
+void CheckGJKDistance(const A &a, const B &b, float d, const vec &pa, const vec &pb)
+{
+	const float eps = 1e-2f;
+	assert2(d >= 0.f && d < FLOAT_INF, d, a.SerializeToString());
+	assert3(EqualAbs(pa.Distance(pb), d, eps), pa, pb, d);
+	assert2(a.Distance(pa) < eps, a.Distance(pa), pa);
+	assert2(b.Distance(pb) < eps, b.Distance(pb), pb);
+	MARK_UNUSED(a); MARK_UNUSED(b); MARK_UNUSED(d); MARK_UNUSED(pa); MARK_UNUSED(pb); MARK_UNUSED(eps);
+}
+
+// Verifies that the plane through pa perpendicular to pb-pa separates the two objects, which proves that no pair of points
+// is closer than the witness points. This is only tested for flat objects: on curved objects, the error of the witness points
+// grows like the square root of the distance error times the radius of curvature.
+template<typename A, typename B>
+void CheckGJKSeparatingPlane(const A &a, const B &b)
+{
+	vec pa, pb;
+	float d = GJKDistance(a, b, pa, pb);
+	assert1(d > 0.f, d);
+	vec n = (pb - pa) / d;
+	assert3(Dot(a.ExtremePoint(n), n) <= Dot(pa, n) + gjkDistanceEps, Dot(a.ExtremePoint(n), n), Dot(pa, n), n);
+	assert3(Dot(b.ExtremePoint(-n), n) >= Dot(pb, n) - gjkDistanceEps, Dot(b.ExtremePoint(-n), n), Dot(pb, n), n);
+	MARK_UNUSED(a); MARK_UNUSED(b); MARK_UNUSED(d); MARK_UNUSED(n);
+}
+
+template<typename A, typename B>
+void CheckGJKDistance(const A &a, const B &b)
+{
+	vec pa, pb;
+	float d = GJKDistance(a, b, pa, pb);
+	CheckGJKDistance(a, b, d, pa, pb);
+	d = GJKDistance(b, a, pb, pa);
+	CheckGJKDistance(b, a, d, pb, pa);
+}
+
+UNIQUE_TEST(GJKDistanceSphereSphereCase)
+{
+	Sphere a(POINT_VEC(0.f, 0.f, 0.f), 1.f);
+	Sphere b(POINT_VEC(10.f, 0.f, 0.f), 2.f);
+	vec pa, pb;
+	float d = GJKDistance(a, b, pa, pb);
+	assert1(EqualAbs(d, 7.f, 1e-3f), d);
+	assert1(pa.Equals(POINT_VEC(1.f, 0.f, 0.f), 1e-3f), pa);
+	assert1(pb.Equals(POINT_VEC(8.f, 0.f, 0.f), 1e-3f), pb);
+	MARK_UNUSED(d);
+}
+
+UNIQUE_TEST(GJKDistanceAABBAABBCase)
+{
+	AABB a(POINT_VEC_SCALAR(-1.f), POINT_VEC_SCALAR(1.f));
+	AABB b(POINT_VEC(3.f, -5.f, -5.f), POINT_VEC(6.f, 5.f, 5.f));
+	vec pa, pb;
+	float d = GJKDistance(a, b, pa, pb);
+	assert1(EqualAbs(d, 2.f, 1e-4f), d);
+	assert1(EqualAbs(pa.x, 1.f, 1e-4f) && EqualAbs(pb.x, 3.f, 1e-4f), pa);
+	assert(GJKDistance(a, a) == 0.f);
+	MARK_UNUSED(d);
+}
+
+RANDOMIZED_TEST(GJKDistanceSphereSphere)
+{
+	Sphere a = RandomSphereContainingPoint(vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE)), SCALE);
+	Sphere b = RandomSphereContainingPoint(vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE)), SCALE);
+	float d = GJKDistance(a, b);
+	assert3(EqualAbs(d, a.Distance(b), gjkDistanceEps), d, a.Distance(b), a.SerializeToString());
+	CheckGJKDistance(a, b);
+	MARK_UNUSED(d);
+}
+
+RANDOMIZED_TEST(GJKDistanceCapsuleCapsule)
+{
+	Plane p(vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE)), vec::RandomDir(rng));
+	Capsule a = RandomCapsuleInHalfspace(p);
+	p.ReverseNormal();
+	Capsule b = RandomCapsuleInHalfspace(p);
+	float d = GJKDistance(a, b);
+	assert3(EqualAbs(d, a.Distance(b), gjkDistanceEps), d, a.Distance(b), a.SerializeToString());
+	assert1(d > 0.f, d);
+	CheckGJKDistance(a, b);
+	MARK_UNUSED(d);
+}
+
+RANDOMIZED_TEST(GJKDistanceLineSegmentLineSegment)
+{
+	Plane p(vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE)), vec::RandomDir(rng));
+	LineSegment a = RandomLineSegmentInHalfspace(p);
+	p.ReverseNormal();
+	LineSegment b = RandomLineSegmentInHalfspace(p);
+	float d = GJKDistance(a, b);
+	assert3(EqualAbs(d, a.Distance(b), gjkDistanceEps), d, a.Distance(b), a.SerializeToString());
+	CheckGJKDistance(a, b);
+	MARK_UNUSED(d);
+}
+
+RANDOMIZED_TEST(GJKDistanceOBBSphere)
+{
+	Plane p(vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE)), vec::RandomDir(rng));
+	OBB a = RandomOBBInHalfspace(p, 10.f);
+	p.ReverseNormal();
+	Sphere b = RandomSphereInHalfspace(p, SCALE);
+	float d = GJKDistance(a, b);
+	assert3(EqualAbs(d, a.Distance(b), gjkDistanceEps), d, a.Distance(b), a.SerializeToString());
+	CheckGJKDistance(a, b);
+	MARK_UNUSED(d);
+}
+
+RANDOMIZED_TEST(GJKDistanceTriangleCapsule)
+{
+	Plane p(vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE)), vec::RandomDir(rng));
+	Triangle a = RandomTriangleInHalfspace(p);
+	p.ReverseNormal();
+	Capsule b = RandomCapsuleInHalfspace(p);
+	float d = GJKDistance(a, b);
+	assert3(EqualAbs(d, a.Distance(b), gjkDistanceEps), d, a.Distance(b), a.SerializeToString());
+	CheckGJKDistance(a, b);
+	MARK_UNUSED(d);
+}
+
+RANDOMIZED_TEST(GJKDistanceOBBOBB)
+{
+	Plane p(vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE)), vec::RandomDir(rng));
+	OBB a = RandomOBBInHalfspace(p, 10.f);
+	p.ReverseNormal();
+	OBB b = RandomOBBInHalfspace(p, 10.f);
+	CheckGJKDistance(a, b);
+	CheckGJKSeparatingPlane(a, b);
+}
+
+RANDOMIZED_TEST(GJKDistanceAABBTriangle)
+{
+	Plane p(vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE)), vec::RandomDir(rng));
+	AABB a = RandomAABBInHalfspace(p, 10.f);
+	p.ReverseNormal();
+	Triangle b = RandomTriangleInHalfspace(p);
+	CheckGJKDistance(a, b);
+	CheckGJKSeparatingPlane(a, b);
+}
+
+RANDOMIZED_TEST(GJKDistanceOBBOBBIntersect)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	OBB a = RandomOBBContainingPoint(pt, 10.f);
+	OBB b = RandomOBBContainingPoint(pt, 10.f);
+	vec pa, pb;
+	float d = GJKDistance(a, b, pa, pb);
+	assert1(d < 1e-3f, d);
+	assert2(a.Distance(pa) < 1e-2f && b.Distance(pb) < 1e-2f, pa, pb);
+	MARK_UNUSED(d);
+}
+
+RANDOMIZED_TEST(GJKDistanceCapsuleTriangleIntersect)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Capsule a = RandomCapsuleContainingPoint(pt);
+	Triangle b = RandomTriangleContainingPoint(pt);
+	float d = GJKDistance(a, b);
+	assert1(d < 1e-3f, d);
+	MARK_UNUSED(d);
+}
+
+static const int numGJKDistanceBenchmarkPairs = 128;
+
+// The benchmark objects are generated from a fixed seed with a local LCG, so that all runs time the same objects. Each
+// pair straddles a random plane, so the objects of a pair are disjoint.
+struct GJKDistanceBenchmarkData
+{
+	Sphere sphere[numGJKDistanceBenchmarkPairs];
+	Capsule capsule[numGJKDistanceBenchmarkPairs];
+	Capsule capsule2[numGJKDistanceBenchmarkPairs];
+	OBB obb[numGJKDistanceBenchmarkPairs];
+	OBB obb2[numGJKDistanceBenchmarkPairs];
+	Triangle triangle[numGJKDistanceBenchmarkPairs];
+
+	GJKDistanceBenchmarkData()
+	{
+		LCG lcg(1234);
+		for(int i = 0; i < numGJKDistanceBenchmarkPairs; ++i)
+		{
+			vec pt = vec::RandomBox(lcg, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+			vec n = vec::RandomDir(lcg);
+			vec a = pt - n * lcg.Float(1.f, 10.f);
+			vec b = pt + n * lcg.Float(1.f, 10.f);
+			float r = lcg.Float(0.5f, 1.f);
+			sphere[i] = Sphere(b + n * r, r);
+			capsule[i] = Capsule(LineSegment(a - n * r, a - n * r + vec::RandomSphere(lcg, vec::zero, 5.f) - n * 5.f), r);
+			capsule2[i] = Capsule(LineSegment(b + n * r, b + n * r + vec::RandomSphere(lcg, vec::zero, 5.f) + n * 5.f), r);
+			triangle[i] = Triangle(a, a + vec::RandomSphere(lcg, vec::zero, 5.f) - n * 5.f, a + vec::RandomSphere(lcg, vec::zero, 5.f) - n * 5.f);
+			AABB aabb(POINT_VEC_SCALAR(-lcg.Float(0.5f, 5.f)), POINT_VEC_SCALAR(lcg.Float(0.5f, 5.f)));
+			obb[i] = aabb.Transform(Quat::RandomRotation(lcg));
+			obb[i].pos += a - obb[i].ExtremePoint(n);
+			obb2[i] = aabb.Transform(Quat::RandomRotation(lcg));
+			obb2[i].pos += b - obb2[i].ExtremePoint(-n);
+		}
+	}
+};
+
+BENCHMARK(GJKDistance_CapsuleCapsule, "GJKDistance(Capsule, Capsule)")
+{
+	static const GJKDistanceBenchmarkData gjkData;
+	int j = i % numGJKDistanceBenchmarkPairs;
+	TestData::dummyResultFloat += GJKDistance(gjkData.capsule[j], gjkData.capsule2[j]);
+}
+BENCHMARK_END
+
+BENCHMARK(Capsule_Distance_Capsule, "Capsule::Distance(Capsule)")
+{
+	static const GJKDistanceBenchmarkData gjkData;
+	int j = i % numGJKDistanceBenchmarkPairs;
+	TestData::dummyResultFloat += gjkData.capsule[j].Distance(gjkData.capsule2[j]);
+}
+BENCHMARK_END
+
+BENCHMARK(GJKDistance_OBBSphere, "GJKDistance(OBB, Sphere)")
+{
+	static const GJKDistanceBenchmarkData gjkData;
+	int j = i % numGJKDistanceBenchmarkPairs;
+	TestData::dummyResultFloat += GJKDistance(gjkData.obb[j], gjkData.sphere[j]);
+}
+BENCHMARK_END
+
+BENCHMARK(OBB_Distance_Sphere, "OBB::Distance(Sphere)")
+{
+	static const GJKDistanceBenchmarkData gjkData;
+	int j = i % numGJKDistanceBenchmarkPairs;
+	TestData::dummyResultFloat += gjkData.obb[j].Distance(gjkData.sphere[j]);
+}
+BENCHMARK_END
+
+BENCHMARK(GJKDistance_TriangleCapsule, "GJKDistance(Triangle, Capsule)")
+{
+	static const GJKDistanceBenchmarkData gjkData;
+	int j = i % numGJKDistanceBenchmarkPairs;
+	TestData::dummyResultFloat += GJKDistance(gjkData.triangle[j], gjkData.capsule2[j]);
+}
+BENCHMARK_END
+
+BENCHMARK(Triangle_Distance_Capsule, "Triangle::Distance(Capsule)")
+{
+	static const GJKDistanceBenchmarkData gjkData;
+	int j = i % numGJKDistanceBenchmarkPairs;
+	TestData::dummyResultFloat += gjkData.triangle[j].Distance(gjkData.capsule2[j]);
+}
+BENCHMARK_END
+
+BENCHMARK(GJKDistance_OBBOBB, "GJKDistance(OBB, OBB) with closest points")
+{
+	static const GJKDistanceBenchmarkData gjkData;
+	int j = i % numGJKDistanceBenchmarkPairs;
+	vec pa, pb;
+	TestData::dummyResultFloat += GJKDistance(gjkData.obb[j], gjkData.obb2[j], pa, pb);
+}
+BENCHMARK_END
+
+// Verifies that the minimum translation vector returned by GJKPenetration() separates the objects, and that a slightly shorter
+// translation does not.
+template<typename A, typename B>
+void CheckGJKPenetration(const A &a, const B &b)
+{
+	vec normal, pa, pb;
+	float depth;
+	bool intersects = GJKPenetration(a, b, normal, depth, pa, pb);
+	assert(intersects);
+	assert1(normal.IsNormalized(1e-3f), normal);
+	assert1(depth >= 0.f && depth < FLOAT_INF, depth);
+	assert3((pa - pb).Equals(depth * normal, gjkDistanceEps), pa, pb, depth * normal);
+	assert2(a.Distance(pa) < 1e-2f && b.Distance(pb) < 1e-2f, pa, pb);
+
+	const float eps = gjkDistanceEps + 1e-2f * depth;
+	B separated = b;
+	separated.Translate((depth + eps) * normal);
+	assert3(GJKDistance(a, separated) > 0.f, depth, normal, GJKDistance(a, separated));
+	if (depth > eps)
+	{
+		B overlapping = b;
+		overlapping.Translate((depth - eps) * normal);
+		assert2(GJKIntersect(a, overlapping), depth, normal);
+	}
+	MARK_UNUSED(intersects); MARK_UNUSED(eps);
+}
+
+UNIQUE_TEST(GJKPenetrationSphereSphereCase)
+{
+	Sphere a(POINT_VEC(0.f, 0.f, 0.f), 1.f);
+	Sphere b(POINT_VEC(0.f, 1.5f, 0.f), 1.f);
+	vec normal, pa, pb;
+	float depth;
+	bool intersects = GJKPenetration(a, b, normal, depth, pa, pb);
+	assert(intersects);
+	// EPA approximates curved objects with a polytope, so the results are only accurate to a fraction of the radii.
+	assert1(EqualAbs(depth, 0.5f, 1e-2f), depth);
+	assert1(normal.Equals(DIR_VEC(0.f, 1.f, 0.f), 1e-2f), normal);
+	assert1(pa.Equals(POINT_VEC(0.f, 1.f, 0.f), 1e-2f), pa);
+	assert1(pb.Equals(POINT_VEC(0.f, 0.5f, 0.f), 1e-2f), pb);
+
+	b.pos = POINT_VEC(0.f, 2.5f, 0.f);
+	intersects = GJKPenetration(a, b, normal, depth, pa, pb);
+	assert(!intersects);
+	MARK_UNUSED(intersects);
+}
+
+UNIQUE_TEST(GJKPenetrationAABBAABBCase)
+{
+	AABB a(POINT_VEC(-1.f, -1.f, -1.f), POINT_VEC(1.f, 1.f, 1.f));
+	AABB b(POINT_VEC(-3.f, -0.75f, -3.f), POINT_VEC(3.f, 5.f, 3.f));
+	vec normal, pa, pb;
+	float depth;
+	bool intersects = GJKPenetration(a, b, normal, depth, pa, pb);
+	assert(intersects);
+	assert1(EqualAbs(depth, 1.75f, 1e-4f), depth);
+	assert1(normal.Equals(DIR_VEC(0.f, 1.f, 0.f), 1e-4f), normal);
+	assert2(EqualAbs(pa.y, 1.f, 1e-4f) && EqualAbs(pb.y, -0.75f, 1e-4f), pa, pb);
+	MARK_UNUSED(intersects);
+}
+
+RANDOMIZED_TEST(GJKPenetrationSphereSphere)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Sphere a(pt, rng.Float(1.f, 10.f));
+	Sphere b(pt + vec::RandomDir(rng) * rng.Float(0.1f, a.r + 9.f), rng.Float(1.f, 10.f));
+	if (a.pos.Distance(b.pos) >= a.r + b.r)
+		b.r = a.pos.Distance(b.pos) - a.r + 1.f;
+	vec normal, pa, pb;
+	float depth;
+	bool intersects = GJKPenetration(a, b, normal, depth, pa, pb);
+	assert(intersects);
+
+	vec expectedNormal = (b.pos - a.pos).Normalized();
+	float expectedDepth = a.r + b.r - a.pos.Distance(b.pos);
+	// When the spheres penetrate deeply, the polytope has to approximate the whole Minkowski difference, and its size limits the accuracy.
+	const float eps = 3e-2f * (a.r + b.r);
+	assert2(EqualAbs(depth, expectedDepth, eps), depth, expectedDepth);
+	// When the centers nearly coincide, the depth barely depends on the direction, so check that the normal gives
+	// a translation of the expected length instead of comparing it directly, and only if the direction is unambiguous.
+	assert1(normal.IsNormalized(1e-3f), normal);
+	if (a.pos.Distance(b.pos) > 2.f * eps)
+		assert2(EqualAbs(a.r + b.r - Dot(normal, b.pos - a.pos), expectedDepth, eps), normal, expectedNormal);
+	// The error of the contact points grows with the square root of the depth error times the radius.
+	const float pointEps = Sqrt(eps * (a.r + b.r));
+	assert2(pa.Equals(a.pos + a.r * normal, pointEps), pa, a.pos + a.r * normal);
+	assert2(pb.Equals(b.pos - b.r * normal, pointEps), pb, b.pos - b.r * normal);
+	MARK_UNUSED(intersects); MARK_UNUSED(eps); MARK_UNUSED(pointEps);
+}
+
+RANDOMIZED_TEST(GJKPenetrationAABBAABB)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	AABB a = RandomAABBContainingPoint(pt, 10.f);
+	AABB b = RandomAABBContainingPoint(pt, 10.f);
+
+	// The minimum translation vector of two AABBs is along the coordinate axis and direction that needs the shortest push.
+	float expectedDepth = FLOAT_INF;
+	vec expectedNormal = vec::zero;
+	float secondDepth = FLOAT_INF;
+	for(int i = 0; i < 3; ++i)
+		for(int sign = -1; sign <= 1; sign += 2)
+		{
+			float push = sign > 0 ? a.maxPoint[i] - b.minPoint[i] : b.maxPoint[i] - a.minPoint[i];
+			vec dir = vec::zero;
+			dir[i] = (float)sign;
+			if (push < expectedDepth)
+			{
+				secondDepth = expectedDepth;
+				expectedDepth = push;
+				expectedNormal = dir;
+			}
+			else if (push < secondDepth)
+				secondDepth = push;
+		}
+
+	vec normal, pa, pb;
+	float depth;
+	bool intersects = GJKPenetration(a, b, normal, depth, pa, pb);
+	assert(intersects);
+	assert2(EqualAbs(depth, expectedDepth, 1e-3f), depth, expectedDepth);
+	if (secondDepth - expectedDepth > 1e-2f) // Otherwise the minimum translation direction is ambiguous.
+		assert2(normal.Equals(expectedNormal, 1e-3f), normal, expectedNormal);
+	CheckGJKPenetration(a, b);
+	MARK_UNUSED(intersects);
+}
+
+RANDOMIZED_TEST(GJKPenetrationOBBOBB)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	OBB a = RandomOBBContainingPoint(pt, 10.f);
+	OBB b = RandomOBBContainingPoint(pt, 10.f);
+	CheckGJKPenetration(a, b);
+}
+
+RANDOMIZED_TEST(GJKPenetrationCapsuleOBB)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Capsule a = RandomCapsuleContainingPoint(pt);
+	OBB b = RandomOBBContainingPoint(pt, 10.f);
+	CheckGJKPenetration(a, b);
+}
+
+RANDOMIZED_TEST(GJKPenetrationSphereTriangle)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Sphere a = RandomSphereContainingPoint(pt, 10.f);
+	Triangle b = RandomTriangleContainingPoint(pt);
+	CheckGJKPenetration(a, b);
+}
+
+RANDOMIZED_TEST(GJKPenetrationDisjoint)
+{
+	Plane p(vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE)), vec::RandomDir(rng));
+	OBB a = RandomOBBInHalfspace(p, 10.f);
+	p.ReverseNormal();
+	Sphere b = RandomSphereInHalfspace(p, 10.f);
+	vec normal, pa, pb;
+	float depth;
+	assert(!GJKPenetration(a, b, normal, depth, pa, pb));
+}
+
+BENCHMARK(GJKPenetration_OBBOBB, "GJKPenetration(OBB, OBB)")
+{
+	static const GJKDistanceBenchmarkData gjkData;
+	int j = i % numGJKDistanceBenchmarkPairs;
+	OBB b = gjkData.obb2[j];
+	b.Translate(gjkData.obb[j].CenterPoint() - b.CenterPoint());
+	vec normal, pa, pb;
+	float depth = 0.f;
+	GJKPenetration(gjkData.obb[j], b, normal, depth, pa, pb);
+	TestData::dummyResultFloat += depth;
+}
+BENCHMARK_END
+
+UNIQUE_TEST(GJKIntersectCachedSphereSphere)
+{
+	Sphere a(POINT_VEC(0.f, 0.f, 0.f), 1.f);
+	Sphere b(POINT_VEC(3.f, 0.f, 0.f), 1.f);
+	GJKCache cache;
+	assert(!GJKIntersect(a, b, cache));
+	assert1(cache.numDirections == 1, cache.numDirections);
+	assert(!GJKIntersect(a, b, cache));
+
+	b.pos = POINT_VEC(1.5f, 0.f, 0.f);
+	assert(GJKIntersect(a, b, cache));
+	assert1(cache.numDirections >= 2, cache.numDirections);
+	b.pos = POINT_VEC(1.4f, 0.1f, 0.f);
+	assert(GJKIntersect(a, b, cache));
+	b.pos = POINT_VEC(0.f, 2.5f, 0.f);
+	assert(!GJKIntersect(a, b, cache));
+	assert1(cache.numDirections == 1, cache.numDirections);
+
+	cache.Reset();
+	assert(!GJKIntersect(a, b, cache));
+}
+
+// Moves one object of a pair in small steps through the other one, and checks that the warm-started query agrees with the
+// regular one on every step, except where the objects are too close to touching for the result to be well-defined.
+RANDOMIZED_TEST(GJKIntersectCachedOBBOBB)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	OBB a = RandomOBBContainingPoint(pt, 10.f);
+	OBB b = RandomOBBContainingPoint(pt, 10.f);
+	vec offset = vec::RandomDir(rng) * 30.f;
+	b.Translate(offset);
+	GJKCache cache;
+	const int numSteps = 40;
+	for(int i = 0; i < numSteps; ++i)
+	{
+		bool intersects = GJKIntersect(a, b, cache);
+		vec normal, pa, pb;
+		float depth = 0.f;
+		if (GJKDistance(a, b) > 1e-2f)
+			assert1(!intersects, i);
+		else if (GJKPenetration(a, b, normal, depth, pa, pb) && depth > 1e-2f)
+			assert1(intersects, i);
+		assert2(intersects == GJKIntersect(a, b) || depth <= 1e-2f, i, depth);
+		b.Translate(offset * (-2.f / numSteps) + vec::RandomDir(rng) * 0.1f);
+		MARK_UNUSED(intersects);
+	}
+}
+
+static const int numGJKCacheBenchmarkFrames = 256;
+
+// Returns the position of obb2 on the given frame of the slowly moving OBB benchmarks. It moves back and forth between the original,
+// disjoint position and the center of obb, and the pairs are at different phases, so that about half of the queries are intersecting.
+static OBB MovingBenchmarkOBB(int pair, int frame)
+{
+	static const GJKDistanceBenchmarkData gjkData;
+	OBB b = gjkData.obb2[pair];
+	float t = Abs((frame + pair * 2) % numGJKCacheBenchmarkFrames - numGJKCacheBenchmarkFrames / 2) * (2.f / numGJKCacheBenchmarkFrames);
+	b.pos += (gjkData.obb[pair].pos - b.pos) * t;
+	return b;
+}
+
+static GJKCache gjkBenchmarkCache[numGJKDistanceBenchmarkPairs];
+
+BENCHMARK(GJKIntersect_OBBOBB_Moving, "GJKIntersect(OBB, OBB) on slowly moving pairs")
+{
+	static const GJKDistanceBenchmarkData gjkData;
+	int j = i % numGJKDistanceBenchmarkPairs;
+	OBB b = MovingBenchmarkOBB(j, i / numGJKDistanceBenchmarkPairs);
+	TestData::dummyResultFloat += GJKIntersect(gjkData.obb[j], b) ? 1.f : 0.f;
+}
+BENCHMARK_END
+
+BENCHMARK(GJKIntersect_OBBOBB_Moving_Cached, "GJKIntersect(OBB, OBB, GJKCache) on slowly moving pairs")
+{
+	static const GJKDistanceBenchmarkData gjkData;
+	int j = i % numGJKDistanceBenchmarkPairs;
+	OBB b = MovingBenchmarkOBB(j, i / numGJKDistanceBenchmarkPairs);
+	TestData::dummyResultFloat += GJKIntersect(gjkData.obb[j], b, gjkBenchmarkCache[j]) ? 1.f : 0.f;
+}
+BENCHMARK_END
+
+UNIQUE_TEST(SATIntersectCachedAABBAABB)
+{
+	AABB a(POINT_VEC(0.f, 0.f, 0.f), POINT_VEC(1.f, 1.f, 1.f));
+	AABB b(POINT_VEC(0.f, 2.f, 0.f), POINT_VEC(1.f, 3.f, 1.f));
+	SATCache cache;
+	assert(!SATIntersect(a, b, cache));
+	assert1(cache.separatingAxis == 1, cache.separatingAxis);
+	assert(!SATIntersect(a, b, cache));
+	assert1(cache.separatingAxis == 1, cache.separatingAxis);
+
+	b.Translate(DIR_VEC(0.f, -1.5f, 0.f));
+	assert(SATIntersect(a, b, cache));
+	assert1(cache.separatingAxis == -1, cache.separatingAxis);
+	b.Translate(DIR_VEC(0.f, 0.f, 2.f));
+	assert(!SATIntersect(a, b, cache));
+	assert1(cache.separatingAxis == 2, cache.separatingAxis);
+
+	cache.separatingAxis = 100;
+	assert(!SATIntersect(a, b, cache));
+	assert1(cache.separatingAxis == 2, cache.separatingAxis);
+	cache.Reset();
+	assert1(cache.separatingAxis == -1, cache.separatingAxis);
+}
+
+// Only an edge-edge axis separates these OBBs, which are rotated 45 degrees about perpendicular axes so that their edges pass each other.
+UNIQUE_TEST(SATIntersectCachedEdgeAxis)
+{
+	OBB a = AABB(POINT_VEC(-1.f, -1.f, -1.f), POINT_VEC(1.f, 1.f, 1.f)).Transform(Quat::RotateX(pi / 4.f));
+	OBB b = AABB(POINT_VEC(-1.f, -1.f, -1.f), POINT_VEC(1.f, 1.f, 1.f)).Transform(Quat::RotateZ(pi / 4.f));
+	b.Translate(DIR_VEC(0.f, 2.f * Sqrt(2.f) + 0.01f, 0.f));
+	SATCache cache;
+	assert(!SATIntersect(a, b, cache));
+	assert1(cache.separatingAxis >= 6, cache.separatingAxis);
+	int edgeAxis = cache.separatingAxis;
+	assert(!SATIntersect(a, b, cache));
+	assert2(cache.separatingAxis == edgeAxis, cache.separatingAxis, edgeAxis);
+	b.Translate(DIR_VEC(0.f, -0.02f, 0.f));
+	assert(SATIntersect(a, b, cache));
+	assert(SATIntersect(a, b));
+	MARK_UNUSED(edgeAxis);
+}
+
+// The warm-started query must return exactly the same result as the regular one, since the cached axis only changes the order
+// in which the axes are tested.
+RANDOMIZED_TEST(SATIntersectCachedOBBOBB)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	OBB a = RandomOBBContainingPoint(pt, 10.f);
+	OBB b = RandomOBBContainingPoint(pt, 10.f);
+	vec offset = vec::RandomDir(rng) * 30.f;
+	b.Translate(offset);
+	SATCache cache;
+	const int numSteps = 40;
+	for(int i = 0; i < numSteps; ++i)
+	{
+		bool intersects = SATIntersect(a, b, cache);
+		assert1(intersects == SATIntersect(a, b), i);
+		vec normal, pa, pb;
+		float depth = 0.f;
+		if (GJKDistance(a, b) > 1e-2f)
+			assert1(!intersects, i);
+		else if (GJKPenetration(a, b, normal, depth, pa, pb) && depth > 1e-2f)
+			assert1(intersects, i);
+		b.Translate(offset * (-2.f / numSteps) + vec::RandomDir(rng) * 0.1f);
+		MARK_UNUSED(intersects);
+	}
+}
+
+RANDOMIZED_TEST(SATIntersectCachedFrustumAABB)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Frustum a = RandomFrustumContainingPoint(rng, pt);
+	AABB b = RandomAABBContainingPoint(pt, 10.f);
+	vec offset = vec::RandomDir(rng) * 2.f * SCALE;
+	b.Translate(offset);
+	SATCache cache;
+	const int numSteps = 20;
+	for(int i = 0; i < numSteps; ++i)
+	{
+		bool intersects = SATIntersect(a, b, cache);
+		assert1(intersects == SATIntersect(a, b), i);
+		assert1(intersects == SATIntersect(b, a), i);
+		b.Translate(offset * (-2.f / numSteps));
+		MARK_UNUSED(intersects);
+	}
+}
+
+// Polyhedron has no upper bound for its number of axes, so SATIntersect() stores them on the heap instead of on the stack.
+RANDOMIZED_TEST(SATIntersectPolyhedronOBB)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Polyhedron a = RandomPolyhedronContainingPoint(pt);
+	OBB b = RandomOBBContainingPoint(pt, 10.f);
+	b.Translate(vec::RandomDir(rng) * rng.Float(0.f, 2.f * SCALE));
+	bool intersects = SATIntersect(a, b);
+	assert(intersects == SATIntersect(b, a));
+	SATCache cache;
+	assert(intersects == SATIntersect(a, b, cache));
+	vec normal, pa, pb;
+	float depth = 0.f;
+	if (GJKDistance(a, b) > 1e-2f)
+		assert(!intersects);
+	else if (GJKPenetration(a, b, normal, depth, pa, pb) && depth > 1e-2f)
+		assert(intersects);
+	MARK_UNUSED(intersects);
+}
+
+static SATCache satBenchmarkCache[numGJKDistanceBenchmarkPairs];
+
+BENCHMARK(SATIntersect_OBBOBB_Moving, "SATIntersect(OBB, OBB) on slowly moving pairs")
+{
+	static const GJKDistanceBenchmarkData gjkData;
+	int j = i % numGJKDistanceBenchmarkPairs;
+	OBB b = MovingBenchmarkOBB(j, i / numGJKDistanceBenchmarkPairs);
+	TestData::dummyResultFloat += SATIntersect(gjkData.obb[j], b) ? 1.f : 0.f;
+}
+BENCHMARK_END
+
+BENCHMARK(SATIntersect_OBBOBB_Moving_Cached, "SATIntersect(OBB, OBB, SATCache) on slowly moving pairs")
+{
+	static const GJKDistanceBenchmarkData gjkData;
+	int j = i % numGJKDistanceBenchmarkPairs;
+	OBB b = MovingBenchmarkOBB(j, i / numGJKDistanceBenchmarkPairs);
+	TestData::dummyResultFloat += SATIntersect(gjkData.obb[j], b, satBenchmarkCache[j]) ? 1.f : 0.f;
+}
+BENCHMARK_END
+
+// Each AABB is placed at a random distance from a point inside the frustum, so that the set has both intersecting and disjoint pairs.
+struct SATFrustumBenchmarkData
+{
+	Frustum frustum[numGJKDistanceBenchmarkPairs];
+	AABB aabb[numGJKDistanceBenchmarkPairs];
+
+	SATFrustumBenchmarkData()
+	{
+		LCG lcg(4321);
+		for(int i = 0; i < numGJKDistanceBenchmarkPairs; ++i)
+		{
+			vec pt = vec::RandomBox(lcg, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+			frustum[i] = RandomFrustumContainingPoint(lcg, pt);
+			vec center = pt + vec::RandomDir(lcg) * lcg.Float(0.f, SCALE);
+			vec halfSize = vec::RandomBox(lcg, POINT_VEC_SCALAR(1.f), POINT_VEC_SCALAR(10.f)) - vec::zero;
+			aabb[i] = AABB(center - halfSize, center + halfSize);
+		}
+	}
+};
+
+static SATCache satFrustumBenchmarkCache[numGJKDistanceBenchmarkPairs];
+
+BENCHMARK(GJKIntersect_FrustumAABB, "GJKIntersect(Frustum, AABB)")
+{
+	static const SATFrustumBenchmarkData satFrustumData;
+	int j = i % numGJKDistanceBenchmarkPairs;
+	TestData::dummyResultFloat += GJKIntersect(satFrustumData.frustum[j], satFrustumData.aabb[j]) ? 1.f : 0.f;
+}
+BENCHMARK_END
+
+BENCHMARK(SATIntersect_FrustumAABB, "SATIntersect(Frustum, AABB)")
+{
+	static const SATFrustumBenchmarkData satFrustumData;
+	int j = i % numGJKDistanceBenchmarkPairs;
+	TestData::dummyResultFloat += SATIntersect(satFrustumData.frustum[j], satFrustumData.aabb[j]) ? 1.f : 0.f;
+}
+BENCHMARK_END
+
+BENCHMARK(SATIntersect_FrustumAABB_Cached, "SATIntersect(Frustum, AABB, SATCache) on repeated queries")
+{
+	static const SATFrustumBenchmarkData satFrustumData;
+	int j = i % numGJKDistanceBenchmarkPairs;
+	TestData::dummyResultFloat += SATIntersect(satFrustumData.frustum[j], satFrustumData.aabb[j], satFrustumBenchmarkCache[j]) ? 1.f : 0.f;
+}
+BENCHMARK_END
+
+// Not a multiple of four, so that the last batch is only partially filled.
+static const int numGJKBatchTestPairs = 11;
+
+template<typename A, typename B>
+static void CheckGJKIntersectBatch(const A *a, const B *b, const bool *expected)
+{
+	bool result[numGJKBatchTestPairs];
+	int numIntersecting = GJKIntersectBatch(a, b, numGJKBatchTestPairs, result);
+	int numExpected = 0;
+	for(int i = 0; i < numGJKBatchTestPairs; ++i)
+	{
+		assert3(result[i] == expected[i], i, a[i], b[i]);
+		assert3(result[i] == GJKIntersect(a[i], b[i]), i, a[i], b[i]);
+		numExpected += expected[i] ? 1 : 0;
+	}
+	assert2(numIntersecting == numExpected, numIntersecting, numExpected);
+	MARK_UNUSED(numIntersecting);
+}
+
+// Each pair either shares a common point, or lies on the opposite sides of a plane.
+RANDOMIZED_TEST(GJKIntersectBatchOBBOBB)
+{
+	OBB a[numGJKBatchTestPairs], b[numGJKBatchTestPairs];
+	bool expected[numGJKBatchTestPairs];
+	for(int i = 0; i < numGJKBatchTestPairs; ++i)
+	{
+		expected[i] = rng.Int(0, 1) == 1;
+		if (expected[i])
+		{
+			vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+			a[i] = RandomOBBContainingPoint(pt, 10.f);
+			b[i] = RandomOBBContainingPoint(pt, 10.f);
+		}
+		else
+		{
+			Plane p(vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE)), vec::RandomDir(rng));
+			a[i] = RandomOBBInHalfspace(p, 10.f);
+			p.ReverseNormal();
+			b[i] = RandomOBBInHalfspace(p, 10.f);
+		}
+	}
+	CheckGJKIntersectBatch(a, b, expected);
+}
+
+RANDOMIZED_TEST(GJKIntersectBatchAABBSphere)
+{
+	AABB a[numGJKBatchTestPairs];
+	Sphere b[numGJKBatchTestPairs];
+	bool expected[numGJKBatchTestPairs];
+	for(int i = 0; i < numGJKBatchTestPairs; ++i)
+	{
+		expected[i] = rng.Int(0, 1) == 1;
+		if (expected[i])
+		{
+			vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+			a[i] = RandomAABBContainingPoint(pt, 10.f);
+			b[i] = RandomSphereContainingPoint(pt, 10.f);
+		}
+		else
+		{
+			Plane p(vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE)), vec::RandomDir(rng));
+			a[i] = RandomAABBInHalfspace(p, 10.f);
+			p.ReverseNormal();
+			b[i] = RandomSphereInHalfspace(p, 10.f);
+		}
+	}
+	CheckGJKIntersectBatch(a, b, expected);
+}
+
+RANDOMIZED_TEST(GJKIntersectBatchCapsuleTriangle)
+{
+	Capsule a[numGJKBatchTestPairs];
+	Triangle b[numGJKBatchTestPairs];
+	bool expected[numGJKBatchTestPairs];
+	for(int i = 0; i < numGJKBatchTestPairs; ++i)
+	{
+		expected[i] = rng.Int(0, 1) == 1;
+		if (expected[i])
+		{
+			vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+			a[i] = RandomCapsuleContainingPoint(pt);
+			b[i] = RandomTriangleContainingPoint(pt);
+		}
+		else
+		{
+			Plane p(vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE)), vec::RandomDir(rng));
+			a[i] = RandomCapsuleInHalfspace(p);
+			p.ReverseNormal();
+			b[i] = RandomTriangleInHalfspace(p);
+		}
+	}
+	CheckGJKIntersectBatch(a, b, expected);
+}
+
+RANDOMIZED_TEST(GJKIntersectBatchLineSegmentOBB)
+{
+	LineSegment a[numGJKBatchTestPairs];
+	OBB b[numGJKBatchTestPairs];
+	bool expected[numGJKBatchTestPairs];
+	for(int i = 0; i < numGJKBatchTestPairs; ++i)
+	{
+		expected[i] = rng.Int(0, 1) == 1;
+		if (expected[i])
+		{
+			vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+			a[i] = RandomLineSegmentContainingPoint(pt);
+			b[i] = RandomOBBContainingPoint(pt, 10.f);
+		}
+		else
+		{
+			Plane p(vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE)), vec::RandomDir(rng));
+			a[i] = RandomLineSegmentInHalfspace(p);
+			p.ReverseNormal();
+			b[i] = RandomOBBInHalfspace(p, 10.f);
+		}
+	}
+	CheckGJKIntersectBatch(a, b, expected);
+}
+
+static const int numGJKBatchBenchmarkPairs = 16;
+
+// The OBB pairs of the moving benchmarks above, frozen at different phases of their movement so that about half of them intersect.
+struct GJKBatchBenchmarkData
+{
+	OBB obb2[numGJKDistanceBenchmarkPairs];
+
+	GJKBatchBenchmarkData()
+	{
+		for(int i = 0; i < numGJKDistanceBenchmarkPairs; ++i)
+			obb2[i] = MovingBenchmarkOBB(i, i);
+	}
+};
+
+BENCHMARK(GJKIntersect_OBBOBB_16Pairs, "GJKIntersect(OBB, OBB) on 16 pairs")
+{
+	static const GJKBatchBenchmarkData gjkBatchData;
+	static const GJKDistanceBenchmarkData gjkData;
+	int j = (i * numGJKBatchBenchmarkPairs) % numGJKDistanceBenchmarkPairs;
+	for(int k = j; k < j + numGJKBatchBenchmarkPairs; ++k)
+		TestData::dummyResultFloat += GJKIntersect(gjkData.obb[k], gjkBatchData.obb2[k]) ? 1.f : 0.f;
+}
+BENCHMARK_END
+
+BENCHMARK(GJKIntersectBatch_OBBOBB_16Pairs, "GJKIntersectBatch(OBB, OBB) on 16 pairs")
+{
+	static const GJKBatchBenchmarkData gjkBatchData;
+	static const GJKDistanceBenchmarkData gjkData;
+	int j = (i * numGJKBatchBenchmarkPairs) % numGJKDistanceBenchmarkPairs;
+	bool result[numGJKBatchBenchmarkPairs];
+	TestData::dummyResultFloat += (float)GJKIntersectBatch(gjkData.obb + j, gjkBatchData.obb2 + j, numGJKBatchBenchmarkPairs, result);
+}
+BENCHMARK_END
+
+BENCHMARK(GJKIntersect_SphereCapsule_16Pairs, "GJKIntersect(Sphere, Capsule) on 16 pairs")
+{
+	static const GJKDistanceBenchmarkData gjkData;
+	int j = (i * numGJKBatchBenchmarkPairs) % numGJKDistanceBenchmarkPairs;
+	for(int k = j; k < j + numGJKBatchBenchmarkPairs; ++k)
+		TestData::dummyResultFloat += GJKIntersect(gjkData.sphere[k], gjkData.capsule2[k]) ? 1.f : 0.f;
+}
+BENCHMARK_END
+
+BENCHMARK(GJKIntersectBatch_SphereCapsule_16Pairs, "GJKIntersectBatch(Sphere, Capsule) on 16 pairs")
+{
+	static const GJKDistanceBenchmarkData gjkData;
+	int j = (i * numGJKBatchBenchmarkPairs) % numGJKDistanceBenchmarkPairs;
+	bool result[numGJKBatchBenchmarkPairs];
+	TestData::dummyResultFloat += (float)GJKIntersectBatch(gjkData.sphere + j, gjkData.capsule2 + j, numGJKBatchBenchmarkPairs, result);
+}
+BENCHMARK_END
+
+UNIQUE_TEST(GJKTimeOfImpactSphereSphere)
+{
+	Sphere a(POINT_VEC(0.f, 0.f, 0.f), 1.f);
+	Sphere b(POINT_VEC(6.f, 0.f, 0.f), 1.f);
+	const float tolerance = 1e-3f;
+	float t;
+	vec normal, pa, pb;
+	bool hit = GJKTimeOfImpact(a, DIR_VEC(10.f, 0.f, 0.f), b, tolerance, t, normal, pa, pb);
+	assert(hit);
+	// The spheres touch when their centers are 2 units apart.
+	assert1(EqualAbs(t, 0.4f, 1e-3f), t);
+	// At a separation below the tolerance, the direction between the closest points is only as precise as GJKDistance() is
+	// relative to the size of the objects.
+	assert1(normal.Equals(DIR_VEC(1.f, 0.f, 0.f), 1e-2f), normal);
+	assert1(pa.Equals(POINT_VEC(5.f, 0.f, 0.f), 1e-2f), pa);
+	assert1(pb.Equals(POINT_VEC(5.f, 0.f, 0.f), 1e-2f), pb);
+
+	hit = GJKTimeOfImpact(a, DIR_VEC(0.f, 10.f, 0.f), b, tolerance, t, normal, pa, pb);
+	assert(!hit);
+	hit = GJKTimeOfImpact(a, DIR_VEC(-10.f, 0.f, 0.f), b, tolerance, t, normal, pa, pb);
+	assert(!hit);
+	hit = GJKTimeOfImpact(a, DIR_VEC(3.9f, 0.f, 0.f), b, tolerance, t, normal, pa, pb);
+	assert(!hit);
+
+	b.pos = POINT_VEC(1.f, 0.f, 0.f);
+	hit = GJKTimeOfImpact(a, DIR_VEC(10.f, 0.f, 0.f), b, tolerance, t, normal, pa, pb);
+	assert(hit);
+	assert1(t == 0.f, t);
+	MARK_UNUSED(hit);
+}
+
+UNIQUE_TEST(GJKTimeOfImpactThinWall)
+{
+	// A projectile that moves past the whole wall within the time interval must not tunnel through it.
+	Capsule a(POINT_VEC(-50.f, 0.f, 0.f), POINT_VEC(-49.f, 0.f, 0.f), 0.1f);
+	OBB b(AABB(POINT_VEC(-0.05f, -10.f, -10.f), POINT_VEC(0.05f, 10.f, 10.f)));
+	float t;
+	vec normal, pa, pb;
+	bool hit = GJKTimeOfImpact(a, DIR_VEC(100.f, 0.f, 0.f), b, 1e-3f, t, normal, pa, pb);
+	assert(hit);
+	assert1(EqualAbs(t, (49.f - 0.1f - 0.05f) / 100.f, 1e-4f), t);
+	assert1(normal.Equals(DIR_VEC(1.f, 0.f, 0.f), 1e-2f), normal);
+	MARK_UNUSED(hit);
+}
+
+UNIQUE_TEST(GJKTimeOfImpactRotatingOBB)
+{
+	// A long thin bar at the origin spins a quarter turn around the z axis towards a sphere above it.
+	OBB a(AABB(POINT_VEC(-5.f, -0.1f, -0.1f), POINT_VEC(5.f, 0.1f, 0.1f)));
+	Sphere b(POINT_VEC(0.f, 3.f, 0.f), 0.5f);
+	float t;
+	vec normal, pa, pb;
+	bool hit = GJKTimeOfImpact(a, vec::zero, DIR_VEC(0.f, 0.f, pi / 2.f), a.CenterPoint(), b, 1e-3f, t, normal, pa, pb);
+	assert(hit);
+	// The bar touches the sphere when the distance 3*cos(angle) from the center of the sphere to the axis of the bar is 0.6.
+	float expectedAngle = Acos(0.2f);
+	assert2(EqualAbs(t * pi / 2.f, expectedAngle, 1e-2f), t * pi / 2.f, expectedAngle);
+	hit = GJKTimeOfImpact(a, vec::zero, DIR_VEC(0.f, 0.f, expectedAngle - 0.05f), a.CenterPoint(), b, 1e-3f, t, normal, pa, pb);
+	assert(!hit);
+	MARK_UNUSED(hit);
+}
+
+// Throws a capsule through an OBB, and checks that the capsule does not intersect the OBB at any time before the time of impact.
+RANDOMIZED_TEST(GJKTimeOfImpactCapsuleOBB)
+{
+	Plane p(vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE)), vec::RandomDir(rng));
+	Capsule a = RandomCapsuleInHalfspace(p);
+	p.ReverseNormal();
+	OBB b = RandomOBBInHalfspace(p, 10.f);
+	vec velocity = (b.CenterPoint() - a.Centroid()) * 2.f;
+	const float tolerance = 1e-3f;
+	float t;
+	vec normal, pa, pb;
+	bool hit = GJKTimeOfImpact(a, velocity, b, tolerance, t, normal, pa, pb);
+	assert(hit);
+	assert1(t >= 0.f && t <= 0.5f, t);
+	// GJKDistance() converges to the distance of a capsule only asymptotically, so measuring the distance again with a
+	// differently rounded copy of the objects agrees only up to a small fraction of the size of the objects.
+	Capsule moved = a;
+	moved.Translate(velocity * t - b.CenterPoint());
+	OBB centeredB = b;
+	centeredB.Translate(-b.CenterPoint());
+	float dist = GJKDistance(moved, centeredB);
+	float measurementError = 1e-3f * (a.r + a.LineLength() + b.r.Length());
+	assert3(dist <= tolerance + measurementError, dist, t, measurementError);
+	MARK_UNUSED(measurementError);
+	for(int i = 0; i < 10; ++i)
+	{
+		moved = a;
+		moved.Translate(velocity * (t * i / 10.f));
+		assert2(!GJKIntersect(moved, b), i, t);
+	}
+	MARK_UNUSED(hit);
+	MARK_UNUSED(dist);
+}
+
+BENCHMARK(GJKTimeOfImpact_CapsuleOBB, "GJKTimeOfImpact(Capsule, OBB)")
+{
+	static const GJKDistanceBenchmarkData gjkData;
+	int j = i % numGJKDistanceBenchmarkPairs;
+	const Capsule &a = gjkData.capsule[j];
+	const OBB &b = gjkData.obb2[j];
+	float t;
+	vec normal, pa, pb;
+	if (GJKTimeOfImpact(a, (b.CenterPoint() - a.Centroid()) * 2.f, b, 1e-3f, t, normal, pa, pb))
+		TestData::dummyResultFloat += t;
+}
+BENCHMARK_END
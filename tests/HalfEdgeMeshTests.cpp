@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/MathGeoLib.h"
+#include "../src/Math/myassert.h"
+#include "TestRunner.h"
+#include "TestData.h"
+#include "../src/Geometry/HalfEdgeMesh.h"
+#include "ObjectGenerators.h"
+
+MATH_IGNORE_UNUSED_VARS_WARNING
+
+RANDOMIZED_TEST(HalfEdgeMesh_Connectivity)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Polyhedron p = RandomPolyhedronContainingPoint(pt);
+	HalfEdgeMesh mesh(p);
+	assert(mesh.NumVertices() == p.NumVertices());
+	assert(mesh.NumFaces() == p.NumFaces());
+	assert(mesh.IsClosed());
+	assert(mesh.NumBoundaryHalfEdges() == 0);
+	assert(mesh.NumEdges() == p.NumEdges());
+
+	for(int i = 0; i < mesh.NumFaces(); ++i)
+	{
+		assert(mesh.NumFaceVertices(i) == (int)p.f[i].v.size());
+		for(int j = 0; j < mesh.NumFaceVertices(i); ++j)
+		{
+			int he = mesh.FaceHalfEdge(i) + j;
+			assert(mesh.Face(he) == i);
+			assert(mesh.Origin(he) == p.f[i].v[j]);
+			assert(mesh.Destination(he) == p.f[i].v[(j + 1) % p.f[i].v.size()]);
+			assert(mesh.Prev(mesh.Next(he)) == he);
+			int twin = mesh.Twin(he);
+			assert(twin >= 0);
+			assert(mesh.Twin(twin) == he);
+			assert(mesh.Origin(twin) == mesh.Destination(he));
+			assert(mesh.Destination(twin) == mesh.Origin(he));
+			assert(mesh.NeighborFace(he) == mesh.Face(twin));
+			assert(mesh.NeighborFace(he) != i);
+		}
+	}
+
+	for(int i = 0; i < mesh.NumVertices(); ++i)
+		for(int j = 0; j < mesh.NumOutgoing(i); ++j)
+			assert(mesh.Origin(mesh.Outgoing(i)[j]) == i);
+
+	assert(mesh.EdgeIndices() == p.EdgeIndices());
+	assert(mesh.GenerateVertexAdjacencyData() == p.GenerateVertexAdjacencyData());
+	assert(mesh.IsConvex(p) == p.IsConvex());
+
+	// Not all generated polyhedra are wound so that their face normals point outwards.
+	p.OrientNormalsOutsideConvex();
+	mesh.Set(p);
+	assert(p.IsConvex());
+	assert(mesh.IsConvex(p));
+
+	// Replace the first face with a fan of triangles around a point that is sunk halfway towards the center of the
+	// polyhedron. This makes a dimple whose rim edges are concave, while all faces stay planar and the mesh stays closed.
+	vec center = p.ApproximateConvexCentroid();
+	vec faceCenter = p.FacePolygon(0).Centroid();
+	std::vector<int> rim = p.f[0].v;
+	p.v.push_back((faceCenter + center) * 0.5f);
+	int apex = p.NumVertices() - 1;
+	p.f.erase(p.f.begin());
+	for(size_t j = 0; j < rim.size(); ++j)
+	{
+		Polyhedron::Face t;
+		t.v.push_back(rim[j]);
+		t.v.push_back(rim[(j + 1) % rim.size()]);
+		t.v.push_back(apex);
+		p.f.push_back(t);
+	}
+	mesh.Set(p);
+	assert(mesh.IsClosed());
+	assert(!p.IsConvex());
+	assert(!mesh.IsConvex(p));
+}
+
+UNIQUE_TEST(HalfEdgeMesh_NotClosed)
+{
+	Polyhedron p = Polyhedron::Dodecahedron();
+	int removedFaceSize = (int)p.f.back().v.size();
+	p.f.pop_back();
+	HalfEdgeMesh mesh(p);
+	assert(!mesh.IsClosed());
+	assert(!p.IsClosed());
+	assert(mesh.NumBoundaryHalfEdges() == removedFaceSize);
+	assert(!mesh.IsConvex(p));
+
+	// A face that is used twice makes each of its edges appear in the same direction twice.
+	p = Polyhedron::Dodecahedron();
+	p.f.push_back(p.f.back());
+	mesh.Set(p);
+	assert(!mesh.IsClosed());
+	assert(!p.IsClosed());
+}
+
+UNIQUE_TEST(HalfEdgeMesh_NotConvex)
+{
+	// Push the top vertex of an octahedron below its center to make a dent.
+	Polyhedron p = Polyhedron::Octahedron();
+	p.v[2] = POINT_VEC(0.f, -0.1f, 0.f);
+	HalfEdgeMesh mesh(p);
+	assert(mesh.IsClosed());
+	assert(!p.IsConvex());
+	assert(!mesh.IsConvex(p));
+}
+
+UNIQUE_TEST(Polyhedron_MergeAdjacentPlanarFaces)
+{
+	// Split each face of a box into two triangles, and merge them back.
+	Polyhedron box = AABB(POINT_VEC(-1.f, -2.f, -3.f), POINT_VEC(1.f, 2.f, 3.f)).ToPolyhedron();
+	Polyhedron p;
+	p.v = box.v;
+	for(int i = 0; i < box.NumFaces(); ++i)
+	{
+		const std::vector<int> &quad = box.f[i].v;
+		assert(quad.size() == 4);
+		Polyhedron::Face a, b;
+		a.v.push_back(quad[0]); a.v.push_back(quad[1]); a.v.push_back(quad[2]);
+		b.v.push_back(quad[0]); b.v.push_back(quad[2]); b.v.push_back(quad[3]);
+		p.f.push_back(a);
+		p.f.push_back(b);
+	}
+	assert(p.IsClosed());
+
+	int numMerges = p.MergeAdjacentPlanarFaces(false);
+	assert1(numMerges == 6, numMerges);
+	assert(p.NumFaces() == 6);
+	assert(p.NumVertices() == 8);
+	assert(p.IsClosed());
+	assert(p.IsConvex());
+	assert(EqualAbs(p.Volume(), 2.f * 4.f * 6.f, 1e-3f));
+}
+
+// The hull has 506 vertices, 528 faces and 1032 edges.
+struct HalfEdgeMeshBenchmarkData
+{
+	Polyhedron polyhedron;
+	HalfEdgeMesh mesh;
+
+	HalfEdgeMeshBenchmarkData()
+	{
+		polyhedron = EllipsoidPolyhedron(POINT_VEC_SCALAR(0.f), DIR_VEC(10.f, 6.f, 8.f), 21, 24);
+		mesh.Set(polyhedron);
+	}
+};
+
+BENCHMARK(HalfEdgeMesh_Build, "Build the HalfEdgeMesh of a 528-face hull")
+{
+	static const HalfEdgeMeshBenchmarkData halfEdgeMeshData;
+	HalfEdgeMesh mesh(halfEdgeMeshData.polyhedron);
+	TestData::dummyResultInt += mesh.NumHalfEdges();
+}
+BENCHMARK_END
+
+BENCHMARK(Polyhedron_IsClosed, "Polyhedron::IsClosed() of a 528-face hull")
+{
+	static const HalfEdgeMeshBenchmarkData halfEdgeMeshData;
+	TestData::dummyResultInt += halfEdgeMeshData.polyhedron.IsClosed() ? 1 : 0;
+}
+BENCHMARK_END
+
+BENCHMARK(Polyhedron_IsConvex, "Polyhedron::IsConvex() of a 528-face hull")
+{
+	static const HalfEdgeMeshBenchmarkData halfEdgeMeshData;
+	TestData::dummyResultInt += halfEdgeMeshData.polyhedron.IsConvex() ? 1 : 0;
+}
+BENCHMARK_END
+
+BENCHMARK(HalfEdgeMesh_IsConvex, "HalfEdgeMesh::IsConvex() of a 528-face hull")
+{
+	static const HalfEdgeMeshBenchmarkData halfEdgeMeshData;
+	TestData::dummyResultInt += halfEdgeMeshData.mesh.IsConvex(halfEdgeMeshData.polyhedron) ? 1 : 0;
+}
+BENCHMARK_END
+
+BENCHMARK(Polyhedron_EdgeIndices, "Polyhedron::EdgeIndices() of a 528-face hull")
+{
+	static const HalfEdgeMeshBenchmarkData halfEdgeMeshData;
+	TestData::dummyResultInt += (int)halfEdgeMeshData.polyhedron.EdgeIndices().size();
+}
+BENCHMARK_END
+
+BENCHMARK(HalfEdgeMesh_EdgeIndices, "HalfEdgeMesh::EdgeIndices() of a 528-face hull")
+{
+	static const HalfEdgeMeshBenchmarkData halfEdgeMeshData;
+	TestData::dummyResultInt += (int)halfEdgeMeshData.mesh.EdgeIndices().size();
+}
+BENCHMARK_END
@@ -1388,6 +1388,8 @@ RANDOMIZED_TEST(PolyhedronPolyhedronNoIntersect)
 	Polyhedron b = RandomPolyhedronInHalfspace(p);
 	assert2(!a.Intersects(b), a, b);
 	assert(!b.Intersects(a));
+	assert2(!a.IntersectsConvex(b), a, b);
+	assert(!b.IntersectsConvex(a));
 //	assert(a.Distance(b) > 0.f);
 //	assert(b.Distance(a) > 0.f);
 //	assert(a.Contains(a.ClosestPoint(b)));
@@ -15,6 +15,14 @@ Triangle RandomTriangleContainingPoint(const vec &pt);
 Polyhedron RandomPolyhedronContainingPoint(const vec &pt);
 Polygon RandomPolygonContainingPoint(const vec &pt);
 
+// Returns a convex polyhedron with 2 + numRings * numSegments vertices on the surface of the given axis-aligned ellipsoid.
+// The faces between the rings are planar quads, and the faces around the poles are triangles.
+Polyhedron EllipsoidPolyhedron(const vec &center, const vec &radii, int numRings, int numSegments);
+// Returns a randomly rotated EllipsoidPolyhedron with 506 vertices and random radii between 1 and 10.
+Polyhedron RandomEllipsoidPolyhedron(LCG &lcg, const vec &center);
+// Returns the convex hull of numPoints points jittered radially below the surface of a sphere of radius 10 at the origin.
+Polyhedron RandomSpherePointHull(LCG &lcg, int numPoints);
+
 AABB RandomAABBInHalfspace(const Plane &plane, float maxSideLength);
 OBB RandomOBBInHalfspace(const Plane &plane, float maxSideLength);
 Sphere RandomSphereInHalfspace(const Plane &plane, float maxRadius);
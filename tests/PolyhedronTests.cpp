@@ -4,8 +4,9 @@
 #include "../src/MathGeoLib.h"
 #include "../src/Math/myassert.h"
 #include "TestRunner.h"
-
-Polyhedron RandomPolyhedronContainingPoint(const vec &pt);
+#include "TestData.h"
+#include "ObjectGenerators.h"
+#include "../src/Geometry/HalfEdgeMesh.h"
 
 RANDOMIZED_TEST(PolyhedronConvexCentroid)
 {
@@ -169,3 +170,503 @@ UNIQUE_TEST(Polyhedron_ConvexHull_case3)
 	for(int i = 0; i < n; ++i)
 		assert1(convexHull.ContainsConvex(points[i]), convexHull.Distance(points[i]));
 }
+
+static Polyhedron RandomPointCloudPolyhedron(LCG &rng, int numVertices)
+{
+	Polyhedron p;
+	for(int i = 0; i < numVertices; ++i)
+		p.v.push_back(vec::RandomBox(rng, -10.f, 10.f));
+	for(int i = 0; i + 2 < numVertices; i += 3)
+	{
+		Polyhedron::Face f;
+		f.v.push_back(i);
+		f.v.push_back(i+1);
+		f.v.push_back(i+2);
+		p.f.push_back(f);
+	}
+	return p;
+}
+
+template<typename Matrix>
+static void AssertTransformToMatchesPerVertex(const Polyhedron &p, const Matrix &transform, const Polyhedron &out)
+{
+	assert(out.v.size() == p.v.size());
+	assert(out.f.size() == p.f.size());
+	for(size_t i = 0; i < p.f.size(); ++i)
+		assert(out.f[i].v == p.f[i].v);
+	for(size_t i = 0; i < p.v.size(); ++i)
+	{
+		vec expected = transform.MulPos(p.v[i]);
+		assert2(out.v[i].Distance(expected) < 1e-3f, out.v[i], expected);
+	}
+}
+
+RANDOMIZED_TEST(Polyhedron_TransformTo)
+{
+	// Odd vertex counts exercise the points that do not fill a whole batch.
+	Polyhedron p = RandomPointCloudPolyhedron(rng, rng.Int(0, 37));
+	float3x4 tm = float3x4::FromTRS(float3::RandomBox(rng, -10.f, 10.f), Quat::RandomRotation(rng), float3(2.f, 0.5f, 1.f));
+	Quat q = Quat::RandomRotation(rng);
+	float3x3 rot = float3x3::RandomRotation(rng);
+
+	Polyhedron out;
+	p.TransformTo(tm, out);
+	AssertTransformToMatchesPerVertex(p, tm, out);
+	p.TransformTo(float4x4(tm), out);
+	AssertTransformToMatchesPerVertex(p, tm, out);
+#ifdef MATH_VEC_IS_FLOAT4
+	// float4x4::MulPos(float3) does not support projection.
+	float4x4 projective(tm);
+	projective.SetRow(3, float4(0.01f, 0.f, 0.f, 1.f));
+	p.TransformTo(projective, out);
+	AssertTransformToMatchesPerVertex(p, projective, out);
+#endif
+	p.TransformTo(rot, out);
+	AssertTransformToMatchesPerVertex(p, float3x4(rot), out);
+	p.TransformTo(q, out);
+	AssertTransformToMatchesPerVertex(p, float3x4(q), out);
+
+	// The in-place transform and the operator give the same results.
+	Polyhedron inPlace = p;
+	inPlace.Transform(tm);
+	AssertTransformToMatchesPerVertex(p, tm, inPlace);
+	AssertTransformToMatchesPerVertex(p, tm, tm * p);
+	inPlace = p;
+	inPlace.TransformTo(q, inPlace);
+	AssertTransformToMatchesPerVertex(p, float3x4(q), inPlace);
+	AssertTransformToMatchesPerVertex(p, float3x4(q), q * p);
+}
+
+UNIQUE_TEST(Polyhedron_TransformTo_ReusesDestination)
+{
+	LCG lcg;
+	Polyhedron large = RandomPointCloudPolyhedron(lcg, 30);
+	Polyhedron small = RandomPointCloudPolyhedron(lcg, 9);
+	float3x4 tm = float3x4::Translate(1.f, 2.f, 3.f);
+
+	Polyhedron out;
+	large.TransformTo(tm, out);
+	const vec *vertexStorage = &out.v[0];
+	MARK_UNUSED(vertexStorage);
+	small.TransformTo(tm, out);
+	AssertTransformToMatchesPerVertex(small, tm, out);
+	assert(&out.v[0] == vertexStorage);
+	large.TransformTo(tm, out);
+	AssertTransformToMatchesPerVertex(large, tm, out);
+	assert(&out.v[0] == vertexStorage);
+}
+
+struct PolyhedronTransformBenchmarkData
+{
+	Polyhedron p;
+	Polyhedron out;
+	float3x4 tm;
+	// The in-place benchmarks apply the transform repeatedly, so they use a rigid transform to keep the vertices bounded.
+	float3x4 rigid;
+	Quat rotation;
+
+	PolyhedronTransformBenchmarkData()
+	{
+		LCG lcg;
+		p = RandomPointCloudPolyhedron(lcg, 1000);
+		out = p;
+		tm = float3x4::FromTRS(float3::RandomBox(lcg, -10.f, 10.f), Quat::RandomRotation(lcg), float3(2.f, 0.5f, 1.f));
+		rigid = float3x4::FromTRS(float3::RandomBox(lcg, -0.01f, 0.01f), Quat::RandomRotation(lcg), float3::one);
+		rotation = Quat::RandomRotation(lcg);
+	}
+};
+
+BENCHMARK(Polyhedron_TransformTo_float3x4, "Polyhedron::TransformTo(float3x4) with 1000 vertices")
+{
+	static PolyhedronTransformBenchmarkData polyhedronTransformData;
+	polyhedronTransformData.p.TransformTo(polyhedronTransformData.tm, polyhedronTransformData.out);
+}
+BENCHMARK_END
+
+BENCHMARK(Polyhedron_Transform_float3x4, "Polyhedron::Transform(float3x4) in-place with 1000 vertices")
+{
+	static PolyhedronTransformBenchmarkData polyhedronTransformData;
+	polyhedronTransformData.out.Transform(polyhedronTransformData.rigid);
+}
+BENCHMARK_END
+
+BENCHMARK(Polyhedron_Transform_float3x4_PerVertex, "An in-place per-vertex float3x4::MulPos() loop over 1000 vertices")
+{
+	static PolyhedronTransformBenchmarkData polyhedronTransformData;
+	Polyhedron &out = polyhedronTransformData.out;
+	for(size_t j = 0; j < out.v.size(); ++j)
+		out.v[j] = polyhedronTransformData.rigid.MulPos(out.v[j]);
+}
+BENCHMARK_END
+
+BENCHMARK(Polyhedron_Transform_Quat, "Polyhedron::Transform(Quat) in-place with 1000 vertices")
+{
+	static PolyhedronTransformBenchmarkData polyhedronTransformData;
+	polyhedronTransformData.out.Transform(polyhedronTransformData.rotation);
+}
+BENCHMARK_END
+
+BENCHMARK(Polyhedron_Transform_Quat_PerVertex, "An in-place per-vertex Quat * vec loop over 1000 vertices")
+{
+	static PolyhedronTransformBenchmarkData polyhedronTransformData;
+	Polyhedron &out = polyhedronTransformData.out;
+	for(size_t j = 0; j < out.v.size(); ++j)
+		out.v[j] = polyhedronTransformData.rotation * out.v[j];
+}
+BENCHMARK_END
+
+BENCHMARK(Polyhedron_operator_mul_float3x4, "float3x4 * Polyhedron with 1000 vertices")
+{
+	static PolyhedronTransformBenchmarkData polyhedronTransformData;
+	Polyhedron out = polyhedronTransformData.tm * polyhedronTransformData.p;
+	polyhedronTransformData.out.v[0] = out.v[0];
+}
+BENCHMARK_END
+
+static Plane AccurateFacePlane(const Polyhedron &p, int faceIndex)
+{
+	return Plane(p.v[p.f[faceIndex].v[0]], p.FaceNormal(faceIndex));
+}
+
+// Tests if the point is inside all face planes of the convex polyhedron, by the given margin. A negative margin accepts
+// points that lie at most that far outside.
+static bool ConvexContainsWithMargin(const Polyhedron &p, const vec &pt, float margin)
+{
+	for(int i = 0; i < p.NumFaces(); ++i)
+		if (AccurateFacePlane(p, i).SignedDistance(pt) > -margin)
+			return false;
+	return true;
+}
+
+// Some of the generated polyhedra have their faces wound so that the face normals point inwards. Flips those.
+static void OrientFacesOutwards(Polyhedron &p)
+{
+	const Plane plane = AccurateFacePlane(p, 0);
+	float farthest = 0.f;
+	for(int i = 0; i < p.NumVertices(); ++i)
+		if (Abs(plane.SignedDistance(p.v[i])) > Abs(farthest))
+			farthest = plane.SignedDistance(p.v[i]);
+	if (farthest > 0.f)
+		p.FlipWindingOrder();
+}
+
+// Polyhedron::Volume() takes the face normals from the first three vertices of each face, which is inaccurate for
+// faces that start with nearly collinear vertices. This sums up the volumes of tetrahedra instead.
+static float TetrahedralVolume(const Polyhedron &p)
+{
+	if (p.v.empty())
+		return 0.f;
+	const vec o = p.v[0];
+	float volume = 0.f;
+	for(int i = 0; i < p.NumFaces(); ++i)
+		for(size_t j = 2; j < p.f[i].v.size(); ++j)
+		{
+			vec a = p.v[p.f[i].v[0]] - o, b = p.v[p.f[i].v[j-1]] - o, c = p.v[p.f[i].v[j]] - o;
+			volume += a.Dot(b.Cross(c));
+		}
+	return Abs(volume) / 6.f;
+}
+
+// Tests the topology and convexity of a clipped polyhedron. Polyhedron::IsClosed() is not used, since it expects the
+// faces to have no edges shorter than 1e-3, and clipping close to a vertex can leave such edges.
+static void AssertIsValidConvexPolyhedron(const Polyhedron &p)
+{
+	HalfEdgeMesh mesh(p);
+	assert(mesh.IsClosed());
+	assert(p.FaceIndicesValid());
+	assert(p.EulerFormulaHolds());
+	assert(mesh.IsConvex(p));
+	// The face normals must point outwards.
+	for(int i = 0; i < p.NumFaces(); ++i)
+	{
+		Plane plane = AccurateFacePlane(p, i);
+		for(int j = 0; j < p.NumVertices(); ++j)
+			assert2(plane.SignedDistance(p.v[j]) <= 1e-2f, i, plane.SignedDistance(p.v[j]));
+	}
+}
+
+RANDOMIZED_TEST(Polyhedron_ClipConvex_Plane)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Polyhedron p = (rng.Int(0, 1) == 0) ? RandomEllipsoidPolyhedron(rng, pt) : RandomPolyhedronContainingPoint(pt);
+	OrientFacesOutwards(p);
+	AABB aabb = p.MinimalEnclosingAABB();
+	Plane plane(aabb.RandomPointInside(rng), vec::RandomDir(rng));
+
+	Polyhedron kept = p;
+	Polyhedron removed = p;
+	bool anyKept = kept.ClipConvex(plane);
+	bool anyRemoved = removed.ClipConvex(Plane(plane.PointOnPlane(), -plane.normal));
+	assert(anyKept || anyRemoved);
+	if (anyKept)
+		AssertIsValidConvexPolyhedron(kept);
+	else
+		assert(kept.IsNull());
+	if (anyRemoved)
+		AssertIsValidConvexPolyhedron(removed);
+	float volume = TetrahedralVolume(p);
+	float keptVolume = TetrahedralVolume(kept);
+	float removedVolume = TetrahedralVolume(removed);
+	assert3(EqualRel(keptVolume + removedVolume, volume, 1e-3f), keptVolume, removedVolume, volume);
+
+	for(int i = 0; i < 100; ++i)
+	{
+		vec x = aabb.RandomPointInside(rng);
+		float d = plane.SignedDistance(x);
+		if (ConvexContainsWithMargin(p, x, 1e-2f) && Abs(d) > 1e-2f)
+		{
+			assert2((anyKept && ConvexContainsWithMargin(kept, x, -1e-2f)) == (d > 0.f), x, d);
+			assert2((anyRemoved && ConvexContainsWithMargin(removed, x, -1e-2f)) == (d < 0.f), x, d);
+		}
+		else if (!ConvexContainsWithMargin(p, x, -1e-2f))
+		{
+			assert(!anyKept || !ConvexContainsWithMargin(kept, x, 1e-2f));
+			assert(!anyRemoved || !ConvexContainsWithMargin(removed, x, 1e-2f));
+		}
+	}
+}
+
+// Planes that pass exactly through vertices and edges of a cube.
+UNIQUE_TEST(Polyhedron_ClipConvex_Plane_ThroughVertices)
+{
+	const Polyhedron cube = AABB(POINT_VEC_SCALAR(-1.f), POINT_VEC_SCALAR(1.f)).ToPolyhedron();
+
+	// Cuts off the corner (1,1,1) through its three neighbors.
+	Polyhedron corner = cube;
+	assert(corner.ClipConvex(Plane(DIR_VEC(1.f, 1.f, 1.f).Normalized(), 1.f / Sqrt(3.f))));
+	AssertIsValidConvexPolyhedron(corner);
+	assert(corner.NumVertices() == 4);
+	assert(corner.NumFaces() == 4);
+	assert(EqualAbs(TetrahedralVolume(corner), 4.f / 3.f, 1e-4f));
+
+	Polyhedron rest = cube;
+	assert(rest.ClipConvex(Plane(DIR_VEC(-1.f, -1.f, -1.f).Normalized(), -1.f / Sqrt(3.f))));
+	AssertIsValidConvexPolyhedron(rest);
+	assert(rest.NumVertices() == 7);
+	assert(rest.NumFaces() == 7);
+	assert(EqualAbs(TetrahedralVolume(rest), 8.f - 4.f / 3.f, 1e-4f));
+
+	// Splits the cube along a diagonal through two of its edges.
+	Polyhedron prism = cube;
+	assert(prism.ClipConvex(Plane(DIR_VEC(1.f, 1.f, 0.f).Normalized(), 0.f)));
+	AssertIsValidConvexPolyhedron(prism);
+	assert(prism.NumVertices() == 6);
+	assert(prism.NumFaces() == 5);
+	assert(EqualAbs(TetrahedralVolume(prism), 4.f, 1e-4f));
+
+	// A plane that touches the cube at a face keeps all of it, or nothing.
+	Polyhedron all = cube;
+	assert(all.ClipConvex(Plane(DIR_VEC(-1.f, 0.f, 0.f), -1.f)));
+	assert(all.NumVertices() == 8);
+	assert(all.NumFaces() == 6);
+	Polyhedron none = cube;
+	assert(!none.ClipConvex(Plane(DIR_VEC(1.f, 0.f, 0.f), 1.f)));
+	assert(none.IsNull());
+}
+
+// Faces with less than three vertices do not define a clipping plane.
+UNIQUE_TEST(Polyhedron_ClipConvex_Polyhedron_DegenerateFaces)
+{
+	const Polyhedron cube = AABB(POINT_VEC_SCALAR(-1.f), POINT_VEC_SCALAR(1.f)).ToPolyhedron();
+	Polyhedron box = AABB(POINT_VEC_SCALAR(0.f), POINT_VEC_SCALAR(2.f)).ToPolyhedron();
+	box.f.insert(box.f.begin(), Polyhedron::Face());
+	Polyhedron p = cube;
+	assert(p.ClipConvex(box));
+	AssertIsValidConvexPolyhedron(p);
+	assert(EqualAbs(TetrahedralVolume(p), 1.f, 1e-4f));
+
+	// Without any proper faces the clipping polyhedron bounds no volume.
+	Polyhedron points = box;
+	points.f.clear();
+	p = cube;
+	assert(!p.ClipConvex(points));
+	assert(p.IsNull());
+	points.f.push_back(Polyhedron::Face());
+	p = cube;
+	assert(!p.ClipConvex(points));
+	assert(p.IsNull());
+}
+
+RANDOMIZED_TEST(Polyhedron_ClipConvex_Polyhedron)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Polyhedron a = RandomEllipsoidPolyhedron(rng, pt);
+	Polyhedron b = RandomPolyhedronContainingPoint(POINT_VEC_SCALAR(0.f));
+	Polyhedron bOutwards = b;
+	OrientFacesOutwards(bOutwards);
+	vec n = vec::RandomDir(rng);
+	vec offset = a.ExtremePoint(n) + n * rng.Float(-5.f, 1.f) - b.ExtremePoint(-n);
+	b.Translate(offset);
+	bOutwards.Translate(offset);
+
+	// The winding order of the clipping polyhedron does not matter.
+	Polyhedron intersection = a;
+	bool intersects = intersection.ClipConvex(b);
+	Polyhedron intersection2 = a;
+	assert(intersection2.ClipConvex(bOutwards) == intersects);
+	assert(EqualAbs(TetrahedralVolume(intersection2), TetrahedralVolume(intersection), 1e-2f));
+	if (intersects)
+		AssertIsValidConvexPolyhedron(intersection);
+	else
+		assert(intersection.IsNull());
+
+	AABB aabb = a.MinimalEnclosingAABB();
+	aabb.Enclose(b.MinimalEnclosingAABB());
+	for(int i = 0; i < 100; ++i)
+	{
+		vec x = aabb.RandomPointInside(rng);
+		if (ConvexContainsWithMargin(a, x, 1e-2f) && ConvexContainsWithMargin(bOutwards, x, 1e-2f))
+			assert1(intersects && ConvexContainsWithMargin(intersection, x, -1e-2f), x);
+		else if (!ConvexContainsWithMargin(a, x, -1e-2f) || !ConvexContainsWithMargin(bOutwards, x, -1e-2f))
+			assert1(!intersects || !ConvexContainsWithMargin(intersection, x, 1e-2f), x);
+	}
+}
+
+static const int numClipConvexBenchmarkPairs = 32;
+
+// Each small hull straddles the supporting plane of the large hull in a random direction.
+struct ClipConvexBenchmarkData
+{
+	Polyhedron hull;
+	Polyhedron small[numClipConvexBenchmarkPairs];
+	vec normal[numClipConvexBenchmarkPairs];
+
+	ClipConvexBenchmarkData()
+	{
+		LCG lcg(4567);
+		hull = EllipsoidPolyhedron(POINT_VEC_SCALAR(0.f), DIR_VEC(10.f, 6.f, 8.f), 21, 24);
+		for(int i = 0; i < numClipConvexBenchmarkPairs; ++i)
+		{
+			normal[i] = vec::RandomDir(lcg);
+			small[i] = EllipsoidPolyhedron(POINT_VEC_SCALAR(0.f), DIR_VEC(3.f, 4.f, 5.f), 10, 12);
+			small[i].Transform(Quat::RandomRotation(lcg));
+			small[i].Translate(hull.ExtremePoint(normal[i]) + normal[i] * lcg.Float(-1.f, 1.f) - small[i].ExtremePoint(-normal[i]));
+		}
+	}
+};
+
+BENCHMARK(Polyhedron_ClipConvex_Plane_Box, "Polyhedron::ClipConvex(Plane) of a box by a plane through its center")
+{
+	static const ClipConvexBenchmarkData data;
+	static const Polyhedron box = AABB(POINT_VEC_SCALAR(-1.f), POINT_VEC_SCALAR(1.f)).ToPolyhedron();
+	static Polyhedron clipped;
+	clipped = box;
+	clipped.ClipConvex(Plane(POINT_VEC_SCALAR(0.f), data.normal[i % numClipConvexBenchmarkPairs]));
+	TestData::dummyResultInt += clipped.NumFaces();
+}
+BENCHMARK_END
+
+BENCHMARK_ITERS(Polyhedron_ClipConvex_Polyhedron, 3, numClipConvexBenchmarkPairs, "Polyhedron::ClipConvex(Polyhedron) of hulls of 506 and 122 vertices")
+{
+	static const ClipConvexBenchmarkData data;
+	static Polyhedron clipped;
+	clipped = data.hull;
+	clipped.ClipConvex(data.small[i]);
+	TestData::dummyResultInt += clipped.NumFaces();
+}
+BENCHMARK_ITERS_END
+
+// Tests that the simplified polyhedron stays close to the original one, by comparing their supporting planes in random
+// directions.
+static void AssertSupportsAreClose(LCG &lcg, const Polyhedron &original, const Polyhedron &simplified, float maxDistance)
+{
+	for(int i = 0; i < 20; ++i)
+	{
+		vec dir = vec::RandomDir(lcg);
+		float d, expected;
+		simplified.ExtremePoint(dir, d);
+		original.ExtremePoint(dir, expected);
+		assert3(EqualAbs(d, expected, maxDistance), d, expected, maxDistance);
+	}
+}
+
+RANDOMIZED_TEST(Polyhedron_Simplify_PreserveConvexity)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Polyhedron p = rng.Int(0, 1) ? RandomEllipsoidPolyhedron(rng, pt) : RandomSpherePointHull(rng, rng.Int(50, 1000));
+	// Ask for fewer vertices than the input has, so that the budget can only be met by removing vertices.
+	const int maxVertices = Min(rng.Int(16, 64), p.NumVertices() - 1);
+	Polyhedron s = p;
+	int numRemoved = s.Simplify(maxVertices, true);
+	assert2(numRemoved == p.NumVertices() - s.NumVertices(), numRemoved, p.NumVertices() - s.NumVertices());
+	assert2(s.NumVertices() < p.NumVertices(), s.NumVertices(), p.NumVertices());
+	assert2(s.NumVertices() <= maxVertices, s.NumVertices(), maxVertices);
+	assert(s.FaceIndicesValid());
+	assert(s.EulerFormulaHolds());
+	HalfEdgeMesh mesh(s);
+	assert(mesh.IsClosed());
+	assert(mesh.IsConvex(s));
+	AABB aabb = p.MinimalEnclosingAABB();
+	AssertSupportsAreClose(rng, p, s, 0.2f * aabb.Size().MaxElement());
+}
+
+RANDOMIZED_TEST(Polyhedron_Simplify)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Polyhedron p = RandomEllipsoidPolyhedron(rng, pt);
+	const int maxVertices = rng.Int(4, 100);
+	Polyhedron s = p;
+	assert(s.Simplify(maxVertices) == p.NumVertices() - maxVertices);
+	assert2(s.NumVertices() == maxVertices, s.NumVertices(), maxVertices);
+	assert(s.FaceIndicesValid());
+	assert(s.EulerFormulaHolds());
+	assert(HalfEdgeMesh(s).IsClosed());
+	assert(s.NumFaces() == 2 * maxVertices - 4);
+}
+
+UNIQUE_TEST(Polyhedron_Simplify_InvalidInput)
+{
+	// A polyhedron that already has few enough vertices is left as is.
+	Polyhedron box = AABB(POINT_VEC_SCALAR(-1.f), POINT_VEC_SCALAR(1.f)).ToPolyhedron();
+	Polyhedron p = box;
+	assert(p.Simplify(8) == 0);
+	assert(p.NumVertices() == 8);
+	assert(p.NumFaces() == 6);
+
+	// The faces must form a closed surface.
+	p.f.pop_back();
+	assert(p.Simplify(4) == 0);
+	assert(p.NumVertices() == 8);
+	assert(p.NumFaces() == 5);
+
+	// A box simplifies down to a tetrahedron, but no further.
+	p = box;
+	assert(p.Simplify(0) == 4);
+	assert(p.NumVertices() == 4);
+	assert(p.NumFaces() == 4);
+	assert(p.EulerFormulaHolds());
+
+	Polyhedron empty;
+	assert(empty.Simplify(4) == 0);
+	assert(empty.IsNull());
+}
+
+// Detailed hulls reduced to collision proxies.
+struct SimplifyBenchmarkData
+{
+	Polyhedron ellipsoid;
+	Polyhedron sphereHull;
+
+	SimplifyBenchmarkData()
+	{
+		LCG lcg(5678);
+		ellipsoid = EllipsoidPolyhedron(POINT_VEC_SCALAR(0.f), DIR_VEC(10.f, 6.f, 8.f), 21, 24);
+		sphereHull = RandomSpherePointHull(lcg, 4000);
+	}
+};
+
+BENCHMARK_ITERS(Polyhedron_Simplify_506, 3, 1, "Polyhedron::Simplify() of a 506-vertex hull to 32 vertices, preserving convexity")
+{
+	static const SimplifyBenchmarkData data;
+	Polyhedron p = data.ellipsoid;
+	TestData::dummyResultInt += p.Simplify(32, true);
+}
+BENCHMARK_ITERS_END
+
+BENCHMARK_ITERS(Polyhedron_Simplify_4000, 3, 1, "Polyhedron::Simplify() of the hull of 4000 points to 64 vertices, preserving convexity")
+{
+	static const SimplifyBenchmarkData data;
+	Polyhedron p = data.sphereHull;
+	TestData::dummyResultInt += p.Simplify(64, true);
+}
+BENCHMARK_ITERS_END
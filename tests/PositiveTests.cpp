@@ -1338,6 +1338,8 @@ RANDOMIZED_TEST(PolyhedronPolyhedronIntersect)
 	Polyhedron b = RandomPolyhedronContainingPoint(pt);
 	assert(a.Intersects(b));
 	assert(b.Intersects(a));
+	assert(a.IntersectsConvex(b));
+	assert(b.IntersectsConvex(a));
 //	assert(a.Distance(b) == 0.f);
 //	assert(b.Distance(a) == 0.f);
 //	assert(a.Contains(a.ClosestPoint(b)));
@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/MathGeoLib.h"
+#include "../src/Math/myassert.h"
+#include "TestRunner.h"
+#include "TestData.h"
+#include "ObjectGenerators.h"
+
+MATH_IGNORE_UNUSED_VARS_WARNING
+
+// Returns a star-shaped, non-convex polyhedron with triangular faces: the hull of points on a sphere, with each vertex
+// pulled towards the center by a random amount.
+static Polyhedron RandomStarPolyhedron(LCG &lcg, const vec &center, float radius, int numPoints)
+{
+	VecArray points;
+	for(int i = 0; i < numPoints; ++i)
+		points.push_back(center + vec::RandomDir(lcg, radius));
+	Polyhedron hull = Polyhedron::ConvexHull(points);
+
+	Polyhedron p;
+	p.v = hull.v;
+	for(int i = 0; i < hull.NumFaces(); ++i)
+		for(size_t j = 2; j < hull.f[i].v.size(); ++j)
+		{
+			Polyhedron::Face triangle;
+			triangle.v.push_back(hull.f[i].v[0]);
+			triangle.v.push_back(hull.f[i].v[j-1]);
+			triangle.v.push_back(hull.f[i].v[j]);
+			p.f.push_back(triangle);
+		}
+	for(int i = 0; i < p.NumVertices(); ++i)
+		p.v[i] = center + (p.v[i] - center) * lcg.Float(0.4f, 1.f);
+	return p;
+}
+
+static float DistanceToSurface(const Polyhedron &p, const vec &pt)
+{
+	float d = FLOAT_INF;
+	for(int i = 0; i < p.NumFaces(); ++i)
+		d = Min(d, p.FacePolygon(i).Distance(pt));
+	return d;
+}
+
+// Tests random points in and around the bounding box of the polyhedron against Polyhedron::Contains(), skipping the
+// points close to the surface, where the two can disagree because of rounding.
+static void AssertContainsMatches(LCG &lcg, const Polyhedron &p, const PreparedPolyhedron &prepared, int numPoints)
+{
+	AABB aabb = p.MinimalEnclosingAABB();
+	aabb.Scale(aabb.CenterPoint(), 1.2f);
+	for(int i = 0; i < numPoints; ++i)
+	{
+		vec pt = aabb.RandomPointInside(lcg);
+		if (DistanceToSurface(p, pt) < 1e-2f)
+			continue;
+		assert2(prepared.Contains(pt) == p.Contains(pt), p, pt);
+	}
+}
+
+RANDOMIZED_TEST(PreparedPolyhedron_Contains_ConvexPolyhedron)
+{
+	vec pt = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Polyhedron p = RandomPolyhedronContainingPoint(pt);
+	PreparedPolyhedron prepared(p);
+	AssertContainsMatches(rng, p, prepared, 100);
+}
+
+RANDOMIZED_TEST(PreparedPolyhedron_Contains_StarPolyhedron)
+{
+	vec center = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	Polyhedron p = RandomStarPolyhedron(rng, center, rng.Float(1.f, SCALE), rng.Int(4, 100));
+	PreparedPolyhedron prepared(p);
+	assert(prepared.NumTriangles() == p.NumFaces());
+	AssertContainsMatches(rng, p, prepared, 100);
+}
+
+// The +X rays from the points of this grid pass exactly through the edges and vertices of the surface, and run along
+// its faces. Each crossing must be counted exactly once.
+UNIQUE_TEST(PreparedPolyhedron_Contains_RaysThroughEdgesAndVertices)
+{
+	AABB box(POINT_VEC_SCALAR(-1.f), POINT_VEC_SCALAR(1.f));
+	PreparedPolyhedron preparedBox(box.ToPolyhedron());
+
+	// The octahedron |x| + |y| + |z| <= 1.
+	Polyhedron octahedron;
+	octahedron.v.push_back(POINT_VEC(1.f, 0.f, 0.f));
+	octahedron.v.push_back(POINT_VEC(-1.f, 0.f, 0.f));
+	octahedron.v.push_back(POINT_VEC(0.f, 1.f, 0.f));
+	octahedron.v.push_back(POINT_VEC(0.f, -1.f, 0.f));
+	octahedron.v.push_back(POINT_VEC(0.f, 0.f, 1.f));
+	octahedron.v.push_back(POINT_VEC(0.f, 0.f, -1.f));
+	for(int i = 0; i < 8; ++i)
+	{
+		Polyhedron::Face face;
+		face.v.push_back(0 + (i & 1));
+		face.v.push_back(2 + ((i >> 1) & 1));
+		face.v.push_back(4 + ((i >> 2) & 1));
+		// The face (x, y, z) is counterclockwise from the outside if an even number of its axes are negative.
+		int numNegative = (i & 1) + ((i >> 1) & 1) + ((i >> 2) & 1);
+		if (numNegative % 2 == 1)
+			std::swap(face.v[1], face.v[2]);
+		octahedron.f.push_back(face);
+	}
+	assert(octahedron.IsClosed());
+	PreparedPolyhedron preparedOctahedron(octahedron);
+
+	for(int x = -4; x <= 4; ++x)
+		for(int y = -4; y <= 4; ++y)
+			for(int z = -4; z <= 4; ++z)
+			{
+				vec pt = POINT_VEC(x * 0.5f, y * 0.5f, z * 0.5f);
+				float boxDistance = Max(Abs(pt.x), Abs(pt.y), Abs(pt.z));
+				if (boxDistance != 1.f)
+					assert1(preparedBox.Contains(pt) == (boxDistance < 1.f), pt);
+				float octahedronDistance = Abs(pt.x) + Abs(pt.y) + Abs(pt.z);
+				if (octahedronDistance != 1.f)
+					assert1(preparedOctahedron.Contains(pt) == (octahedronDistance < 1.f), pt);
+			}
+}
+
+UNIQUE_TEST(PreparedPolyhedron_Empty)
+{
+	PreparedPolyhedron prepared;
+	assert(prepared.NumTriangles() == 0);
+	assert(!prepared.Contains(POINT_VEC_SCALAR(0.f)));
+
+	prepared.Set(Polyhedron());
+	assert(!prepared.Contains(POINT_VEC_SCALAR(0.f)));
+
+	vec pt = POINT_VEC_SCALAR(0.f);
+	u32 bits = 0xFFFFFFFFu;
+	prepared.ContainsMany(&pt, 1, &bits);
+	assert(bits == 0);
+}
+
+RANDOMIZED_TEST(PreparedPolyhedron_ContainsMany)
+{
+	vec center = vec::RandomBox(rng, POINT_VEC_SCALAR(-SCALE), POINT_VEC_SCALAR(SCALE));
+	float radius = rng.Float(1.f, SCALE);
+	PreparedPolyhedron prepared(RandomStarPolyhedron(rng, center, radius, rng.Int(4, 100)));
+
+	const int numPoints = rng.Int(1, 300);
+	const int numWords = (numPoints + 31) / 32;
+	VecArray points;
+	for(int i = 0; i < numPoints; ++i)
+		points.push_back(vec::RandomBox(rng, center - DIR_VEC_SCALAR(radius), center + DIR_VEC_SCALAR(radius)));
+
+	std::vector<u32> bits(numWords, 0xFFFFFFFFu);
+	std::vector<u32> parallelBits(numWords, 0xFFFFFFFFu);
+	prepared.ContainsMany(&points[0], numPoints, &bits[0]);
+	ThreadPool pool(rng.Int(1, 4));
+	prepared.ContainsMany(&points[0], numPoints, &parallelBits[0], pool, rng.Int(0, 100));
+
+	for(int i = 0; i < numWords * 32; ++i)
+	{
+		bool bit = (bits[i / 32] & (1u << (i % 32))) != 0;
+		bool expected = i < numPoints && prepared.Contains(points[i]);
+		assert2(bit == expected, i, numPoints);
+	}
+	for(int i = 0; i < numWords; ++i)
+		assert2(parallelBits[i] == bits[i], i, numWords);
+}
+
+// A non-convex mesh of about a thousand triangles, and the centers of a 32x32x32 voxel grid over its bounding box.
+struct PreparedPolyhedronBenchmarkData
+{
+	Polyhedron polyhedron;
+	PreparedPolyhedron prepared;
+	VecArray voxelCenters;
+	std::vector<u32> bits;
+
+	PreparedPolyhedronBenchmarkData()
+	{
+		LCG lcg(123);
+		polyhedron = RandomStarPolyhedron(lcg, POINT_VEC_SCALAR(0.f), SCALE, 500);
+		prepared.Set(polyhedron);
+		AABB aabb = polyhedron.MinimalEnclosingAABB();
+		const int n = 32;
+		for(int z = 0; z < n; ++z)
+			for(int y = 0; y < n; ++y)
+				for(int x = 0; x < n; ++x)
+					voxelCenters.push_back(aabb.PointInside((x + 0.5f) / n, (y + 0.5f) / n, (z + 0.5f) / n));
+		bits.resize((voxelCenters.size() + 31) / 32);
+	}
+};
+
+static PreparedPolyhedronBenchmarkData &BenchmarkData()
+{
+	static PreparedPolyhedronBenchmarkData data;
+	return data;
+}
+
+// Each iteration tests one voxel center, spread over the whole grid.
+BENCHMARK_ITERS(Polyhedron_Contains_VoxelCenter, 3, 64, "Polyhedron::Contains of one voxel center against a non-convex mesh of 1000 triangles")
+{
+	const PreparedPolyhedronBenchmarkData &data = BenchmarkData();
+	TestData::dummyResultInt += data.polyhedron.Contains(data.voxelCenters[i * 509 % data.voxelCenters.size()]) ? 1 : 0;
+}
+BENCHMARK_ITERS_END
+
+BENCHMARK_ITERS(PreparedPolyhedron_Contains_VoxelCenter, 3, 32768, "PreparedPolyhedron::Contains of one voxel center against a non-convex mesh of 1000 triangles")
+{
+	const PreparedPolyhedronBenchmarkData &data = BenchmarkData();
+	TestData::dummyResultInt += data.prepared.Contains(data.voxelCenters[i]) ? 1 : 0;
+}
+BENCHMARK_ITERS_END
+
+BENCHMARK_ITERS(PreparedPolyhedron_Set, 3, 1, "PreparedPolyhedron::Set of a non-convex mesh of 1000 triangles")
+{
+	PreparedPolyhedron prepared(BenchmarkData().polyhedron);
+	TestData::dummyResultInt += prepared.NumTriangles();
+}
+BENCHMARK_ITERS_END
+
+BENCHMARK_ITERS(PreparedPolyhedron_ContainsMany_VoxelGrid, 10, 1, "PreparedPolyhedron::ContainsMany of the 32768 voxel centers of a non-convex mesh of 1000 triangles")
+{
+	PreparedPolyhedronBenchmarkData &data = BenchmarkData();
+	data.prepared.ContainsMany(&data.voxelCenters[0], (int)data.voxelCenters.size(), &data.bits[0]);
+	TestData::dummyResultInt += data.bits[0];
+}
+BENCHMARK_ITERS_END
+
+static void BenchmarkParallelContainsMany(int numThreads)
+{
+	PreparedPolyhedronBenchmarkData &data = BenchmarkData();
+	data.prepared.ContainsMany(&data.voxelCenters[0], (int)data.voxelCenters.size(), &data.bits[0], TestData::BenchmarkThreadPool(numThreads));
+	TestData::dummyResultInt += data.bits[0];
+}
+
+BENCHMARK_ITERS(PreparedPolyhedron_ContainsMany_VoxelGrid_1Thread, 10, 1, "Parallel PreparedPolyhedron::ContainsMany of 32768 voxel centers on 1 thread")
+{
+	BenchmarkParallelContainsMany(1);
+}
+BENCHMARK_ITERS_END
+
+BENCHMARK_ITERS(PreparedPolyhedron_ContainsMany_VoxelGrid_2Threads, 10, 1, "Parallel PreparedPolyhedron::ContainsMany of 32768 voxel centers on 2 threads")
+{
+	BenchmarkParallelContainsMany(2);
+}
+BENCHMARK_ITERS_END
+
+BENCHMARK_ITERS(PreparedPolyhedron_ContainsMany_VoxelGrid_4Threads, 10, 1, "Parallel PreparedPolyhedron::ContainsMany of 32768 voxel centers on 4 threads")
+{
+	BenchmarkParallelContainsMany(4);
+}
+BENCHMARK_ITERS_END
+
+BENCHMARK_ITERS(PreparedPolyhedron_ContainsMany_VoxelGrid_8Threads, 10, 1, "Parallel PreparedPolyhedron::ContainsMany of 32768 voxel centers on 8 threads")
+{
+	BenchmarkParallelContainsMany(8);
+}
+BENCHMARK_ITERS_END
@@ -297,6 +297,18 @@ float4 *VectorArrayWithW0Or1()
 	return arr;
 }
 
+ThreadPool &BenchmarkThreadPool(int numThreads)
+{
+	static ThreadPool pool1(1), pool2(2), pool4(4), pool8(8);
+	switch(numThreads)
+	{
+	case 1: return pool1;
+	case 2: return pool2;
+	case 4: return pool4;
+	default: return pool8;
+	}
+}
+
 float2 uninitializedFloat2;
 float3 uninitializedFloat3;
 float4 uninitializedFloat4;
@@ -306,6 +318,7 @@ float4x4 uninitializedFloat4x4;
 Quat uninitializedQuat;
 
 int dummyResultInt = 0;
+float dummyResultFloat = 0.f;
 vec dummyResultVec = vec::zero;
 
 float *f = 0;
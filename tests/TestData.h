@@ -31,6 +31,10 @@ AABB *AABBArray();
 OBB *OBBArray();
 Frustum *FrustumArray();
 
+/// Returns a thread pool with 1, 2, 4 or 8 worker threads, shared by the multithreaded benchmarks. Any other
+/// numThreads returns the pool with 8 threads.
+ThreadPool &BenchmarkThreadPool(int numThreads);
+
 void InitTestData();
 
 #ifdef _MSC_VER
@@ -70,6 +74,7 @@ extern Quat uninitializedQuat;
 // An otherwise unused variable, but global so that writing results to this has the effect that compiler won't
 // optimize out benchmarks that time how long computations take.
 extern int dummyResultInt;
+extern float dummyResultFloat;
 extern vec dummyResultVec;
 
 } // ~TestData
@@ -0,0 +1,44 @@
+#include "../src/Math/myassert.h"
+#include "../src/MathGeoLib.h"
+#include "../tests/TestRunner.h"
+
+#include <vector>
+
+MATH_IGNORE_UNUSED_VARS_WARNING
+
+static void IncrementRange(void *userData, int begin, int end)
+{
+	int *counts = reinterpret_cast<int *>(userData);
+	for(int i = begin; i < end; ++i)
+		++counts[i];
+}
+
+RANDOMIZED_TEST(ThreadPool_ParallelFor_VisitsEachItemOnce)
+{
+	ThreadPool pool(rng.Int(1, 4));
+	int numItems = rng.Int(0, 1000);
+	int chunkSize = rng.Int(0, 100);
+	std::vector<int> counts(numItems + 1, 0);
+	pool.ParallelFor(numItems, chunkSize, IncrementRange, &counts[0]);
+	for(int i = 0; i < numItems; ++i)
+		assert2(counts[i] == 1, i, counts[i]);
+	assert(counts[numItems] == 0);
+
+	// The pool must be reusable for subsequent jobs.
+	pool.ParallelFor(numItems, chunkSize, IncrementRange, &counts[0]);
+	for(int i = 0; i < numItems; ++i)
+		assert2(counts[i] == 2, i, counts[i]);
+}
+
+UNIQUE_TEST(ThreadPool_NumThreads)
+{
+	assert(ThreadPool::HardwareConcurrency() >= 1);
+	ThreadPool pool;
+#ifdef MATH_THREADS
+	assert(pool.NumThreads() == ThreadPool::HardwareConcurrency());
+	ThreadPool pool3(3);
+	assert(pool3.NumThreads() == 3);
+#else
+	assert(pool.NumThreads() == 1);
+#endif
+}
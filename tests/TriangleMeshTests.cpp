@@ -1,6 +1,8 @@
 #include "../src/Math/myassert.h"
 #include "../src/MathGeoLib.h"
 #include "../tests/TestRunner.h"
+#include "../tests/TestData.h"
+#include <stdio.h>
 
 UNIQUE_TEST(TriangleMeshSet)
 {
@@ -46,3 +48,837 @@ TEST(TriangleMeshSet3)
 	triangleMesh->Set((Triangle*)p, 12);
 	delete triangleMesh;
 }
+
+// Generates a soup of small random triangles scattered inside a box.
+static std::vector<float3> RandomTriangleSoup(LCG &lcg, int numTriangles)
+{
+	std::vector<float3> vertices;
+	for(int i = 0; i < numTriangles; ++i)
+	{
+		float3 center = float3::RandomBox(lcg, -SCALE, SCALE);
+		for(int j = 0; j < 3; ++j)
+			vertices.push_back(center + float3::RandomBox(lcg, -10.f, 10.f));
+	}
+	return vertices;
+}
+
+// Generates a ray that is aimed at the centroid of a random triangle of the given triangle soup.
+static Ray RandomRayTowardsTriangleSoup(LCG &lcg, const std::vector<float3> &vertices)
+{
+	int t = lcg.Int(0, (int)vertices.size()/3 - 1);
+	float3 target = (vertices[t*3] + vertices[t*3+1] + vertices[t*3+2]) / 3.f;
+	float3 pos = float3::RandomBox(lcg, -2.f*SCALE, 2.f*SCALE);
+	return Ray(POINT_VEC(pos), DIR_VEC((target - pos).Normalized()));
+}
+
+#if defined(MATH_SSE41) || defined(MATH_AVX)
+// Computes the nearest ray-triangle soup intersection distance using the scalar ray-triangle test.
+static float NearestRayTriangleSoupHit(const Ray &ray, const std::vector<float3> &vertices)
+{
+	float nearestD = FLOAT_INF;
+	for(size_t i = 0; i+3 <= vertices.size(); i += 3)
+	{
+		float u, v;
+		float d = Triangle::IntersectLineTri(ray.pos, ray.dir, POINT_VEC(vertices[i]), POINT_VEC(vertices[i+1]), POINT_VEC(vertices[i+2]), u, v);
+		if (d >= 0.f && d < nearestD)
+			nearestD = d;
+	}
+	return nearestD;
+}
+#endif
+
+#ifdef MATH_SSE41
+RANDOMIZED_TEST(TriangleMesh_IntersectRay_Planes_SSE41)
+{
+	std::vector<float3> vertices = RandomTriangleSoup(rng, 16);
+	TriangleMesh m;
+	m.SetSoA4Planes((const float*)&vertices[0], 16, sizeof(float3));
+	Ray ray = RandomRayTowardsTriangleSoup(rng, vertices);
+	float expected = NearestRayTriangleSoupHit(ray, vertices);
+	int triangleIndex = -1;
+	float u, v;
+	float d = m.IntersectRay_Planes_TriangleIndex_UV_SSE41(ray, triangleIndex, u, v);
+	assert2(EqualAbs(d, expected, 1e-3f * Max(1.f, expected)), d, expected);
+	assert1(triangleIndex >= 0 && triangleIndex < 16, triangleIndex);
+	assert(EqualAbs(m.IntersectRay_Planes_SSE41(ray), d));
+	assert(EqualAbs(m.IntersectRay_Planes_SSE2(ray), d));
+
+	// The public entry points dispatch the plane layout to its kernel.
+	int triangleIndex2 = -1;
+	float u2, v2;
+	assert(EqualAbs(m.IntersectRay(ray), d));
+	assert(EqualAbs(m.IntersectRay_TriangleIndex(ray, triangleIndex2), d) && triangleIndex2 == triangleIndex);
+	assert(EqualAbs(m.IntersectRay_TriangleIndex_UV(ray, triangleIndex2, u2, v2), d) && EqualAbs(u2, u) && EqualAbs(v2, v));
+
+	// The reported hit must be on the reported triangle at the reported barycentric coordinates.
+	vec hit = ray.GetPoint(d);
+	vec a = POINT_VEC(vertices[triangleIndex*3]);
+	vec b = POINT_VEC(vertices[triangleIndex*3+1]);
+	vec c = POINT_VEC(vertices[triangleIndex*3+2]);
+	vec pt = a + u * (b - a) + v * (c - a);
+	assert2(pt.Distance(hit) < 1e-1f, pt, hit);
+}
+#endif
+
+#ifdef MATH_AVX
+RANDOMIZED_TEST(TriangleMesh_IntersectRay_Planes_AVX)
+{
+	std::vector<float3> vertices = RandomTriangleSoup(rng, 16);
+	TriangleMesh m;
+	m.SetSoA8Planes((const float*)&vertices[0], 16, sizeof(float3));
+	Ray ray = RandomRayTowardsTriangleSoup(rng, vertices);
+	float expected = NearestRayTriangleSoupHit(ray, vertices);
+	int triangleIndex = -1;
+	float u, v;
+	float d = m.IntersectRay_Planes_TriangleIndex_UV_AVX(ray, triangleIndex, u, v);
+	assert2(EqualAbs(d, expected, 1e-3f * Max(1.f, expected)), d, expected);
+	assert1(triangleIndex >= 0 && triangleIndex < 16, triangleIndex);
+	assert(EqualAbs(m.IntersectRay_Planes_AVX(ray), d));
+
+	int triangleIndex2 = -1;
+	float u2, v2;
+	assert(EqualAbs(m.IntersectRay(ray), d));
+	assert(EqualAbs(m.IntersectRay_TriangleIndex(ray, triangleIndex2), d) && triangleIndex2 == triangleIndex);
+	assert(EqualAbs(m.IntersectRay_TriangleIndex_UV(ray, triangleIndex2, u2, v2), d) && EqualAbs(u2, u) && EqualAbs(v2, v));
+
+	vec hit = ray.GetPoint(d);
+	vec a = POINT_VEC(vertices[triangleIndex*3]);
+	vec b = POINT_VEC(vertices[triangleIndex*3+1]);
+	vec c = POINT_VEC(vertices[triangleIndex*3+2]);
+	vec pt = a + u * (b - a) + v * (c - a);
+	assert2(pt.Distance(hit) < 1e-1f, pt, hit);
+}
+#endif
+
+UNIQUE_TEST(TriangleMesh_IntersectRay_Planes_Degenerate)
+{
+	// Zero-area triangles must never report a hit.
+	float3 vertices[12];
+	for(int i = 0; i < 12; ++i)
+		vertices[i] = float3((float)i, 0.f, 0.f);
+	Ray ray(POINT_VEC(1.f, -1.f, 0.f), DIR_VEC(0.f, 1.f, 0.f));
+	TriangleMesh m;
+#ifdef MATH_SSE41
+	m.SetSoA4Planes((const float*)vertices, 4, sizeof(float3));
+	assert(m.IntersectRay_Planes_SSE41(ray) == FLOAT_INF);
+#endif
+#ifdef MATH_AVX
+	float3 vertices8[24];
+	for(int i = 0; i < 24; ++i)
+		vertices8[i] = float3((float)i, 0.f, 0.f);
+	m.SetSoA8Planes((const float*)vertices8, 8, sizeof(float3));
+	assert(m.IntersectRay_Planes_AVX(ray) == FLOAT_INF);
+#endif
+	MARK_UNUSED(ray);
+	MARK_UNUSED(m);
+}
+
+const int numBenchmarkMeshTriangles = 256;
+
+// Returns the triangle soup that is used for benchmarking the ray-mesh intersection kernels.
+static const std::vector<float3> &BenchmarkTriangleSoup()
+{
+	static std::vector<float3> vertices;
+	if (vertices.empty())
+	{
+		LCG lcg;
+		vertices = RandomTriangleSoup(lcg, numBenchmarkMeshTriangles);
+	}
+	return vertices;
+}
+
+#if defined(MATH_SSE41) || defined(MATH_AVX)
+static const Ray *BenchmarkRays()
+{
+	static std::vector<Ray> rays;
+	if (rays.empty())
+	{
+		LCG lcg;
+		for(int i = 0; i < testrunner_numItersPerTest; ++i)
+			rays.push_back(RandomRayTowardsTriangleSoup(lcg, BenchmarkTriangleSoup()));
+	}
+	return &rays[0];
+}
+#endif
+
+static TriangleMesh *CreateBenchmarkMesh(void (TriangleMesh::*setFunc)(const float *, int, int))
+{
+	TriangleMesh *m = new TriangleMesh;
+	(m->*setFunc)((const float*)&BenchmarkTriangleSoup()[0], numBenchmarkMeshTriangles, sizeof(float3));
+	return m;
+}
+
+#ifdef MATH_SSE41
+static const TriangleMesh *MeshSoA4()
+{
+	static TriangleMesh *mesh = CreateBenchmarkMesh(&TriangleMesh::SetSoA4);
+	return mesh;
+}
+
+static const TriangleMesh *MeshSoA4Planes()
+{
+	static TriangleMesh *mesh = CreateBenchmarkMesh(&TriangleMesh::SetSoA4Planes);
+	return mesh;
+}
+
+BENCHMARK(TriangleMesh_IntersectRay_SSE41, "TriangleMesh::IntersectRay_SSE41 with 256 triangles")
+{
+	TestData::dummyResultFloat += MeshSoA4()->IntersectRay_SSE41(BenchmarkRays()[i]);
+}
+BENCHMARK_END
+
+BENCHMARK(TriangleMesh_IntersectRay_Planes_SSE41, "TriangleMesh::IntersectRay_Planes_SSE41 with 256 triangles")
+{
+	TestData::dummyResultFloat += MeshSoA4Planes()->IntersectRay_Planes_SSE41(BenchmarkRays()[i]);
+}
+BENCHMARK_END
+#endif
+
+#ifdef MATH_AVX
+static const TriangleMesh *MeshSoA8()
+{
+	static TriangleMesh *mesh = CreateBenchmarkMesh(&TriangleMesh::SetSoA8);
+	return mesh;
+}
+
+static const TriangleMesh *MeshSoA8Planes()
+{
+	static TriangleMesh *mesh = CreateBenchmarkMesh(&TriangleMesh::SetSoA8Planes);
+	return mesh;
+}
+
+BENCHMARK(TriangleMesh_IntersectRay_AVX, "TriangleMesh::IntersectRay_AVX with 256 triangles")
+{
+	TestData::dummyResultFloat += MeshSoA8()->IntersectRay_AVX(BenchmarkRays()[i]);
+}
+BENCHMARK_END
+
+BENCHMARK(TriangleMesh_IntersectRay_Planes_AVX, "TriangleMesh::IntersectRay_Planes_AVX with 256 triangles")
+{
+	TestData::dummyResultFloat += MeshSoA8Planes()->IntersectRay_Planes_AVX(BenchmarkRays()[i]);
+}
+BENCHMARK_END
+#endif
+
+static std::vector<Triangle> TrianglesFromSoup(const std::vector<float3> &vertices)
+{
+	std::vector<Triangle> tris;
+	for(size_t i = 0; i+3 <= vertices.size(); i += 3)
+		tris.push_back(Triangle(POINT_VEC(vertices[i]), POINT_VEC(vertices[i+1]), POINT_VEC(vertices[i+2])));
+	return tris;
+}
+
+RANDOMIZED_TEST(TriangleMesh_IntersectRays)
+{
+	const int numTris = 16;
+	std::vector<float3> vertices = RandomTriangleSoup(rng, numTris);
+	TriangleMesh m;
+	std::vector<Triangle> tris = TrianglesFromSoup(vertices);
+	m.Set(&tris[0], numTris);
+
+	const int numRays = 100;
+	Ray rays[numRays];
+	for(int i = 0; i < numRays; ++i)
+		rays[i] = (i % 4 == 0) ? Ray(POINT_VEC(0.f, 0.f, 3.f*SCALE), DIR_VEC(0.f, 0.f, 1.f)) : RandomRayTowardsTriangleSoup(rng, vertices); // Every fourth ray points away from the mesh.
+
+	float distances[numRays];
+	int indices[numRays];
+	m.IntersectRays(rays, numRays, distances, indices);
+
+	ThreadPool pool(3);
+	float distancesMT[numRays];
+	int indicesMT[numRays];
+	m.IntersectRays(rays, numRays, distancesMT, indicesMT, pool, 7);
+
+	for(int i = 0; i < numRays; ++i)
+	{
+		int triangleIndex = -1;
+		float d = m.IntersectRay_TriangleIndex(rays[i], triangleIndex);
+		assert3(distances[i] == d, i, distances[i], d);
+		assert3(indices[i] == triangleIndex, i, indices[i], triangleIndex);
+		assert2(distancesMT[i] == distances[i], distancesMT[i], distances[i]);
+		assert2(indicesMT[i] == indices[i], indicesMT[i], indices[i]);
+	}
+	for(int i = 0; i < numRays; i += 4)
+		assert2(distances[i] == FLOAT_INF && indices[i] == -1, distances[i], indices[i]);
+}
+
+const int numBenchmarkBatchRays = 1024;
+
+static void BenchmarkIntersectRays(int numThreads)
+{
+	static TriangleMesh *mesh = 0;
+	static std::vector<Ray> rays;
+	static std::vector<float> distances(numBenchmarkBatchRays);
+	if (!mesh)
+	{
+		mesh = new TriangleMesh;
+		std::vector<Triangle> tris = TrianglesFromSoup(BenchmarkTriangleSoup());
+		mesh->Set(&tris[0], numBenchmarkMeshTriangles);
+		LCG lcg;
+		for(int i = 0; i < numBenchmarkBatchRays; ++i)
+			rays.push_back(RandomRayTowardsTriangleSoup(lcg, BenchmarkTriangleSoup()));
+	}
+	mesh->IntersectRays(&rays[0], numBenchmarkBatchRays, &distances[0], 0, TestData::BenchmarkThreadPool(numThreads));
+	TestData::dummyResultFloat += distances[0];
+}
+
+BENCHMARK_ITERS(TriangleMesh_IntersectRays_1Thread, 10, 10, "TriangleMesh::IntersectRays, 1024 rays vs 256 triangles on 1 thread")
+{
+	BenchmarkIntersectRays(1);
+}
+BENCHMARK_ITERS_END
+
+BENCHMARK_ITERS(TriangleMesh_IntersectRays_2Threads, 10, 10, "TriangleMesh::IntersectRays, 1024 rays vs 256 triangles on 2 threads")
+{
+	BenchmarkIntersectRays(2);
+}
+BENCHMARK_ITERS_END
+
+BENCHMARK_ITERS(TriangleMesh_IntersectRays_4Threads, 10, 10, "TriangleMesh::IntersectRays, 1024 rays vs 256 triangles on 4 threads")
+{
+	BenchmarkIntersectRays(4);
+}
+BENCHMARK_ITERS_END
+
+BENCHMARK_ITERS(TriangleMesh_IntersectRays_8Threads, 10, 10, "TriangleMesh::IntersectRays, 1024 rays vs 256 triangles on 8 threads")
+{
+	BenchmarkIntersectRays(8);
+}
+BENCHMARK_ITERS_END
+
+static float NearestTriangleSoupDistance(const vec &point, const std::vector<float3> &vertices)
+{
+	float nearestD = FLOAT_INF;
+	for(size_t i = 0; i+3 <= vertices.size(); i += 3)
+		nearestD = Min(nearestD, Triangle(POINT_VEC(vertices[i]), POINT_VEC(vertices[i+1]), POINT_VEC(vertices[i+2])).Distance(point));
+	return nearestD;
+}
+
+static void CheckClosestPoint(const TriangleMesh &m, float d, const vec &closestPoint, int triangleIndex, const vec &point, float expected)
+{
+	assert3(EqualAbs(d, expected, 1e-3f * Max(1.f, expected)), d, expected, m.NumTriangles());
+	assert2(triangleIndex >= 0 && triangleIndex < m.NumTriangles(), triangleIndex, m.NumTriangles());
+	assert2(EqualAbs(closestPoint.Distance(point), d, 1e-3f * Max(1.f, d)), closestPoint.Distance(point), d);
+	assert2(m.GetTriangle(triangleIndex).Distance(closestPoint) < 1e-2f, triangleIndex, m.GetTriangle(triangleIndex).Distance(closestPoint));
+	MARK_UNUSED(m); MARK_UNUSED(d); MARK_UNUSED(closestPoint); MARK_UNUSED(triangleIndex); MARK_UNUSED(point); MARK_UNUSED(expected);
+}
+
+RANDOMIZED_TEST(TriangleMesh_ClosestPoint)
+{
+	const int numTris = 16;
+	std::vector<float3> vertices = RandomTriangleSoup(rng, numTris);
+	// Alternate between points far away from the mesh and points right next to a triangle.
+	vec point = POINT_VEC(float3::RandomBox(rng, -2.f*SCALE, 2.f*SCALE));
+	if (rng.Int(0, 1) == 0)
+	{
+		int t = rng.Int(0, numTris-1);
+		point = Triangle(POINT_VEC(vertices[t*3]), POINT_VEC(vertices[t*3+1]), POINT_VEC(vertices[t*3+2])).RandomPointInside(rng) + DIR_VEC(float3::RandomDir(rng, 0.1f));
+	}
+	float expected = NearestTriangleSoupDistance(point, vertices);
+
+	TriangleMesh m;
+	std::vector<Triangle> tris = TrianglesFromSoup(vertices);
+	m.SetAoS((const float*)&tris[0], numTris, sizeof(Triangle)/3);
+	vec closestPoint;
+	int triangleIndex = -1;
+	float d = m.ClosestPoint_CPP(point, closestPoint, triangleIndex);
+	CheckClosestPoint(m, d, closestPoint, triangleIndex, point, expected);
+	assert(EqualAbs(m.Distance(point), d));
+
+	m.SetSoA4((const float*)&vertices[0], numTris, sizeof(float3));
+	d = m.ClosestPoint_CPP(point, closestPoint, triangleIndex);
+	CheckClosestPoint(m, d, closestPoint, triangleIndex, point, expected);
+	closestPoint = m.ClosestPoint(point, &triangleIndex);
+	CheckClosestPoint(m, m.Distance(point), closestPoint, triangleIndex, point, expected);
+#ifdef MATH_SSE2
+	d = m.ClosestPoint_SSE2(point, closestPoint, triangleIndex);
+	CheckClosestPoint(m, d, closestPoint, triangleIndex, point, expected);
+#endif
+#ifdef MATH_SSE41
+	d = m.ClosestPoint_SSE41(point, closestPoint, triangleIndex);
+	CheckClosestPoint(m, d, closestPoint, triangleIndex, point, expected);
+#endif
+
+	m.SetSoA8((const float*)&vertices[0], numTris, sizeof(float3));
+	closestPoint = m.ClosestPoint(point, &triangleIndex);
+	CheckClosestPoint(m, m.Distance(point), closestPoint, triangleIndex, point, expected);
+#ifdef MATH_AVX
+	d = m.ClosestPoint_AVX(point, closestPoint, triangleIndex);
+	CheckClosestPoint(m, d, closestPoint, triangleIndex, point, expected);
+#endif
+}
+
+UNIQUE_TEST(TriangleMesh_ClosestPoint_Degenerate)
+{
+	// A mesh padded with degenerate triangles must still find the one proper triangle.
+	float3 vertices[24];
+	for(int i = 0; i < 24; ++i)
+		vertices[i] = float3((float)i, 0.f, 0.f);
+	vertices[21] = float3(0.f, 0.f, 10.f);
+	vertices[22] = float3(1.f, 0.f, 10.f);
+	vertices[23] = float3(0.f, 1.f, 10.f);
+	vec point = POINT_VEC(0.25f, 0.25f, 12.f);
+	TriangleMesh m;
+	m.SetSoA4((const float*)vertices, 8, sizeof(float3));
+	assert(EqualAbs(m.Distance(point), 2.f));
+	int triangleIndex = -1;
+	assert(m.ClosestPoint(point, &triangleIndex).Equals(POINT_VEC(0.25f, 0.25f, 10.f)));
+	assert(triangleIndex == 7);
+	m.SetSoA8((const float*)vertices, 8, sizeof(float3));
+	assert(EqualAbs(m.Distance(point), 2.f));
+	assert(m.ClosestPoint(point, &triangleIndex).Equals(POINT_VEC(0.25f, 0.25f, 10.f)));
+	assert(triangleIndex == 7);
+
+	TriangleMesh empty;
+	assert(empty.Distance(point) == FLOAT_INF);
+	assert(!empty.ClosestPoint(point, &triangleIndex).IsFinite());
+	assert(triangleIndex == -1);
+	MARK_UNUSED(point);
+	MARK_UNUSED(triangleIndex);
+}
+
+UNIQUE_TEST(TriangleMesh_VertexQueries_PlaneLayouts)
+{
+	// The plane layouts do not store the vertices, so the vertex queries must report that nothing was found.
+	const float3 vertices[24] = { float3(0,0,0), float3(1,0,0), float3(0,1,0) };
+	vec point = POINT_VEC(0.25f, 0.25f, 1.f);
+	TriangleMesh m;
+	for(int i = 0; i < 2; ++i)
+	{
+		if (i == 0)
+			m.SetSoA4Planes((const float*)vertices, 4, sizeof(float3));
+		else
+			m.SetSoA8Planes((const float*)vertices, 8, sizeof(float3));
+		assert(!m.GetTriangle(0).IsFinite());
+		int triangleIndex = 0;
+		vec closestPoint;
+		assert(m.ClosestPoint_TriangleIndex(point, closestPoint, triangleIndex) == FLOAT_INF);
+		assert(!closestPoint.IsFinite());
+		assert(triangleIndex == -1);
+		assert(m.Distance(point) == FLOAT_INF);
+
+		vec contactPoint, contactNormal;
+		triangleIndex = 0;
+		assert(m.SweepSphere(Sphere(point, 0.5f), DIR_VEC(0.f, 0.f, -2.f), contactPoint, contactNormal, triangleIndex) == FLOAT_INF);
+		assert(!contactPoint.IsFinite() && !contactNormal.IsFinite() && triangleIndex == -1);
+		triangleIndex = 0;
+		Capsule capsule(point, point + DIR_VEC(0.f, 0.f, 1.f), 0.5f);
+		assert(m.SweepCapsule(capsule, DIR_VEC(0.f, 0.f, -2.f), contactPoint, contactNormal, triangleIndex) == FLOAT_INF);
+		assert(!contactPoint.IsFinite() && !contactNormal.IsFinite() && triangleIndex == -1);
+		MARK_UNUSED(triangleIndex);
+	}
+	MARK_UNUSED(point);
+}
+
+static const vec *BenchmarkQueryPoints()
+{
+	static std::vector<vec> points;
+	if (points.empty())
+	{
+		LCG lcg;
+		for(int i = 0; i < testrunner_numItersPerTest; ++i)
+			points.push_back(POINT_VEC(float3::RandomBox(lcg, -2.f*SCALE, 2.f*SCALE)));
+	}
+	return &points[0];
+}
+
+static const TriangleMesh *MeshAoS()
+{
+	static TriangleMesh *mesh = CreateBenchmarkMesh(&TriangleMesh::SetAoS);
+	return mesh;
+}
+
+BENCHMARK(TriangleMesh_ClosestPoint_CPP, "TriangleMesh::ClosestPoint_CPP with 256 triangles")
+{
+	vec pt;
+	int triangleIndex;
+	TestData::dummyResultFloat += MeshAoS()->ClosestPoint_CPP(BenchmarkQueryPoints()[i], pt, triangleIndex);
+}
+BENCHMARK_END
+
+#ifdef MATH_SSE41
+BENCHMARK(TriangleMesh_ClosestPoint_SSE41, "TriangleMesh::ClosestPoint_SSE41 with 256 triangles")
+{
+	vec pt;
+	int triangleIndex;
+	TestData::dummyResultFloat += MeshSoA4()->ClosestPoint_SSE41(BenchmarkQueryPoints()[i], pt, triangleIndex);
+}
+BENCHMARK_END
+#endif
+
+#ifdef MATH_AVX
+BENCHMARK(TriangleMesh_ClosestPoint_AVX, "TriangleMesh::ClosestPoint_AVX with 256 triangles")
+{
+	vec pt;
+	int triangleIndex;
+	TestData::dummyResultFloat += MeshSoA8()->ClosestPoint_AVX(BenchmarkQueryPoints()[i], pt, triangleIndex);
+}
+BENCHMARK_END
+#endif
+
+// Computes the distance between the given triangle and the axis of a swept sphere or capsule.
+static float TriangleAxisDistance(const Triangle &tri, const LineSegment &axis)
+{
+	if (axis.a.Equals(axis.b))
+		return tri.Distance(axis.a);
+	vec otherPt;
+	vec pt = tri.ClosestPoint(axis, &otherPt);
+	return pt.Distance(otherPt);
+}
+
+// Verifies the result of a sweep of a shape with the given axis and radius against the triangle soup by sampling the motion.
+static void CheckSweep(const TriangleMesh &m, const std::vector<Triangle> &tris, const LineSegment &axis, float r, const vec &motion,
+	float t, const vec &contactPoint, const vec &contactNormal, int triangleIndex)
+{
+	// The time of impact is solved relative to the start of the motion, so its precision depends on the length of the motion.
+	const float eps = 1e-2f * Max(1.f, r) + 1e-4f * motion.Length();
+	if (triangleIndex < 0)
+	{
+		assert1(t == FLOAT_INF, t);
+		assert(!contactPoint.IsFinite() && !contactNormal.IsFinite());
+	}
+	else
+	{
+		assert1(t >= 0.f && t <= 1.f, t);
+		assert2(triangleIndex < m.NumTriangles(), triangleIndex, m.NumTriangles());
+		LineSegment hitAxis(axis.a + t * motion, axis.b + t * motion);
+		const Triangle &tri = tris[triangleIndex];
+		float d = TriangleAxisDistance(tri, hitAxis);
+		// At the time of impact the shape touches the triangle, or overlaps it if the shape intersects the mesh at the start.
+		assert4(t == 0.f ? d <= r + eps : EqualAbs(d, r, eps), t, d, r, triangleIndex);
+		assert2(tri.Distance(contactPoint) < eps, tri.Distance(contactPoint), triangleIndex);
+		assert1(t == 0.f || EqualAbs(hitAxis.Distance(contactPoint), r, eps), hitAxis.Distance(contactPoint));
+		assert1(contactNormal.IsNormalized(1e-3f), contactNormal);
+		assert2(t == 0.f || contactNormal.Dot(motion) <= eps * motion.Length(), contactNormal, motion);
+		MARK_UNUSED(d);
+	}
+
+	// The shape must stay clear of all triangles before the time of impact.
+	const int numSteps = 16;
+	float tEnd = Min(t, 1.f);
+	for(int i = 0; i < numSteps && tEnd > 0.f; ++i)
+	{
+		float ti = tEnd * i / numSteps;
+		LineSegment a(axis.a + ti * motion, axis.b + ti * motion);
+		for(size_t j = 0; j < tris.size(); ++j)
+			assert4(TriangleAxisDistance(tris[j], a) >= r - eps, ti, t, (int)j, TriangleAxisDistance(tris[j], a));
+	}
+	MARK_UNUSED(m); MARK_UNUSED(tris); MARK_UNUSED(contactPoint); MARK_UNUSED(contactNormal); MARK_UNUSED(r);
+}
+
+// Returns a motion vector that moves the given point towards a random triangle of the soup, overshooting or stopping short of it at random.
+static vec RandomSweepMotion(LCG &lcg, const vec &pos, const std::vector<float3> &vertices)
+{
+	int t = lcg.Int(0, (int)vertices.size()/3 - 1);
+	vec target = POINT_VEC((vertices[t*3] + vertices[t*3+1] + vertices[t*3+2]) / 3.f);
+	return (target - pos) * lcg.Float(0.5f, 1.5f);
+}
+
+static void CheckSweepVariantsAgree(float t, int triangleIndex, float t2, int triangleIndex2)
+{
+	assert2((triangleIndex < 0) == (triangleIndex2 < 0), triangleIndex, triangleIndex2);
+	assert2(triangleIndex < 0 || EqualAbs(t, t2, 1e-3f), t, t2);
+	MARK_UNUSED(t); MARK_UNUSED(triangleIndex); MARK_UNUSED(t2); MARK_UNUSED(triangleIndex2);
+}
+
+RANDOMIZED_TEST(TriangleMesh_SweepSphere)
+{
+	const int numTris = 16;
+	std::vector<float3> vertices = RandomTriangleSoup(rng, numTris);
+	std::vector<Triangle> tris = TrianglesFromSoup(vertices);
+	Sphere sphere(POINT_VEC(float3::RandomBox(rng, -2.f*SCALE, 2.f*SCALE)), rng.Float(0.5f, 10.f));
+	vec motion = RandomSweepMotion(rng, sphere.pos, vertices);
+	LineSegment axis(sphere.pos, sphere.pos);
+
+	TriangleMesh m;
+	m.SetAoS((const float*)&tris[0], numTris, sizeof(Triangle)/3);
+	vec contactPoint, contactNormal;
+	int triangleIndex;
+	float t = m.SweepSphere(sphere, motion, contactPoint, contactNormal, triangleIndex);
+	CheckSweep(m, tris, axis, sphere.r, motion, t, contactPoint, contactNormal, triangleIndex);
+
+	m.SetSoA4((const float*)&vertices[0], numTris, sizeof(float3));
+	int triangleIndex2;
+	float t2 = m.SweepSphere(sphere, motion, contactPoint, contactNormal, triangleIndex2);
+	CheckSweep(m, tris, axis, sphere.r, motion, t2, contactPoint, contactNormal, triangleIndex2);
+	CheckSweepVariantsAgree(t, triangleIndex, t2, triangleIndex2);
+	t2 = m.SweepSphere_CPP(sphere, motion, contactPoint, triangleIndex2);
+	CheckSweepVariantsAgree(t, triangleIndex, t2, triangleIndex2);
+
+	m.SetSoA8((const float*)&vertices[0], numTris, sizeof(float3));
+	t2 = m.SweepSphere(sphere, motion, contactPoint, contactNormal, triangleIndex2);
+	CheckSweep(m, tris, axis, sphere.r, motion, t2, contactPoint, contactNormal, triangleIndex2);
+	CheckSweepVariantsAgree(t, triangleIndex, t2, triangleIndex2);
+}
+
+RANDOMIZED_TEST(TriangleMesh_SweepCapsule)
+{
+	const int numTris = 16;
+	std::vector<float3> vertices = RandomTriangleSoup(rng, numTris);
+	std::vector<Triangle> tris = TrianglesFromSoup(vertices);
+	vec a = POINT_VEC(float3::RandomBox(rng, -2.f*SCALE, 2.f*SCALE));
+	Capsule capsule(a, a + DIR_VEC(float3::RandomDir(rng, rng.Float(1.f, 30.f))), rng.Float(0.5f, 10.f));
+	vec motion = RandomSweepMotion(rng, capsule.Center(), vertices);
+
+	TriangleMesh m;
+	m.SetAoS((const float*)&tris[0], numTris, sizeof(Triangle)/3);
+	vec contactPoint, contactNormal;
+	int triangleIndex;
+	float t = m.SweepCapsule(capsule, motion, contactPoint, contactNormal, triangleIndex);
+	CheckSweep(m, tris, capsule.l, capsule.r, motion, t, contactPoint, contactNormal, triangleIndex);
+
+	m.SetSoA4((const float*)&vertices[0], numTris, sizeof(float3));
+	int triangleIndex2;
+	float t2 = m.SweepCapsule(capsule, motion, contactPoint, contactNormal, triangleIndex2);
+	CheckSweep(m, tris, capsule.l, capsule.r, motion, t2, contactPoint, contactNormal, triangleIndex2);
+	CheckSweepVariantsAgree(t, triangleIndex, t2, triangleIndex2);
+	t2 = m.SweepCapsule_CPP(capsule, motion, contactPoint, triangleIndex2);
+	CheckSweepVariantsAgree(t, triangleIndex, t2, triangleIndex2);
+
+	m.SetSoA8((const float*)&vertices[0], numTris, sizeof(float3));
+	t2 = m.SweepCapsule(capsule, motion, contactPoint, contactNormal, triangleIndex2);
+	CheckSweep(m, tris, capsule.l, capsule.r, motion, t2, contactPoint, contactNormal, triangleIndex2);
+	CheckSweepVariantsAgree(t, triangleIndex, t2, triangleIndex2);
+}
+
+UNIQUE_TEST(TriangleMesh_SweepCapsule_Features)
+{
+	// A triangle on the z=0 plane, and capsules that first touch it on the face, on an edge and on a vertex.
+	// The SoA4 layout needs a multiple of four triangles, so pad with copies of the triangle far away.
+	float3 vertices[12];
+	for(int i = 0; i < 4; ++i)
+	{
+		vertices[i*3] = float3(0.f, 0.f, 1000.f * i);
+		vertices[i*3+1] = float3(10.f, 0.f, 1000.f * i);
+		vertices[i*3+2] = float3(0.f, 10.f, 1000.f * i);
+	}
+	TriangleMesh m;
+	m.SetSoA4((const float*)vertices, 4, sizeof(float3));
+	vec contactPoint, contactNormal;
+	int triangleIndex;
+
+	// Face: a horizontal capsule falling down.
+	Capsule capsule(POINT_VEC(1.f, 1.f, 5.f), POINT_VEC(3.f, 1.f, 5.f), 1.f);
+	float t = m.SweepCapsule(capsule, DIR_VEC(0.f, 0.f, -8.f), contactPoint, contactNormal, triangleIndex);
+	assert1(EqualAbs(t, 0.5f), t);
+	assert(triangleIndex == 0);
+	assert2(contactPoint.z == 0.f && contactPoint.x >= 1.f - 1e-4f && contactPoint.x <= 3.f + 1e-4f, contactPoint, t);
+	assert1(contactNormal.Equals(DIR_VEC(0.f, 0.f, 1.f), 1e-4f), contactNormal);
+
+	// Edge: a capsule perpendicular to the y=0 edge, sliding towards it from the side.
+	capsule = Capsule(POINT_VEC(5.f, -4.f, -3.f), POINT_VEC(5.f, -4.f, 3.f), 1.f);
+	t = m.SweepCapsule(capsule, DIR_VEC(0.f, 6.f, 0.f), contactPoint, contactNormal, triangleIndex);
+	assert1(EqualAbs(t, 0.5f), t);
+	assert1(contactPoint.Equals(POINT_VEC(5.f, 0.f, 0.f), 1e-4f), contactPoint);
+	assert1(contactNormal.Equals(DIR_VEC(0.f, -1.f, 0.f), 1e-4f), contactNormal);
+
+	// Vertex: an end cap approaching the corner at the origin.
+	Sphere sphere(POINT_VEC(-3.f, -4.f, 0.f), 1.f);
+	t = m.SweepSphere(sphere, DIR_VEC(3.f, 4.f, 0.f) * 2.f, contactPoint, contactNormal, triangleIndex);
+	assert1(EqualAbs(t, 0.4f), t);
+	assert1(contactPoint.Equals(POINT_VEC(0.f, 0.f, 0.f), 1e-4f), contactPoint);
+
+	// Miss: moving parallel to the triangle plane above it.
+	t = m.SweepSphere(sphere, DIR_VEC(0.f, 0.f, 1.f), contactPoint, contactNormal, triangleIndex);
+	assert1(t == FLOAT_INF, t);
+	assert(triangleIndex == -1);
+	MARK_UNUSED(t);
+}
+
+static const Sphere *BenchmarkSpheres()
+{
+	static std::vector<Sphere> spheres;
+	if (spheres.empty())
+	{
+		LCG lcg;
+		for(int i = 0; i < testrunner_numItersPerTest; ++i)
+			spheres.push_back(Sphere(POINT_VEC(float3::RandomBox(lcg, -2.f*SCALE, 2.f*SCALE)), lcg.Float(0.5f, 10.f)));
+	}
+	return &spheres[0];
+}
+
+static const vec *BenchmarkSweepMotions()
+{
+	static std::vector<vec> motions;
+	if (motions.empty())
+	{
+		LCG lcg;
+		for(int i = 0; i < testrunner_numItersPerTest; ++i)
+			motions.push_back(RandomSweepMotion(lcg, BenchmarkSpheres()[i].pos, BenchmarkTriangleSoup()));
+	}
+	return &motions[0];
+}
+
+static Capsule BenchmarkCapsule(int i)
+{
+	const Sphere &s = BenchmarkSpheres()[i];
+	return Capsule(s.pos, s.pos + DIR_VEC(s.r, s.r, 0.f), s.r);
+}
+
+BENCHMARK(TriangleMesh_SweepSphere_CPP, "TriangleMesh::SweepSphere_CPP with 256 triangles")
+{
+	vec pt;
+	int triangleIndex;
+	TestData::dummyResultFloat += MeshAoS()->SweepSphere_CPP(BenchmarkSpheres()[i], BenchmarkSweepMotions()[i], pt, triangleIndex);
+}
+BENCHMARK_END
+
+BENCHMARK(TriangleMesh_SweepCapsule_CPP, "TriangleMesh::SweepCapsule_CPP with 256 triangles")
+{
+	vec pt;
+	int triangleIndex;
+	TestData::dummyResultFloat += MeshAoS()->SweepCapsule_CPP(BenchmarkCapsule(i), BenchmarkSweepMotions()[i], pt, triangleIndex);
+}
+BENCHMARK_END
+
+#ifdef MATH_SSE41
+BENCHMARK(TriangleMesh_SweepSphere_SSE2, "TriangleMesh::SweepSphere_SSE2 with 256 triangles")
+{
+	vec pt;
+	int triangleIndex;
+	TestData::dummyResultFloat += MeshSoA4()->SweepSphere_SSE2(BenchmarkSpheres()[i], BenchmarkSweepMotions()[i], pt, triangleIndex);
+}
+BENCHMARK_END
+
+BENCHMARK(TriangleMesh_SweepCapsule_SSE2, "TriangleMesh::SweepCapsule_SSE2 with 256 triangles")
+{
+	vec pt;
+	int triangleIndex;
+	TestData::dummyResultFloat += MeshSoA4()->SweepCapsule_SSE2(BenchmarkCapsule(i), BenchmarkSweepMotions()[i], pt, triangleIndex);
+}
+BENCHMARK_END
+#endif
+
+#ifdef MATH_AVX
+BENCHMARK(TriangleMesh_SweepSphere_AVX, "TriangleMesh::SweepSphere_AVX with 256 triangles")
+{
+	vec pt;
+	int triangleIndex;
+	TestData::dummyResultFloat += MeshSoA8()->SweepSphere_AVX(BenchmarkSpheres()[i], BenchmarkSweepMotions()[i], pt, triangleIndex);
+}
+BENCHMARK_END
+
+BENCHMARK(TriangleMesh_SweepCapsule_AVX, "TriangleMesh::SweepCapsule_AVX with 256 triangles")
+{
+	vec pt;
+	int triangleIndex;
+	TestData::dummyResultFloat += MeshSoA8()->SweepCapsule_AVX(BenchmarkCapsule(i), BenchmarkSweepMotions()[i], pt, triangleIndex);
+}
+BENCHMARK_END
+#endif
+
+// Reads a whole file into a 32-byte aligned buffer, in the same way that memory mapping the file would provide it.
+static void *LoadAlignedFile(const char *filename, size_t &outSizeBytes)
+{
+	FILE *handle = fopen(filename, "rb");
+	if (!handle)
+		return 0;
+	fseek(handle, 0, SEEK_END);
+	outSizeBytes = (size_t)ftell(handle);
+	fseek(handle, 0, SEEK_SET);
+	void *fileData = AlignedMalloc(outSizeBytes, 32);
+	if (fread(fileData, outSizeBytes, 1, handle) != 1)
+		outSizeBytes = 0;
+	fclose(handle);
+	return fileData;
+}
+
+RANDOMIZED_TEST(TriangleMesh_SoAFileView)
+{
+	const int numTris = rng.Int(1, 20);
+	std::vector<float3> vertices = RandomTriangleSoup(rng, numTris);
+	std::vector<Triangle> tris = TrianglesFromSoup(vertices);
+	const int simdWidth = rng.Int(0, 1) ? 8 : 4;
+	const char *filename = "TriangleMesh_SoAFileView.bin";
+	bool saved = TriangleMesh::SaveSoAFile(filename, (const float*)&vertices[0], numTris, sizeof(float3), simdWidth);
+	assert(saved);
+	MARK_UNUSED(saved);
+
+	size_t fileSizeBytes = 0;
+	void *fileData = LoadAlignedFile(filename, fileSizeBytes);
+	remove(filename);
+	assert(fileData);
+
+	TriangleMesh m;
+	bool success = m.SetSoAFileView(fileData, fileSizeBytes);
+	assert(success);
+	assert(m.IsView());
+	assert2(m.NumTriangles() % simdWidth == 0 && m.NumTriangles() >= numTris && m.NumTriangles() < numTris + simdWidth, m.NumTriangles(), numTris);
+	for(int i = 0; i < numTris; ++i)
+		assert2(m.GetTriangle(i).Equals(tris[i], 1e-3f), m.GetTriangle(i), tris[i]);
+
+	vec point = POINT_VEC(float3::RandomBox(rng, -2.f*SCALE, 2.f*SCALE));
+	float expected = NearestTriangleSoupDistance(point, vertices);
+	vec closestPoint;
+	int triangleIndex = -1;
+	closestPoint = m.ClosestPoint(point, &triangleIndex);
+	CheckClosestPoint(m, m.Distance(point), closestPoint, triangleIndex, point, expected);
+	assert(triangleIndex < numTris);
+
+	// The view is intersected with the kernel of its own layout, whichever layout Set() would have chosen.
+	TriangleMesh aos;
+	aos.SetAoS((const float*)&vertices[0], numTris, sizeof(float3));
+	Ray ray = RandomRayTowardsTriangleSoup(rng, vertices);
+	int aosTriangleIndex = -1;
+	float aosD = aos.IntersectRay_TriangleIndex(ray, aosTriangleIndex);
+	triangleIndex = -1;
+	float d = m.IntersectRay_TriangleIndex(ray, triangleIndex);
+	assert2(EqualAbs(d, aosD, 1e-3f * Max(1.f, aosD)), d, aosD);
+	assert2(triangleIndex == aosTriangleIndex, triangleIndex, aosTriangleIndex);
+	assert2(EqualAbs(m.IntersectRay(ray), d), m.IntersectRay(ray), d);
+
+	// Copies of a view refer to the same data instead of copying it.
+	TriangleMesh copy(m);
+	assert(copy.IsView());
+	assert(EqualAbs(copy.Distance(point), m.Distance(point)));
+
+	// Setting owned data turns the mesh back into a regular mesh.
+	copy.SetAoS((const float*)&tris[0], numTris, sizeof(Triangle)/3);
+	assert(!copy.IsView());
+	assert(EqualAbs(copy.Distance(point), expected, 1e-3f * Max(1.f, expected)));
+
+	// Truncated and misaligned data is rejected.
+	success = m.SetSoAFileView(fileData, fileSizeBytes - 4);
+	assert(!success);
+	assert(m.NumTriangles() == 0);
+	success = m.SetSoA4View((const float*)fileData + 1, 4);
+	assert(!success);
+	success = m.SetSoA8View((const float*)fileData + 4, 8);
+	assert(!success);
+	success = m.SetSoA4View((const float*)fileData + 4, 0);
+	assert(success);
+	AlignedFree(fileData);
+	MARK_UNUSED(success);
+	MARK_UNUSED(expected);
+	MARK_UNUSED(aosD);
+	MARK_UNUSED(d);
+}
+
+UNIQUE_TEST(TriangleMesh_AoSView)
+{
+	const float3 vertices[6] = { float3(0,0,0), float3(1,0,0), float3(0,1,0), float3(0,0,2), float3(1,0,2), float3(0,1,2) };
+	TriangleMesh m;
+	bool success = m.SetAoSView((const float*)vertices, 2, sizeof(float3));
+	assert(success);
+	assert(m.IsView());
+	assert(m.GetTriangle(1).Equals(Triangle(POINT_VEC(0,0,2), POINT_VEC(1,0,2), POINT_VEC(0,1,2))));
+	int triangleIndex = -1;
+	m.ClosestPoint(POINT_VEC(0.25f, 0.25f, 3.f), &triangleIndex);
+	assert(triangleIndex == 1);
+	// The stride of the view is sizeof(float3), which differs from sizeof(vec) in float4 builds.
+	float u, v;
+	float d = m.IntersectRay_TriangleIndex_UV(Ray(POINT_VEC(0.25f, 0.25f, 3.f), DIR_VEC(0, 0, -1)), triangleIndex, u, v);
+	assert(EqualAbs(d, 1.f));
+	assert(triangleIndex == 1);
+	assert(EqualAbs(u, 0.25f) && EqualAbs(v, 0.25f));
+	assert(EqualAbs(m.IntersectRay(Ray(POINT_VEC(0.5f, 0.25f, -1.f), DIR_VEC(0, 0, 1))), 1.f));
+	success = m.SetAoSView((const float*)vertices, 2, 2);
+	assert(!success);
+	assert(!m.IsView());
+	MARK_UNUSED(success);
+	MARK_UNUSED(triangleIndex);
+	MARK_UNUSED(d);
+	MARK_UNUSED(u);
+	MARK_UNUSED(v);
+}